@@ -50,7 +50,12 @@ class MetalRenderer: NSObject, MTKViewDelegate {
         setupPipeline()
         
         // Create texture for SNES screen
-        let textureDescriptor = MTLTextureDescriptor.texture2DDescriptor(pixelFormat: .rgba8Unorm, width: Int(emulator.frameBufferWidth()), height: Int(emulator.frameBufferHeight()), mipmapped: false)
+        makeTexture(width: Int(emulator.frameBufferWidth()), height: Int(emulator.frameBufferHeight()))
+    }
+    
+    // The frame size changes with hi-res, interlace and overscan
+    func makeTexture(width: Int, height: Int) {
+        let textureDescriptor = MTLTextureDescriptor.texture2DDescriptor(pixelFormat: .bgra8Unorm, width: width, height: height, mipmapped: false)
         textureDescriptor.usage = [.shaderRead]
         texture = device.makeTexture(descriptor: textureDescriptor)
     }
@@ -97,24 +102,16 @@ class MetalRenderer: NSObject, MTKViewDelegate {
     }
     
     func updateTexture() {
-        guard let texture = texture else { return }
-        
         let frameBuffer = emulator.getFrameBuffer()
         let width = Int(emulator.frameBufferWidth())
         let height = Int(emulator.frameBufferHeight())
-        
-        // Convert RGB to RGBA
-        var rgbaData = [UInt8](repeating: 0, count: width * height * 4)
-        for i in 0..<(width * height) {
-            let srcOffset = i * 3
-            let dstOffset = i * 4
-            rgbaData[dstOffset] = frameBuffer[srcOffset]
-            rgbaData[dstOffset + 1] = frameBuffer[srcOffset + 1]
-            rgbaData[dstOffset + 2] = frameBuffer[srcOffset + 2]
-            rgbaData[dstOffset + 3] = 255
+        if texture == nil || texture!.width != width || texture!.height != height {
+            makeTexture(width: width, height: height)
         }
+        guard let texture = texture else { return }
         
+        // The core already renders BGRA rows, so upload them as they are
         let region = MTLRegionMake2D(0, 0, width, height)
-        texture.replace(region: region, mipmapLevel: 0, withBytes: rgbaData, bytesPerRow: width * 4)
+        texture.replace(region: region, mipmapLevel: 0, withBytes: frameBuffer, bytesPerRow: Int(emulator.frameBufferBytesPerRow()))
     }
 }
@@ -24,21 +24,50 @@ NS_ASSUME_NONNULL_BEGIN
 // Emulator control
 -(void)reset;
 -(void)runFrame;            // Run one frame worth of cycles
+// Run frames as fast as possible, drawing every interval-th one and the
+// last (0 = only the last), without sound. Returns the speed reached as a
+// multiple of real time.
+-(double)fastForward:(NSInteger)frames renderEvery:(NSInteger)interval;
 -(void)step;                // Execute one instruction
 
 // Get frame buffer for rendering
-// Returns pointer to RGB pixel data (SNES native is 256x224)
+// Returns pointer to BGRA pixel data; rows are frameBufferBytesPerRow
+// apart and can be uploaded as they are.
+// This is the newest complete frame; it stays valid and unchanged until
+// the next call, even while runFrame renders on another thread.
+// The size can change between frames: 256 wide, or 512 with hi-res
+// lines; 224 or 239 (overscan) tall, doubled when interlaced. The
+// frameBuffer* sizes describe the frame getFrameBuffer last returned.
 -(const uint8_t *)getFrameBuffer;
 -(NSInteger)frameBufferWidth;
 -(NSInteger)frameBufferHeight;
+-(NSInteger)frameBufferBytesPerRow;
 
 // Emulator state
 -(BOOL)isRunning;
 -(void)pause;
 -(void)resume;
+// Run the sound CPU and DSP on a thread of their own (on by default
+// with 4 or more cores); results are the same either way
+-(void)setAPUThreaded:(BOOL)threaded;
+// Show frames that many frames ahead of the game (0 = off), hiding its
+// own input lag. A frame in which the input changes then costs
+// frames + 1 frames of work; the others, about one.
+-(void)setRunAhead:(NSInteger)frames;
+
+// Audio, as interleaved stereo float at the host's rate (48 kHz unless set)
+// readAudio is lock-free and can be called from the audio callback's
+// thread; missing frames are silence. Returns the frames that were ready.
+-(void)setAudioOutputRate:(double)rate;
+-(NSInteger)readAudio:(float*)buffer frames:(NSInteger)frames;
+-(double)audioFillLevel;            // 0 (empty) to 1 (full)
 
 // Debug info
 -(NSString*)getCPUState;
+-(NSString*)getTileCacheStats;      // Decoded tile cache hit rate
+-(NSString*)getLineStats;           // Unchanged scanlines reused instead of drawn
+-(NSString*)getBRRCacheStats;       // BRR sample blocks reused instead of decoded
+-(NSString*)getAPUThreadStats;      // Speculation rolled back, and waits on the thread
 @end
 
 NS_ASSUME_NONNULL_END
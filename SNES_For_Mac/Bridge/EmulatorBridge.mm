@@ -6,18 +6,12 @@
 //
 
 #import "EmulatorBridge.h"
-#import "../Core/CPU/CPU65c816.hpp"
-#import "../Core/Memory/Memory.hpp"
-#include <vector>
-
-// SNES native resolution
-const int SCREEN_WIDTH = 256;
-const int SCREEN_HEIGHT = 224;
+#import "../Core/Emulator.hpp"
+#include <thread>
+#include <algorithm>
 
 @interface EmulatorBridge() {
-    CPU65c816* cpu;
-    Memory* memory;
-    std::vector<uint8_t>* frameBuffer;
+    Emulator* emulator;
     BOOL running;
 }
 @end
@@ -26,12 +20,18 @@ const int SCREEN_HEIGHT = 224;
 -(instancetype)init {
     self = [super init];
     if (self) {
-        cpu = new CPU65c816();
-        memory = new Memory();
-        cpu->setMemory(memory);
+        emulator = new Emulator();
+        PPU& ppu = emulator->getPPU();
+        
+        // The PPU renders straight into the texture's format (BGRA, 4 bytes per pixel)
+        ppu.getOutput().setFormat(FrameOutput::FORMAT_BGRA8888);
+        
+        // Draw each frame's lines in parallel at v-blank on the spare cores
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        ppu.setRenderThreads(std::min(cores - 1, 7));
         
-        // Allocate frame buffer (RGB, 3 bytes per pixel)
-        frameBuffer = new std::vector<uint8_t>(SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+        // The SPC700 and DSP get a core of their own if there are enough
+        emulator->setAPUThreaded(cores >= 4);
         
         // Fill with a test pattern initially
         [self fillTestPattern];
@@ -42,9 +42,7 @@ const int SCREEN_HEIGHT = 224;
 }
 
 -(void)dealloc {
-    delete cpu;
-    delete memory;
-    delete frameBuffer;
+    delete emulator;
 }
 
 -(BOOL)loadROMFromPath:(NSString *)path error:(NSError **)error {
@@ -70,52 +68,69 @@ const int SCREEN_HEIGHT = 224;
     const uint8_t* bytes = (const uint8_t*)data.bytes;
     std::vector<uint8_t> romData(bytes, bytes + data.length);
     
-    bool success = memory->loadROM(romData);
-    if (!success) {
+    if (!emulator->loadROM(romData)) {
         if (error) {
             *error = [NSError errorWithDomain:@"EmulatorError" code:3 userInfo:@{NSLocalizedDescriptionKey:@"Failed to load ROM"}];
         }
         return NO;
     }
-    [self reset];
+    [self fillTestPattern];
     return YES;
 }
 
 -(void)reset {
-    cpu->reset();
-    memory->reset();
+    emulator->reset();
     [self fillTestPattern];
 }
 
+-(void)setAPUThreaded:(BOOL)threaded {
+    emulator->setAPUThreaded(threaded);
+}
+
+-(void)setRunAhead:(NSInteger)frames {
+    emulator->setRunAhead((int)frames);
+}
+
 -(void)runFrame {
     if (!running) return;
-    // SNES runs at ~60Hz
-    // At ~3.58MHz CPU speed, that's roughly 59,666 cycles per frame
-    const int CYCLES_PER_FRAME = 59666;
-    
-    int cyclesRun = 0;
-    while (cyclesRun < CYCLES_PER_FRAME) {
-        int cycles = cpu->executeInstruction();
-        cyclesRun += cycles;
-    }
-    // TODO: Update frame buffer with actual PPU output
-    // For now, we'll keep the test pattern
+    emulator->runFrame();
+}
+
+-(double)fastForward:(NSInteger)frames renderEvery:(NSInteger)interval {
+    if (!running) return 0.0;
+    return emulator->fastForward((int)frames, (int)interval);
+}
+
+-(void)setAudioOutputRate:(double)rate {
+    emulator->setAudioOutputRate(rate);
+}
+
+-(NSInteger)readAudio:(float*)buffer frames:(NSInteger)frames {
+    return emulator->readAudio(buffer, (int)frames);
+}
+
+-(double)audioFillLevel {
+    return emulator->getAudioFillLevel();
 }
 
 -(void)step {
-    cpu->executeInstruction();
+    emulator->step();
 }
 
 -(const uint8_t*)getFrameBuffer {
-    return frameBuffer->data();
+    return emulator->getOutput().acquireFrame().pixels;
+}
+
+-(NSInteger)frameBufferBytesPerRow {
+    return emulator->getOutput().getFrontFrame().stride;
 }
 
 -(NSInteger)frameBufferWidth {
-    return SCREEN_WIDTH;
+    return emulator->getOutput().getFrontFrame().width;
 }
 
 -(NSInteger)frameBufferHeight {
-    return SCREEN_HEIGHT;
+    return emulator->getOutput().getFrontFrame().height;
 }
 
 -(BOOL)isRunning {
@@ -131,34 +146,78 @@ const int SCREEN_HEIGHT = 224;
 }
 
 -(NSString*)getCPUState {
+    CPU65c816& cpu = emulator->getCPU();
     // Format CPU registers for debugging
     return [NSString stringWithFormat:@"A: $%04X  X: $%04X  Y: $%04X\n"
     @"SP: $%04X  PC: $%04X  P: $%02X\n"
     @"DBR: $%02X  PBR: $%02X  D: $%04X\n"
     @"E: %d  Cycles: %llu",
-    cpu->registers.A,
-    cpu->registers.X,
-    cpu->registers.Y,
-    cpu->registers.SP,
-    cpu->registers.PC,
-    cpu->registers.P,
-    cpu->registers.DBR,
-    cpu->registers.PBR,
-    cpu->registers.D,
-    cpu->registers.E ? 1 : 0,
-    cpu->totalCycles];
+    cpu.registers.A,
+    cpu.registers.X,
+    cpu.registers.Y,
+    cpu.registers.SP,
+    cpu.registers.PC,
+    cpu.registers.P,
+    cpu.registers.DBR,
+    cpu.registers.PBR,
+    cpu.registers.D,
+    cpu.registers.E ? 1 : 0,
+    cpu.totalCycles];
+}
+
+-(NSString*)getTileCacheStats {
+    TileCache& cache = emulator->getPPU().getTileCache();
+    return [NSString stringWithFormat:@"Tile cache: %.1f%% hits (%llu hits, %llu decodes)",
+            cache.getHitRate() * 100.0,
+            (unsigned long long)cache.getHits(),
+            (unsigned long long)cache.getMisses()];
+}
+
+-(NSString*)getLineStats {
+    PPU& ppu = emulator->getPPU();
+    unsigned long long skipped = ppu.getSkippedLines();
+    unsigned long long total = skipped + ppu.getRenderedLines();
+    return [NSString stringWithFormat:@"Scanlines: %.1f%% reused (%llu reused, %llu drawn)",
+            total ? skipped * 100.0 / total : 0.0,
+            skipped,
+            total - skipped];
+}
+
+-(NSString*)getBRRCacheStats {
+    unsigned long long hits = emulator->getBRRCacheHits();
+    unsigned long long total = hits + emulator->getBRRCacheMisses();
+    return [NSString stringWithFormat:@"BRR cache: %.1f%% hits (%llu hits, %llu decodes)",
+            total ? hits * 100.0 / total : 0.0,
+            hits,
+            total - hits];
+}
+
+-(NSString*)getAPUThreadStats {
+    APUThread& thread = emulator->getAPUThread();
+    return [NSString stringWithFormat:@"APU thread: %@, %llu rollbacks, %llu stalls",
+            thread.isRunning() ? @"running" : @"off",
+            (unsigned long long)thread.getRollbacks(),
+            (unsigned long long)thread.getStalls()];
 }
 
 // Helper: Fill frame buffer with a colorful test pattern
 -(void)fillTestPattern {
-    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
-        for(int x = 0; x < SCREEN_WIDTH; ++x) {
-            int offset = (y * SCREEN_WIDTH + x) * 3;
-            // Create a gradient pattern
-            (*frameBuffer)[offset + 0] = (uint8_t)((x * 255) / SCREEN_WIDTH);           // R
-            (*frameBuffer)[offset + 1] = (uint8_t)((y * 255) / SCREEN_HEIGHT);          // G
-            (*frameBuffer)[offset + 2] = (uint8_t)(((x + y) * 255) / (SCREEN_WIDTH + SCREEN_HEIGHT));       // B
+    const int width = PPU::SCREEN_WIDTH;
+    const int height = PPU::SCREEN_HEIGHT;
+    PPU& ppu = emulator->getPPU();
+    FrameOutput& output = ppu.getOutput();
+    output.resize(width, height);
+    uint16_t line[width];
+    for (int y = 0; y < height; ++y) {
+        for(int x = 0; x < width; ++x) {
+            // Create a gradient pattern (BGR555)
+            uint16_t r = (x * 31) / width;
+            uint16_t g = (y * 31) / height;
+            uint16_t b = ((x + y) * 31) / (width + height);
+            line[x] = r | (g << 5) | (b << 10);
         }
+        output.writeLine(y, line, 0x0F, width);
     }
+    ppu.endFrame();
 }
 @end
@@ -0,0 +1,74 @@
+//
+//  APUClock.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "APUClock.hpp"
+#include "SPC700.hpp"
+#include "APUThread.hpp"
+#include "../CPU/CPU65c816.hpp"
+#include "../Types/Timing.hpp"
+
+APUClock::APUClock(): cpu(nullptr), apu(nullptr), thread(nullptr) {
+    reset();
+}
+
+void APUClock::setCPU(const CPU65c816* processor) {
+    cpu = processor;
+}
+
+void APUClock::setAPU(SPC700* sound) {
+    apu = sound;
+}
+
+void APUClock::setThread(APUThread* worker) {
+    thread = worker;
+}
+
+void APUClock::reset() {
+    masterCycles = cpu ? cpu->totalCycles * MASTER_CYCLES_PER_CPU_CYCLE : 0;
+    remainder = 0;
+    catchUps = 0;
+}
+
+void APUClock::catchUp() {
+    if (!cpu || !apu) {
+        return;
+    }
+    // The S-CPU's count is where the current instruction started
+    uint64 now = cpu->totalCycles * MASTER_CYCLES_PER_CPU_CYCLE;
+    if (now <= masterCycles) {
+        return;
+    }
+    remainder += (now - masterCycles) * APU_CLOCK;
+    masterCycles = now;
+    uint64 cycles = remainder / MASTER_CLOCK_NTSC;
+    remainder %= MASTER_CLOCK_NTSC;
+    if (cycles > 0) {
+        if (thread && thread->isRunning()) {
+            thread->advance(cycles);
+        } else {
+            apu->run(static_cast<int>(cycles));
+        }
+        catchUps++;
+    }
+}
+
+uint8 APUClock::readPort(int port) {
+    catchUp();
+    if (thread && thread->isRunning()) {
+        return thread->readPort(port);
+    }
+    return apu->readPort(port);
+}
+
+void APUClock::writePort(int port, uint8 value) {
+    catchUp();
+    if (thread && thread->isRunning()) {
+        thread->writePort(port, value);
+    } else {
+        apu->writePort(port, value);
+    }
+}
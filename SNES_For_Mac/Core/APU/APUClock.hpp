@@ -0,0 +1,58 @@
+//
+//  APUClock.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef APUCLOCK_HPP
+#define APUCLOCK_HPP
+
+#include "../Types/Types.hpp"
+
+class CPU65c816;
+class SPC700;
+class APUThread;
+
+// Keeps the SPC700 behind the S-CPU and runs it forward in one batch
+// when the two have to agree: when the S-CPU touches $2140-$2143 (Memory
+// calls catchUp() first) and at the end of the frame.
+// The SPC700 only sees the S-CPU through the ports and runs the same
+// instructions however its run() calls are split, so this matches running
+// it in lockstep after every S-CPU instruction.
+// While an APUThread is set and running, the time goes to it instead and
+// port access goes through its queues.
+class APUClock {
+public:
+    APUClock();
+
+    // S-CPU time source (its cycle count) and the SPC700 it drives
+    void setCPU(const CPU65c816* processor);
+    void setAPU(SPC700* sound);
+    void setThread(APUThread* worker);
+
+    // Start counting from the S-CPU's current time (after either is reset)
+    void reset();
+
+    // Run the SPC700 up to the S-CPU's current time
+    void catchUp();
+
+    // $2140-$2143 as the S-CPU sees them, after catching up
+    uint8 readPort(int port);
+    void writePort(int port, uint8 value);
+
+    // Master cycle the SPC700 has been run up to
+    uint64 getTime() const { return masterCycles; }
+
+    // Batches run since reset
+    uint64 getCatchUps() const { return catchUps; }
+
+private:
+    const CPU65c816* cpu;
+    SPC700* apu;
+    APUThread* thread;
+    uint64 masterCycles;
+    uint64 remainder;                   // Master cycles * APU_CLOCK short of a whole SPC700 cycle
+    uint64 catchUps;
+};
+#endif
@@ -0,0 +1,317 @@
+//
+//  APUThread.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "APUThread.hpp"
+#include <algorithm>
+#include <chrono>
+
+APUThread::APUThread(): apu(nullptr), dsp(nullptr), running(false),
+                        writes(4096), events(16384), audio(32768 * 2),
+                        target(0), writesApplied(0), reached(0), rollbacks(0),
+                        stalls(0), brrHits(0), brrMisses(0),
+                        stopping(false), finished(false), sleeping(false),
+                        time(0), writesSent(0), base(0), foldedTo(0),
+                        appliedBase(0), given(0), coolUntil(0) {
+    std::fill(ports, ports + 4, 0);
+}
+
+APUThread::~APUThread() {
+    stop();
+}
+
+void APUThread::setAPU(SPC700* sound) {
+    apu = sound;
+}
+
+void APUThread::setDSP(DSP* sound) {
+    dsp = sound;
+}
+
+void APUThread::start() {
+    if (running || !apu || !dsp) {
+        return;
+    }
+    // S-CPU side
+    time = 0;
+    writesSent = 0;
+    base = apu->getTargetCycle();
+    for (int i = 0; i < 4; ++i) {
+        ports[i] = apu->readPort(i);
+    }
+    foldedTo = base;
+    changes.clear();
+
+    // Thread side, set up before it starts
+    target.store(0);
+    writesApplied.store(0);
+    reached.store(0);
+    stopping.store(false);
+    finished.store(false);
+    brrHits.store(dsp->getCacheHits());
+    brrMisses.store(dsp->getCacheMisses());
+    given = 0;
+    coolUntil = 0;
+    pending.clear();
+    applied.clear();
+    appliedBase = 0;
+    log.clear();
+    apu->setPortLog(&log);
+    takeCheckpoint();
+
+    running = true;
+    thread = std::thread(&APUThread::threadMain, this);
+}
+
+void APUThread::stop() {
+    if (!running) {
+        return;
+    }
+    stopping.store(true);
+    notify();
+    // Keep taking events so the thread never blocks on a full queue
+    while (!finished.load(std::memory_order_acquire)) {
+        drainEvents();
+        std::this_thread::yield();
+    }
+    thread.join();
+    drainEvents();
+    changes.clear();
+    running = false;
+}
+
+void APUThread::advance(uint64 cycles) {
+    time += cycles;
+    target.store(time, std::memory_order_release);
+    notify();
+    drainEvents();
+}
+
+uint8 APUThread::readPort(int port) {
+    // The thread has to have taken every write and got as far as now
+    auto ready = [this]() {
+        return writesApplied.load(std::memory_order_acquire) == writesSent &&
+               reached.load(std::memory_order_acquire) >= time;
+    };
+    if (!ready()) {
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        notify();
+        while (!ready()) {
+            drainEvents();
+            std::this_thread::yield();
+        }
+    }
+    drainEvents();
+
+    // Changes from instructions that started before now are final: a later
+    // write can only roll back past them to replay them unchanged
+    uint64 now = base + time;
+    size_t folded = 0;
+    while (folded < changes.size() && changes[folded].cycle < now) {
+        ports[changes[folded].port] = changes[folded].value;
+        folded++;
+    }
+    changes.erase(changes.begin(), changes.begin() + folded);
+    foldedTo = std::max(foldedTo, now);
+    return ports[port & 0x03];
+}
+
+void APUThread::writePort(int port, uint8 value) {
+    Write write = {time, static_cast<uint8>(port & 0x03), value};
+    while (!writes.push(write)) {
+        notify();
+        std::this_thread::yield();
+    }
+    writesSent++;
+    notify();
+}
+
+void APUThread::drainEvents() {
+    Event event;
+    while (events.pop(event)) {
+        if (event.port == ROLLBACK) {
+            while (!changes.empty() && changes.back().cycle >= event.cycle) {
+                changes.pop_back();
+            }
+        } else if (event.cycle >= foldedTo) {
+            changes.push_back(event);
+        }
+    }
+}
+
+void APUThread::notify() {
+    // Pairs with the fence in sleep(): either the thread sees the new
+    // state before waiting or this sees it asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake.notify_one();
+    }
+}
+
+void APUThread::threadMain() {
+    while (true) {
+        uint64 now = target.load(std::memory_order_acquire);
+        bool finishing = stopping.load(std::memory_order_acquire);
+        Write write;
+        while (writes.pop(write)) {
+            pending.push_back(write);
+        }
+        // A write before the point speculation got to
+        if (!pending.empty() && pending.front().time < given) {
+            rollback(pending.front().time);
+        }
+        finalize(now);
+
+        uint64 limit = now;
+        if (!finishing && given >= coolUntil) {
+            limit += AHEAD_CYCLES;
+        }
+        if (!pending.empty()) {
+            limit = std::min(limit, pending.front().time);
+        }
+        if (given < limit) {
+            run(std::min<uint64>(limit - given, STEP_CYCLES));
+        } else if (!pending.empty() && pending.front().time == given) {
+            applyWrite();
+        } else if (finishing) {
+            if (given > now) {
+                rollback(now);
+                continue;
+            }
+            break;
+        } else {
+            sleep(now);
+        }
+    }
+
+    // Everything run is final now
+    checkpoints.back()->frames = dsp->getSampleCount();
+    for (std::unique_ptr<Checkpoint>& checkpoint : checkpoints) {
+        pushAudio(*checkpoint);
+        spare.push_back(std::move(checkpoint));
+    }
+    checkpoints.clear();
+    dsp->setOutput(nullptr, 0);
+    apu->setPortLog(nullptr);
+    publish();
+    finished.store(true, std::memory_order_release);
+}
+
+void APUThread::run(uint64 cycles) {
+    apu->run(static_cast<int>(cycles));
+    given += cycles;
+    if (given - checkpoints.back()->time >= static_cast<uint64>(CHECKPOINT_CYCLES)) {
+        takeCheckpoint();
+    }
+    publish();
+}
+
+void APUThread::applyWrite() {
+    Write write = pending.front();
+    pending.erase(pending.begin());
+    apu->writePort(write.port, write.value);
+    applied.push_back(write);
+    publish();
+}
+
+void APUThread::rollback(uint64 to) {
+    // Newest checkpoint at or before to (the oldest is never after a write)
+    size_t index = checkpoints.size() - 1;
+    while (index > 0 && checkpoints[index]->time > to) {
+        index--;
+    }
+    for (size_t i = index + 1; i < checkpoints.size(); ++i) {
+        spare.push_back(std::move(checkpoints[i]));
+    }
+    checkpoints.resize(index + 1);
+    const Checkpoint& checkpoint = *checkpoints.back();
+    *apu = checkpoint.apu;
+    *dsp = checkpoint.dsp;
+    given = checkpoint.time;
+
+    // Writes applied since then go back ahead of the pending ones
+    size_t keep = static_cast<size_t>(checkpoint.applied - appliedBase);
+    pending.insert(pending.begin(), applied.begin() + keep, applied.end());
+    applied.resize(keep);
+
+    log.clear();
+    Event event = {apu->totalCycles, ROLLBACK, 0};
+    while (!events.push(event)) {
+        std::this_thread::yield();
+    }
+    rollbacks.fetch_add(1, std::memory_order_relaxed);
+    coolUntil = to + COOLDOWN_CYCLES;
+    publish();
+}
+
+void APUThread::takeCheckpoint() {
+    if (!checkpoints.empty()) {
+        checkpoints.back()->frames = dsp->getSampleCount();
+    }
+    std::unique_ptr<Checkpoint> checkpoint;
+    if (spare.empty()) {
+        checkpoint.reset(new Checkpoint());
+        checkpoint->audio.resize(AUDIO_FRAMES * 2);
+    } else {
+        checkpoint = std::move(spare.back());
+        spare.pop_back();
+    }
+    checkpoint->time = given;
+    checkpoint->applied = appliedBase + applied.size();
+    checkpoint->frames = 0;
+    // Samples from here on go to this interval's buffer, which a rollback
+    // to it starts over
+    dsp->setOutput(checkpoint->audio.data(), AUDIO_FRAMES);
+    checkpoint->apu = *apu;
+    checkpoint->dsp = *dsp;
+    checkpoints.push_back(std::move(checkpoint));
+}
+
+void APUThread::finalize(uint64 until) {
+    // The S-CPU is at until, so no write can come before it: intervals
+    // that end by then are final and the checkpoint after them is the
+    // oldest one a rollback can need
+    while (checkpoints.size() >= 2 && checkpoints[1]->time <= until) {
+        pushAudio(*checkpoints[0]);
+        size_t drop = static_cast<size_t>(checkpoints[1]->applied - appliedBase);
+        applied.erase(applied.begin(), applied.begin() + drop);
+        appliedBase += drop;
+        spare.push_back(std::move(checkpoints[0]));
+        checkpoints.erase(checkpoints.begin());
+    }
+}
+
+void APUThread::pushAudio(const Checkpoint& checkpoint) {
+    // Dropped if nobody is taking samples
+    audio.push(checkpoint.audio.data(), checkpoint.frames * 2);
+}
+
+void APUThread::publish() {
+    // Port changes first, so a reader that sees reached has them all
+    for (const SPC700::PortWrite& change : log) {
+        Event event = {change.cycle, change.port, change.value};
+        while (!events.push(event)) {
+            std::this_thread::yield();
+        }
+    }
+    log.clear();
+    reached.store(given, std::memory_order_release);
+    writesApplied.store(appliedBase + applied.size(), std::memory_order_release);
+    brrHits.store(dsp->getCacheHits(), std::memory_order_relaxed);
+    brrMisses.store(dsp->getCacheMisses(), std::memory_order_relaxed);
+}
+
+void APUThread::sleep(uint64 seen) {
+    std::unique_lock<std::mutex> lock(mutex);
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (target.load(std::memory_order_relaxed) == seen && writes.size() == 0 &&
+        !stopping.load(std::memory_order_relaxed)) {
+        wake.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    sleeping.store(false, std::memory_order_relaxed);
+}
@@ -0,0 +1,154 @@
+//
+//  APUThread.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef APUTHREAD_HPP
+#define APUTHREAD_HPP
+
+#include "../Types/Types.hpp"
+#include "../Types/SPSCRing.hpp"
+#include "SPC700.hpp"
+#include "DSP.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs the SPC700 and DSP on a thread of their own (optional; APUClock
+// routes the ports here while it runs)
+// The S-CPU side only hands over time and port writes, stamped in SPC700
+// cycles, through lock-free queues. The thread speculates up to
+// AHEAD_CYCLES past the S-CPU, assuming no more port writes; the port
+// values it produces come back stamped, so most port reads are answered
+// without waiting. A write stamped earlier than the thread has already
+// run rolls it back to a checkpoint and replays it. Afterwards it stops
+// speculating for a while, since port traffic tends to come in bursts.
+// Reads only wait when the thread is behind.
+// Because every write lands at its stamp and a run of the SPC700 does
+// not depend on how it is split, the results match APUClock's catch-up
+// exactly.
+class APUThread {
+public:
+    static const int AHEAD_CYCLES = 4096;       // SPC700 cycles of speculation
+    static const int CHECKPOINT_CYCLES = 2048;  // Between rollback points
+    static const int COOLDOWN_CYCLES = 32768;   // Without speculation after a rollback
+
+    APUThread();
+    ~APUThread();
+
+    APUThread(const APUThread&) = delete;
+    APUThread& operator=(const APUThread&) = delete;
+
+    void setAPU(SPC700* sound);
+    void setDSP(DSP* sound);
+
+    // Hand the SPC700 and DSP to the thread; nothing else may touch them
+    // until stop(), which brings them up to the S-CPU's time and returns them
+    void start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    // S-CPU side (one thread)
+    // The S-CPU moved on by cycles of SPC700 time
+    void advance(uint64 cycles);
+    // Port value as of now; waits only if the thread is behind
+    uint8 readPort(int port);
+    // Takes effect now (at the current time); never waits unless the queue is full
+    void writePort(int port, uint8 value);
+
+    // Finished stereo samples (left, right), in order. Samples the thread
+    // could still roll back are held back until they are final.
+    SPSCRing<int16>& getAudio() { return audio; }
+
+    // Statistics; safe to read from any thread
+    uint64 getRollbacks() const { return rollbacks.load(std::memory_order_relaxed); }
+    uint64 getStalls() const { return stalls.load(std::memory_order_relaxed); }
+    // The DSP's BRR cache counters, as of the thread's last progress report
+    uint64 getBRRCacheHits() const { return brrHits.load(std::memory_order_relaxed); }
+    uint64 getBRRCacheMisses() const { return brrMisses.load(std::memory_order_relaxed); }
+
+private:
+    SPC700* apu;
+    DSP* dsp;
+    std::thread thread;
+    bool running;
+
+    struct Write {
+        uint64 time;                    // SPC700 cycles since start()
+        uint8 port;
+        uint8 value;
+    };
+
+    // Output port changes and rollbacks, in the order the thread made them
+    struct Event {
+        uint64 cycle;                   // SPC700 totalCycles the change (or rollback point) is at
+        int16 port;                     // ROLLBACK: drop changes at or after cycle
+        uint8 value;
+    };
+    static const int16 ROLLBACK = -1;
+
+    static const int STEP_CYCLES = 256;         // Per run(), so new writes are seen soon
+    static const int AUDIO_FRAMES = 192;        // Per checkpoint interval
+
+    SPSCRing<Write> writes;
+    SPSCRing<Event> events;
+    SPSCRing<int16> audio;
+
+    // Shared progress
+    std::atomic<uint64> target;         // S-CPU time
+    std::atomic<uint64> writesApplied;
+    std::atomic<uint64> reached;        // Thread time; valid once writesApplied catches up
+    std::atomic<uint64> rollbacks;
+    std::atomic<uint64> stalls;
+    std::atomic<uint64> brrHits;
+    std::atomic<uint64> brrMisses;
+    std::atomic<bool> stopping;
+    std::atomic<bool> finished;
+    std::atomic<bool> sleeping;
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    // S-CPU side
+    uint64 time;
+    uint64 writesSent;
+    uint64 base;                        // SPC700 target cycle at start()
+    uint8 ports[4];                     // Values as of foldedTo
+    uint64 foldedTo;                    // SPC700 cycle
+    std::vector<Event> changes;         // After foldedTo, possibly speculative
+
+    // Thread side
+    struct Checkpoint {
+        uint64 time;
+        uint64 applied;                 // Writes applied before it was taken
+        SPC700 apu;
+        DSP dsp;
+        std::vector<int16> audio;       // Samples made until the next checkpoint
+        int frames;
+    };
+    std::vector<std::unique_ptr<Checkpoint>> checkpoints;  // Oldest first
+    std::vector<std::unique_ptr<Checkpoint>> spare;
+    std::vector<Write> pending;         // Received, not applied yet (in order)
+    std::vector<Write> applied;         // Since the oldest checkpoint, for replays
+    uint64 appliedBase;                 // Writes applied before applied[0]
+    std::vector<SPC700::PortWrite> log;
+    uint64 given;                       // SPC700 cycles run
+    uint64 coolUntil;
+
+    void threadMain();
+    void run(uint64 cycles);
+    void applyWrite();
+    void rollback(uint64 to);
+    void takeCheckpoint();
+    void finalize(uint64 until);
+    void pushAudio(const Checkpoint& checkpoint);
+    void publish();
+    void sleep(uint64 seen);
+    void notify();
+    void drainEvents();
+};
+#endif
@@ -0,0 +1,537 @@
+//
+//  DSP.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "DSP.hpp"
+#include "SPC700.hpp"
+#include "VoiceMixer.hpp"
+#include <cstring>
+
+namespace {
+    // Interpolation kernel: taps use entries 255-f, 511-f, 256+f and f for
+    // the 8-bit fraction f of the sample position
+    const int16 GAUSS[512] = {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,
+       2,   2,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,   5,
+       6,   6,   6,   6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  10,
+      11,  11,  11,  12,  12,  13,  13,  14,  14,  15,  15,  15,  16,  16,  17,  17,
+      18,  19,  19,  20,  20,  21,  21,  22,  23,  23,  24,  24,  25,  26,  27,  27,
+      28,  29,  29,  30,  31,  32,  32,  33,  34,  35,  36,  36,  37,  38,  39,  40,
+      41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,
+      58,  59,  60,  61,  62,  64,  65,  66,  67,  69,  70,  71,  73,  74,  76,  77,
+      78,  80,  81,  83,  84,  86,  87,  89,  90,  92,  94,  95,  97,  99, 100, 102,
+     104, 106, 107, 109, 111, 113, 115, 117, 118, 120, 122, 124, 126, 128, 130, 132,
+     134, 137, 139, 141, 143, 145, 147, 150, 152, 154, 156, 159, 161, 163, 166, 168,
+     171, 173, 175, 178, 180, 183, 186, 188, 191, 193, 196, 199, 201, 204, 207, 210,
+     212, 215, 218, 221, 224, 227, 230, 233, 236, 239, 242, 245, 248, 251, 254, 257,
+     260, 263, 267, 270, 273, 276, 280, 283, 286, 290, 293, 297, 300, 304, 307, 311,
+     314, 318, 321, 325, 328, 332, 336, 339, 343, 347, 351, 354, 358, 362, 366, 370,
+     374, 378, 381, 385, 389, 393, 397, 401, 405, 410, 414, 418, 422, 426, 430, 434,
+     439, 443, 447, 451, 456, 460, 464, 469, 473, 477, 482, 486, 491, 495, 499, 504,
+     508, 513, 517, 522, 527, 531, 536, 540, 545, 550, 554, 559, 563, 568, 573, 577,
+     582, 587, 592, 596, 601, 606, 611, 615, 620, 625, 630, 635, 640, 644, 649, 654,
+     659, 664, 669, 674, 678, 683, 688, 693, 698, 703, 708, 713, 718, 723, 728, 732,
+     737, 742, 747, 752, 757, 762, 767, 772, 777, 782, 787, 792, 797, 802, 806, 811,
+     816, 821, 826, 831, 836, 841, 846, 851, 855, 860, 865, 870, 875, 880, 884, 889,
+     894, 899, 904, 908, 913, 918, 923, 927, 932, 937, 941, 946, 951, 955, 960, 965,
+     969, 974, 978, 983, 988, 992, 997,1001,1005,1010,1014,1019,1023,1027,1032,1036,
+    1040,1045,1049,1053,1057,1061,1066,1070,1074,1078,1082,1086,1090,1094,1098,1102,
+    1106,1109,1113,1117,1121,1125,1128,1132,1136,1139,1143,1146,1150,1153,1157,1160,
+    1164,1167,1170,1174,1177,1180,1183,1186,1190,1193,1196,1199,1202,1205,1207,1210,
+    1213,1216,1219,1221,1224,1227,1229,1232,1234,1237,1239,1241,1244,1246,1248,1251,
+    1253,1255,1257,1259,1261,1263,1265,1267,1269,1270,1272,1274,1275,1277,1279,1280,
+    1282,1283,1284,1286,1287,1288,1290,1291,1292,1293,1294,1295,1296,1297,1297,1298,
+    1299,1300,1300,1301,1302,1302,1303,1303,1303,1304,1304,1304,1304,1304,1305,1305
+    };
+
+    // Envelope and noise rates: a rate fires on the samples where the
+    // shared counter (counting down through 30720) plus its offset is a
+    // multiple of its period. Rate 0 never fires.
+    const int COUNTER_RANGE = 2048 * 5 * 3;
+    const uint16 COUNTER_RATES[32] = {
+        COUNTER_RANGE + 1, 2048, 1536,
+        1280, 1024, 768,
+        640, 512, 384,
+        320, 256, 192,
+        160, 128, 96,
+        80, 64, 48,
+        40, 32, 24,
+        20, 16, 12,
+        10, 8, 6,
+        5, 4, 3,
+        2,
+        1
+    };
+    const uint16 COUNTER_OFFSETS[32] = {
+        1, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        536, 0, 1040,
+        0,
+        0
+    };
+
+    inline int clamp16(int value) {
+        return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+    }
+}
+
+DSP::DSP(): apu(nullptr), output(nullptr), outputCapacity(0), outputCount(0) {
+    reset();
+}
+
+void DSP::reset() {
+    std::memset(registers, 0, sizeof(registers));
+    registers[FLG] = 0xE0;              // Soft reset, muted, echo writes off
+    cycles = 0;
+    std::memset(voices, 0, sizeof(voices));
+    for (Voice& voice : voices) {
+        voice.mode = ENV_RELEASE;
+    }
+    keyOn = 0;
+    counter = 0;
+    noise = 0x4000;
+    std::memset(echoHistory, 0, sizeof(echoHistory));
+    echoOffset = 0;
+    echoLength = 0;
+    outputCount = 0;
+    for (CacheEntry& entry : brrCache) {
+        entry.valid = false;
+    }
+    cacheHits = 0;
+    cacheMisses = 0;
+}
+
+void DSP::setAPU(SPC700* sound) {
+    apu = sound;
+}
+
+void DSP::setOutput(int16* buffer, int frames) {
+    output = buffer;
+    outputCapacity = buffer ? frames : 0;
+    outputCount = 0;
+}
+
+void DSP::write(uint8 address, uint8 value) {
+    address &= 0x7F;
+    registers[address] = value;
+    if (address == KON) {
+        keyOn |= value;
+    } else if (address == ENDX) {
+        // Any write clears it
+        registers[ENDX] = 0;
+    }
+}
+
+bool DSP::counterFires(int rate) const {
+    return (static_cast<unsigned>(counter) + COUNTER_OFFSETS[rate]) % COUNTER_RATES[rate] == 0;
+}
+
+void DSP::renderChunk(int count) {
+    const int older = EchoFilter::TAPS - 1;
+    int16 history[2][older + CHUNK_SAMPLES];
+    int16 main[2][CHUNK_SAMPLES];
+    int16 echoIn[2][CHUNK_SAMPLES];
+    for (int ch = 0; ch < 2; ++ch) {
+        std::memcpy(history[ch], echoHistory[ch], sizeof(echoHistory[ch]));
+    }
+    int8 coefficients[EchoFilter::TAPS];
+    for (int n = 0; n < EchoFilter::TAPS; ++n) {
+        coefficients[n] = static_cast<int8>(registers[FIR + n * 0x10]);
+    }
+
+    // Echo buffer slot of every sample; EDL is latched at the start of the
+    // buffer, and 0 makes it a single slot
+    uint16 addresses[CHUNK_SAMPLES];
+    int restarts = 0;
+    for (int i = 0; i < count; ++i) {
+        addresses[i] = static_cast<uint16>((registers[ESA] << 8) + echoOffset);
+        if (echoOffset == 0) {
+            echoLength = (registers[EDL] & 0x0F) * 0x800;
+            restarts++;
+        }
+        echoOffset += 4;
+        if (echoOffset >= echoLength) {
+            echoOffset = 0;
+        }
+    }
+
+    // The FIR's result only goes to the output and the echo feedback;
+    // without either, the buffer is still read to keep the taps current
+    bool echoWrites = !(registers[FLG] & 0x20);
+    bool filtered = echoWrites || output;
+
+    // Unless the buffer is shorter than the chunk, no sample reads a slot
+    // an earlier one in the chunk wrote, so the reads and the FIR can all
+    // be done first
+    bool batched = restarts <= 1;
+    if (batched) {
+        for (int i = 0; i < count; ++i) {
+            readEcho(addresses[i], &history[0][older + i], &history[1][older + i]);
+        }
+        if (filtered) {
+            for (int ch = 0; ch < 2; ++ch) {
+                EchoFilter::filter(history[ch], coefficients, count, echoIn[ch]);
+            }
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        int16 sampleMain[2];
+        int16 sampleEcho[2];
+        renderVoices(sampleMain, sampleEcho);
+        if (!batched) {
+            readEcho(addresses[i], &history[0][older + i], &history[1][older + i]);
+            for (int ch = 0; filtered && ch < 2; ++ch) {
+                EchoFilter::filter(history[ch] + i, coefficients, 1, &echoIn[ch][i]);
+            }
+        }
+        for (int ch = 0; ch < 2; ++ch) {
+            main[ch][i] = sampleMain[ch];
+        }
+
+        // Feedback into the buffer, before the next sample's voices read RAM
+        if (echoWrites) {
+            for (int ch = 0; ch < 2; ++ch) {
+                int feedback = sampleEcho[ch] + static_cast<int16>((echoIn[ch][i] * static_cast<int8>(registers[EFB])) >> 7);
+                feedback = clamp16(feedback) & ~1;
+                uint16 address = static_cast<uint16>(addresses[i] + ch * 2);
+                apu->writeRAM(address, feedback & 0xFF);
+                apu->writeRAM(static_cast<uint16>(address + 1), (feedback >> 8) & 0xFF);
+            }
+        }
+    }
+    for (int ch = 0; ch < 2; ++ch) {
+        std::memcpy(echoHistory[ch], &history[ch][count], sizeof(echoHistory[ch]));
+    }
+
+    if (!output) {
+        return;
+    }
+    int16 out[2][CHUNK_SAMPLES];
+    EchoFilter::mix(main[0], echoIn[0], static_cast<int8>(registers[MVOLL]), static_cast<int8>(registers[EVOLL]), count, out[0]);
+    EchoFilter::mix(main[1], echoIn[1], static_cast<int8>(registers[MVOLR]), static_cast<int8>(registers[EVOLR]), count, out[1]);
+    bool muted = registers[FLG] & 0x40;
+    for (int i = 0; i < count && outputCount < outputCapacity; ++i) {
+        output[outputCount * 2] = muted ? 0 : out[0][i];
+        output[outputCount * 2 + 1] = muted ? 0 : out[1][i];
+        outputCount++;
+    }
+}
+
+void DSP::readEcho(uint16 address, int16* left, int16* right) const {
+    const uint8* ram = apu->getRAM();
+    int16 sample[2];
+    for (int ch = 0; ch < 2; ++ch) {
+        uint16 sampleAddress = static_cast<uint16>(address + ch * 2);
+        sample[ch] = static_cast<int16>(ram[sampleAddress] | (ram[static_cast<uint16>(sampleAddress + 1)] << 8));
+    }
+    *left = static_cast<int16>(sample[0] >> 1);
+    *right = static_cast<int16>(sample[1] >> 1);
+}
+
+void DSP::renderVoices(int16* main, int16* echo) {
+    if (--counter < 0) {
+        counter = COUNTER_RANGE - 1;
+    }
+
+    uint8 flags = registers[FLG];
+    if (counterFires(flags & 0x1F)) {
+        int feedback = (noise << 13) ^ (noise << 14);
+        noise = (feedback & 0x4000) ^ (noise >> 1);
+    }
+
+    // Key on, then key off (which wins) and soft reset
+    if (keyOn) {
+        for (int v = 0; v < VOICES; ++v) {
+            if (keyOn & (1 << v)) {
+                keyOnVoice(v);
+            }
+        }
+        keyOn = 0;
+    }
+    uint8 keyOff = registers[KOFF];
+    if (keyOff || (flags & 0x80)) {
+        for (int v = 0; v < VOICES; ++v) {
+            if ((keyOff & (1 << v)) || (flags & 0x80)) {
+                voices[v].mode = ENV_RELEASE;
+                if (flags & 0x80) {
+                    voices[v].envelope = 0;
+                }
+            }
+        }
+    }
+
+    // A voice with no envelope puts out nothing, so with none sounding
+    // there is nothing to interpolate
+    int16 out[VOICES];
+    int16 left[VOICES];
+    int16 right[VOICES];
+    bool sounding = false;
+    for (int v = 0; v < VOICES; ++v) {
+        sounding = sounding || voices[v].envelope != 0;
+    }
+    if (sounding) {
+        voiceOutputs(out, left, right);
+    } else {
+        std::memset(out, 0, sizeof(out));
+        std::memset(left, 0, sizeof(left));
+        std::memset(right, 0, sizeof(right));
+    }
+
+    // Mixing clamps after every voice, so it stays in voice order
+    int mainLeft = 0;
+    int mainRight = 0;
+    int echoLeft = 0;
+    int echoRight = 0;
+    uint8 echoOn = registers[EON];
+    uint8 pitchMod = registers[PMON];
+    for (int v = 0; v < VOICES; ++v) {
+        mainLeft = clamp16(mainLeft + left[v]);
+        mainRight = clamp16(mainRight + right[v]);
+        if (echoOn & (1 << v)) {
+            echoLeft = clamp16(echoLeft + left[v]);
+            echoRight = clamp16(echoRight + right[v]);
+        }
+        registers[(v << 4) | OUTX] = static_cast<uint8>(out[v] >> 8);
+
+        // Pitch modulation takes the previous voice's output of this sample
+        int pitch = ((voiceRegister(v, PITCHH) & 0x3F) << 8) | voiceRegister(v, PITCHL);
+        if (v > 0 && (pitchMod & (1 << v))) {
+            pitch += ((out[v - 1] >> 5) * pitch) >> 10;
+        }
+        advanceVoice(v, pitch);
+        runEnvelope(v);
+        registers[(v << 4) | ENVX] = static_cast<uint8>(voices[v].envelope >> 4);
+    }
+
+    main[0] = static_cast<int16>(mainLeft);
+    main[1] = static_cast<int16>(mainRight);
+    echo[0] = static_cast<int16>(echoLeft);
+    echo[1] = static_cast<int16>(echoRight);
+}
+
+void DSP::voiceOutputs(int16* out, int16* left, int16* right) {
+    // Gather every voice's taps and parameters side by side
+    int16 taps[4][VOICES];
+    int16 coeffs[4][VOICES];
+    int16 envelope[VOICES];
+    int16 volumeLeft[VOICES];
+    int16 volumeRight[VOICES];
+    for (int v = 0; v < VOICES; ++v) {
+        const Voice& voice = voices[v];
+        const int16* in = &voice.buffer[voice.position >> 12];
+        int fraction = (voice.position >> 4) & 0xFF;
+        taps[0][v] = in[0];
+        taps[1][v] = in[1];
+        taps[2][v] = in[2];
+        taps[3][v] = in[3];
+        coeffs[0][v] = GAUSS[255 - fraction];
+        coeffs[1][v] = GAUSS[511 - fraction];
+        coeffs[2][v] = GAUSS[256 + fraction];
+        coeffs[3][v] = GAUSS[fraction];
+        envelope[v] = static_cast<int16>(voice.envelope);
+        volumeLeft[v] = static_cast<int8>(voiceRegister(v, VOLL));
+        volumeRight[v] = static_cast<int8>(voiceRegister(v, VOLR));
+    }
+
+    int16 samples[VOICES];
+    VoiceMixer::interpolate(taps, coeffs, samples);
+    uint8 noiseOn = registers[NON];
+    if (noiseOn) {
+        int16 noiseSample = static_cast<int16>(noise * 2);
+        for (int v = 0; v < VOICES; ++v) {
+            if (noiseOn & (1 << v)) {
+                samples[v] = noiseSample;
+            }
+        }
+    }
+
+    VoiceMixer::applyVolume(samples, envelope, volumeLeft, volumeRight, out, left, right);
+}
+
+void DSP::keyOnVoice(int v) {
+    Voice& voice = voices[v];
+    const uint8* ram = apu->getRAM();
+    uint16 entry = (registers[DIR] << 8) + (voiceRegister(v, SRCN) << 2);
+    voice.blockAddress = ram[entry] | (ram[static_cast<uint16>(entry + 1)] << 8);
+    voice.position = 0;
+    std::memset(voice.buffer, 0, sizeof(voice.buffer));
+    voice.mode = ENV_ATTACK;
+    voice.envelope = 0;
+    voice.hiddenEnvelope = 0;
+    registers[ENDX] &= ~(1 << v);
+    decodeBlock(voice);
+}
+
+void DSP::advanceVoice(int v, int pitch) {
+    Voice& voice = voices[v];
+    voice.position += pitch > 0x7FFF ? 0x7FFF : pitch;
+    if (voice.position < (16 << 12)) {
+        return;
+    }
+    voice.position -= 16 << 12;
+    if (voice.header & 0x01) {
+        // End block: continue at the loop point, silenced unless it loops
+        registers[ENDX] |= 1 << v;
+        const uint8* ram = apu->getRAM();
+        uint16 entry = (registers[DIR] << 8) + (voiceRegister(v, SRCN) << 2) + 2;
+        voice.blockAddress = ram[entry] | (ram[static_cast<uint16>(entry + 1)] << 8);
+        if (!(voice.header & 0x02)) {
+            voice.mode = ENV_RELEASE;
+            voice.envelope = 0;
+        }
+    } else {
+        voice.blockAddress += 9;
+    }
+    decodeBlock(voice);
+}
+
+void DSP::decodeBlock(Voice& voice) {
+    // Keep the previous block's last samples for interpolation and prediction
+    voice.buffer[0] = voice.buffer[16];
+    voice.buffer[1] = voice.buffer[17];
+    voice.buffer[2] = voice.buffer[18];
+    int16 p1 = voice.buffer[2];
+    int16 p2 = voice.buffer[1];
+
+    uint16 address = voice.blockAddress;
+    const uint8* ram = apu->getRAM();
+    uint8 block[9];
+    if (address <= 0x10000 - 9) {
+        std::memcpy(block, ram + address, 9);
+    } else {
+        for (int i = 0; i < 9; ++i) {
+            block[i] = ram[static_cast<uint16>(address + i)];
+        }
+    }
+    voice.header = block[0];
+
+    const uint32* writes = apu->getRAMWrites();
+    uint32 stamp = writes[address >> SPC700::RAM_CHUNK_SHIFT] +
+                   writes[static_cast<uint16>(address + 8) >> SPC700::RAM_CHUNK_SHIFT];
+    bool predicted = (block[0] & 0x0C) != 0;
+    CacheEntry& entry = brrCache[address & (BRR_CACHE_SIZE - 1)];
+    if (entry.valid && entry.address == address && entry.writes == stamp &&
+        (!predicted || (entry.previous[0] == p1 && entry.previous[1] == p2))) {
+        cacheHits++;
+    } else {
+        decodeBRR(block, p1, p2, entry.samples);
+        entry.valid = true;
+        entry.address = address;
+        entry.writes = stamp;
+        entry.previous[0] = p1;
+        entry.previous[1] = p2;
+        cacheMisses++;
+    }
+    std::memcpy(&voice.buffer[3], entry.samples, sizeof(entry.samples));
+}
+
+// 9-byte BRR block: header (range, filter, loop, end), then 16 4-bit samples.
+// Samples are kept doubled, as the hardware does; p1/p2 are the two before.
+void DSP::decodeBRR(const uint8* block, int16 p1, int16 p2, int16* out) {
+    int shift = block[0] >> 4;
+    int filter = block[0] & 0x0C;
+    for (int i = 0; i < 16; ++i) {
+        uint8 byte = block[1 + (i >> 1)];
+        int s = ((i & 1) ? (byte & 0x0F) : (byte >> 4)) ^ 0x08;
+        s -= 0x08;
+        s = (s << shift) >> 1;
+        if (shift >= 0x0D) {
+            s = s < 0 ? -2048 : 0;
+        }
+        int previous = p1;
+        int older = p2 >> 1;
+        if (filter >= 8) {
+            s += previous - older;
+            if (filter == 8) {
+                s += older >> 4;
+                s += (previous * -3) >> 6;
+            } else {
+                s += (previous * -13) >> 7;
+                s += (older * 3) >> 4;
+            }
+        } else if (filter) {
+            s += previous >> 1;
+            s += (-previous) >> 5;
+        }
+        s = static_cast<int16>(clamp16(s) * 2);
+        out[i] = static_cast<int16>(s);
+        p2 = p1;
+        p1 = static_cast<int16>(s);
+    }
+}
+
+void DSP::runEnvelope(int v) {
+    Voice& voice = voices[v];
+    int env = voice.envelope;
+    if (voice.mode == ENV_RELEASE) {
+        env -= 0x08;
+        voice.envelope = env < 0 ? 0 : env;
+        return;
+    }
+
+    int rate;
+    uint8 adsr1 = voiceRegister(v, ADSR1);
+    int data = voiceRegister(v, ADSR2);
+    if (adsr1 & 0x80) {
+        if (voice.mode >= ENV_DECAY) {
+            // Exponential decrease
+            env--;
+            env -= env >> 8;
+            rate = data & 0x1F;
+            if (voice.mode == ENV_DECAY) {
+                rate = ((adsr1 >> 3) & 0x0E) + 0x10;
+            }
+        } else {
+            rate = (adsr1 & 0x0F) * 2 + 1;
+            env += rate < 31 ? 0x20 : 0x400;
+        }
+    } else {
+        data = voiceRegister(v, GAIN);
+        int mode = data >> 5;
+        if (mode < 4) {
+            // Direct
+            env = data * 0x10;
+            rate = 31;
+        } else {
+            rate = data & 0x1F;
+            if (mode == 4) {
+                env -= 0x20;                        // Linear decrease
+            } else if (mode < 6) {
+                env--;                              // Exponential decrease
+                env -= env >> 8;
+            } else {
+                env += 0x20;                        // Linear/bent increase
+                if (mode > 6 && static_cast<unsigned>(voice.hiddenEnvelope) >= 0x600) {
+                    env += 0x08 - 0x20;
+                }
+            }
+        }
+    }
+
+    // Sustain level
+    if ((env >> 8) == (data >> 5) && voice.mode == ENV_DECAY) {
+        voice.mode = ENV_SUSTAIN;
+    }
+    voice.hiddenEnvelope = env;
+    if (static_cast<unsigned>(env) > 0x7FF) {
+        env = env < 0 ? 0 : 0x7FF;
+        if (voice.mode == ENV_ATTACK) {
+            voice.mode = ENV_DECAY;
+        }
+    }
+    if (counterFires(rate)) {
+        voice.envelope = env;
+    }
+}
@@ -0,0 +1,149 @@
+//
+//  DSP.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef DSP_HPP
+#define DSP_HPP
+
+#include "../Types/Types.hpp"
+#include "EchoFilter.hpp"
+
+class SPC700;
+
+// S-DSP: 8 BRR sample voices with ADSR/GAIN envelopes, pitch modulation,
+// noise and echo, mixed to 32 kHz stereo
+// The DSP makes one stereo sample every 32 SPC700 cycles and is run up
+// to the SPC700's clock whenever its registers are accessed, and a chunk
+// at a time as the SPC700 passes chunk boundaries.
+// Samples are made in chunks of up to 32: voices sample by sample, the
+// echo FIR and output volume for the whole chunk at once.
+// Decoded BRR blocks are cached by ARAM address; an entry is dropped once
+// the SPC700 (or the echo buffer) writes to the RAM it came from.
+class DSP {
+public:
+    static const int VOICES = 8;
+    static const int SAMPLE_RATE = 32000;
+    static const int CYCLES_PER_SAMPLE = 32;    // SPC700 cycles
+    static const int CHUNK_SAMPLES = 32;
+
+    // Global registers
+    enum Register: uint8 {
+        MVOLL = 0x0C, MVOLR = 0x1C,
+        EVOLL = 0x2C, EVOLR = 0x3C,
+        KON   = 0x4C, KOFF  = 0x5C,
+        FLG   = 0x6C, ENDX  = 0x7C,
+        EFB   = 0x0D, PMON  = 0x2D,
+        NON   = 0x3D, EON   = 0x4D,
+        DIR   = 0x5D, ESA   = 0x6D,
+        EDL   = 0x7D, FIR   = 0x0F     // FIR coefficient n at $nF
+    };
+
+    // Voice n registers are at $n0-$n9
+    enum VoiceRegister: uint8 {
+        VOLL   = 0x00, VOLR   = 0x01,
+        PITCHL = 0x02, PITCHH = 0x03,
+        SRCN   = 0x04,
+        ADSR1  = 0x05, ADSR2  = 0x06,
+        GAIN   = 0x07,
+        ENVX   = 0x08, OUTX   = 0x09
+    };
+
+    DSP();
+
+    void reset();
+
+    // Sample and echo memory (the SPC700's ARAM)
+    void setAPU(SPC700* sound);
+
+    // $F2/$F3 access (address $00-$7F)
+    uint8 read(uint8 address) const { return registers[address & 0x7F]; }
+    void write(uint8 address, uint8 value);
+
+    // Make samples up to SPC700 cycle
+    void runUntil(uint64 cycle) {
+        while (cycles + CYCLES_PER_SAMPLE <= cycle) {
+            uint64 samples = (cycle - cycles) / CYCLES_PER_SAMPLE;
+            int count = samples < CHUNK_SAMPLES ? static_cast<int>(samples) : CHUNK_SAMPLES;
+            renderChunk(count);
+            cycles += count * CYCLES_PER_SAMPLE;
+        }
+    }
+
+    // Stereo samples (left, right) go to buffer until it holds frames;
+    // later ones are dropped. Pass nullptr to discard output: the final
+    // mix is skipped, everything that reaches ARAM or the registers is not.
+    void setOutput(int16* buffer, int frames);
+    int getSampleCount() const { return outputCount; }
+
+    // BRR block decodes served from the cache / decoded from ARAM
+    uint64 getCacheHits() const { return cacheHits; }
+    uint64 getCacheMisses() const { return cacheMisses; }
+    void resetCacheStats() { cacheHits = 0; cacheMisses = 0; }
+
+private:
+    SPC700* apu;
+    uint8 registers[128];
+    uint64 cycles;                      // SPC700 cycle the next sample is made at
+
+    enum EnvelopeMode {
+        ENV_RELEASE,
+        ENV_ATTACK,
+        ENV_DECAY,
+        ENV_SUSTAIN
+    };
+
+    struct Voice {
+        // Last 3 samples of the previous block, then the 16 of the current one
+        int16 buffer[3 + 16];
+        uint32 position;                // Into the current block, 4.12 fixed point
+        uint16 blockAddress;
+        uint8 header;                   // Current block's BRR header
+        EnvelopeMode mode;
+        int envelope;                   // 11 bits
+        int hiddenEnvelope;             // Before the rate counter gates it
+    };
+    Voice voices[VOICES];
+
+    uint8 keyOn;                        // KON bits not acted on yet
+    int counter;                        // Envelope/noise rate counter
+    int noise;                          // 15-bit LFSR
+
+    // Last 7 echo samples per channel, oldest first (the FIR's older taps)
+    int16 echoHistory[2][EchoFilter::TAPS - 1];
+    int echoOffset;                     // Bytes into the echo buffer
+    int echoLength;
+
+    int16* output;
+    int outputCapacity;                 // Frames
+    int outputCount;
+
+    // BRR cache: direct mapped on the block address. Blocks using a
+    // prediction filter also depend on the two samples before them.
+    static const int BRR_CACHE_SIZE = 1024;
+    struct CacheEntry {
+        bool valid;
+        uint16 address;
+        uint32 writes;                  // RAM write stamps the block was decoded at
+        int16 previous[2];
+        int16 samples[16];
+    };
+    CacheEntry brrCache[BRR_CACHE_SIZE];
+    uint64 cacheHits;
+    uint64 cacheMisses;
+
+    void renderChunk(int count);
+    void renderVoices(int16* main, int16* echo);
+    void voiceOutputs(int16* out, int16* left, int16* right);
+    void keyOnVoice(int v);
+    void decodeBlock(Voice& voice);
+    void decodeBRR(const uint8* block, int16 p1, int16 p2, int16* out);
+    void advanceVoice(int v, int pitch);
+    void runEnvelope(int v);
+    bool counterFires(int rate) const;
+    void readEcho(uint16 address, int16* left, int16* right) const;
+    uint8 voiceRegister(int v, int index) const { return registers[(v << 4) | index]; }
+};
+#endif
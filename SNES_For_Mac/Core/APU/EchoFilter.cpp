@@ -0,0 +1,195 @@
+//
+//  EchoFilter.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "EchoFilter.hpp"
+#include "../PPU/TileDecoder.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ECHOFILTER_X86 1
+#endif
+
+namespace {
+    inline int clamp16(int value) {
+        return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+    }
+}
+
+void EchoFilter::filter(const int16* history, const int8* coefficients, int count, int16* out) {
+#ifdef ECHOFILTER_X86
+    TileDecoder::Level level = TileDecoder::getLevel();
+    if (level >= TileDecoder::LEVEL_AVX2) {
+        filterAVX2(history, coefficients, count, out);
+        return;
+    }
+    if (level >= TileDecoder::LEVEL_SSE2) {
+        filterSSE2(history, coefficients, count, out);
+        return;
+    }
+#endif
+    filterScalar(history, coefficients, count, out);
+}
+
+void EchoFilter::mix(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out) {
+#ifdef ECHOFILTER_X86
+    TileDecoder::Level level = TileDecoder::getLevel();
+    if (level >= TileDecoder::LEVEL_AVX2) {
+        mixAVX2(main, echo, mainVolume, echoVolume, count, out);
+        return;
+    }
+    if (level >= TileDecoder::LEVEL_SSE2) {
+        mixSSE2(main, echo, mainVolume, echoVolume, count, out);
+        return;
+    }
+#endif
+    mixScalar(main, echo, mainVolume, echoVolume, count, out);
+}
+
+void EchoFilter::filterScalar(const int16* history, const int8* coefficients, int count, int16* out) {
+    for (int i = 0; i < count; ++i) {
+        const int16* in = history + i;
+        int sum = 0;
+        for (int n = 0; n < TAPS - 1; ++n) {
+            sum += (in[n] * coefficients[n]) >> 6;
+        }
+        sum = static_cast<int16>(sum);
+        sum += static_cast<int16>((in[TAPS - 1] * coefficients[TAPS - 1]) >> 6);
+        out[i] = static_cast<int16>(clamp16(sum) & ~1);
+    }
+}
+
+void EchoFilter::mixScalar(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out) {
+    for (int i = 0; i < count; ++i) {
+        out[i] = static_cast<int16>(clamp16(static_cast<int16>((main[i] * mainVolume) >> 7) +
+                                            static_cast<int16>((echo[i] * echoVolume) >> 7)));
+    }
+}
+
+#ifdef ECHOFILTER_X86
+
+namespace {
+    // 32-bit products of 8 signed 16-bit lanes, arithmetic-shifted right
+    __attribute__((target("sse2")))
+    inline void multiplyShiftSSE2(__m128i a, __m128i b, int shift, __m128i& low, __m128i& high) {
+        __m128i productLow = _mm_mullo_epi16(a, b);
+        __m128i productHigh = _mm_mulhi_epi16(a, b);
+        low = _mm_sra_epi32(_mm_unpacklo_epi16(productLow, productHigh), _mm_cvtsi32_si128(shift));
+        high = _mm_sra_epi32(_mm_unpackhi_epi16(productLow, productHigh), _mm_cvtsi32_si128(shift));
+    }
+
+    // Sign-extend the low 16 bits of each 32-bit lane
+    __attribute__((target("sse2")))
+    inline __m128i wrap16SSE2(__m128i value) {
+        return _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+    }
+
+    // Same per 128-bit half; unpack and pack both stay inside halves,
+    // so lane order survives the round trip
+    __attribute__((target("avx2")))
+    inline void multiplyShiftAVX2(__m256i a, __m256i b, int shift, __m256i& low, __m256i& high) {
+        __m256i productLow = _mm256_mullo_epi16(a, b);
+        __m256i productHigh = _mm256_mulhi_epi16(a, b);
+        low = _mm256_sra_epi32(_mm256_unpacklo_epi16(productLow, productHigh), _mm_cvtsi32_si128(shift));
+        high = _mm256_sra_epi32(_mm256_unpackhi_epi16(productLow, productHigh), _mm_cvtsi32_si128(shift));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i wrap16AVX2(__m256i value) {
+        return _mm256_srai_epi32(_mm256_slli_epi32(value, 16), 16);
+    }
+}
+
+__attribute__((target("sse2")))
+void EchoFilter::filterSSE2(const int16* history, const int8* coefficients, int count, int16* out) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i sumLow = _mm_setzero_si128();
+        __m128i sumHigh = _mm_setzero_si128();
+        for (int n = 0; n < TAPS - 1; ++n) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(history + i + n));
+            __m128i low, high;
+            multiplyShiftSSE2(in, _mm_set1_epi16(coefficients[n]), 6, low, high);
+            sumLow = _mm_add_epi32(sumLow, low);
+            sumHigh = _mm_add_epi32(sumHigh, high);
+        }
+        // The last tap (-16384 * -128 >> 6 = 32768) wraps on its own too
+        __m128i low, high;
+        multiplyShiftSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(history + i + TAPS - 1)), _mm_set1_epi16(coefficients[TAPS - 1]), 6, low, high);
+        sumLow = _mm_add_epi32(wrap16SSE2(sumLow), wrap16SSE2(low));
+        sumHigh = _mm_add_epi32(wrap16SSE2(sumHigh), wrap16SSE2(high));
+        // packs clamps to 16 bits
+        __m128i result = _mm_and_si128(_mm_packs_epi32(sumLow, sumHigh), _mm_set1_epi16(static_cast<short>(0xFFFE)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+    if (i < count) {
+        filterScalar(history + i, coefficients, count - i, out + i);
+    }
+}
+
+__attribute__((target("sse2")))
+void EchoFilter::mixSSE2(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out) {
+    const __m128i mainFactor = _mm_set1_epi16(mainVolume);
+    const __m128i echoFactor = _mm_set1_epi16(echoVolume);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i mainLow, mainHigh, echoLow, echoHigh;
+        multiplyShiftSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(main + i)), mainFactor, 7, mainLow, mainHigh);
+        multiplyShiftSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(echo + i)), echoFactor, 7, echoLow, echoHigh);
+        // -32768 * -128 >> 7 wraps, so each term is wrapped before the clamped sum
+        __m128i low = _mm_add_epi32(wrap16SSE2(mainLow), wrap16SSE2(echoLow));
+        __m128i high = _mm_add_epi32(wrap16SSE2(mainHigh), wrap16SSE2(echoHigh));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(low, high));
+    }
+    if (i < count) {
+        mixScalar(main + i, echo + i, mainVolume, echoVolume, count - i, out + i);
+    }
+}
+
+__attribute__((target("avx2")))
+void EchoFilter::filterAVX2(const int16* history, const int8* coefficients, int count, int16* out) {
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i sumLow = _mm256_setzero_si256();
+        __m256i sumHigh = _mm256_setzero_si256();
+        for (int n = 0; n < TAPS - 1; ++n) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(history + i + n));
+            __m256i low, high;
+            multiplyShiftAVX2(in, _mm256_set1_epi16(coefficients[n]), 6, low, high);
+            sumLow = _mm256_add_epi32(sumLow, low);
+            sumHigh = _mm256_add_epi32(sumHigh, high);
+        }
+        __m256i low, high;
+        multiplyShiftAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(history + i + TAPS - 1)), _mm256_set1_epi16(coefficients[TAPS - 1]), 6, low, high);
+        sumLow = _mm256_add_epi32(wrap16AVX2(sumLow), wrap16AVX2(low));
+        sumHigh = _mm256_add_epi32(wrap16AVX2(sumHigh), wrap16AVX2(high));
+        __m256i result = _mm256_and_si256(_mm256_packs_epi32(sumLow, sumHigh), _mm256_set1_epi16(static_cast<short>(0xFFFE)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+    }
+    if (i < count) {
+        filterSSE2(history + i, coefficients, count - i, out + i);
+    }
+}
+
+__attribute__((target("avx2")))
+void EchoFilter::mixAVX2(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out) {
+    const __m256i mainFactor = _mm256_set1_epi16(mainVolume);
+    const __m256i echoFactor = _mm256_set1_epi16(echoVolume);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i mainLow, mainHigh, echoLow, echoHigh;
+        multiplyShiftAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(main + i)), mainFactor, 7, mainLow, mainHigh);
+        multiplyShiftAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(echo + i)), echoFactor, 7, echoLow, echoHigh);
+        __m256i low = _mm256_add_epi32(wrap16AVX2(mainLow), wrap16AVX2(echoLow));
+        __m256i high = _mm256_add_epi32(wrap16AVX2(mainHigh), wrap16AVX2(echoHigh));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_packs_epi32(low, high));
+    }
+    if (i < count) {
+        mixSSE2(main + i, echo + i, mainVolume, echoVolume, count - i, out + i);
+    }
+}
+
+#endif
@@ -0,0 +1,41 @@
+//
+//  EchoFilter.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef ECHOFILTER_HPP
+#define ECHOFILTER_HPP
+
+#include "../Types/Types.hpp"
+
+// Echo kernels over a run of samples of one channel
+// The DSP hands over up to a chunk of samples at a time, so each step is
+// vectorized across samples (8 per SSE2 register, 16 per AVX2 register).
+// Results match the hardware's truncation, wrapping and clamping exactly.
+// The kernel level follows TileDecoder::getLevel().
+class EchoFilter {
+public:
+    static const int TAPS = 8;
+
+    // 8-tap FIR: out[i] filters history[i] .. history[i + 7] (oldest first)
+    // with coefficients[0] .. coefficients[7]. Each product is shifted right
+    // by 6; the sum wraps to 16 bits before the last tap and is clamped
+    // after it, bit 0 cleared. history holds count + 7 samples.
+    static void filter(const int16* history, const int8* coefficients, int count, int16* out);
+
+    // Main and echo volume:
+    // out[i] = clamp16(wrap16((main[i] * mainVolume) >> 7) + wrap16((echo[i] * echoVolume) >> 7))
+    static void mix(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out);
+
+    static void filterScalar(const int16* history, const int8* coefficients, int count, int16* out);
+    static void mixScalar(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out);
+#if defined(__x86_64__) || defined(__i386__)
+    static void filterSSE2(const int16* history, const int8* coefficients, int count, int16* out);
+    static void mixSSE2(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out);
+    static void filterAVX2(const int16* history, const int8* coefficients, int count, int16* out);
+    static void mixAVX2(const int16* main, const int16* echo, int8 mainVolume, int8 echoVolume, int count, int16* out);
+#endif
+};
+#endif
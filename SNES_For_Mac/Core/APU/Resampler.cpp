@@ -0,0 +1,197 @@
+//
+//  Resampler.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "Resampler.hpp"
+#include "../PPU/TileDecoder.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RESAMPLER_X86 1
+#endif
+
+namespace {
+    const double PI = 3.14159265358979323846;
+    const double KAISER_BETA = 7.0;         // About 70 dB stopband for the window
+    const double PASSBAND = 0.9;            // Of the lower Nyquist rate
+
+    // Modified Bessel function of the first kind, order 0 (for the Kaiser window)
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+}
+
+Resampler::Resampler(int capacity): ring(static_cast<size_t>(capacity) * 2), inputRate(32000.0), outputRate(48000.0),
+                                    adjust(1.0), position(0), step(0), overruns(0), clearMark(0), underruns(0) {
+    setRates(inputRate, outputRate);
+}
+
+void Resampler::setRates(double input, double output) {
+    inputRate = input;
+    outputRate = output;
+    buildFilters();
+    updateStep();
+    // The first output frame is centred on the first input sample
+    left.assign(TAPS / 2 - 1, 0.0f);
+    right.assign(TAPS / 2 - 1, 0.0f);
+    position = 0;
+}
+
+void Resampler::setAdjust(double factor) {
+    double limit = MAX_ADJUST_PERCENT / 100.0;
+    adjust = factor < 1.0 - limit ? 1.0 - limit : (factor > 1.0 + limit ? 1.0 + limit : factor);
+    updateStep();
+}
+
+void Resampler::updateStep() {
+    step = static_cast<uint64>(inputRate / (outputRate * adjust) * 4294967296.0);
+}
+
+void Resampler::buildFilters() {
+    // Cutoff in cycles per input sample
+    double cutoff = 0.5 * PASSBAND * (outputRate < inputRate ? outputRate / inputRate : 1.0);
+    double half = TAPS / 2.0;
+    double window = besselI0(KAISER_BETA);
+    filters.resize((PHASES + 1) * TAPS);
+    for (int p = 0; p <= PHASES; ++p) {
+        double fraction = static_cast<double>(p) / PHASES;
+        double taps[TAPS];
+        double sum = 0.0;
+        for (int k = 0; k < TAPS; ++k) {
+            // Distance from the output sample's position, in input samples
+            double d = k - (TAPS / 2 - 1) - fraction;
+            double x = 2.0 * cutoff * d;
+            double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+            double r = d / half;
+            double w = r * r < 1.0 ? besselI0(KAISER_BETA * std::sqrt(1.0 - r * r)) / window : 0.0;
+            taps[k] = sinc * w;
+            sum += taps[k];
+        }
+        // Unity gain at DC for every phase
+        for (int k = 0; k < TAPS; ++k) {
+            filters[p * TAPS + k] = static_cast<float>(taps[k] / sum);
+        }
+    }
+}
+
+int Resampler::write(const int16* samples, int count) {
+    for (int i = 0; i < count; ++i) {
+        left.push_back(samples[i * 2] * (1.0f / 32768.0f));
+        right.push_back(samples[i * 2 + 1] * (1.0f / 32768.0f));
+    }
+
+    frames.clear();
+    float frame[2];
+    while ((position >> 32) + TAPS <= left.size()) {
+        size_t index = static_cast<size_t>(position >> 32);
+        uint32 fraction = static_cast<uint32>(position);
+        int phase = fraction >> 24;
+        float t = (fraction & 0xFFFFFF) * (1.0f / 16777216.0f);
+        convolve(&left[index], &right[index], &filters[phase * TAPS], &filters[(phase + 1) * TAPS], t, frame);
+        frames.push_back(frame[0]);
+        frames.push_back(frame[1]);
+        position += step;
+    }
+
+    // Keep what the next frames still tap
+    size_t used = std::min(static_cast<size_t>(position >> 32), left.size());
+    left.erase(left.begin(), left.begin() + used);
+    right.erase(right.begin(), right.begin() + used);
+    position -= static_cast<uint64>(used) << 32;
+
+    size_t pushed = ring.push(frames.data(), frames.size());
+    overruns += (frames.size() - pushed) / 2;
+    return static_cast<int>(frames.size() / 2);
+}
+
+void Resampler::clear() {
+    // Only the consumer may move the ring's read side
+    clearMark.store(ring.mark(), std::memory_order_release);
+}
+
+int Resampler::read(float* out, int count) {
+    ring.skipTo(clearMark.load(std::memory_order_acquire));
+    int got = static_cast<int>(ring.pop(out, static_cast<size_t>(count) * 2) / 2);
+    for (int i = got * 2; i < count * 2; ++i) {
+        out[i] = 0.0f;
+    }
+    underruns += count - got;
+    return got;
+}
+
+void Resampler::convolve(const float* left, const float* right, const float* phase, const float* next, float t, float* out) {
+#ifdef RESAMPLER_X86
+    TileDecoder::Level level = TileDecoder::getLevel();
+    if (level >= TileDecoder::LEVEL_AVX2) {
+        convolveAVX2(left, right, phase, next, t, out);
+        return;
+    }
+    if (level >= TileDecoder::LEVEL_SSE2) {
+        convolveSSE2(left, right, phase, next, t, out);
+        return;
+    }
+#endif
+    convolveScalar(left, right, phase, next, t, out);
+}
+
+void Resampler::convolveScalar(const float* left, const float* right, const float* phase, const float* next, float t, float* out) {
+    float sumLeft = 0.0f;
+    float sumRight = 0.0f;
+    for (int k = 0; k < TAPS; ++k) {
+        float c = phase[k] + (next[k] - phase[k]) * t;
+        sumLeft += left[k] * c;
+        sumRight += right[k] * c;
+    }
+    out[0] = sumLeft;
+    out[1] = sumRight;
+}
+
+#ifdef RESAMPLER_X86
+
+__attribute__((target("sse2")))
+void Resampler::convolveSSE2(const float* left, const float* right, const float* phase, const float* next, float t, float* out) {
+    __m128 weight = _mm_set1_ps(t);
+    __m128 sumLeft = _mm_setzero_ps();
+    __m128 sumRight = _mm_setzero_ps();
+    for (int k = 0; k < TAPS; k += 4) {
+        __m128 a = _mm_loadu_ps(phase + k);
+        __m128 c = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(next + k), a), weight));
+        sumLeft = _mm_add_ps(sumLeft, _mm_mul_ps(_mm_loadu_ps(left + k), c));
+        sumRight = _mm_add_ps(sumRight, _mm_mul_ps(_mm_loadu_ps(right + k), c));
+    }
+    // Add across: (l0+l2, r0+r2, l1+l3, r1+r3), then the two halves
+    __m128 pairs = _mm_add_ps(_mm_unpacklo_ps(sumLeft, sumRight), _mm_unpackhi_ps(sumLeft, sumRight));
+    __m128 totals = _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs));
+    _mm_storel_pi(reinterpret_cast<__m64*>(out), totals);
+}
+
+__attribute__((target("avx2")))
+void Resampler::convolveAVX2(const float* left, const float* right, const float* phase, const float* next, float t, float* out) {
+    __m256 weight = _mm256_set1_ps(t);
+    __m256 sumLeft = _mm256_setzero_ps();
+    __m256 sumRight = _mm256_setzero_ps();
+    for (int k = 0; k < TAPS; k += 8) {
+        __m256 a = _mm256_loadu_ps(phase + k);
+        __m256 c = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(next + k), a), weight));
+        sumLeft = _mm256_add_ps(sumLeft, _mm256_mul_ps(_mm256_loadu_ps(left + k), c));
+        sumRight = _mm256_add_ps(sumRight, _mm256_mul_ps(_mm256_loadu_ps(right + k), c));
+    }
+    __m128 halfLeft = _mm_add_ps(_mm256_castps256_ps128(sumLeft), _mm256_extractf128_ps(sumLeft, 1));
+    __m128 halfRight = _mm_add_ps(_mm256_castps256_ps128(sumRight), _mm256_extractf128_ps(sumRight, 1));
+    __m128 pairs = _mm_add_ps(_mm_unpacklo_ps(halfLeft, halfRight), _mm_unpackhi_ps(halfLeft, halfRight));
+    __m128 totals = _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs));
+    _mm_storel_pi(reinterpret_cast<__m64*>(out), totals);
+}
+
+#endif
@@ -0,0 +1,103 @@
+//
+//  Resampler.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef RESAMPLER_HPP
+#define RESAMPLER_HPP
+
+#include "../Types/Types.hpp"
+#include "../Types/SPSCRing.hpp"
+#include <atomic>
+#include <vector>
+
+// Converts the DSP's stereo output to the host's rate with a polyphase
+// windowed-sinc filter: TAPS input samples per output sample, weighted by
+// one of PHASES precomputed filters (interpolated between the two nearest
+// ones). The cutoff sits below the lower of the two Nyquist rates.
+// Output goes to a lock-free ring as interleaved float frames, for the
+// audio callback to read on its own thread. The emulator writes at its
+// own pace, so the ratio can be nudged (setAdjust()) by the ring's fill
+// level to keep it from running dry or overflowing.
+// The convolution kernel level follows TileDecoder::getLevel().
+class Resampler {
+public:
+    static const int TAPS = 32;
+    static const int PHASES = 256;
+    static const int MAX_ADJUST_PERCENT = 1;    // setAdjust() range, either way
+
+    // Ring size in frames
+    explicit Resampler(int capacity = 8192);
+
+    Resampler(const Resampler&) = delete;
+    Resampler& operator=(const Resampler&) = delete;
+
+    // Input and output rates in Hz; drops the input history
+    void setRates(double input, double output);
+    double getInputRate() const { return inputRate; }
+    double getOutputRate() const { return outputRate; }
+
+    // Scale the output rate by factor (clamped to 1 +/- MAX_ADJUST_PERCENT%):
+    // above 1 makes more frames from the same input
+    void setAdjust(double factor);
+    double getAdjust() const { return adjust; }
+
+    // Producer: count stereo samples (left, right); returns frames made.
+    // Frames that don't fit in the ring are dropped and counted.
+    int write(const int16* samples, int count);
+
+    // Producer: drop the frames in the ring; the consumer skips them on
+    // its next read()
+    void clear();
+
+    // Consumer: up to count frames of interleaved float; the rest of out
+    // is filled with silence and counted. Returns frames read.
+    int read(float* out, int count);
+
+    // Either side
+    int getBufferedFrames() const { return static_cast<int>(ring.size() / 2); }
+    int getCapacity() const { return static_cast<int>(ring.capacity() / 2); }
+    double getFillLevel() const { return static_cast<double>(getBufferedFrames()) / getCapacity(); }
+
+    uint64 getOverruns() const { return overruns; }     // Frames dropped (producer)
+    uint64 getUnderruns() const { return underruns; }   // Frames of silence (consumer)
+
+    // One stereo output frame: taps TAPS samples from left and right with
+    // phase + (next - phase) * t
+    static void convolve(const float* left, const float* right, const float* phase, const float* next, float t, float* out);
+
+    static void convolveScalar(const float* left, const float* right, const float* phase, const float* next, float t, float* out);
+#if defined(__x86_64__) || defined(__i386__)
+    static void convolveSSE2(const float* left, const float* right, const float* phase, const float* next, float t, float* out);
+    static void convolveAVX2(const float* left, const float* right, const float* phase, const float* next, float t, float* out);
+#endif
+
+private:
+    SPSCRing<float> ring;
+    double inputRate;
+    double outputRate;
+    double adjust;
+
+    // Filter for phase p at filters[p * TAPS]; PHASES + 1 of them so the
+    // last one can be interpolated towards
+    std::vector<float> filters;
+
+    // Producer side
+    std::vector<float> left;            // Input not fully used yet
+    std::vector<float> right;
+    uint64 position;                    // Of the first tap in left/right, 32.32 fixed point
+    uint64 step;                        // Input samples per output sample, 32.32
+    std::vector<float> frames;          // Made this write(), before the ring
+    uint64 overruns;
+
+    std::atomic<size_t> clearMark;      // Ring items before it are dropped
+
+    // Consumer side
+    uint64 underruns;
+
+    void buildFilters();
+    void updateStep();
+};
+#endif
@@ -0,0 +1,1075 @@
+//
+//  SPC700.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "SPC700.hpp"
+#include "DSP.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Boot ROM: announces $AA/$BB on ports 0/1, then loads blocks sent by the
+// S-CPU through the ports and jumps to them
+const uint8 SPC700::IPL_ROM[64] = {
+    0xCD, 0xEF, 0xBD, 0xE8, 0x00, 0xC6, 0x1D, 0xD0, 0xFC, 0x8F, 0xAA, 0xF4, 0x8F, 0xBB, 0xF5, 0x78,
+    0xCC, 0xF4, 0xD0, 0xFB, 0x2F, 0x19, 0xEB, 0xF4, 0xD0, 0xFC, 0x7E, 0xF4, 0xD0, 0x0B, 0xE4, 0xF5,
+    0xCB, 0xF4, 0xD7, 0x00, 0xFC, 0xD0, 0xF3, 0xAB, 0x01, 0x10, 0xEF, 0x7E, 0xF4, 0x10, 0xEB, 0xBA,
+    0xF6, 0xDA, 0x00, 0xBA, 0xF4, 0xC4, 0xF4, 0xDD, 0x5D, 0xD0, 0xDB, 0x1F, 0x00, 0x00, 0xC0, 0xFF
+};
+
+SPC700::SPC700(): totalCycles(0), aram(0x10000, 0), iplMapped(false), portLog(nullptr), dsp(nullptr), extraCycles(0) {
+    std::memset(ramWrites, 0, sizeof(ramWrites));
+    reset();
+}
+
+void SPC700::reset() {
+    std::fill(aram.begin(), aram.end(), 0);
+    iplMapped = false;
+    mapIPL(true);
+
+    std::memset(inputPorts, 0, sizeof(inputPorts));
+    std::memset(outputPorts, 0, sizeof(outputPorts));
+    dspAddress = 0;
+    // All of RAM changed
+    for (uint32& writes : ramWrites) {
+        writes++;
+    }
+
+    static const uint32 TIMER_PERIODS[3] = {128, 128, 16};
+    for (int i = 0; i < 3; i++) {
+        timers[i].period = TIMER_PERIODS[i];
+        timers[i].enabled = false;
+        timers[i].target = 0;
+        timers[i].stage = 0;
+        timers[i].counter = 0;
+        timers[i].updated = 0;
+    }
+
+    registers.A = 0;
+    registers.X = 0;
+    registers.Y = 0;
+    registers.SP = 0xEF;
+    registers.PSW = 0;
+    registers.PC = readWord(0xFFFE);    // $FFC0, the start of the IPL ROM
+    totalCycles = 0;
+    cycleBalance = 0;
+    dspSync = DSP::CHUNK_SAMPLES * DSP::CYCLES_PER_SAMPLE;
+    extraCycles = 0;
+    stopped = false;
+    if (dsp) {
+        dsp->reset();
+    }
+}
+
+void SPC700::setDSP(DSP* sound) {
+    dsp = sound;
+}
+
+void SPC700::setPortLog(std::vector<PortWrite>* log) {
+    portLog = log;
+}
+
+int SPC700::executeInstruction() {
+    if (stopped) {
+        totalCycles += 2;
+        return 2;
+    }
+    extraCycles = 0;
+    uint8 opcode = fetch();
+    (this->*HANDLERS[opcode])();
+    int cycles = CYCLES[opcode] + extraCycles;
+    totalCycles += cycles;
+    return cycles;
+}
+
+void SPC700::run(int cycles) {
+    cycleBalance += cycles;
+    if (stopped) {
+        // Nothing left to run until reset
+        if (cycleBalance > 0) {
+            totalCycles += cycleBalance;
+            cycleBalance = 0;
+        }
+    }
+    while (cycleBalance > 0) {
+        cycleBalance -= executeInstruction();
+        if (totalCycles >= dspSync) {
+            syncDSP();
+        }
+    }
+    if (totalCycles >= dspSync) {
+        syncDSP();
+    }
+}
+
+void SPC700::syncDSP() {
+    const uint64 chunk = DSP::CHUNK_SAMPLES * DSP::CYCLES_PER_SAMPLE;
+    uint64 boundary = totalCycles - totalCycles % chunk;
+    if (dsp) {
+        dsp->runUntil(boundary);
+    }
+    dspSync = boundary + chunk;
+}
+
+void SPC700::write(uint16 address, uint8 value) {
+    if ((address & 0xFFF0) == 0x00F0) {
+        // Registers also write through to the RAM underneath
+        writeIO(address, value);
+    } else if (address >= IPL_BASE && iplMapped) {
+        iplShadow[address - IPL_BASE] = value;
+        ramWrites[address >> RAM_CHUNK_SHIFT]++;
+        return;
+    }
+    aram[address] = value;
+    ramWrites[address >> RAM_CHUNK_SHIFT]++;
+}
+
+void SPC700::mapIPL(bool mapped) {
+    if (mapped == iplMapped) {
+        return;
+    }
+    if (mapped) {
+        std::memcpy(iplShadow, &aram[IPL_BASE], sizeof(iplShadow));
+        std::memcpy(&aram[IPL_BASE], IPL_ROM, sizeof(IPL_ROM));
+    } else {
+        std::memcpy(&aram[IPL_BASE], iplShadow, sizeof(iplShadow));
+    }
+    iplMapped = mapped;
+}
+
+uint8 SPC700::readIO(uint16 address) {
+    switch (address) {
+        case 0xF2:
+            return dspAddress;
+        case 0xF3:
+            if (!dsp) {
+                return 0;
+            }
+            dsp->runUntil(totalCycles);
+            return dsp->read(dspAddress & 0x7F);
+        case 0xF4: case 0xF5: case 0xF6: case 0xF7:
+            return inputPorts[address - 0xF4];
+        case 0xF8: case 0xF9:
+            return aram[address];
+        case 0xFD: case 0xFE: case 0xFF: {
+            Timer& timer = timers[address - 0xFD];
+            updateTimer(timer);
+            uint8 value = timer.counter;
+            timer.counter = 0;
+            return value;
+        }
+        default:
+            // TEST, CONTROL and the timer targets are write-only
+            return 0;
+    }
+}
+
+void SPC700::writeIO(uint16 address, uint8 value) {
+    switch (address) {
+        case 0xF1:
+            // CONTROL: timer enables, port clears, IPL ROM mapping
+            for (int i = 0; i < 3; i++) {
+                Timer& timer = timers[i];
+                bool enable = (value >> i) & 1;
+                updateTimer(timer);
+                if (enable && !timer.enabled) {
+                    timer.stage = 0;
+                    timer.counter = 0;
+                }
+                timer.enabled = enable;
+            }
+            if (value & 0x10) {
+                inputPorts[0] = 0;
+                inputPorts[1] = 0;
+            }
+            if (value & 0x20) {
+                inputPorts[2] = 0;
+                inputPorts[3] = 0;
+            }
+            mapIPL((value & 0x80) != 0);
+            break;
+        case 0xF2:
+            dspAddress = value;
+            break;
+        case 0xF3:
+            // $80-$FF mirror $00-$7F read-only
+            if (dspAddress < 0x80 && dsp) {
+                dsp->runUntil(totalCycles);
+                dsp->write(dspAddress, value);
+            }
+            break;
+        case 0xF4: case 0xF5: case 0xF6: case 0xF7:
+            outputPorts[address - 0xF4] = value;
+            if (portLog) {
+                // totalCycles is only added to once the instruction is done
+                portLog->push_back({totalCycles, static_cast<uint8>(address - 0xF4), value});
+            }
+            break;
+        case 0xFA: case 0xFB: case 0xFC: {
+            Timer& timer = timers[address - 0xFA];
+            updateTimer(timer);
+            timer.target = value;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void SPC700::updateTimer(Timer& timer) {
+    uint64 ticks = totalCycles / timer.period - timer.updated / timer.period;
+    timer.updated = totalCycles;
+    if (!timer.enabled || ticks == 0) {
+        return;
+    }
+    uint32 target = timer.target ? timer.target : 256;
+    uint64 stage = timer.stage + ticks;
+    timer.counter = (timer.counter + stage / target) & 0x0F;
+    timer.stage = stage % target;
+}
+
+// MARK: - Addressing
+
+template <int mode> uint16 SPC700::address() {
+    switch (mode) {
+        case MODE_IMM:      return registers.PC++;
+        case MODE_DP:       return dp(fetch());
+        case MODE_DPX:      return dp(fetch() + registers.X);
+        case MODE_DPY:      return dp(fetch() + registers.Y);
+        case MODE_ABS:      return fetchWord();
+        case MODE_ABSX:     return fetchWord() + registers.X;
+        case MODE_ABSY:     return fetchWord() + registers.Y;
+        case MODE_INDX:     return dp(registers.X);
+        case MODE_DPX_IND:  return readDPWord(fetch() + registers.X);
+        default:            return readDPWord(fetch()) + registers.Y;
+    }
+}
+
+// MARK: - ALU
+
+uint8 SPC700::alu_or(uint8 a, uint8 b) {
+    uint8 result = a | b;
+    setNZ(result);
+    return result;
+}
+
+uint8 SPC700::alu_and(uint8 a, uint8 b) {
+    uint8 result = a & b;
+    setNZ(result);
+    return result;
+}
+
+uint8 SPC700::alu_eor(uint8 a, uint8 b) {
+    uint8 result = a ^ b;
+    setNZ(result);
+    return result;
+}
+
+uint8 SPC700::alu_cmp(uint8 a, uint8 b) {
+    int result = a - b;
+    setFlag(FLAG_C, result >= 0);
+    setNZ(result & 0xFF);
+    return a;
+}
+
+uint8 SPC700::alu_adc(uint8 a, uint8 b) {
+    int result = a + b + (registers.PSW & FLAG_C);
+    setFlag(FLAG_C, result > 0xFF);
+    setFlag(FLAG_H, ((a ^ b ^ result) & 0x10) != 0);
+    setFlag(FLAG_V, (~(a ^ b) & (a ^ result) & 0x80) != 0);
+    setNZ(result & 0xFF);
+    return result & 0xFF;
+}
+
+uint8 SPC700::alu_sbc(uint8 a, uint8 b) {
+    return alu_adc(a, ~b);
+}
+
+uint8 SPC700::mod_asl(uint8 value) {
+    setFlag(FLAG_C, (value & 0x80) != 0);
+    value <<= 1;
+    setNZ(value);
+    return value;
+}
+
+uint8 SPC700::mod_rol(uint8 value) {
+    uint8 carry = registers.PSW & FLAG_C;
+    setFlag(FLAG_C, (value & 0x80) != 0);
+    value = (value << 1) | carry;
+    setNZ(value);
+    return value;
+}
+
+uint8 SPC700::mod_lsr(uint8 value) {
+    setFlag(FLAG_C, (value & 0x01) != 0);
+    value >>= 1;
+    setNZ(value);
+    return value;
+}
+
+uint8 SPC700::mod_ror(uint8 value) {
+    uint8 carry = (registers.PSW & FLAG_C) << 7;
+    setFlag(FLAG_C, (value & 0x01) != 0);
+    value = (value >> 1) | carry;
+    setNZ(value);
+    return value;
+}
+
+uint8 SPC700::mod_inc(uint8 value) {
+    value++;
+    setNZ(value);
+    return value;
+}
+
+uint8 SPC700::mod_dec(uint8 value) {
+    value--;
+    setNZ(value);
+    return value;
+}
+
+void SPC700::branch(bool condition) {
+    int8 offset = fetch();
+    if (condition) {
+        registers.PC += offset;
+        extraCycles += 2;
+    }
+}
+
+// MARK: - Handler templates
+
+template <SPC700::AluOp op, int mode> void SPC700::op_aluA() {
+    registers.A = (this->*op)(registers.A, operand<mode>());
+}
+
+template <SPC700::AluOp op> void SPC700::op_aluDpDp() {
+    uint8 source = read(dp(fetch()));
+    uint16 target = dp(fetch());
+    uint8 result = (this->*op)(read(target), source);
+    if (op != &SPC700::alu_cmp) {
+        write(target, result);
+    }
+}
+
+template <SPC700::AluOp op> void SPC700::op_aluDpImm() {
+    uint8 source = fetch();
+    uint16 target = dp(fetch());
+    uint8 result = (this->*op)(read(target), source);
+    if (op != &SPC700::alu_cmp) {
+        write(target, result);
+    }
+}
+
+template <SPC700::AluOp op> void SPC700::op_aluXY() {
+    uint8 source = read(dp(registers.Y));
+    uint16 target = dp(registers.X);
+    uint8 result = (this->*op)(read(target), source);
+    if (op != &SPC700::alu_cmp) {
+        write(target, result);
+    }
+}
+
+template <int mode> void SPC700::op_cmpX() {
+    alu_cmp(registers.X, operand<mode>());
+}
+
+template <int mode> void SPC700::op_cmpY() {
+    alu_cmp(registers.Y, operand<mode>());
+}
+
+template <SPC700::ModifyOp op, int mode> void SPC700::op_modify() {
+    uint16 target = address<mode>();
+    write(target, (this->*op)(read(target)));
+}
+
+template <SPC700::ModifyOp op> void SPC700::op_modifyA() {
+    registers.A = (this->*op)(registers.A);
+}
+
+template <SPC700::ModifyOp op> void SPC700::op_modifyX() {
+    registers.X = (this->*op)(registers.X);
+}
+
+template <SPC700::ModifyOp op> void SPC700::op_modifyY() {
+    registers.Y = (this->*op)(registers.Y);
+}
+
+template <int mode> void SPC700::op_movA() {
+    registers.A = operand<mode>();
+    setNZ(registers.A);
+}
+
+template <int mode> void SPC700::op_movX() {
+    registers.X = operand<mode>();
+    setNZ(registers.X);
+}
+
+template <int mode> void SPC700::op_movY() {
+    registers.Y = operand<mode>();
+    setNZ(registers.Y);
+}
+
+template <int mode> void SPC700::op_storeA() {
+    write(address<mode>(), registers.A);
+}
+
+template <int mode> void SPC700::op_storeX() {
+    write(address<mode>(), registers.X);
+}
+
+template <int mode> void SPC700::op_storeY() {
+    write(address<mode>(), registers.Y);
+}
+
+template <int bit> void SPC700::op_set1() {
+    uint16 target = dp(fetch());
+    write(target, read(target) | (1 << bit));
+}
+
+template <int bit> void SPC700::op_clr1() {
+    uint16 target = dp(fetch());
+    write(target, read(target) & ~(1 << bit));
+}
+
+template <int bit> void SPC700::op_bbs() {
+    uint8 value = read(dp(fetch()));
+    branch((value & (1 << bit)) != 0);
+}
+
+template <int bit> void SPC700::op_bbc() {
+    uint8 value = read(dp(fetch()));
+    branch((value & (1 << bit)) == 0);
+}
+
+template <int vector> void SPC700::op_tcall() {
+    pushWord(registers.PC);
+    registers.PC = readWord(0xFFDE - vector * 2);
+}
+
+template <uint8 flag, bool set> void SPC700::op_branch() {
+    branch(((registers.PSW & flag) != 0) == set);
+}
+
+template <uint8 flag, bool set> void SPC700::op_setFlag() {
+    setFlag(flag, set);
+}
+
+// MARK: - Handlers
+
+void SPC700::op_nop() {
+}
+
+void SPC700::op_bra() {
+    int8 offset = fetch();
+    registers.PC += offset;
+}
+
+void SPC700::op_movDpDp() {
+    uint8 value = read(dp(fetch()));
+    write(dp(fetch()), value);
+}
+
+void SPC700::op_movDpImm() {
+    uint8 value = fetch();
+    write(dp(fetch()), value);
+}
+
+void SPC700::op_movAX() {
+    registers.A = registers.X;
+    setNZ(registers.A);
+}
+
+void SPC700::op_movAY() {
+    registers.A = registers.Y;
+    setNZ(registers.A);
+}
+
+void SPC700::op_movXA() {
+    registers.X = registers.A;
+    setNZ(registers.X);
+}
+
+void SPC700::op_movYA() {
+    registers.Y = registers.A;
+    setNZ(registers.Y);
+}
+
+void SPC700::op_movXSP() {
+    registers.X = registers.SP;
+    setNZ(registers.X);
+}
+
+void SPC700::op_movSPX() {
+    registers.SP = registers.X;
+}
+
+void SPC700::op_movIncXA() {
+    write(dp(registers.X), registers.A);
+    registers.X++;
+}
+
+void SPC700::op_movAIncX() {
+    registers.A = read(dp(registers.X));
+    registers.X++;
+    setNZ(registers.A);
+}
+
+void SPC700::op_movwYA() {
+    setYA(readDPWord(fetch()));
+    setNZ16(getYA());
+}
+
+void SPC700::op_movwDp() {
+    uint8 offset = fetch();
+    write(dp(offset), registers.A);
+    write(dp(offset + 1), registers.Y);
+}
+
+void SPC700::op_incw() {
+    uint8 offset = fetch();
+    uint16 value = readDPWord(offset) + 1;
+    write(dp(offset), value & 0xFF);
+    write(dp(offset + 1), value >> 8);
+    setNZ16(value);
+}
+
+void SPC700::op_decw() {
+    uint8 offset = fetch();
+    uint16 value = readDPWord(offset) - 1;
+    write(dp(offset), value & 0xFF);
+    write(dp(offset + 1), value >> 8);
+    setNZ16(value);
+}
+
+void SPC700::op_addw() {
+    uint16 value = readDPWord(fetch());
+    uint16 ya = getYA();
+    uint32 result = ya + value;
+    setFlag(FLAG_C, result > 0xFFFF);
+    setFlag(FLAG_H, ((ya ^ value ^ result) & 0x1000) != 0);
+    setFlag(FLAG_V, (~(ya ^ value) & (ya ^ result) & 0x8000) != 0);
+    setYA(result & 0xFFFF);
+    setNZ16(result & 0xFFFF);
+}
+
+void SPC700::op_subw() {
+    uint16 value = readDPWord(fetch());
+    uint16 ya = getYA();
+    int32 result = ya - value;
+    setFlag(FLAG_C, result >= 0);
+    setFlag(FLAG_H, ((ya ^ value ^ result) & 0x1000) == 0);
+    setFlag(FLAG_V, ((ya ^ value) & (ya ^ result) & 0x8000) != 0);
+    setYA(result & 0xFFFF);
+    setNZ16(result & 0xFFFF);
+}
+
+void SPC700::op_cmpw() {
+    uint16 value = readDPWord(fetch());
+    int32 result = getYA() - value;
+    setFlag(FLAG_C, result >= 0);
+    setNZ16(result & 0xFFFF);
+}
+
+void SPC700::op_mul() {
+    setYA(registers.Y * registers.A);
+    setNZ(registers.Y);
+}
+
+void SPC700::op_div() {
+    // Matches the hardware for quotients that do not fit in 8 bits too
+    uint16 ya = getYA();
+    uint8 x = registers.X;
+    setFlag(FLAG_H, (registers.Y & 0x0F) >= (x & 0x0F));
+    setFlag(FLAG_V, registers.Y >= x);
+    if (registers.Y < (x << 1)) {
+        registers.A = ya / x;
+        registers.Y = ya % x;
+    } else {
+        registers.A = 255 - (ya - (x << 9)) / (256 - x);
+        registers.Y = x + (ya - (x << 9)) % (256 - x);
+    }
+    setNZ(registers.A);
+}
+
+void SPC700::op_daa() {
+    if ((registers.PSW & FLAG_C) || registers.A > 0x99) {
+        registers.A += 0x60;
+        setFlag(FLAG_C, true);
+    }
+    if ((registers.PSW & FLAG_H) || (registers.A & 0x0F) > 0x09) {
+        registers.A += 0x06;
+    }
+    setNZ(registers.A);
+}
+
+void SPC700::op_das() {
+    if (!(registers.PSW & FLAG_C) || registers.A > 0x99) {
+        registers.A -= 0x60;
+        setFlag(FLAG_C, false);
+    }
+    if (!(registers.PSW & FLAG_H) || (registers.A & 0x0F) > 0x09) {
+        registers.A -= 0x06;
+    }
+    setNZ(registers.A);
+}
+
+void SPC700::op_xcn() {
+    registers.A = (registers.A >> 4) | (registers.A << 4);
+    setNZ(registers.A);
+}
+
+void SPC700::op_notc() {
+    registers.PSW ^= FLAG_C;
+}
+
+void SPC700::op_clrv() {
+    setFlag(FLAG_V | FLAG_H, false);
+}
+
+void SPC700::op_tset1() {
+    uint16 target = fetchWord();
+    uint8 value = read(target);
+    setNZ(registers.A - value);
+    write(target, value | registers.A);
+}
+
+void SPC700::op_tclr1() {
+    uint16 target = fetchWord();
+    uint8 value = read(target);
+    setNZ(registers.A - value);
+    write(target, value & ~registers.A);
+}
+
+void SPC700::op_or1() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    if ((read(target) >> bit) & 1) {
+        registers.PSW |= FLAG_C;
+    }
+}
+
+void SPC700::op_or1Not() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    if (!((read(target) >> bit) & 1)) {
+        registers.PSW |= FLAG_C;
+    }
+}
+
+void SPC700::op_and1() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    if (!((read(target) >> bit) & 1)) {
+        registers.PSW &= ~FLAG_C;
+    }
+}
+
+void SPC700::op_and1Not() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    if ((read(target) >> bit) & 1) {
+        registers.PSW &= ~FLAG_C;
+    }
+}
+
+void SPC700::op_eor1() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    registers.PSW ^= (read(target) >> bit) & FLAG_C;
+}
+
+void SPC700::op_not1() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    write(target, read(target) ^ (1 << bit));
+}
+
+void SPC700::op_mov1ToC() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    setFlag(FLAG_C, (read(target) >> bit) & 1);
+}
+
+void SPC700::op_mov1FromC() {
+    int bit;
+    uint16 target = fetchMemoryBit(bit);
+    uint8 value = read(target) & ~(1 << bit);
+    write(target, value | ((registers.PSW & FLAG_C) << bit));
+}
+
+void SPC700::op_cbneDp() {
+    uint8 value = read(dp(fetch()));
+    branch(registers.A != value);
+}
+
+void SPC700::op_cbneDpX() {
+    uint8 value = read(dp(fetch() + registers.X));
+    branch(registers.A != value);
+}
+
+void SPC700::op_dbnzDp() {
+    uint16 target = dp(fetch());
+    uint8 value = read(target) - 1;
+    write(target, value);
+    branch(value != 0);
+}
+
+void SPC700::op_dbnzY() {
+    registers.Y--;
+    branch(registers.Y != 0);
+}
+
+void SPC700::op_pushA() {
+    push(registers.A);
+}
+
+void SPC700::op_pushX() {
+    push(registers.X);
+}
+
+void SPC700::op_pushY() {
+    push(registers.Y);
+}
+
+void SPC700::op_pushPSW() {
+    push(registers.PSW);
+}
+
+void SPC700::op_popA() {
+    registers.A = pop();
+}
+
+void SPC700::op_popX() {
+    registers.X = pop();
+}
+
+void SPC700::op_popY() {
+    registers.Y = pop();
+}
+
+void SPC700::op_popPSW() {
+    registers.PSW = pop();
+}
+
+void SPC700::op_call() {
+    uint16 target = fetchWord();
+    pushWord(registers.PC);
+    registers.PC = target;
+}
+
+void SPC700::op_pcall() {
+    uint8 offset = fetch();
+    pushWord(registers.PC);
+    registers.PC = 0xFF00 | offset;
+}
+
+void SPC700::op_ret() {
+    registers.PC = popWord();
+}
+
+void SPC700::op_reti() {
+    registers.PSW = pop();
+    registers.PC = popWord();
+}
+
+void SPC700::op_brk() {
+    pushWord(registers.PC);
+    push(registers.PSW);
+    registers.PSW = (registers.PSW | FLAG_B) & ~FLAG_I;
+    registers.PC = readWord(0xFFDE);
+}
+
+void SPC700::op_jmp() {
+    registers.PC = fetchWord();
+}
+
+void SPC700::op_jmpIndirect() {
+    registers.PC = readWord(fetchWord() + registers.X);
+}
+
+void SPC700::op_stop() {
+    // SLEEP/STOP halt the core until reset (there are no interrupts to wake it)
+    stopped = true;
+}
+
+// MARK: - Tables
+
+const SPC700::Handler SPC700::HANDLERS[256] = {
+    &SPC700::op_nop,                                            // 00 NOP
+    &SPC700::op_tcall<0>,                                       // 01 TCALL 0
+    &SPC700::op_set1<0>,                                        // 02 SET1 dp.0
+    &SPC700::op_bbs<0>,                                         // 03 BBS dp.0,r
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_DP>,                 // 04 OR A,dp
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_ABS>,                // 05 OR A,!a
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_INDX>,               // 06 OR A,(X)
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_DPX_IND>,            // 07 OR A,[dp+X]
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_IMM>,                // 08 OR A,#i
+    &SPC700::op_aluDpDp<&SPC700::alu_or>,                       // 09 OR dp,dp
+    &SPC700::op_or1,                                            // 0A OR1 C,m.b
+    &SPC700::op_modify<&SPC700::mod_asl, MODE_DP>,              // 0B ASL dp
+    &SPC700::op_modify<&SPC700::mod_asl, MODE_ABS>,             // 0C ASL !a
+    &SPC700::op_pushPSW,                                        // 0D PUSH PSW
+    &SPC700::op_tset1,                                          // 0E TSET1 !a
+    &SPC700::op_brk,                                            // 0F BRK
+    &SPC700::op_branch<FLAG_N, false>,                          // 10 BPL r
+    &SPC700::op_tcall<1>,                                       // 11 TCALL 1
+    &SPC700::op_clr1<0>,                                        // 12 CLR1 dp.0
+    &SPC700::op_bbc<0>,                                         // 13 BBC dp.0,r
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_DPX>,                // 14 OR A,dp+X
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_ABSX>,               // 15 OR A,!a+X
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_ABSY>,               // 16 OR A,!a+Y
+    &SPC700::op_aluA<&SPC700::alu_or, MODE_DP_IND_Y>,           // 17 OR A,[dp]+Y
+    &SPC700::op_aluDpImm<&SPC700::alu_or>,                      // 18 OR dp,#i
+    &SPC700::op_aluXY<&SPC700::alu_or>,                         // 19 OR (X),(Y)
+    &SPC700::op_decw,                                           // 1A DECW dp
+    &SPC700::op_modify<&SPC700::mod_asl, MODE_DPX>,             // 1B ASL dp+X
+    &SPC700::op_modifyA<&SPC700::mod_asl>,                      // 1C ASL A
+    &SPC700::op_modifyX<&SPC700::mod_dec>,                      // 1D DEC X
+    &SPC700::op_cmpX<MODE_ABS>,                                 // 1E CMP X,!a
+    &SPC700::op_jmpIndirect,                                    // 1F JMP [!a+X]
+    &SPC700::op_setFlag<FLAG_P, false>,                         // 20 CLRP
+    &SPC700::op_tcall<2>,                                       // 21 TCALL 2
+    &SPC700::op_set1<1>,                                        // 22 SET1 dp.1
+    &SPC700::op_bbs<1>,                                         // 23 BBS dp.1,r
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_DP>,                // 24 AND A,dp
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_ABS>,               // 25 AND A,!a
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_INDX>,              // 26 AND A,(X)
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_DPX_IND>,           // 27 AND A,[dp+X]
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_IMM>,               // 28 AND A,#i
+    &SPC700::op_aluDpDp<&SPC700::alu_and>,                      // 29 AND dp,dp
+    &SPC700::op_or1Not,                                         // 2A OR1 C,/m.b
+    &SPC700::op_modify<&SPC700::mod_rol, MODE_DP>,              // 2B ROL dp
+    &SPC700::op_modify<&SPC700::mod_rol, MODE_ABS>,             // 2C ROL !a
+    &SPC700::op_pushA,                                          // 2D PUSH A
+    &SPC700::op_cbneDp,                                         // 2E CBNE dp,r
+    &SPC700::op_bra,                                            // 2F BRA r
+    &SPC700::op_branch<FLAG_N, true>,                           // 30 BMI r
+    &SPC700::op_tcall<3>,                                       // 31 TCALL 3
+    &SPC700::op_clr1<1>,                                        // 32 CLR1 dp.1
+    &SPC700::op_bbc<1>,                                         // 33 BBC dp.1,r
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_DPX>,               // 34 AND A,dp+X
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_ABSX>,              // 35 AND A,!a+X
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_ABSY>,              // 36 AND A,!a+Y
+    &SPC700::op_aluA<&SPC700::alu_and, MODE_DP_IND_Y>,          // 37 AND A,[dp]+Y
+    &SPC700::op_aluDpImm<&SPC700::alu_and>,                     // 38 AND dp,#i
+    &SPC700::op_aluXY<&SPC700::alu_and>,                        // 39 AND (X),(Y)
+    &SPC700::op_incw,                                           // 3A INCW dp
+    &SPC700::op_modify<&SPC700::mod_rol, MODE_DPX>,             // 3B ROL dp+X
+    &SPC700::op_modifyA<&SPC700::mod_rol>,                      // 3C ROL A
+    &SPC700::op_modifyX<&SPC700::mod_inc>,                      // 3D INC X
+    &SPC700::op_cmpX<MODE_DP>,                                  // 3E CMP X,dp
+    &SPC700::op_call,                                           // 3F CALL !a
+    &SPC700::op_setFlag<FLAG_P, true>,                          // 40 SETP
+    &SPC700::op_tcall<4>,                                       // 41 TCALL 4
+    &SPC700::op_set1<2>,                                        // 42 SET1 dp.2
+    &SPC700::op_bbs<2>,                                         // 43 BBS dp.2,r
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_DP>,                // 44 EOR A,dp
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_ABS>,               // 45 EOR A,!a
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_INDX>,              // 46 EOR A,(X)
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_DPX_IND>,           // 47 EOR A,[dp+X]
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_IMM>,               // 48 EOR A,#i
+    &SPC700::op_aluDpDp<&SPC700::alu_eor>,                      // 49 EOR dp,dp
+    &SPC700::op_and1,                                           // 4A AND1 C,m.b
+    &SPC700::op_modify<&SPC700::mod_lsr, MODE_DP>,              // 4B LSR dp
+    &SPC700::op_modify<&SPC700::mod_lsr, MODE_ABS>,             // 4C LSR !a
+    &SPC700::op_pushX,                                          // 4D PUSH X
+    &SPC700::op_tclr1,                                          // 4E TCLR1 !a
+    &SPC700::op_pcall,                                          // 4F PCALL up
+    &SPC700::op_branch<FLAG_V, false>,                          // 50 BVC r
+    &SPC700::op_tcall<5>,                                       // 51 TCALL 5
+    &SPC700::op_clr1<2>,                                        // 52 CLR1 dp.2
+    &SPC700::op_bbc<2>,                                         // 53 BBC dp.2,r
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_DPX>,               // 54 EOR A,dp+X
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_ABSX>,              // 55 EOR A,!a+X
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_ABSY>,              // 56 EOR A,!a+Y
+    &SPC700::op_aluA<&SPC700::alu_eor, MODE_DP_IND_Y>,          // 57 EOR A,[dp]+Y
+    &SPC700::op_aluDpImm<&SPC700::alu_eor>,                     // 58 EOR dp,#i
+    &SPC700::op_aluXY<&SPC700::alu_eor>,                        // 59 EOR (X),(Y)
+    &SPC700::op_cmpw,                                           // 5A CMPW YA,dp
+    &SPC700::op_modify<&SPC700::mod_lsr, MODE_DPX>,             // 5B LSR dp+X
+    &SPC700::op_modifyA<&SPC700::mod_lsr>,                      // 5C LSR A
+    &SPC700::op_movXA,                                          // 5D MOV X,A
+    &SPC700::op_cmpY<MODE_ABS>,                                 // 5E CMP Y,!a
+    &SPC700::op_jmp,                                            // 5F JMP !a
+    &SPC700::op_setFlag<FLAG_C, false>,                         // 60 CLRC
+    &SPC700::op_tcall<6>,                                       // 61 TCALL 6
+    &SPC700::op_set1<3>,                                        // 62 SET1 dp.3
+    &SPC700::op_bbs<3>,                                         // 63 BBS dp.3,r
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_DP>,                // 64 CMP A,dp
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_ABS>,               // 65 CMP A,!a
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_INDX>,              // 66 CMP A,(X)
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_DPX_IND>,           // 67 CMP A,[dp+X]
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_IMM>,               // 68 CMP A,#i
+    &SPC700::op_aluDpDp<&SPC700::alu_cmp>,                      // 69 CMP dp,dp
+    &SPC700::op_and1Not,                                        // 6A AND1 C,/m.b
+    &SPC700::op_modify<&SPC700::mod_ror, MODE_DP>,              // 6B ROR dp
+    &SPC700::op_modify<&SPC700::mod_ror, MODE_ABS>,             // 6C ROR !a
+    &SPC700::op_pushY,                                          // 6D PUSH Y
+    &SPC700::op_dbnzDp,                                         // 6E DBNZ dp,r
+    &SPC700::op_ret,                                            // 6F RET
+    &SPC700::op_branch<FLAG_V, true>,                           // 70 BVS r
+    &SPC700::op_tcall<7>,                                       // 71 TCALL 7
+    &SPC700::op_clr1<3>,                                        // 72 CLR1 dp.3
+    &SPC700::op_bbc<3>,                                         // 73 BBC dp.3,r
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_DPX>,               // 74 CMP A,dp+X
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_ABSX>,              // 75 CMP A,!a+X
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_ABSY>,              // 76 CMP A,!a+Y
+    &SPC700::op_aluA<&SPC700::alu_cmp, MODE_DP_IND_Y>,          // 77 CMP A,[dp]+Y
+    &SPC700::op_aluDpImm<&SPC700::alu_cmp>,                     // 78 CMP dp,#i
+    &SPC700::op_aluXY<&SPC700::alu_cmp>,                        // 79 CMP (X),(Y)
+    &SPC700::op_addw,                                           // 7A ADDW YA,dp
+    &SPC700::op_modify<&SPC700::mod_ror, MODE_DPX>,             // 7B ROR dp+X
+    &SPC700::op_modifyA<&SPC700::mod_ror>,                      // 7C ROR A
+    &SPC700::op_movAX,                                          // 7D MOV A,X
+    &SPC700::op_cmpY<MODE_DP>,                                  // 7E CMP Y,dp
+    &SPC700::op_reti,                                           // 7F RETI
+    &SPC700::op_setFlag<FLAG_C, true>,                          // 80 SETC
+    &SPC700::op_tcall<8>,                                       // 81 TCALL 8
+    &SPC700::op_set1<4>,                                        // 82 SET1 dp.4
+    &SPC700::op_bbs<4>,                                         // 83 BBS dp.4,r
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_DP>,                // 84 ADC A,dp
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_ABS>,               // 85 ADC A,!a
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_INDX>,              // 86 ADC A,(X)
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_DPX_IND>,           // 87 ADC A,[dp+X]
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_IMM>,               // 88 ADC A,#i
+    &SPC700::op_aluDpDp<&SPC700::alu_adc>,                      // 89 ADC dp,dp
+    &SPC700::op_eor1,                                           // 8A EOR1 C,m.b
+    &SPC700::op_modify<&SPC700::mod_dec, MODE_DP>,              // 8B DEC dp
+    &SPC700::op_modify<&SPC700::mod_dec, MODE_ABS>,             // 8C DEC !a
+    &SPC700::op_movY<MODE_IMM>,                                 // 8D MOV Y,#i
+    &SPC700::op_popPSW,                                         // 8E POP PSW
+    &SPC700::op_movDpImm,                                       // 8F MOV dp,#i
+    &SPC700::op_branch<FLAG_C, false>,                          // 90 BCC r
+    &SPC700::op_tcall<9>,                                       // 91 TCALL 9
+    &SPC700::op_clr1<4>,                                        // 92 CLR1 dp.4
+    &SPC700::op_bbc<4>,                                         // 93 BBC dp.4,r
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_DPX>,               // 94 ADC A,dp+X
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_ABSX>,              // 95 ADC A,!a+X
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_ABSY>,              // 96 ADC A,!a+Y
+    &SPC700::op_aluA<&SPC700::alu_adc, MODE_DP_IND_Y>,          // 97 ADC A,[dp]+Y
+    &SPC700::op_aluDpImm<&SPC700::alu_adc>,                     // 98 ADC dp,#i
+    &SPC700::op_aluXY<&SPC700::alu_adc>,                        // 99 ADC (X),(Y)
+    &SPC700::op_subw,                                           // 9A SUBW YA,dp
+    &SPC700::op_modify<&SPC700::mod_dec, MODE_DPX>,             // 9B DEC dp+X
+    &SPC700::op_modifyA<&SPC700::mod_dec>,                      // 9C DEC A
+    &SPC700::op_movXSP,                                         // 9D MOV X,SP
+    &SPC700::op_div,                                            // 9E DIV YA,X
+    &SPC700::op_xcn,                                            // 9F XCN A
+    &SPC700::op_setFlag<FLAG_I, true>,                          // A0 EI
+    &SPC700::op_tcall<10>,                                      // A1 TCALL 10
+    &SPC700::op_set1<5>,                                        // A2 SET1 dp.5
+    &SPC700::op_bbs<5>,                                         // A3 BBS dp.5,r
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_DP>,                // A4 SBC A,dp
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_ABS>,               // A5 SBC A,!a
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_INDX>,              // A6 SBC A,(X)
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_DPX_IND>,           // A7 SBC A,[dp+X]
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_IMM>,               // A8 SBC A,#i
+    &SPC700::op_aluDpDp<&SPC700::alu_sbc>,                      // A9 SBC dp,dp
+    &SPC700::op_mov1ToC,                                        // AA MOV1 C,m.b
+    &SPC700::op_modify<&SPC700::mod_inc, MODE_DP>,              // AB INC dp
+    &SPC700::op_modify<&SPC700::mod_inc, MODE_ABS>,             // AC INC !a
+    &SPC700::op_cmpY<MODE_IMM>,                                 // AD CMP Y,#i
+    &SPC700::op_popA,                                           // AE POP A
+    &SPC700::op_movIncXA,                                       // AF MOV (X)+,A
+    &SPC700::op_branch<FLAG_C, true>,                           // B0 BCS r
+    &SPC700::op_tcall<11>,                                      // B1 TCALL 11
+    &SPC700::op_clr1<5>,                                        // B2 CLR1 dp.5
+    &SPC700::op_bbc<5>,                                         // B3 BBC dp.5,r
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_DPX>,               // B4 SBC A,dp+X
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_ABSX>,              // B5 SBC A,!a+X
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_ABSY>,              // B6 SBC A,!a+Y
+    &SPC700::op_aluA<&SPC700::alu_sbc, MODE_DP_IND_Y>,          // B7 SBC A,[dp]+Y
+    &SPC700::op_aluDpImm<&SPC700::alu_sbc>,                     // B8 SBC dp,#i
+    &SPC700::op_aluXY<&SPC700::alu_sbc>,                        // B9 SBC (X),(Y)
+    &SPC700::op_movwYA,                                         // BA MOVW YA,dp
+    &SPC700::op_modify<&SPC700::mod_inc, MODE_DPX>,             // BB INC dp+X
+    &SPC700::op_modifyA<&SPC700::mod_inc>,                      // BC INC A
+    &SPC700::op_movSPX,                                         // BD MOV SP,X
+    &SPC700::op_das,                                            // BE DAS A
+    &SPC700::op_movAIncX,                                       // BF MOV A,(X)+
+    &SPC700::op_setFlag<FLAG_I, false>,                         // C0 DI
+    &SPC700::op_tcall<12>,                                      // C1 TCALL 12
+    &SPC700::op_set1<6>,                                        // C2 SET1 dp.6
+    &SPC700::op_bbs<6>,                                         // C3 BBS dp.6,r
+    &SPC700::op_storeA<MODE_DP>,                                // C4 MOV dp,A
+    &SPC700::op_storeA<MODE_ABS>,                               // C5 MOV !a,A
+    &SPC700::op_storeA<MODE_INDX>,                              // C6 MOV (X),A
+    &SPC700::op_storeA<MODE_DPX_IND>,                           // C7 MOV [dp+X],A
+    &SPC700::op_cmpX<MODE_IMM>,                                 // C8 CMP X,#i
+    &SPC700::op_storeX<MODE_ABS>,                               // C9 MOV !a,X
+    &SPC700::op_mov1FromC,                                      // CA MOV1 m.b,C
+    &SPC700::op_storeY<MODE_DP>,                                // CB MOV dp,Y
+    &SPC700::op_storeY<MODE_ABS>,                               // CC MOV !a,Y
+    &SPC700::op_movX<MODE_IMM>,                                 // CD MOV X,#i
+    &SPC700::op_popX,                                           // CE POP X
+    &SPC700::op_mul,                                            // CF MUL YA
+    &SPC700::op_branch<FLAG_Z, false>,                          // D0 BNE r
+    &SPC700::op_tcall<13>,                                      // D1 TCALL 13
+    &SPC700::op_clr1<6>,                                        // D2 CLR1 dp.6
+    &SPC700::op_bbc<6>,                                         // D3 BBC dp.6,r
+    &SPC700::op_storeA<MODE_DPX>,                               // D4 MOV dp+X,A
+    &SPC700::op_storeA<MODE_ABSX>,                              // D5 MOV !a+X,A
+    &SPC700::op_storeA<MODE_ABSY>,                              // D6 MOV !a+Y,A
+    &SPC700::op_storeA<MODE_DP_IND_Y>,                          // D7 MOV [dp]+Y,A
+    &SPC700::op_storeX<MODE_DP>,                                // D8 MOV dp,X
+    &SPC700::op_storeX<MODE_DPY>,                               // D9 MOV dp+Y,X
+    &SPC700::op_movwDp,                                         // DA MOVW dp,YA
+    &SPC700::op_storeY<MODE_DPX>,                               // DB MOV dp+X,Y
+    &SPC700::op_modifyY<&SPC700::mod_dec>,                      // DC DEC Y
+    &SPC700::op_movAY,                                          // DD MOV A,Y
+    &SPC700::op_cbneDpX,                                        // DE CBNE dp+X,r
+    &SPC700::op_daa,                                            // DF DAA A
+    &SPC700::op_clrv,                                           // E0 CLRV
+    &SPC700::op_tcall<14>,                                      // E1 TCALL 14
+    &SPC700::op_set1<7>,                                        // E2 SET1 dp.7
+    &SPC700::op_bbs<7>,                                         // E3 BBS dp.7,r
+    &SPC700::op_movA<MODE_DP>,                                  // E4 MOV A,dp
+    &SPC700::op_movA<MODE_ABS>,                                 // E5 MOV A,!a
+    &SPC700::op_movA<MODE_INDX>,                                // E6 MOV A,(X)
+    &SPC700::op_movA<MODE_DPX_IND>,                             // E7 MOV A,[dp+X]
+    &SPC700::op_movA<MODE_IMM>,                                 // E8 MOV A,#i
+    &SPC700::op_movX<MODE_ABS>,                                 // E9 MOV X,!a
+    &SPC700::op_not1,                                           // EA NOT1 m.b
+    &SPC700::op_movY<MODE_DP>,                                  // EB MOV Y,dp
+    &SPC700::op_movY<MODE_ABS>,                                 // EC MOV Y,!a
+    &SPC700::op_notc,                                           // ED NOTC
+    &SPC700::op_popY,                                           // EE POP Y
+    &SPC700::op_stop,                                           // EF SLEEP
+    &SPC700::op_branch<FLAG_Z, true>,                           // F0 BEQ r
+    &SPC700::op_tcall<15>,                                      // F1 TCALL 15
+    &SPC700::op_clr1<7>,                                        // F2 CLR1 dp.7
+    &SPC700::op_bbc<7>,                                         // F3 BBC dp.7,r
+    &SPC700::op_movA<MODE_DPX>,                                 // F4 MOV A,dp+X
+    &SPC700::op_movA<MODE_ABSX>,                                // F5 MOV A,!a+X
+    &SPC700::op_movA<MODE_ABSY>,                                // F6 MOV A,!a+Y
+    &SPC700::op_movA<MODE_DP_IND_Y>,                            // F7 MOV A,[dp]+Y
+    &SPC700::op_movX<MODE_DP>,                                  // F8 MOV X,dp
+    &SPC700::op_movX<MODE_DPY>,                                 // F9 MOV X,dp+Y
+    &SPC700::op_movDpDp,                                        // FA MOV dp,dp
+    &SPC700::op_movY<MODE_DPX>,                                 // FB MOV Y,dp+X
+    &SPC700::op_modifyY<&SPC700::mod_inc>,                      // FC INC Y
+    &SPC700::op_movYA,                                          // FD MOV Y,A
+    &SPC700::op_dbnzY,                                          // FE DBNZ Y,r
+    &SPC700::op_stop,                                           // FF STOP
+};
+
+// Base cycles; taken branches add 2
+const uint8 SPC700::CYCLES[256] = {
+    2, 8, 4, 5, 3, 4, 3, 6, 2, 6, 5, 4, 5, 4, 6, 8,     // 0x
+    2, 8, 4, 5, 4, 5, 5, 6, 5, 5, 6, 5, 2, 2, 4, 6,     // 1x
+    2, 8, 4, 5, 3, 4, 3, 6, 2, 6, 5, 4, 5, 4, 5, 4,     // 2x
+    2, 8, 4, 5, 4, 5, 5, 6, 5, 5, 6, 5, 2, 2, 3, 8,     // 3x
+    2, 8, 4, 5, 3, 4, 3, 6, 2, 6, 4, 4, 5, 4, 6, 6,     // 4x
+    2, 8, 4, 5, 4, 5, 5, 6, 5, 5, 4, 5, 2, 2, 4, 3,     // 5x
+    2, 8, 4, 5, 3, 4, 3, 6, 2, 6, 4, 4, 5, 4, 5, 5,     // 6x
+    2, 8, 4, 5, 4, 5, 5, 6, 5, 5, 5, 5, 2, 2, 3, 6,     // 7x
+    2, 8, 4, 5, 3, 4, 3, 6, 2, 6, 5, 4, 5, 2, 4, 5,     // 8x
+    2, 8, 4, 5, 4, 5, 5, 6, 5, 5, 5, 5, 2, 2, 12, 5,    // 9x
+    3, 8, 4, 5, 3, 4, 3, 6, 2, 6, 4, 4, 5, 2, 4, 4,     // Ax
+    2, 8, 4, 5, 4, 5, 5, 6, 5, 5, 5, 5, 2, 2, 3, 4,     // Bx
+    3, 8, 4, 5, 4, 5, 4, 7, 2, 5, 6, 4, 5, 2, 4, 9,     // Cx
+    2, 8, 4, 5, 5, 6, 6, 7, 4, 5, 5, 5, 2, 2, 6, 3,     // Dx
+    2, 8, 4, 5, 3, 4, 3, 6, 2, 4, 5, 3, 4, 3, 4, 3,     // Ex
+    2, 8, 4, 5, 4, 5, 5, 6, 3, 4, 5, 4, 2, 2, 4, 3      // Fx
+};
@@ -0,0 +1,315 @@
+//
+//  SPC700.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef SPC700_HPP
+#define SPC700_HPP
+
+#include "../Types/Types.hpp"
+#include <vector>
+
+class DSP;
+
+// SPC700 sound CPU with its 64KB of audio RAM, IPL ROM, timers and the
+// $F0-$FF control registers
+// Opcodes go through a 256-entry table of handlers and base cycle counts.
+// ARAM is one flat array: reads only check for the I/O page, because the
+// IPL ROM is swapped into $FFC0-$FFFF while it is mapped (the RAM under
+// it is kept aside). Timers are brought up to date from the cycle count
+// only when they are read or reprogrammed.
+// $F2/$F3 reach the DSP, which is run up to the current cycle first.
+// Otherwise the DSP is run a chunk at a time, after the instruction that
+// crosses a chunk boundary, so how run() calls are split does not change
+// what it sees.
+class SPC700 {
+public:
+    // PSW flags
+    enum Flag: uint8 {
+        FLAG_C = 0x01,                  // Carry
+        FLAG_Z = 0x02,                  // Zero
+        FLAG_I = 0x04,                  // Interrupt enable (unused on the SNES)
+        FLAG_H = 0x08,                  // Half carry
+        FLAG_B = 0x10,                  // Break
+        FLAG_P = 0x20,                  // Direct page at $0100
+        FLAG_V = 0x40,                  // Overflow
+        FLAG_N = 0x80                   // Negative
+    };
+
+    struct Registers {
+        uint8  A;
+        uint8  X;
+        uint8  Y;
+        uint8  SP;                      // Stack at $0100 + SP
+        uint16 PC;
+        uint8  PSW;
+    } registers;
+
+    // Cycles run since reset (1.024 MHz)
+    uint64 totalCycles;
+
+    SPC700();
+
+    void reset();
+
+    // Execute one instruction; returns the cycles it took
+    int executeInstruction();
+
+    // Run for cycles; an instruction that overshoots is paid back on the next call
+    void run(int cycles);
+
+    // Cycle run() has been asked to reach: every instruction that starts
+    // before it has been executed
+    uint64 getTargetCycle() const { return totalCycles + cycleBalance; }
+
+    // Attach the S-DSP ($F2/$F3); it is reset along with the SPC700
+    void setDSP(DSP* sound);
+
+    // S-CPU side of the four ports ($2140-$2143)
+    uint8 readPort(int port) const { return outputPorts[port & 0x03]; }
+    void writePort(int port, uint8 value) { inputPorts[port & 0x03] = value; }
+
+    // A write to $F4-$F7, stamped with the cycle its instruction started at
+    struct PortWrite {
+        uint64 cycle;
+        uint8 port;
+        uint8 value;
+    };
+
+    // When set, every write to $F4-$F7 is appended to log
+    void setPortLog(std::vector<PortWrite>* log);
+
+    // Bus access as the SPC700 sees it
+    uint8 read(uint16 address) {
+        if ((address & 0xFFF0) == 0x00F0) {
+            return readIO(address);
+        }
+        return aram[address];
+    }
+    void write(uint16 address, uint8 value);
+
+    // Audio RAM (while the IPL ROM is mapped, $FFC0-$FFFF holds the ROM)
+    // Writes made through this pointer are not seen by the DSP's BRR cache.
+    uint8* getRAM() { return aram.data(); }
+
+    // RAM write that skips the I/O registers (DSP echo buffer writes)
+    void writeRAM(uint16 address, uint8 value) {
+        if (address >= IPL_BASE && iplMapped) {
+            iplShadow[address - IPL_BASE] = value;
+        } else {
+            aram[address] = value;
+        }
+        ramWrites[address >> RAM_CHUNK_SHIFT]++;
+    }
+
+    // Write counts per 64-byte chunk of ARAM (chunk n = bytes n * 64 onwards)
+    static const int RAM_CHUNK_SHIFT = 6;
+    const uint32* getRAMWrites() const { return ramWrites; }
+
+    bool isStopped() const { return stopped; }
+
+private:
+    static const uint8 IPL_ROM[64];
+    static const uint16 IPL_BASE = 0xFFC0;
+
+    std::vector<uint8> aram;
+    uint8 iplShadow[64];                // RAM under the IPL ROM while it is mapped
+    bool iplMapped;
+
+    uint8 inputPorts[4];                // Written by the S-CPU, read at $F4-$F7
+    uint8 outputPorts[4];               // Written at $F4-$F7, read by the S-CPU
+    std::vector<PortWrite>* portLog;
+    uint32 ramWrites[0x10000 >> RAM_CHUNK_SHIFT];
+    DSP* dsp;
+    uint8 dspAddress;
+    uint64 dspSync;                     // Cycle the DSP is next run up to a chunk boundary at
+    bool stopped;                       // SLEEP/STOP
+    int32 cycleBalance;                 // Cycles run() still owes (negative after an overshoot)
+
+    // Timers 0/1 tick at 8 kHz, timer 2 at 64 kHz
+    struct Timer {
+        uint32 period;                  // SPC700 cycles per tick
+        bool enabled;
+        uint8 target;                   // 0 = 256
+        uint8 stage;                    // Ticks towards target
+        uint8 counter;                  // 4-bit output, cleared when read
+        uint64 updated;                 // totalCycles it was brought up to
+    };
+    Timer timers[3];
+
+    uint8 readIO(uint16 address);
+    void writeIO(uint16 address, uint8 value);
+    void updateTimer(Timer& timer);
+    void mapIPL(bool mapped);
+    void syncDSP();
+
+    // Handler table
+    typedef void (SPC700::*Handler)();
+    static const Handler HANDLERS[256];
+    static const uint8 CYCLES[256];
+    int extraCycles;                    // Taken branches and the like
+
+    // Operand addressing
+    enum Mode {
+        MODE_IMM,                       // #i
+        MODE_DP,                        // dp
+        MODE_DPX,                       // dp+X
+        MODE_DPY,                       // dp+Y
+        MODE_ABS,                       // !a
+        MODE_ABSX,                      // !a+X
+        MODE_ABSY,                      // !a+Y
+        MODE_INDX,                      // (X)
+        MODE_DPX_IND,                   // [dp+X]
+        MODE_DP_IND_Y                   // [dp]+Y
+    };
+
+    uint8 fetch() { return read(registers.PC++); }
+    uint16 fetchWord() {
+        uint8 low = fetch();
+        return low | (fetch() << 8);
+    }
+    uint16 page() const { return (registers.PSW & FLAG_P) ? 0x0100 : 0x0000; }
+    uint16 dp(uint8 offset) const { return page() | offset; }
+    uint16 readWord(uint16 address) { return read(address) | (read(address + 1) << 8); }
+    // Direct page words wrap inside the page
+    uint16 readDPWord(uint8 offset) { return read(dp(offset)) | (read(dp(offset + 1)) << 8); }
+    // m.b operands: 13-bit address with the bit number in the top 3 bits
+    uint16 fetchMemoryBit(int& bit) {
+        uint16 value = fetchWord();
+        bit = value >> 13;
+        return value & 0x1FFF;
+    }
+    template <int mode> uint16 address();
+    template <int mode> uint8 operand() { return read(address<mode>()); }
+
+    void push(uint8 value) { write(0x0100 | registers.SP--, value); }
+    uint8 pop() { return read(0x0100 | ++registers.SP); }
+    void pushWord(uint16 value) {
+        push(value >> 8);
+        push(value & 0xFF);
+    }
+    uint16 popWord() {
+        uint8 low = pop();
+        return low | (pop() << 8);
+    }
+
+    void setFlag(uint8 flag, bool value) {
+        registers.PSW = value ? (registers.PSW | flag) : (registers.PSW & ~flag);
+    }
+    void setNZ(uint8 value) {
+        registers.PSW = (registers.PSW & ~(FLAG_N | FLAG_Z)) | (value & FLAG_N) | (value ? 0 : FLAG_Z);
+    }
+    void setNZ16(uint16 value) {
+        registers.PSW = (registers.PSW & ~(FLAG_N | FLAG_Z)) | ((value >> 8) & FLAG_N) | (value ? 0 : FLAG_Z);
+    }
+    uint16 getYA() const { return (registers.Y << 8) | registers.A; }
+    void setYA(uint16 value) {
+        registers.A = value & 0xFF;
+        registers.Y = value >> 8;
+    }
+
+    // ALU operations: first operand, second operand -> result (CMP returns the first)
+    typedef uint8 (SPC700::*AluOp)(uint8, uint8);
+    uint8 alu_or(uint8 a, uint8 b);
+    uint8 alu_and(uint8 a, uint8 b);
+    uint8 alu_eor(uint8 a, uint8 b);
+    uint8 alu_cmp(uint8 a, uint8 b);
+    uint8 alu_adc(uint8 a, uint8 b);
+    uint8 alu_sbc(uint8 a, uint8 b);
+
+    // Read-modify-write operations
+    typedef uint8 (SPC700::*ModifyOp)(uint8);
+    uint8 mod_asl(uint8 value);
+    uint8 mod_rol(uint8 value);
+    uint8 mod_lsr(uint8 value);
+    uint8 mod_ror(uint8 value);
+    uint8 mod_inc(uint8 value);
+    uint8 mod_dec(uint8 value);
+
+    void branch(bool condition);
+
+    // Handlers
+    template <AluOp op, int mode> void op_aluA();
+    template <AluOp op> void op_aluDpDp();
+    template <AluOp op> void op_aluDpImm();
+    template <AluOp op> void op_aluXY();
+    template <int mode> void op_cmpX();
+    template <int mode> void op_cmpY();
+    template <ModifyOp op, int mode> void op_modify();
+    template <ModifyOp op> void op_modifyA();
+    template <ModifyOp op> void op_modifyX();
+    template <ModifyOp op> void op_modifyY();
+    template <int mode> void op_movA();
+    template <int mode> void op_movX();
+    template <int mode> void op_movY();
+    template <int mode> void op_storeA();
+    template <int mode> void op_storeX();
+    template <int mode> void op_storeY();
+    template <int bit> void op_set1();
+    template <int bit> void op_clr1();
+    template <int bit> void op_bbs();
+    template <int bit> void op_bbc();
+    template <int vector> void op_tcall();
+    template <uint8 flag, bool set> void op_branch();
+    template <uint8 flag, bool set> void op_setFlag();
+
+    void op_nop();
+    void op_bra();
+    void op_movDpDp();
+    void op_movDpImm();
+    void op_movAX();
+    void op_movAY();
+    void op_movXA();
+    void op_movYA();
+    void op_movXSP();
+    void op_movSPX();
+    void op_movIncXA();
+    void op_movAIncX();
+    void op_movwYA();
+    void op_movwDp();
+    void op_incw();
+    void op_decw();
+    void op_addw();
+    void op_subw();
+    void op_cmpw();
+    void op_mul();
+    void op_div();
+    void op_daa();
+    void op_das();
+    void op_xcn();
+    void op_notc();
+    void op_clrv();
+    void op_tset1();
+    void op_tclr1();
+    void op_or1();
+    void op_or1Not();
+    void op_and1();
+    void op_and1Not();
+    void op_eor1();
+    void op_not1();
+    void op_mov1ToC();
+    void op_mov1FromC();
+    void op_cbneDp();
+    void op_cbneDpX();
+    void op_dbnzDp();
+    void op_dbnzY();
+    void op_pushA();
+    void op_pushX();
+    void op_pushY();
+    void op_pushPSW();
+    void op_popA();
+    void op_popX();
+    void op_popY();
+    void op_popPSW();
+    void op_call();
+    void op_pcall();
+    void op_ret();
+    void op_reti();
+    void op_brk();
+    void op_jmp();
+    void op_jmpIndirect();
+    void op_stop();
+};
+#endif
@@ -0,0 +1,124 @@
+//
+//  VoiceMixer.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "VoiceMixer.hpp"
+#include "../PPU/TileDecoder.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VOICEMIXER_X86 1
+#endif
+
+namespace {
+    inline int clamp16(int value) {
+        return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+    }
+}
+
+void VoiceMixer::interpolate(const int16 taps[4][VOICES], const int16 coeffs[4][VOICES], int16* out) {
+#ifdef VOICEMIXER_X86
+    if (TileDecoder::getLevel() >= TileDecoder::LEVEL_SSE2) {
+        interpolateSSE2(taps, coeffs, out);
+        return;
+    }
+#endif
+    interpolateScalar(taps, coeffs, out);
+}
+
+void VoiceMixer::applyVolume(const int16* samples, const int16* envelope,
+                             const int16* volumeLeft, const int16* volumeRight,
+                             int16* out, int16* left, int16* right) {
+#ifdef VOICEMIXER_X86
+    if (TileDecoder::getLevel() >= TileDecoder::LEVEL_SSE2) {
+        applyVolumeSSE2(samples, envelope, volumeLeft, volumeRight, out, left, right);
+        return;
+    }
+#endif
+    applyVolumeScalar(samples, envelope, volumeLeft, volumeRight, out, left, right);
+}
+
+void VoiceMixer::interpolateScalar(const int16 taps[4][VOICES], const int16 coeffs[4][VOICES], int16* out) {
+    for (int v = 0; v < VOICES; ++v) {
+        int sum = (coeffs[0][v] * taps[0][v]) >> 11;
+        sum += (coeffs[1][v] * taps[1][v]) >> 11;
+        sum += (coeffs[2][v] * taps[2][v]) >> 11;
+        sum = static_cast<int16>(sum);
+        sum += (coeffs[3][v] * taps[3][v]) >> 11;
+        out[v] = static_cast<int16>(clamp16(sum) & ~1);
+    }
+}
+
+void VoiceMixer::applyVolumeScalar(const int16* samples, const int16* envelope,
+                                   const int16* volumeLeft, const int16* volumeRight,
+                                   int16* out, int16* left, int16* right) {
+    for (int v = 0; v < VOICES; ++v) {
+        int value = ((samples[v] * envelope[v]) >> 11) & ~1;
+        out[v] = static_cast<int16>(value);
+        left[v] = static_cast<int16>((value * volumeLeft[v]) >> 7);
+        right[v] = static_cast<int16>((value * volumeRight[v]) >> 7);
+    }
+}
+
+#ifdef VOICEMIXER_X86
+
+namespace {
+    // 32-bit products of 8 signed 16-bit lanes, arithmetic-shifted right
+    __attribute__((target("sse2")))
+    inline void multiplyShiftSSE2(__m128i a, __m128i b, int shift, __m128i& low, __m128i& high) {
+        __m128i productLow = _mm_mullo_epi16(a, b);
+        __m128i productHigh = _mm_mulhi_epi16(a, b);
+        low = _mm_sra_epi32(_mm_unpacklo_epi16(productLow, productHigh), _mm_cvtsi32_si128(shift));
+        high = _mm_sra_epi32(_mm_unpackhi_epi16(productLow, productHigh), _mm_cvtsi32_si128(shift));
+    }
+
+    // Sign-extend the low 16 bits of each 32-bit lane
+    __attribute__((target("sse2")))
+    inline __m128i wrap16SSE2(__m128i value) {
+        return _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+    }
+}
+
+__attribute__((target("sse2")))
+void VoiceMixer::interpolateSSE2(const int16 taps[4][VOICES], const int16 coeffs[4][VOICES], int16* out) {
+    __m128i sumLow = _mm_setzero_si128();
+    __m128i sumHigh = _mm_setzero_si128();
+    for (int n = 0; n < 4; ++n) {
+        if (n == 3) {
+            sumLow = wrap16SSE2(sumLow);
+            sumHigh = wrap16SSE2(sumHigh);
+        }
+        __m128i tap = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[n]));
+        __m128i coeff = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coeffs[n]));
+        __m128i low, high;
+        multiplyShiftSSE2(tap, coeff, 11, low, high);
+        sumLow = _mm_add_epi32(sumLow, low);
+        sumHigh = _mm_add_epi32(sumHigh, high);
+    }
+    // packs clamps to 16 bits
+    __m128i result = _mm_and_si128(_mm_packs_epi32(sumLow, sumHigh), _mm_set1_epi16(static_cast<short>(0xFFFE)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+}
+
+__attribute__((target("sse2")))
+void VoiceMixer::applyVolumeSSE2(const int16* samples, const int16* envelope,
+                                 const int16* volumeLeft, const int16* volumeRight,
+                                 int16* out, int16* left, int16* right) {
+    __m128i sample = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+    __m128i env = _mm_loadu_si128(reinterpret_cast<const __m128i*>(envelope));
+    __m128i low, high;
+    multiplyShiftSSE2(sample, env, 11, low, high);
+    // Envelopes are at most 0x7FF, so the products fit in 16 bits again
+    __m128i value = _mm_and_si128(_mm_packs_epi32(low, high), _mm_set1_epi16(static_cast<short>(0xFFFE)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), value);
+
+    multiplyShiftSSE2(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(volumeLeft)), 7, low, high);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(left), _mm_packs_epi32(low, high));
+    multiplyShiftSSE2(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(volumeRight)), 7, low, high);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(right), _mm_packs_epi32(low, high));
+}
+
+#endif
@@ -0,0 +1,47 @@
+//
+//  VoiceMixer.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef VOICEMIXER_HPP
+#define VOICEMIXER_HPP
+
+#include "../Types/Types.hpp"
+
+// Per-sample voice kernels
+// The DSP gathers one sample's inputs for all 8 voices side by side (one
+// array per tap or parameter), so each step is a single 8-lane operation.
+// Results match the hardware's truncation, wrapping and clamping exactly.
+// The kernel level follows TileDecoder::getLevel(); 8 voices fill one
+// SSE2 register, so AVX2 uses the SSE2 kernels.
+class VoiceMixer {
+public:
+    static const int VOICES = 8;
+
+    // 4-tap Gaussian interpolation:
+    // out[v] = sum of (taps[n][v] * coeffs[n][v]) >> 11, wrapped to 16 bits
+    // after the first three taps, clamped after the fourth, bit 0 cleared.
+    // taps[0] is the oldest sample.
+    static void interpolate(const int16 taps[4][VOICES], const int16 coeffs[4][VOICES], int16* out);
+
+    // Envelope and volume:
+    // out[v] = (samples[v] * envelope[v]) >> 11 with bit 0 cleared,
+    // left[v] / right[v] = (out[v] * volume[v]) >> 7
+    static void applyVolume(const int16* samples, const int16* envelope,
+                            const int16* volumeLeft, const int16* volumeRight,
+                            int16* out, int16* left, int16* right);
+
+    static void interpolateScalar(const int16 taps[4][VOICES], const int16 coeffs[4][VOICES], int16* out);
+    static void applyVolumeScalar(const int16* samples, const int16* envelope,
+                                  const int16* volumeLeft, const int16* volumeRight,
+                                  int16* out, int16* left, int16* right);
+#if defined(__x86_64__) || defined(__i386__)
+    static void interpolateSSE2(const int16 taps[4][VOICES], const int16 coeffs[4][VOICES], int16* out);
+    static void applyVolumeSSE2(const int16* samples, const int16* envelope,
+                                const int16* volumeLeft, const int16* volumeRight,
+                                int16* out, int16* left, int16* right);
+#endif
+};
+#endif
@@ -7,8 +7,9 @@
 
 #include "CPU65c816.hpp"
 #include "../Memory/Memory.hpp"
+#include "../Types/Timing.hpp"
 
-CPU65c816::CPU65c816(): memory(nullptr), totalCycles(0) {
+CPU65c816::CPU65c816(): totalCycles(0), memory(nullptr), nmiPending(false), irqLine(false), waiting(false), runTarget(0), codePage(nullptr), codePageBase(0xFFFFFFFF), codePageGeneration(0), lowRAM(nullptr) {
     reset();
 }
 
@@ -27,10 +28,18 @@ void CPU65c816::reset() {
     // For now, we'll set it to 0x8000 at a placeholder
     registers.PC = 0x8000;
     totalCycles = 0;
+    nmiPending = false;
+    irqLine = false;
+    waiting = false;
+    codePage = nullptr;
+    codePageBase = 0xFFFFFFFF;
 }
 
 void CPU65c816::setMemory(Memory* mem) {
     memory = mem;
+    lowRAM = mem ? mem->getLowRAM() : nullptr;
+    codePage = nullptr;
+    codePageBase = 0xFFFFFFFF;
 }
 
 bool CPU65c816::getFlag(StatusFlag flag) const {
@@ -47,7 +56,11 @@ void CPU65c816::setFlag(StatusFlag flag, bool value) {
 
 // Memory access functions
 uint8 CPU65c816::read8(uint32 address) {
-    // TODO: Implement with actual memory interface
+    // Bank $00 low WRAM: the stack, direct page operands and indirect
+    // pointers almost always land here, so skip the mapping code entirely
+    if (address < LOW_RAM_SIZE && lowRAM) {
+        return lowRAM[address];
+    }
     if (memory) {
         return memory->read(address);
     }
@@ -62,6 +75,10 @@ uint16 CPU65c816::read16(uint32 address) {
 }
 
 void CPU65c816::write8(uint32 address, uint8 value) {
+    if (address < LOW_RAM_SIZE && lowRAM) {
+        lowRAM[address] = value;
+        return;
+    }
     if (memory) {
         memory->write(address, value);
     }
@@ -74,9 +91,25 @@ void CPU65c816::write16(uint32 address, uint16 value) {
 }
 
 // Fetch operations
+void CPU65c816::refreshCodePage(uint32 address) {
+    codePageBase = address & 0xFFFF00;
+    if (memory) {
+        codePage = memory->getPagePointer(codePageBase);
+        codePageGeneration = memory->getMappingGeneration();
+    } else {
+        codePage = nullptr;
+    }
+}
+
 uint8 CPU65c816::fetchByte() {
     uint32 address = (static_cast<uint32>(registers.PBR) << 16) | registers.PC;
-    uint8 value = read8(address);
+    // Sequential fetches stay inside the cached page; jumps, bank changes,
+    // page crossings and ROM reloads all show up as a base/generation mismatch
+    if ((address & 0xFFFF00) != codePageBase ||
+        (memory && memory->getMappingGeneration() != codePageGeneration)) {
+        refreshCodePage(address);
+    }
+    uint8 value = codePage ? codePage[address & 0xFF] : read8(address);
     registers.PC++;
     return value;
 }
@@ -128,12 +161,83 @@ void CPU65c816::updateNZ16(uint16 value) {
 }
 
 int CPU65c816::executeInstruction() {
+    if (nmiPending || irqLine || waiting) {
+        bool wasWaiting = waiting;
+        int cycles = serviceInterrupt();
+        if (cycles > 0) {
+            if (wasWaiting && memory) {
+                // A DMA while waiting only ate into the wait
+                memory->consumeStallCycles();
+            }
+            totalCycles += cycles;
+            return cycles;
+        }
+    }
     uint8 opcode = fetchByte();
     int cycles = decodeAndExecute(opcode);
+    if (memory) {
+        // DMA started by this instruction halts the CPU until it finishes
+        uint32 stall = memory->consumeStallCycles();
+        cycles += (stall + MASTER_CYCLES_PER_CPU_CYCLE - 1) / MASTER_CYCLES_PER_CPU_CYCLE;
+    }
     totalCycles += cycles;
     return cycles;
 }
 
+void CPU65c816::run(uint64 cycles) {
+    runTarget = cycles;
+    while (totalCycles < runTarget) {
+        if (waiting && !nmiPending && !irqLine) {
+            // Nothing can wake it before then, and any DMA stall so far
+            // is spent waiting rather than charged to the next instruction
+            if (memory) {
+                memory->consumeStallCycles();
+            }
+            totalCycles = runTarget;
+            break;
+        }
+        executeInstruction();
+    }
+    runTarget = 0;
+}
+
+// Cycles spent on an interrupt or waiting, or 0 to run the next instruction
+int CPU65c816::serviceInterrupt() {
+    if (nmiPending) {
+        nmiPending = false;
+        waiting = false;
+        interrupt(0xFFEA, 0xFFFA);
+        return registers.E ? 7 : 8;
+    }
+    if (irqLine) {
+        // IRQ ends WAI even when masked; execution then just carries on
+        waiting = false;
+        if (!getFlag(FLAG_IRQ_DISABLE)) {
+            interrupt(0xFFEE, 0xFFFE);
+            return registers.E ? 7 : 8;
+        }
+        return 0;
+    }
+    return waiting ? 1 : 0;
+}
+
+void CPU65c816::interrupt(uint16 nativeVector, uint16 emulationVector) {
+    // Like BRK, but the return address is the next instruction and, in
+    // emulation mode, the pushed B flag is clear
+    if (registers.E) {
+        push16(registers.PC);
+        push8(registers.P & ~0x10);
+    } else {
+        push8(registers.PBR);
+        push16(registers.PC);
+        push8(registers.P);
+    }
+    setFlag(FLAG_IRQ_DISABLE, true);
+    setFlag(FLAG_DECIMAL, false);
+    registers.PC = read16(registers.E ? emulationVector : nativeVector);
+    registers.PBR = 0;
+}
+
 int CPU65c816::decodeAndExecute(uint8 opcode) {
     // This is where we'll decode opcode and execute instructions
     // For now, just a skeleton with a few basic instructions
@@ -2202,13 +2306,7 @@ void CPU65c816::op_STP() {
 
 void CPU65c816::op_WAI() {
     // WAI - Wait for Interrupt
-    // Stops execution until an interrupt occurs (IRQ or NMI)
-    // For emulator purposes, similar to STP but waits for interrupt
-    
-    // For now, implement as a simple wait
-    // In real implementation, this would wait for interrupt signal
-    registers.PC -= 1;  // Stay at WAI instruction
-    
-    // A proper implementation would check for pending interrupts
-    // before each instruction and resume when one occurs
+    // Stops execution until an interrupt occurs (IRQ or NMI); the
+    // interrupt then returns to the instruction after WAI
+    waiting = true;
 }
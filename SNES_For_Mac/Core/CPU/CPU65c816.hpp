@@ -50,10 +50,26 @@ public:
     // Reset the CPU to initial state
     void reset();
     
-    // Execute one instruction
+    // Execute one instruction (or take a pending interrupt)
     // Returns number of cycles taken
     int executeInstruction();
     
+    // Execute until totalCycles reaches cycles; the last instruction may
+    // run past it. Nothing outside the CPU is checked in between, so the
+    // caller stops it at the next point something else has to happen.
+    void run(uint64 cycles);
+    
+    // Bring the end of the current run() forward (when an I/O write makes
+    // something happen sooner)
+    void limitRun(uint64 cycles) { runTarget = cycles < runTarget ? cycles : runTarget; }
+    
+    // Interrupt inputs: NMI is an edge, taken before the next instruction;
+    // IRQ is a level, taken while asserted and the I flag is clear.
+    // Either one ends WAI.
+    void setNMI() { nmiPending = true; }
+    void setIRQ(bool asserted) { irqLine = asserted; }
+    bool isWaiting() const { return waiting; }
+    
     // Set memory interface
     void setMemory(Memory* mem);
     
@@ -73,6 +89,25 @@ public:
 private:
     Memory* memory;
     
+    bool nmiPending;
+    bool irqLine;
+    bool waiting;                       // Stopped by WAI until an interrupt
+    uint64 runTarget;
+    int serviceInterrupt();
+    void interrupt(uint16 nativeVector, uint16 emulationVector);
+    
+    // Cached host pointer to the page the PC is executing from
+    // Rebuilt when PBR:PC leaves the page or the memory mapping changes
+    const uint8* codePage;              // nullptr = page must go through read8()
+    uint32 codePageBase;                // 24-bit address of the cached page
+    uint32 codePageGeneration;          // Memory mapping generation it was built for
+    void refreshCodePage(uint32 address);
+    
+    // Bank $00 low WRAM ($0000-$1FFF), used to bypass Memory for the
+    // stack and direct page when they point there
+    uint8* lowRAM;
+    static const uint32 LOW_RAM_SIZE = 0x2000;
+    
     // Memory access functions
     uint8 read8(uint32 address);
     uint16 read16(uint32 address);
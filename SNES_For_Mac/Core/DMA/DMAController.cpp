@@ -0,0 +1,349 @@
+//
+//  DMAController.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "DMAController.hpp"
+#include "../Memory/Memory.hpp"
+#include "../Types/Timing.hpp"
+#include <algorithm>
+#include <cstring>
+
+const uint8 DMAController::TRANSFER_PATTERN[8][4] = {
+    { 0, 0, 0, 0 },         // 0: 1 register, write once
+    { 0, 1, 0, 1 },         // 1: 2 registers, write once each
+    { 0, 0, 0, 0 },         // 2: 1 register, write twice
+    { 0, 0, 1, 1 },         // 3: 2 registers, write twice each
+    { 0, 1, 2, 3 },         // 4: 4 registers, write once each
+    { 0, 1, 0, 1 },         // 5: 2 registers, write twice alternating
+    { 0, 0, 0, 0 },         // 6: same as mode 2
+    { 0, 0, 1, 1 }          // 7: same as mode 3
+};
+
+const uint8 DMAController::TRANSFER_LENGTH[8] = { 1, 2, 2, 4, 4, 4, 2, 4 };
+
+DMAController::DMAController(): memory(nullptr) {
+    buffer.resize(0x10000);
+    reset();
+}
+
+void DMAController::reset() {
+    // Channel registers power up as $FF
+    for (Channel& channel : channels) {
+        channel.control = 0xFF;
+        channel.bAddress = 0xFF;
+        channel.aAddress = 0xFFFF;
+        channel.aBank = 0xFF;
+        channel.byteCount = 0xFFFF;
+        channel.indirectBank = 0xFF;
+        channel.tableAddress = 0xFFFF;
+        channel.lineCounter = 0xFF;
+        channel.unused = 0xFF;
+    }
+    hdmaEnable = 0;
+    hdmaActive = 0;
+    hdmaWrites.clear();
+    std::fill(hdmaLineStart, hdmaLineStart + HDMA_MAX_LINES + 1, 0);
+    std::fill(&hdmaLineCycles[0][0], &hdmaLineCycles[0][0] + 8 * HDMA_MAX_LINES, 0);
+}
+
+void DMAController::saveState(State& saved) const {
+    std::copy(channels, channels + 8, saved.channels);
+    saved.hdmaEnable = hdmaEnable;
+    saved.hdmaActive = hdmaActive;
+    saved.hdmaWrites = hdmaWrites;
+    std::copy(hdmaLineStart, hdmaLineStart + HDMA_MAX_LINES + 1, saved.hdmaLineStart);
+    std::copy(&hdmaLineCycles[0][0], &hdmaLineCycles[0][0] + 8 * HDMA_MAX_LINES, &saved.hdmaLineCycles[0][0]);
+}
+
+void DMAController::loadState(const State& saved) {
+    std::copy(saved.channels, saved.channels + 8, channels);
+    hdmaEnable = saved.hdmaEnable;
+    hdmaActive = saved.hdmaActive;
+    hdmaWrites = saved.hdmaWrites;
+    std::copy(saved.hdmaLineStart, saved.hdmaLineStart + HDMA_MAX_LINES + 1, hdmaLineStart);
+    std::copy(&saved.hdmaLineCycles[0][0], &saved.hdmaLineCycles[0][0] + 8 * HDMA_MAX_LINES, &hdmaLineCycles[0][0]);
+}
+
+void DMAController::setMemory(Memory* mem) {
+    memory = mem;
+}
+
+uint8 DMAController::readRegister(uint16 offset) {
+    Channel& channel = channels[(offset >> 4) & 0x07];
+    switch (offset & 0x0F) {
+        case 0x0: return channel.control;
+        case 0x1: return channel.bAddress;
+        case 0x2: return channel.aAddress & 0xFF;
+        case 0x3: return channel.aAddress >> 8;
+        case 0x4: return channel.aBank;
+        case 0x5: return channel.byteCount & 0xFF;
+        case 0x6: return channel.byteCount >> 8;
+        case 0x7: return channel.indirectBank;
+        case 0x8: return channel.tableAddress & 0xFF;
+        case 0x9: return channel.tableAddress >> 8;
+        case 0xA: return channel.lineCounter;
+        case 0xB:
+        case 0xF: return channel.unused;
+        default:  return 0xFF;          // Open bus
+    }
+}
+
+void DMAController::writeRegister(uint16 offset, uint8 value) {
+    Channel& channel = channels[(offset >> 4) & 0x07];
+    switch (offset & 0x0F) {
+        case 0x0: channel.control = value; break;
+        case 0x1: channel.bAddress = value; break;
+        case 0x2: channel.aAddress = (channel.aAddress & 0xFF00) | value; break;
+        case 0x3: channel.aAddress = (channel.aAddress & 0x00FF) | (value << 8); break;
+        case 0x4: channel.aBank = value; break;
+        case 0x5: channel.byteCount = (channel.byteCount & 0xFF00) | value; break;
+        case 0x6: channel.byteCount = (channel.byteCount & 0x00FF) | (value << 8); break;
+        case 0x7: channel.indirectBank = value; break;
+        case 0x8: channel.tableAddress = (channel.tableAddress & 0xFF00) | value; break;
+        case 0x9: channel.tableAddress = (channel.tableAddress & 0x00FF) | (value << 8); break;
+        case 0xA: channel.lineCounter = value; break;
+        case 0xB:
+        case 0xF: channel.unused = value; break;
+        default: break;
+    }
+}
+
+uint32 DMAController::runGeneralDMA(uint8 mask) {
+    if (!memory || mask == 0) {
+        return 0;
+    }
+    uint32 cycles = DMA_CYCLES_SETUP;
+    // Channels run in order 0-7, one after another
+    for (int i = 0; i < 8; ++i) {
+        if (mask & (1 << i)) {
+            cycles += transferChannel(channels[i]);
+        }
+    }
+    return cycles;
+}
+
+uint32 DMAController::transferChannel(Channel& channel) {
+    uint32 count = channel.byteCount ? channel.byteCount : 0x10000;
+    uint8 mode = channel.control & 0x07;
+    bool fixed = (channel.control & 0x08) != 0;
+    bool decrement = (channel.control & 0x10) != 0;
+
+    if ((channel.control & 0x80) == 0) {
+        // A-bus -> B-bus
+        if (fixed) {
+            uint8 value = readABus((static_cast<uint32>(channel.aBank) << 16) | channel.aAddress);
+            memory->fillBBusBlock(channel.bAddress, mode, value, count);
+        } else if (!decrement) {
+            gatherABus(channel.aBank, channel.aAddress, buffer.data(), count);
+            memory->writeBBusBlock(channel.bAddress, mode, buffer.data(), count);
+        } else {
+            uint16 address = channel.aAddress;
+            for (uint32 i = 0; i < count; ++i) {
+                buffer[i] = readABus((static_cast<uint32>(channel.aBank) << 16) | address--);
+            }
+            memory->writeBBusBlock(channel.bAddress, mode, buffer.data(), count);
+        }
+    } else {
+        // B-bus -> A-bus
+        memory->readBBusBlock(channel.bAddress, mode, buffer.data(), count);
+        if (fixed) {
+            uint32 address = (static_cast<uint32>(channel.aBank) << 16) | channel.aAddress;
+            for (uint32 i = 0; i < count; ++i) {
+                writeABus(address, buffer[i]);
+            }
+        } else if (!decrement) {
+            scatterABus(channel.aBank, channel.aAddress, buffer.data(), count);
+        } else {
+            uint16 address = channel.aAddress;
+            for (uint32 i = 0; i < count; ++i) {
+                writeABus((static_cast<uint32>(channel.aBank) << 16) | address--, buffer[i]);
+            }
+        }
+    }
+
+    // The A-bus address is left pointing past the block, the counter at zero
+    if (!fixed) {
+        channel.aAddress = decrement ? channel.aAddress - count : channel.aAddress + count;
+    }
+    channel.byteCount = 0;
+
+    return DMA_CYCLES_PER_CHANNEL + count * DMA_CYCLES_PER_BYTE;
+}
+
+// HDMA
+uint32 DMAController::initHDMA() {
+    hdmaActive = memory ? hdmaEnable : 0;
+    hdmaWrites.clear();
+    hdmaScratch.clear();
+    hdmaScratchLine.clear();
+    std::fill(hdmaLineStart, hdmaLineStart + HDMA_MAX_LINES + 1, 0);
+    std::fill(&hdmaLineCycles[0][0], &hdmaLineCycles[0][0] + 8 * HDMA_MAX_LINES, 0);
+    if (hdmaActive == 0) {
+        return 0;
+    }
+    
+    // Tables are read once here rather than through the bus every line.
+    // Games build their tables during V-blank (usually double-buffered),
+    // so the frame's contents are already final at this point.
+    uint32 cycles = HDMA_CYCLES_PER_LINE;
+    for (int i = 0; i < 8; ++i) {
+        if (hdmaActive & (1 << i)) {
+            expandHDMAChannel(i);
+            cycles += HDMA_CYCLES_PER_CHANNEL;
+        }
+    }
+    
+    // Counting sort by line; channels were expanded in order, so writes
+    // within a line stay in channel order like on hardware
+    for (uint16 line : hdmaScratchLine) {
+        hdmaLineStart[line + 1]++;
+    }
+    for (int line = 0; line < HDMA_MAX_LINES; ++line) {
+        hdmaLineStart[line + 1] += hdmaLineStart[line];
+    }
+    hdmaWrites.resize(hdmaScratch.size());
+    uint32 cursor[HDMA_MAX_LINES];
+    std::copy(hdmaLineStart, hdmaLineStart + HDMA_MAX_LINES, cursor);
+    for (size_t i = 0; i < hdmaScratch.size(); ++i) {
+        hdmaWrites[cursor[hdmaScratchLine[i]]++] = hdmaScratch[i];
+    }
+    return cycles;
+}
+
+void DMAController::expandHDMAChannel(int index) {
+    Channel& channel = channels[index];
+    uint8 mode = channel.control & 0x07;
+    bool indirect = (channel.control & 0x40) != 0;
+    uint8 length = TRANSFER_LENGTH[mode];
+    const uint8* pattern = TRANSFER_PATTERN[mode];
+    uint16* lineCycles = hdmaLineCycles[index];
+    uint32 tableBank = static_cast<uint32>(channel.aBank) << 16;
+    uint32 indirectBank = static_cast<uint32>(channel.indirectBank) << 16;
+    
+    channel.tableAddress = channel.aAddress;
+    int line = 0;
+    while (line < HDMA_MAX_LINES) {
+        // Line count header: bit 7 = repeat, bits 0-6 = lines ($80 = 128 repeat)
+        uint8 header = readABus(tableBank | channel.tableAddress++);
+        lineCycles[line] += HDMA_CYCLES_HEADER;
+        channel.lineCounter = header;
+        if (header == 0) {
+            break;
+        }
+        bool repeat = (header & 0x80) != 0;
+        int lines = (header & 0x7F) ? (header & 0x7F) : 128;
+        if (indirect) {
+            uint8 lo = readABus(tableBank | channel.tableAddress++);
+            uint8 hi = readABus(tableBank | channel.tableAddress++);
+            channel.byteCount = (hi << 8) | lo;
+            lineCycles[line] += HDMA_CYCLES_INDIRECT;
+        }
+        
+        for (int i = 0; i < lines && line < HDMA_MAX_LINES; ++i, ++line) {
+            // Non-repeat entries transfer on their first line only
+            if (i > 0 && !repeat) {
+                continue;
+            }
+            for (int b = 0; b < length; ++b) {
+                uint8 value;
+                if (indirect) {
+                    value = readABus(indirectBank | channel.byteCount++);
+                } else {
+                    value = readABus(tableBank | channel.tableAddress++);
+                }
+                hdmaScratch.push_back({ static_cast<uint8>(index),
+                                        static_cast<uint8>(channel.bAddress + pattern[b]), value });
+                hdmaScratchLine.push_back(static_cast<uint16>(line));
+            }
+            lineCycles[line] += HDMA_CYCLES_PER_CHANNEL + length * DMA_CYCLES_PER_BYTE;
+        }
+    }
+}
+
+uint32 DMAController::runHDMALine(int line) {
+    if (line < 0 || line >= HDMA_MAX_LINES) {
+        return 0;
+    }
+    // Channels disabled mid-frame through $420C stop immediately
+    uint8 mask = hdmaActive & hdmaEnable;
+    if (mask == 0) {
+        return 0;
+    }
+    uint32 end = hdmaLineStart[line + 1];
+    for (uint32 i = hdmaLineStart[line]; i < end; ++i) {
+        const HDMAWrite& write = hdmaWrites[i];
+        if (mask & (1 << write.channel)) {
+            memory->writeHardware(0x2100 | write.port, write.value);
+        }
+    }
+    // And stop stalling the CPU for their bytes
+    uint32 cycles = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (mask & (1 << i)) {
+            cycles += hdmaLineCycles[i][line];
+        }
+    }
+    return cycles ? HDMA_CYCLES_PER_LINE + cycles : 0;
+}
+
+bool DMAController::isABusBlocked(uint32 address) {
+    uint8 bank = (address >> 16) & 0xFF;
+    uint16 offset = address & 0xFFFF;
+    if ((bank & 0x40) != 0) {
+        return false;
+    }
+    return (offset >= 0x2100 && offset < 0x2200) || (offset >= 0x4300 && offset < 0x4380);
+}
+
+uint8 DMAController::readABus(uint32 address) {
+    if (isABusBlocked(address)) {
+        return 0x00;
+    }
+    return memory->read(address);
+}
+
+void DMAController::writeABus(uint32 address, uint8 value) {
+    if (!isABusBlocked(address)) {
+        memory->write(address, value);
+    }
+}
+
+void DMAController::gatherABus(uint8 bank, uint16 address, uint8* data, uint32 count) {
+    // Copy page by page; the A-bus address wraps within its bank
+    while (count > 0) {
+        uint32 full = (static_cast<uint32>(bank) << 16) | address;
+        uint32 run = std::min<uint32>(count, 0x100 - (address & 0xFF));
+        const uint8* page = memory->getPagePointer(full);
+        if (page) {
+            std::memcpy(data, page + (address & 0xFF), run);
+        } else {
+            for (uint32 i = 0; i < run; ++i) {
+                data[i] = readABus(full + i);
+            }
+        }
+        address += run;
+        data += run;
+        count -= run;
+    }
+}
+
+void DMAController::scatterABus(uint8 bank, uint16 address, const uint8* data, uint32 count) {
+    while (count > 0) {
+        uint32 full = (static_cast<uint32>(bank) << 16) | address;
+        uint32 run = std::min<uint32>(count, 0x100 - (address & 0xFF));
+        uint8* page = memory->getWritablePagePointer(full);
+        if (page) {
+            std::memcpy(page + (address & 0xFF), data, run);
+        } else {
+            for (uint32 i = 0; i < run; ++i) {
+                writeABus(full + i, data[i]);
+            }
+        }
+        address += run;
+        data += run;
+        count -= run;
+    }
+}
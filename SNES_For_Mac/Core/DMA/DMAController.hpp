@@ -0,0 +1,111 @@
+//
+//  DMAController.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef DMACONTROLLER_HPP
+#define DMACONTROLLER_HPP
+
+#include "../Types/Types.hpp"
+#include <vector>
+
+class Memory;
+
+// 8-channel DMA controller ($420B, $420C, $4300-$437F)
+class DMAController {
+public:
+    // B-bus port offsets written for each byte of a transfer unit, per mode
+    static const uint8 TRANSFER_PATTERN[8][4];
+    // Bytes per HDMA transfer unit, per mode
+    static const uint8 TRANSFER_LENGTH[8];
+    
+    // Lines HDMA tables are expanded for (overscan frames show 239)
+    static const int HDMA_MAX_LINES = 240;
+    
+    DMAController();
+    
+    void reset();
+    
+    void setMemory(Memory* mem);
+    
+    // Channel registers $43x0-$43xF
+    uint8 readRegister(uint16 offset);
+    void writeRegister(uint16 offset, uint8 value);
+    
+    // Run general purpose DMA on every channel set in mask ($420B write)
+    // Returns the number of master cycles the CPU is stalled for
+    uint32 runGeneralDMA(uint8 mask);
+    
+    // HDMA ($420C). initHDMA() runs at the top of the frame and expands every
+    // enabled channel's table into a per-scanline list of B-bus writes;
+    // runHDMALine() replays one line's writes at H-blank, for the channels
+    // still enabled then. A channel enabled mid-frame starts at the next
+    // frame: its table is only set up at the top of one (games don't rely
+    // on the hardware carrying on from stale table registers).
+    // Both return the master cycles the CPU is stalled for.
+    void setHDMAEnable(uint8 mask) { hdmaEnable = mask; }
+    uint8 getHDMAEnable() const { return hdmaEnable; }
+    uint32 initHDMA();
+    uint32 runHDMALine(int line);
+    
+    // Savestate: channel registers and this frame's HDMA writes
+    struct State;
+    void saveState(State& saved) const;
+    void loadState(const State& saved);
+    
+private:
+    struct Channel {
+        uint8  control;                 // DMAPx  ($43x0)
+        uint8  bAddress;                // BBADx  ($43x1)
+        uint16 aAddress;                // A1TxL/H ($43x2-$43x3)
+        uint8  aBank;                   // A1Bx   ($43x4)
+        uint16 byteCount;               // DASxL/H ($43x5-$43x6)
+        uint8  indirectBank;            // DASBx  ($43x7)
+        uint16 tableAddress;            // A2AxL/H ($43x8-$43x9)
+        uint8  lineCounter;             // NLTRx  ($43xA)
+        uint8  unused;                  // UNUSEDx ($43xB/$43xF)
+    } channels[8];
+    
+    Memory* memory;
+    
+    // Staging area for one channel's A-bus data (max 64KB per transfer)
+    std::vector<uint8> buffer;
+    
+    // Precomputed HDMA writes for the current frame, grouped by line and
+    // in channel order within a line
+    struct HDMAWrite {
+        uint8 channel;
+        uint8 port;                     // $21xx
+        uint8 value;
+    };
+    uint8 hdmaEnable;                   // HDMAEN ($420C)
+    uint8 hdmaActive;                   // Channels whose table was expanded this frame
+    std::vector<HDMAWrite> hdmaWrites;
+    std::vector<HDMAWrite> hdmaScratch;
+    std::vector<uint16> hdmaScratchLine;
+    uint32 hdmaLineStart[HDMA_MAX_LINES + 1];
+    uint16 hdmaLineCycles[8][HDMA_MAX_LINES];   // Per channel, so disabled ones stop costing
+    
+    void expandHDMAChannel(int index);
+    
+    uint32 transferChannel(Channel& channel);
+    
+    // A-bus helpers; the A-bus cannot see the B-bus or DMA registers
+    static bool isABusBlocked(uint32 address);
+    uint8 readABus(uint32 address);
+    void writeABus(uint32 address, uint8 value);
+    void gatherABus(uint8 bank, uint16 address, uint8* data, uint32 count);
+    void scatterABus(uint8 bank, uint16 address, const uint8* data, uint32 count);
+};
+
+struct DMAController::State {
+    Channel channels[8];
+    uint8 hdmaEnable;
+    uint8 hdmaActive;
+    std::vector<HDMAWrite> hdmaWrites;
+    uint32 hdmaLineStart[HDMA_MAX_LINES + 1];
+    uint16 hdmaLineCycles[8][HDMA_MAX_LINES];
+};
+#endif
@@ -0,0 +1,288 @@
+//
+//  Emulator.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "Emulator.hpp"
+#include "Types/Timing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+Emulator::Emulator(): apuThreaded(false), runAheadFrames(0), audio(1024 * 2), audioFrames(0) {
+    cpu.setMemory(&memory);
+    memory.setDMA(&dma);
+    memory.setPPU(&ppu);
+    memory.setAPU(&apu);
+    memory.setAPUClock(&apuClock);
+    memory.setScheduler(&scheduler);
+    scheduler.setCPU(&cpu);
+    scheduler.setMemory(&memory);
+    scheduler.setPPU(&ppu);
+    scheduler.setDMA(&dma);
+    scheduler.setAPUClock(&apuClock);
+    apuClock.setCPU(&cpu);
+    apuClock.setAPU(&apu);
+    apuClock.setThread(&apuThread);
+    apuThread.setAPU(&apu);
+    apuThread.setDSP(&dsp);
+    apu.setDSP(&dsp);
+    dsp.setAPU(&apu);
+    dma.setMemory(&memory);
+    ppu.setMemory(&memory);
+    resampler.setRates(DSP::SAMPLE_RATE, DEFAULT_OUTPUT_RATE);
+}
+
+Emulator::~Emulator() {
+    // Gives the SPC700 and DSP back before they go
+    apuThread.stop();
+}
+
+bool Emulator::loadROM(const std::vector<uint8>& data) {
+    if (!memory.loadROM(data)) {
+        return false;
+    }
+    reset();
+    return true;
+}
+
+bool Emulator::loadROMFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return loadROM(data);
+}
+
+void Emulator::reset() {
+    apuThread.stop();
+    cpu.reset();
+    memory.reset();
+    dma.reset();
+    ppu.reset();
+    apu.reset();
+    scheduler.reset();
+    apuClock.reset();
+    // Nothing from before the reset is heard after it
+    apuThread.getAudio().skip(apuThread.getAudio().size());
+    resampler.setRates(resampler.getInputRate(), resampler.getOutputRate());
+    resampler.setAdjust(1.0);
+    resampler.clear();
+    audioFrames = 0;
+    dropAheadFrames();
+    updateAPUThread();
+}
+
+void Emulator::setAPUThreaded(bool threaded) {
+    apuThreaded = threaded;
+    updateAPUThread();
+}
+
+void Emulator::setRunAhead(int frames) {
+    runAheadFrames = std::max(frames, 0);
+    dropAheadFrames();
+    // Saving and loading state every frame means having the SPC700 and
+    // DSP at hand
+    updateAPUThread();
+}
+
+void Emulator::updateAPUThread() {
+    runAPUThread(apuThreaded && runAheadFrames == 0);
+}
+
+void Emulator::runAPUThread(bool threaded) {
+    // Keep the APU thread running alongside rather than only when the
+    // ports are touched
+    scheduler.setAPUSyncInterval(threaded ? MASTER_CYCLES_PER_SCANLINE : 0);
+    if (threaded) {
+        apuThread.start();
+    } else {
+        // Catches the SPC700 up to the CPU's time on its way out
+        apuThread.stop();
+    }
+}
+
+void Emulator::saveState(State& state) {
+    bool threaded = apuThread.isRunning();
+    apuThread.stop();
+    state.cpu = cpu;
+    memory.saveState(state.memory);
+    dma.saveState(state.dma);
+    ppu.saveState(state.ppu);
+    state.apu = apu;
+    state.dsp = dsp;
+    state.scheduler = scheduler;
+    state.apuClock = apuClock;
+    if (threaded) {
+        apuThread.start();
+    }
+}
+
+void Emulator::loadState(const State& state) {
+    dropAheadFrames();
+    restoreState(state);
+}
+
+void Emulator::restoreState(const State& state) {
+    apuThread.stop();
+    cpu = state.cpu;
+    memory.loadState(state.memory);
+    dma.loadState(state.dma);
+    ppu.loadState(state.ppu);
+    apu = state.apu;
+    dsp = state.dsp;
+    scheduler = state.scheduler;
+    apuClock = state.apuClock;
+    // The state may have been saved with the thread on or off
+    updateAPUThread();
+}
+
+void Emulator::setJoypad(int port, uint16 buttons) {
+    if (scheduler.getJoypad(port) != buttons) {
+        // The frames run ahead guessed otherwise
+        dropAheadFrames();
+    }
+    scheduler.setJoypad(port, buttons);
+}
+
+void Emulator::runFrame() {
+    if (runAheadFrames == 0) {
+        audioFrames = emulateFrame(&audio);
+        playAudio();
+        return;
+    }
+    if (static_cast<int>(aheadFrames.size()) == runAheadFrames) {
+        // Same input as when the frames ahead were run, so running them
+        // again would make them the same: only the newest one is new
+        std::unique_ptr<AheadFrame>& next = aheadFrames.front();
+        if (next->audioFrames < 0) {
+            // Run unheard: the console is still at the frame before it,
+            // so run it again, mixed, to the same state
+            ppu.setRenderEnabled(false);
+            next->audioFrames = emulateFrame(&next->audio);
+        }
+        restoreState(aheadFrames.back()->state);
+        runAheadFrame(true, true);
+    } else {
+        // From the frame to keep on, with the new input. Only that one is
+        // sure to be heard; the rest are mixed if the input holds.
+        dropAheadFrames();
+        for (int frame = 0; frame <= runAheadFrames; ++frame) {
+            runAheadFrame(frame == runAheadFrames, frame == 0);
+        }
+    }
+    // The oldest is kept, and heard
+    std::unique_ptr<AheadFrame> kept = std::move(aheadFrames.front());
+    aheadFrames.erase(aheadFrames.begin());
+    restoreState(kept->state);
+    std::swap(audio, kept->audio);
+    audioFrames = kept->audioFrames;
+    playAudio();
+    spareFrames.push_back(std::move(kept));
+}
+
+void Emulator::runAheadFrame(bool render, bool mix) {
+    std::unique_ptr<AheadFrame> frame;
+    if (spareFrames.empty()) {
+        frame.reset(new AheadFrame());
+        frame->audio.resize(audio.size());
+    } else {
+        frame = std::move(spareFrames.back());
+        spareFrames.pop_back();
+    }
+    ppu.setRenderEnabled(render);
+    if (mix) {
+        frame->audioFrames = emulateFrame(&frame->audio);
+    } else {
+        emulateFrame(nullptr);
+        frame->audioFrames = -1;
+    }
+    saveState(frame->state);
+    aheadFrames.push_back(std::move(frame));
+}
+
+void Emulator::dropAheadFrames() {
+    for (std::unique_ptr<AheadFrame>& frame : aheadFrames) {
+        spareFrames.push_back(std::move(frame));
+    }
+    aheadFrames.clear();
+}
+
+double Emulator::fastForward(int frames, int renderInterval) {
+    if (frames <= 0) {
+        return 0.0;
+    }
+    dropAheadFrames();
+    // Without mixing, the DSP's share is small enough for this thread
+    runAPUThread(false);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int frame = 1; frame <= frames; ++frame) {
+        ppu.setRenderEnabled(frame == frames || (renderInterval > 0 && frame % renderInterval == 0));
+        emulateFrame(nullptr);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    audioFrames = 0;
+    updateAPUThread();
+    const double frameSeconds = static_cast<double>(SCANLINES_PER_FRAME_NTSC * MASTER_CYCLES_PER_SCANLINE) / MASTER_CLOCK_NTSC;
+    return elapsed.count() > 0.0 ? frames * frameSeconds / elapsed.count() : 0.0;
+}
+
+int Emulator::emulateFrame(std::vector<int16>* buffer) {
+    bool threaded = apuThread.isRunning();
+    if (!threaded) {
+        if (buffer) {
+            dsp.setOutput(buffer->data(), static_cast<int>(buffer->size() / 2));
+        } else {
+            dsp.setOutput(nullptr, 0);
+        }
+    }
+    // 262 lines of 1364 master cycles; the APU is caught up at the end
+    scheduler.runFrame();
+    if (!buffer) {
+        return 0;
+    }
+    if (threaded) {
+        // Samples come out as the thread makes them final, which can run a
+        // little behind or ahead of the frame; take all that are there
+        SPSCRing<int16>& samples = apuThread.getAudio();
+        size_t pending = samples.size();
+        if (pending > buffer->size()) {
+            buffer->resize(pending);
+        }
+        return static_cast<int>(samples.pop(buffer->data(), pending) / 2);
+    }
+    return dsp.getSampleCount();
+}
+
+void Emulator::playAudio() {
+    resampler.write(audio.data(), audioFrames);
+    // Dynamic rate control: run the output up to 0.5% fast or slow to keep
+    // the ring half full, however the host's clock drifts from ours
+    resampler.setAdjust(1.0 + (0.5 - resampler.getFillLevel()) * 0.01);
+}
+
+uint64 Emulator::getBRRCacheHits() const {
+    return apuThread.isRunning() ? apuThread.getBRRCacheHits() : dsp.getCacheHits();
+}
+
+uint64 Emulator::getBRRCacheMisses() const {
+    return apuThread.isRunning() ? apuThread.getBRRCacheMisses() : dsp.getCacheMisses();
+}
+
+void Emulator::step() {
+    dropAheadFrames();
+    cpu.executeInstruction();
+}
+
+void Emulator::setAudioOutputRate(double rate) {
+    resampler.setRates(DSP::SAMPLE_RATE, rate);
+}
+
+int Emulator::readAudio(float* out, int frames) {
+    return resampler.read(out, frames);
+}
@@ -5,3 +5,155 @@
 //  Created by Haide Lan on 2025/11/13.
 //
 
+#ifndef EMULATOR_HPP
+#define EMULATOR_HPP
+
+#include "Types/Types.hpp"
+#include "CPU/CPU65c816.hpp"
+#include "Memory/Memory.hpp"
+#include "DMA/DMAController.hpp"
+#include "PPU/PPU.hpp"
+#include "APU/SPC700.hpp"
+#include "APU/DSP.hpp"
+#include "APU/APUClock.hpp"
+#include "APU/APUThread.hpp"
+#include "APU/Resampler.hpp"
+#include "Scheduler/Scheduler.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// The whole console: owns every component, wires them together and runs
+// them a frame at a time
+// Plain C++ with no platform dependencies; a front end only has to load a
+// ROM, call runFrame() at 60 Hz, and take the frames and audio it makes.
+class Emulator {
+public:
+    static const int DEFAULT_OUTPUT_RATE = 48000;
+
+    Emulator();
+    ~Emulator();
+
+    Emulator(const Emulator&) = delete;
+    Emulator& operator=(const Emulator&) = delete;
+
+    // Load a ROM image and reset; false if it is empty or unreadable
+    bool loadROM(const std::vector<uint8>& data);
+    bool loadROMFile(const std::string& path);
+
+    void reset();
+
+    // Run one frame (262 lines); its audio is then in getAudio() and in
+    // the resampler's ring
+    void runFrame();
+    // Execute one CPU instruction, outside the frame's timing
+    void step();
+
+    // Run the SPC700 and DSP on a thread of their own; results are the
+    // same either way
+    void setAPUThreaded(bool threaded);
+    bool isAPUThreaded() const { return apuThreaded; }
+
+    // Run-ahead: each runFrame() also emulates that many frames further
+    // with the current input, shows the last of them and goes back, hiding
+    // as many frames of the game's own input lag. What is heard is the
+    // frame that is kept.
+    // Frames run ahead are kept, with their samples, until the input
+    // changes: until then each runFrame() only has to run the newest one.
+    // After a change only the kept frame is mixed; each of the others is
+    // run once more, mixed, if it is still kept.
+    // Anything other than setJoypad(), reset() and loadState() that changes
+    // the console between frames is not seen by the frames already ahead.
+    // The APU stays on this thread while it is on. 0 = off.
+    void setRunAhead(int frames);
+    int getRunAhead() const { return runAheadFrames; }
+
+    // Fast-forward: run frames back to back as fast as the host allows,
+    // drawing only every renderInterval-th one and the last (0 = only the
+    // last). Nothing is heard, but the DSP runs exactly as it otherwise
+    // would, on this thread. Returns the speed reached, as a multiple of
+    // real time.
+    double fastForward(int frames, int renderInterval = 0);
+
+    // In-memory savestate, taken between frames. Reusing one avoids
+    // reallocating; the ROM is not part of it.
+    struct State {
+        CPU65c816 cpu;
+        Memory::State memory;
+        DMAController::State dma;
+        PPU::State ppu;
+        SPC700 apu;
+        DSP dsp;
+        Scheduler scheduler;
+        APUClock apuClock;
+    };
+    void saveState(State& state);
+    void loadState(const State& state);
+
+    // Buttons on joypad port (0-3), as Scheduler::setJoypad()
+    void setJoypad(int port, uint16 buttons);
+
+    // Video: finished frames, triple buffered for a presenter thread
+    FrameOutput& getOutput() { return ppu.getOutput(); }
+
+    // Audio: the last frame's 32 kHz stereo samples (left, right). With
+    // the APU threaded, whatever the thread finished since the frame before.
+    const int16* getAudio() const { return audio.data(); }
+    int getAudioFrames() const { return audioFrames; }
+
+    // Audio at the host's rate, as interleaved stereo float. readAudio()
+    // is lock-free and can be called from the audio callback's thread;
+    // missing frames are silence. Returns the frames that were ready.
+    void setAudioOutputRate(double rate);
+    int readAudio(float* out, int frames);
+    double getAudioFillLevel() const { return resampler.getFillLevel(); }
+
+    // BRR decode cache counters of the DSP, on whichever thread it runs
+    uint64 getBRRCacheHits() const;
+    uint64 getBRRCacheMisses() const;
+
+    // Components, for debugging and statistics
+    CPU65c816& getCPU() { return cpu; }
+    Memory& getMemory() { return memory; }
+    PPU& getPPU() { return ppu; }
+    SPC700& getAPU() { return apu; }
+    DSP& getDSP() { return dsp; }
+    APUThread& getAPUThread() { return apuThread; }
+    Scheduler& getScheduler() { return scheduler; }
+
+private:
+    CPU65c816 cpu;
+    Memory memory;
+    DMAController dma;
+    PPU ppu;
+    SPC700 apu;
+    DSP dsp;
+    Scheduler scheduler;            // Runs the frame: lines, V-blank, interrupts
+    APUClock apuClock;              // Runs the SPC700 when the CPU talks to it
+    APUThread apuThread;            // Or hands its time to a thread of its own
+    bool apuThreaded;
+
+    int runAheadFrames;
+
+    // A frame run ahead: the state after it, and the samples it made
+    struct AheadFrame {
+        State state;
+        std::vector<int16> audio;
+        int audioFrames;            // -1 if run without mixing
+    };
+    std::vector<std::unique_ptr<AheadFrame>> aheadFrames;  // Past the kept one, oldest first
+    std::vector<std::unique_ptr<AheadFrame>> spareFrames;
+
+    std::vector<int16> audio;       // One frame of 32 kHz stereo samples, or more
+    int audioFrames;
+    Resampler resampler;            // To the host's rate, for the audio callback
+
+    int emulateFrame(std::vector<int16>* buffer);     // Samples go to buffer; none are mixed without one
+    void playAudio();
+    void runAheadFrame(bool render, bool mix);
+    void dropAheadFrames();
+    void restoreState(const State& state);
+    void updateAPUThread();
+    void runAPUThread(bool threaded);
+};
+#endif
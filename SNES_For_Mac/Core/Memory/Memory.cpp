@@ -5,25 +5,119 @@
 //  Created by Haide Lan on 2025/11/13.
 //
 #include "Memory.hpp"
+#include "../DMA/DMAController.hpp"
+#include "../PPU/PPU.hpp"
+#include "../APU/SPC700.hpp"
+#include "../APU/APUClock.hpp"
+#include "../Scheduler/Scheduler.hpp"
+#include <algorithm>
 #include <cstring>
 
-Memory::Memory() {
+Memory::Memory(): mappingGeneration(0), dma(nullptr), ppu(nullptr), apu(nullptr), apuClock(nullptr), scheduler(nullptr), stallCycles(0) {
     wram.resize(128 * 1024);        // 128KB Work RAM
     sram.resize(32 * 1024);         // 32KB Save RAM (can vary)
     vram.resize(64 * 1024);         // 64KB Video RAM
     cgram.resize(512);              // 512 bytes Color RAM
     oam.resize(544);                // 544 bytes OAM
+    reset();
 }
 
 Memory::~Memory() { }
 
 void Memory::reset() {
+    if (ppu) {
+        // Decoded copies of VRAM/OAM are about to go stale
+        ppu->beforeVRAMWrite(0, 0x10000);
+        ppu->beforeCGRAMWrite();
+        ppu->beforeOAMWrite();
+    }
     // Clear all RAM
     std::fill(wram.begin(), wram.end(), 0);
     std::fill(sram.begin(), sram.end(), 0);
     std::fill(vram.begin(), vram.end(), 0);
     std::fill(cgram.begin(), cgram.end(), 0);
     std::fill(oam.begin(), oam.end(), 0);
+    mappingGeneration++;
+    
+    stallCycles = 0;
+    vramAddress = 0;
+    vramIncrementMode = 0;
+    vramReadBuffer = 0;
+    cgramAddress = 0;
+    cgramLatch = 0;
+    oamAddress = 0;
+    oamLatch = 0;
+    wramPortAddress = 0;
+}
+
+void Memory::saveState(State& saved) const {
+    // Same-sized vectors are copied into their existing storage
+    saved.wram = wram;
+    saved.sram = sram;
+    saved.vram = vram;
+    saved.cgram = cgram;
+    saved.oam = oam;
+    saved.stallCycles = stallCycles;
+    saved.vramAddress = vramAddress;
+    saved.vramIncrementMode = vramIncrementMode;
+    saved.vramReadBuffer = vramReadBuffer;
+    saved.cgramAddress = cgramAddress;
+    saved.cgramLatch = cgramLatch;
+    saved.oamAddress = oamAddress;
+    saved.oamLatch = oamLatch;
+    saved.wramPortAddress = wramPortAddress;
+}
+
+void Memory::loadState(const State& saved) {
+    // Copied in place, so page pointers handed out stay valid
+    std::copy(saved.wram.begin(), saved.wram.end(), wram.begin());
+    std::copy(saved.sram.begin(), saved.sram.end(), sram.begin());
+    if (ppu) {
+        const uint32 block = 0x400;
+        for (uint32 address = 0; address < vram.size(); address += block) {
+            if (std::memcmp(&vram[address], &saved.vram[address], block) != 0) {
+                ppu->beforeVRAMWrite(address, block);
+            }
+        }
+        if (cgram != saved.cgram) {
+            ppu->beforeCGRAMWrite();
+        }
+        if (oam != saved.oam) {
+            ppu->beforeOAMWrite();
+        }
+    }
+    std::copy(saved.vram.begin(), saved.vram.end(), vram.begin());
+    std::copy(saved.cgram.begin(), saved.cgram.end(), cgram.begin());
+    std::copy(saved.oam.begin(), saved.oam.end(), oam.begin());
+    stallCycles = saved.stallCycles;
+    vramAddress = saved.vramAddress;
+    vramIncrementMode = saved.vramIncrementMode;
+    vramReadBuffer = saved.vramReadBuffer;
+    cgramAddress = saved.cgramAddress;
+    cgramLatch = saved.cgramLatch;
+    oamAddress = saved.oamAddress;
+    oamLatch = saved.oamLatch;
+    wramPortAddress = saved.wramPortAddress;
+}
+
+void Memory::setDMA(DMAController* controller) {
+    dma = controller;
+}
+
+void Memory::setPPU(PPU* video) {
+    ppu = video;
+}
+
+void Memory::setAPU(SPC700* sound) {
+    apu = sound;
+}
+
+void Memory::setAPUClock(APUClock* clock) {
+    apuClock = clock;
+}
+
+void Memory::setScheduler(Scheduler* timing) {
+    scheduler = timing;
 }
 
 bool Memory::loadROM(const std::vector<uint8> &romData) {
@@ -32,6 +126,7 @@ bool Memory::loadROM(const std::vector<uint8> &romData) {
     }
     
     rom = romData;
+    mappingGeneration++;
     return true;
 }
 
@@ -43,6 +138,48 @@ void Memory::write(uint32 address, uint8 value) {
     writeMapped(address & 0xFFFFFF, value);
 }
 
+const uint8* Memory::getPagePointer(uint32 address) {
+    address &= 0xFFFF00;
+    uint8 bank = (address >> 16) & 0xFF;
+    uint16 offset = address & 0xFFFF;
+    
+    switch (getRegion(address)) {
+        case REGION_WRAM:
+            if (bank == 0x7E || bank == 0x7F) {
+                return &wram[((bank & 0x01) << 16) | offset];
+            }
+            return &wram[offset];
+        case REGION_ROM:
+        {
+            // Same mirroring as readMapped(); the page is only usable when
+            // all 256 bytes land contiguously inside the ROM image
+            if (rom.empty() || (rom.size() & 0xFF) != 0) {
+                return nullptr;
+            }
+            uint32 romAddr = address & (rom.size() - 1);
+            if (romAddr + 0xFF < rom.size()) {
+                return &rom[romAddr];
+            }
+            return nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+uint8* Memory::getWritablePagePointer(uint32 address) {
+    address &= 0xFFFF00;
+    if (getRegion(address) != REGION_WRAM) {
+        return nullptr;
+    }
+    uint8 bank = (address >> 16) & 0xFF;
+    uint16 offset = address & 0xFFFF;
+    if (bank == 0x7E || bank == 0x7F) {
+        return &wram[((bank & 0x01) << 16) | offset];
+    }
+    return &wram[offset];
+}
+
 Memory::MemoryRegion Memory::getRegion(uint32 address) {
     uint8 bank = (address >> 16) & 0xFF;
     uint16 offset = address & 0xFFFF;
@@ -112,9 +249,7 @@ uint8 Memory::readMapped(uint32 address) {
         }
             break;
         case REGION_HARDWARE:
-            // TODO: Implement hardware register reads
-            // For now, return open bus value
-            return 0xFF;
+            return readHardware(offset);
         case REGION_UNMAPPED:
         default:
             return 0xFF;        // Open bus
@@ -151,7 +286,7 @@ void Memory::writeMapped(uint32 address, uint8 value) {
         }
             break;
         case REGION_HARDWARE:
-            // TODO: Implement hardware register writes
+            writeHardware(offset, value);
             break;
         case REGION_ROM:
         case REGION_UNMAPPED:
@@ -173,3 +308,336 @@ void Memory::write16(uint32 address, uint16 value) {
     write(address, value & 0xFF);           // Low byte
     write(address + 1, (value >> 8) & 0xFF); // High byte
 }
+
+// Hardware registers
+uint8 Memory::readHardware(uint16 offset) {
+    switch (offset) {
+        case 0x2138:            // OAMDATAREAD
+        {
+            uint8 value = oamAddress < 0x200 ? oam[oamAddress] : oam[0x200 | (oamAddress & 0x1F)];
+            oamAddress = (oamAddress + 1) & 0x3FF;
+            return value;
+        }
+        case 0x2139:            // VMDATALREAD
+            return readVRAMPort(false);
+        case 0x213A:            // VMDATAHREAD
+            return readVRAMPort(true);
+        case 0x213B:            // CGDATAREAD
+        {
+            uint8 value = cgram[cgramAddress];
+            cgramAddress = (cgramAddress + 1) & 0x1FF;
+            return value;
+        }
+        case 0x2180:            // WMDATA
+        {
+            uint8 value = wram[wramPortAddress];
+            wramPortAddress = (wramPortAddress + 1) & 0x1FFFF;
+            return value;
+        }
+        default:
+            break;
+    }
+    if (offset >= 0x2100 && offset < 0x2140 && ppu) {
+        return ppu->readRegister(offset);
+    }
+    if (offset >= 0x2140 && offset < 0x2180 && apu) {
+        if (apuClock) {
+            return apuClock->readPort(offset & 0x03);
+        }
+        return apu->readPort(offset & 0x03);
+    }
+    if (offset >= 0x4300 && offset < 0x4380 && dma) {
+        return dma->readRegister(offset);
+    }
+    if (scheduler && ((offset >= 0x4210 && offset <= 0x4212) || (offset >= 0x4218 && offset < 0x4220))) {
+        return scheduler->readRegister(offset);
+    }
+    // TODO: multiply/divide and the other CPU I/O registers
+    return 0xFF;                // Open bus
+}
+
+void Memory::writeHardware(uint16 offset, uint8 value) {
+    switch (offset) {
+        case 0x2102:            // OAMADDL
+            oamAddress = ((oamAddress & 0x200) | (value << 1)) & 0x3FF;
+            return;
+        case 0x2103:            // OAMADDH
+            oamAddress = ((value & 0x01) << 9) | (oamAddress & 0x1FE);
+            return;
+        case 0x2104:            // OAMDATA
+            writeOAMPort(value);
+            return;
+        case 0x2115:            // VMAIN
+            vramIncrementMode = value;
+            return;
+        case 0x2116:            // VMADDL
+        case 0x2117:            // VMADDH
+        {
+            if (offset == 0x2116) {
+                vramAddress = (vramAddress & 0xFF00) | value;
+            } else {
+                vramAddress = (vramAddress & 0x00FF) | (value << 8);
+            }
+            // Setting the address prefetches the read buffer
+            vramReadBuffer = readVRAMWord(vramTranslate(vramAddress));
+            return;
+        }
+        case 0x2118:            // VMDATAL
+            writeVRAMPort(false, value);
+            return;
+        case 0x2119:            // VMDATAH
+            writeVRAMPort(true, value);
+            return;
+        case 0x2121:            // CGADD
+            cgramAddress = value << 1;
+            return;
+        case 0x2122:            // CGDATA
+            writeCGRAMPort(value);
+            return;
+        case 0x2180:            // WMDATA
+            wram[wramPortAddress] = value;
+            wramPortAddress = (wramPortAddress + 1) & 0x1FFFF;
+            return;
+        case 0x2181:            // WMADDL
+            wramPortAddress = (wramPortAddress & 0x1FF00) | value;
+            return;
+        case 0x2182:            // WMADDM
+            wramPortAddress = (wramPortAddress & 0x100FF) | (value << 8);
+            return;
+        case 0x2183:            // WMADDH
+            wramPortAddress = (wramPortAddress & 0x0FFFF) | ((value & 0x01) << 16);
+            return;
+        case 0x420B:            // MDMAEN
+            if (dma) {
+                stallCycles += dma->runGeneralDMA(value);
+            }
+            return;
+        case 0x420C:            // HDMAEN
+            if (dma) {
+                dma->setHDMAEnable(value);
+            }
+            return;
+        default:
+            break;
+    }
+    if (offset >= 0x2100 && offset < 0x2140 && ppu) {
+        ppu->writeRegister(offset, value);
+    } else if (offset >= 0x2140 && offset < 0x2180 && apu) {
+        if (apuClock) {
+            apuClock->writePort(offset & 0x03, value);
+        } else {
+            apu->writePort(offset & 0x03, value);
+        }
+    } else if (offset >= 0x4300 && offset < 0x4380 && dma) {
+        dma->writeRegister(offset, value);
+    } else if (scheduler && (offset == 0x4200 || (offset >= 0x4207 && offset <= 0x420A))) {
+        scheduler->writeRegister(offset, value);
+    }
+    // TODO: multiply/divide and the other CPU I/O registers
+}
+
+// VRAM address remapping (VMAIN bits 2-3) used for bitmap-style uploads
+uint16 Memory::vramTranslate(uint16 address) const {
+    switch ((vramIncrementMode >> 2) & 0x03) {
+        case 1:     // aaaaaaaaBBBccccc -> aaaaaaaacccccBBB
+            return (address & 0xFF00) | ((address & 0x001F) << 3) | ((address >> 5) & 0x07);
+        case 2:     // aaaaaaaBBBcccccc -> aaaaaaaccccccBBB
+            return (address & 0xFE00) | ((address & 0x003F) << 3) | ((address >> 6) & 0x07);
+        case 3:     // aaaaaaBBBccccccc -> aaaaaacccccccBBB
+            return (address & 0xFC00) | ((address & 0x007F) << 3) | ((address >> 7) & 0x07);
+        default:
+            return address;
+    }
+}
+
+uint16 Memory::vramStep() const {
+    static const uint16 steps[4] = { 1, 32, 128, 128 };
+    return steps[vramIncrementMode & 0x03];
+}
+
+void Memory::writeVRAMPort(bool high, uint8 value) {
+    uint32 byte = (vramTranslate(vramAddress) & 0x7FFF) << 1;
+    // Rewriting the same value leaves the PPU's view alone
+    if (vram[byte + (high ? 1 : 0)] != value) {
+        if (ppu) {
+            ppu->beforeVRAMWrite(byte);
+        }
+        vram[byte + (high ? 1 : 0)] = value;
+    }
+    // VMAIN bit 7 selects whether the low or the high write increments
+    if (high == ((vramIncrementMode & 0x80) != 0)) {
+        vramAddress += vramStep();
+    }
+}
+
+uint8 Memory::readVRAMPort(bool high) {
+    uint8 value = high ? (vramReadBuffer >> 8) : (vramReadBuffer & 0xFF);
+    if (high == ((vramIncrementMode & 0x80) != 0)) {
+        vramReadBuffer = readVRAMWord(vramTranslate(vramAddress));
+        vramAddress += vramStep();
+    }
+    return value;
+}
+
+void Memory::writeCGRAMPort(uint8 value) {
+    // CGRAM is written a full color (word) at a time
+    if ((cgramAddress & 0x01) == 0) {
+        cgramLatch = value;
+    } else if (cgram[cgramAddress - 1] != cgramLatch || cgram[cgramAddress] != (value & 0x7F)) {
+        if (ppu) {
+            ppu->beforeCGRAMWrite();
+        }
+        cgram[cgramAddress - 1] = cgramLatch;
+        cgram[cgramAddress] = value & 0x7F;
+    }
+    cgramAddress = (cgramAddress + 1) & 0x1FF;
+}
+
+void Memory::writeOAMPort(uint8 value) {
+    if (oamAddress >= 0x200) {
+        // High table is written directly (mirrored every 32 bytes)
+        uint32 index = 0x200 | (oamAddress & 0x1F);
+        if (oam[index] != value) {
+            if (ppu) {
+                ppu->beforeOAMWrite();
+            }
+            oam[index] = value;
+        }
+    } else if ((oamAddress & 0x01) == 0) {
+        oamLatch = value;
+    } else if (oam[oamAddress - 1] != oamLatch || oam[oamAddress] != value) {
+        if (ppu) {
+            ppu->beforeOAMWrite();
+        }
+        oam[oamAddress - 1] = oamLatch;
+        oam[oamAddress] = value;
+    }
+    oamAddress = (oamAddress + 1) & 0x3FF;
+}
+
+// Bulk B-bus transfers for DMA
+void Memory::writeBBusBlock(uint8 bbad, uint8 mode, const uint8* data, uint32 count) {
+    const uint8* pattern = DMAController::TRANSFER_PATTERN[mode & 0x07];
+    bool singlePort = pattern[1] == 0 && pattern[2] == 0 && pattern[3] == 0;
+    
+    // Word uploads to $2118/$2119 with plain +1 increment after the high byte:
+    // the VRAM address just walks forward, so copy straight into VRAM
+    if (bbad == 0x18 && (mode & 0x03) == 1 && (vramIncrementMode & 0x8F) == 0x80) {
+        uint32 words = count >> 1;
+        while (words > 0) {
+            uint32 start = vramAddress & 0x7FFF;
+            uint32 run = std::min<uint32>(words, 0x8000 - start);
+            if (std::memcmp(&vram[start << 1], data, run << 1) != 0) {
+                if (ppu) {
+                    ppu->beforeVRAMWrite(start << 1, run << 1);
+                }
+                std::memcpy(&vram[start << 1], data, run << 1);
+            }
+            vramAddress += run;
+            data += run << 1;
+            words -= run;
+        }
+        if (count & 0x01) {
+            writeVRAMPort(false, *data);
+        }
+        return;
+    }
+    
+    // Single-port streams into WRAM through $2180
+    if (bbad == 0x80 && singlePort) {
+        while (count > 0) {
+            uint32 run = std::min<uint32>(count, 0x20000 - wramPortAddress);
+            std::memcpy(&wram[wramPortAddress], data, run);
+            wramPortAddress = (wramPortAddress + run) & 0x1FFFF;
+            data += run;
+            count -= run;
+        }
+        return;
+    }
+    
+    // Everything else: dispatch straight to the port without going
+    // through the address decoder for each byte
+    for (uint32 i = 0; i < count; ++i) {
+        writeHardware(0x2100 | ((bbad + pattern[i & 0x03]) & 0xFF), data[i]);
+    }
+}
+
+void Memory::fillBBusBlock(uint8 bbad, uint8 mode, uint8 value, uint32 count) {
+    const uint8* pattern = DMAController::TRANSFER_PATTERN[mode & 0x07];
+    bool singlePort = pattern[1] == 0 && pattern[2] == 0 && pattern[3] == 0;
+    
+    // Fixed-source fill of VRAM words
+    if (bbad == 0x18 && (mode & 0x03) == 1 && (vramIncrementMode & 0x8F) == 0x80) {
+        // An odd last byte goes through the port, which tells the PPU itself
+        if (ppu && count >= 2) {
+            ppu->beforeVRAMWrite((vramAddress & 0x7FFF) << 1, count & ~0x01);
+        }
+        for (uint32 words = count >> 1; words > 0; --words) {
+            uint32 byte = (vramAddress & 0x7FFF) << 1;
+            vram[byte] = value;
+            vram[byte + 1] = value;
+            vramAddress++;
+        }
+        if (count & 0x01) {
+            writeVRAMPort(false, value);
+        }
+        return;
+    }
+    
+    // Fixed-source fill of one VRAM byte plane ($2118 or $2119 alone,
+    // incrementing on that same port) - the usual way games clear VRAM
+    if ((bbad == 0x18 || bbad == 0x19) && singlePort && (vramIncrementMode & 0x0F) == 0 &&
+        (bbad == 0x19) == ((vramIncrementMode & 0x80) != 0)) {
+        uint32 plane = bbad - 0x18;
+        if (ppu) {
+            ppu->beforeVRAMWrite((vramAddress & 0x7FFF) << 1, count << 1);
+        }
+        for (; count > 0; --count) {
+            vram[((vramAddress & 0x7FFF) << 1) | plane] = value;
+            vramAddress++;
+        }
+        return;
+    }
+    
+    if (bbad == 0x80 && singlePort) {
+        while (count > 0) {
+            uint32 run = std::min<uint32>(count, 0x20000 - wramPortAddress);
+            std::memset(&wram[wramPortAddress], value, run);
+            wramPortAddress = (wramPortAddress + run) & 0x1FFFF;
+            count -= run;
+        }
+        return;
+    }
+    
+    for (uint32 i = 0; i < count; ++i) {
+        writeHardware(0x2100 | ((bbad + pattern[i & 0x03]) & 0xFF), value);
+    }
+}
+
+void Memory::readBBusBlock(uint8 bbad, uint8 mode, uint8* data, uint32 count) {
+    const uint8* pattern = DMAController::TRANSFER_PATTERN[mode & 0x07];
+    
+    // VRAM download through $2139/$213A: after the prefetched word the
+    // data is simply consecutive VRAM words
+    if (bbad == 0x39 && (mode & 0x03) == 1 && (vramIncrementMode & 0x8F) == 0x80 && count >= 2) {
+        data[0] = vramReadBuffer & 0xFF;
+        data[1] = vramReadBuffer >> 8;
+        uint32 words = count >> 1;
+        for (uint32 i = 1; i < words; ++i) {
+            uint32 byte = (vramAddress & 0x7FFF) << 1;
+            data[i * 2] = vram[byte];
+            data[i * 2 + 1] = vram[byte + 1];
+            vramAddress++;
+        }
+        vramReadBuffer = readVRAMWord(vramAddress);
+        vramAddress++;
+        if (count & 0x01) {
+            data[count - 1] = readVRAMPort(false);
+        }
+        return;
+    }
+    
+    for (uint32 i = 0; i < count; ++i) {
+        data[i] = readHardware(0x2100 | ((bbad + pattern[i & 0x03]) & 0xFF));
+    }
+}
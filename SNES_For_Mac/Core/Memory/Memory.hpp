@@ -12,6 +12,12 @@
 #include "../Types/Types.hpp"
 #include <vector>
 
+class DMAController;
+class PPU;
+class SPC700;
+class APUClock;
+class Scheduler;
+
 class Memory {
 public:
     Memory();
@@ -23,12 +29,95 @@ public:
     
     uint16 read16(uint32 address);
     void write16(uint32 address, uint16 value);
+    
+    // Direct host pointer to the 256-byte page containing address
+    // Returns nullptr if the page is not plain ROM/WRAM (hardware, SRAM, open bus)
+    const uint8* getPagePointer(uint32 address);
+    
+    // First 8KB of WRAM, mirrored at $0000-$1FFF in banks $00-$3F/$80-$BF
+    // (stack and direct page live here in practically every game)
+    uint8* getLowRAM() { return wram.data(); }
+    
+    // Writable counterpart of getPagePointer(), only returned for WRAM pages
+    uint8* getWritablePagePointer(uint32 address);
+    
+    // Incremented whenever previously returned page pointers may be stale
+    uint32 getMappingGeneration() const { return mappingGeneration; }
+    
+    // Attach the DMA controller ($420B/$420C, $4300-$437F)
+    void setDMA(DMAController* controller);
+    
+    // Attach the PPU ($2100-$213F, except the VRAM/CGRAM/OAM data ports)
+    void setPPU(PPU* video);
+    
+    // Attach the sound CPU ($2140-$217F, the four APU ports mirrored)
+    void setAPU(SPC700* sound);
+    
+    // Catch the sound CPU up before every port access (without one it is
+    // expected to run in lockstep)
+    void setAPUClock(APUClock* clock);
+    
+    // Attach the frame timing registers ($4200, $4207-$420A, $4210-$4212,
+    // $4218-$421F)
+    void setScheduler(Scheduler* timing);
+    
+    // Video memory as seen by the PPU renderer
+    const uint8* getVRAM() const { return vram.data(); }
+    const uint8* getCGRAM() const { return cgram.data(); }
+    const uint8* getOAM() const { return oam.data(); }
+    uint16 readVRAMWord(uint16 wordAddress) const {
+        uint32 byte = (wordAddress & 0x7FFF) << 1;
+        return vram[byte] | (vram[byte + 1] << 8);
+    }
+    
+    // Hardware registers (offset within bank $00, $2100-$21FF and $4200-$43FF)
+    uint8 readHardware(uint16 offset);
+    void writeHardware(uint16 offset, uint8 value);
+    
+    // Bulk B-bus access used by DMA. bbad is the $21xx port, mode the DMA
+    // transfer pattern (0-7). Common port/mode combinations are copied
+    // straight into VRAM/CGRAM/OAM/WRAM; anything else goes port by port.
+    void writeBBusBlock(uint8 bbad, uint8 mode, const uint8* data, uint32 count);
+    void fillBBusBlock(uint8 bbad, uint8 mode, uint8 value, uint32 count);
+    void readBBusBlock(uint8 bbad, uint8 mode, uint8* data, uint32 count);
+    
+    // Master cycles the CPU was stalled for (DMA) since the last call
+    uint32 consumeStallCycles() {
+        uint32 cycles = stallCycles;
+        stallCycles = 0;
+        return cycles;
+    }
+    void addStallCycles(uint32 cycles) { stallCycles += cycles; }
+    
     // Load ROM data
     bool loadROM(const std::vector<uint8>& romData);
     
     // Reset memory to initial state
     void reset();
     
+    // Savestate: RAM and the B-bus ports; the ROM and the attached
+    // components are not part of it
+    struct State {
+        std::vector<uint8> wram;
+        std::vector<uint8> sram;
+        std::vector<uint8> vram;
+        std::vector<uint8> cgram;
+        std::vector<uint8> oam;
+        uint32 stallCycles;
+        uint16 vramAddress;
+        uint8  vramIncrementMode;
+        uint16 vramReadBuffer;
+        uint16 cgramAddress;
+        uint8  cgramLatch;
+        uint16 oamAddress;
+        uint8  oamLatch;
+        uint32 wramPortAddress;
+    };
+    void saveState(State& saved) const;
+    // Video memory that differs from the state is reported to the PPU as
+    // written, so only what changed is decoded or drawn again
+    void loadState(const State& saved);
+    
 private:
     // SNES Memory Map (simplified for now)
     // Total addressable space: 16MB (24-bit addressing)
@@ -44,6 +133,33 @@ private:
     // ROM data
     std::vector<uint8> rom;
     
+    // Bumped on ROM load/reset so cached page pointers get rebuilt
+    uint32 mappingGeneration;
+    
+    DMAController* dma;
+    PPU* ppu;
+    SPC700* apu;
+    APUClock* apuClock;
+    Scheduler* scheduler;
+    uint32 stallCycles;
+    
+    // B-bus access ports for VRAM/CGRAM/OAM/WRAM
+    uint16 vramAddress;                         // VMADD ($2116/$2117), word address
+    uint8  vramIncrementMode;                   // VMAIN ($2115)
+    uint16 vramReadBuffer;                      // Prefetch latch for $2139/$213A
+    uint16 cgramAddress;                        // Byte address into CGRAM (CGADD * 2 + phase)
+    uint8  cgramLatch;                          // Low byte waiting for its high byte
+    uint16 oamAddress;                          // Byte address into OAM
+    uint8  oamLatch;
+    uint32 wramPortAddress;                     // WMADD ($2181-$2183), 17-bit
+    
+    uint16 vramTranslate(uint16 address) const;
+    uint16 vramStep() const;
+    void writeVRAMPort(bool high, uint8 value);
+    uint8 readVRAMPort(bool high);
+    void writeCGRAMPort(uint8 value);
+    void writeOAMPort(uint8 value);
+    
     // Memory mapping helper
     uint8 readMapped(uint32 address);
     void writeMapped(uint32 address, uint8 value);
@@ -0,0 +1,248 @@
+//
+//  Compositor.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "Compositor.hpp"
+#include "TileDecoder.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMPOSITOR_X86 1
+#endif
+
+void Compositor::mergeLayer(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                            const uint8* index, const uint8* depth, int step,
+                            const uint8* window, uint8 math, uint8 mathMin, int count) {
+    switch (TileDecoder::getLevel()) {
+#ifdef COMPOSITOR_X86
+        case TileDecoder::LEVEL_AVX2:
+            mergeLayerAVX2(destIndex, destDepth, destMath, index, depth, step, window, math, mathMin, count);
+            break;
+        case TileDecoder::LEVEL_SSE2:
+            mergeLayerSSE2(destIndex, destDepth, destMath, index, depth, step, window, math, mathMin, count);
+            break;
+#endif
+        default:
+            mergeLayerScalar(destIndex, destDepth, destMath, index, depth, step, window, math, mathMin, count);
+            break;
+    }
+}
+
+void Compositor::blendLine(const uint16* mainColor, const uint16* subColor,
+                          const uint8* math, const uint8* half,
+                          bool subtract, uint16* out, int count) {
+    switch (TileDecoder::getLevel()) {
+#ifdef COMPOSITOR_X86
+        case TileDecoder::LEVEL_AVX2:
+            blendLineAVX2(mainColor, subColor, math, half, subtract, out, count);
+            break;
+        case TileDecoder::LEVEL_SSE2:
+            blendLineSSE2(mainColor, subColor, math, half, subtract, out, count);
+            break;
+#endif
+        default:
+            blendLineScalar(mainColor, subColor, math, half, subtract, out, count);
+            break;
+    }
+}
+
+void Compositor::mergeLayerScalar(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                                  const uint8* index, const uint8* depth, int step,
+                                  const uint8* window, uint8 math, uint8 mathMin, int count) {
+    for (int x = 0; x < count; ++x) {
+        uint8 c = index[x * step];
+        uint8 z = depth[x * step];
+        if (c != 0 && z > destDepth[x] && window[x] == 0) {
+            destIndex[x] = c;
+            destDepth[x] = z;
+            destMath[x] = c >= mathMin ? math : 0x00;
+        }
+    }
+}
+
+void Compositor::blendLineScalar(const uint16* mainColor, const uint16* subColor,
+                                const uint8* math, const uint8* half,
+                                bool subtract, uint16* out, int count) {
+    for (int x = 0; x < count; ++x) {
+        uint16 result = 0;
+        for (int shift = 0; shift < 15; shift += 5) {
+            int a = (mainColor[x] >> shift) & 0x1F;
+            int b = (subColor[x] >> shift) & 0x1F;
+            int value = subtract ? a - b : a + b;
+            if (subtract && value < 0) {
+                value = 0;
+            }
+            if (half[x]) {
+                value >>= 1;
+            } else if (value > 31) {
+                value = 31;
+            }
+            if (!math[x]) {
+                value = a;
+            }
+            result |= value << shift;
+        }
+        out[x] = result;
+    }
+}
+
+#ifdef COMPOSITOR_X86
+
+namespace {
+    // 16 layer pixels, taking every other byte for hi-res layers
+    __attribute__((target("sse2")))
+    inline __m128i loadLayerSSE2(const uint8* source, int step) {
+        if (step == 1) {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        }
+        const __m128i even = _mm_set1_epi16(0x00FF);
+        __m128i low = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source)), even);
+        __m128i high = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16)), even);
+        return _mm_packus_epi16(low, high);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i loadLayerAVX2(const uint8* source, int step) {
+        if (step == 1) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+        }
+        const __m256i even = _mm256_set1_epi16(0x00FF);
+        __m256i low = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)), even);
+        __m256i high = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 32)), even);
+        // packus works per 128-bit lane; put the quarters back in order
+        return _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+    }
+}
+
+__attribute__((target("sse2")))
+void Compositor::mergeLayerSSE2(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                                const uint8* index, const uint8* depth, int step,
+                                const uint8* window, uint8 math, uint8 mathMin, int count) {
+    if (step > 2) {
+        mergeLayerScalar(destIndex, destDepth, destMath, index, depth, step, window, math, mathMin, count);
+        return;
+    }
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mathValue = _mm_set1_epi8(static_cast<char>(math));
+    const __m128i minimum = _mm_set1_epi8(static_cast<char>(mathMin));
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i c = loadLayerSSE2(index + x * step, step);
+        __m128i z = loadLayerSSE2(depth + x * step, step);
+        __m128i oldIndex = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destIndex + x));
+        __m128i oldDepth = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destDepth + x));
+        __m128i oldMath = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destMath + x));
+        __m128i outside = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(window + x)), zero);
+        __m128i take = _mm_andnot_si128(_mm_cmpeq_epi8(c, zero), _mm_and_si128(_mm_cmpgt_epi8(z, oldDepth), outside));
+        __m128i pixelMath = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(c, minimum), c), mathValue);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destIndex + x),
+                         _mm_or_si128(_mm_and_si128(take, c), _mm_andnot_si128(take, oldIndex)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destDepth + x),
+                         _mm_or_si128(_mm_and_si128(take, z), _mm_andnot_si128(take, oldDepth)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destMath + x),
+                         _mm_or_si128(_mm_and_si128(take, pixelMath), _mm_andnot_si128(take, oldMath)));
+    }
+    if (x < count) {
+        mergeLayerScalar(destIndex + x, destDepth + x, destMath + x, index + x * step, depth + x * step,
+                         step, window + x, math, mathMin, count - x);
+    }
+}
+
+__attribute__((target("avx2")))
+void Compositor::mergeLayerAVX2(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                                const uint8* index, const uint8* depth, int step,
+                                const uint8* window, uint8 math, uint8 mathMin, int count) {
+    if (step > 2) {
+        mergeLayerScalar(destIndex, destDepth, destMath, index, depth, step, window, math, mathMin, count);
+        return;
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mathValue = _mm256_set1_epi8(static_cast<char>(math));
+    const __m256i minimum = _mm256_set1_epi8(static_cast<char>(mathMin));
+    int x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i c = loadLayerAVX2(index + x * step, step);
+        __m256i z = loadLayerAVX2(depth + x * step, step);
+        __m256i oldIndex = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destIndex + x));
+        __m256i oldDepth = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destDepth + x));
+        __m256i oldMath = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destMath + x));
+        __m256i outside = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(window + x)), zero);
+        __m256i take = _mm256_andnot_si256(_mm256_cmpeq_epi8(c, zero), _mm256_and_si256(_mm256_cmpgt_epi8(z, oldDepth), outside));
+        __m256i pixelMath = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(c, minimum), c), mathValue);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destIndex + x), _mm256_blendv_epi8(oldIndex, c, take));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destDepth + x), _mm256_blendv_epi8(oldDepth, z, take));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destMath + x), _mm256_blendv_epi8(oldMath, pixelMath, take));
+    }
+    if (x < count) {
+        mergeLayerSSE2(destIndex + x, destDepth + x, destMath + x, index + x * step, depth + x * step,
+                       step, window + x, math, mathMin, count - x);
+    }
+}
+
+__attribute__((target("sse2")))
+void Compositor::blendLineSSE2(const uint16* mainColor, const uint16* subColor,
+                              const uint8* math, const uint8* half,
+                              bool subtract, uint16* out, int count) {
+    const __m128i component = _mm_set1_epi16(0x1F);
+    const __m128i maximum = _mm_set1_epi16(31);
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mainColor + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(subColor + x));
+        // Widen the byte masks to 16-bit lanes
+        __m128i mathMask = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(math + x));
+        __m128i halfMask = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(half + x));
+        mathMask = _mm_unpacklo_epi8(mathMask, mathMask);
+        halfMask = _mm_unpacklo_epi8(halfMask, halfMask);
+
+        __m128i result = _mm_setzero_si128();
+        for (int shift = 0; shift < 15; shift += 5) {
+            __m128i ca = _mm_and_si128(_mm_srli_epi16(a, shift), component);
+            __m128i cb = _mm_and_si128(_mm_srli_epi16(b, shift), component);
+            __m128i value = subtract ? _mm_subs_epu16(ca, cb) : _mm_add_epi16(ca, cb);
+            __m128i halved = _mm_srli_epi16(value, 1);
+            __m128i clamped = _mm_min_epi16(value, maximum);
+            value = _mm_or_si128(_mm_and_si128(halfMask, halved), _mm_andnot_si128(halfMask, clamped));
+            value = _mm_or_si128(_mm_and_si128(mathMask, value), _mm_andnot_si128(mathMask, ca));
+            result = _mm_or_si128(result, _mm_slli_epi16(value, shift));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), result);
+    }
+    if (x < count) {
+        blendLineScalar(mainColor + x, subColor + x, math + x, half + x, subtract, out + x, count - x);
+    }
+}
+
+__attribute__((target("avx2")))
+void Compositor::blendLineAVX2(const uint16* mainColor, const uint16* subColor,
+                              const uint8* math, const uint8* half,
+                              bool subtract, uint16* out, int count) {
+    const __m256i component = _mm256_set1_epi16(0x1F);
+    const __m256i maximum = _mm256_set1_epi16(31);
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mainColor + x));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(subColor + x));
+        __m256i mathMask = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(math + x)));
+        __m256i halfMask = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half + x)));
+
+        __m256i result = _mm256_setzero_si256();
+        for (int shift = 0; shift < 15; shift += 5) {
+            __m256i ca = _mm256_and_si256(_mm256_srli_epi16(a, shift), component);
+            __m256i cb = _mm256_and_si256(_mm256_srli_epi16(b, shift), component);
+            __m256i value = subtract ? _mm256_subs_epu16(ca, cb) : _mm256_add_epi16(ca, cb);
+            value = _mm256_blendv_epi8(_mm256_min_epi16(value, maximum), _mm256_srli_epi16(value, 1), halfMask);
+            value = _mm256_blendv_epi8(ca, value, mathMask);
+            result = _mm256_or_si256(result, _mm256_slli_epi16(value, shift));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), result);
+    }
+    if (x < count) {
+        blendLineSSE2(mainColor + x, subColor + x, math + x, half + x, subtract, out + x, count - x);
+    }
+}
+
+#endif
@@ -0,0 +1,57 @@
+//
+//  Compositor.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef COMPOSITOR_HPP
+#define COMPOSITOR_HPP
+
+#include "../Types/Types.hpp"
+
+// Per-line compositing kernels
+// Layers are merged into the main/sub screen lines by depth, then the
+// two lines are blended (color math). Master brightness is left to the
+// output conversion (FrameOutput).
+// Everything works on whole lines with byte masks (0x00/0xFF), so there
+// is no per-pixel branching. The kernel level follows TileDecoder::getLevel().
+class Compositor {
+public:
+    // Merge one layer into a screen line. A layer pixel wins if it is
+    // opaque (index != 0), outside the masking window (window == 0) and
+    // deeper than what is there (depth values < 128). The winner's math
+    // flag is math if its index >= mathMin, else 0. Layer pixels are read
+    // every step bytes (1, or 2 for hi-res layers).
+    static void mergeLayer(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                           const uint8* index, const uint8* depth, int step,
+                           const uint8* window, uint8 math, uint8 mathMin, int count);
+
+    // out[x] = math[x] ? main[x] +/- sub[x] (halved where half[x]) : main[x]
+    // Sums clamp at 31 per component, differences at 0.
+    static void blendLine(const uint16* mainColor, const uint16* subColor,
+                          const uint8* math, const uint8* half,
+                          bool subtract, uint16* out, int count);
+
+    static void mergeLayerScalar(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                                 const uint8* index, const uint8* depth, int step,
+                                 const uint8* window, uint8 math, uint8 mathMin, int count);
+    static void blendLineScalar(const uint16* mainColor, const uint16* subColor,
+                                const uint8* math, const uint8* half,
+                                bool subtract, uint16* out, int count);
+#if defined(__x86_64__) || defined(__i386__)
+    static void mergeLayerSSE2(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                               const uint8* index, const uint8* depth, int step,
+                               const uint8* window, uint8 math, uint8 mathMin, int count);
+    static void mergeLayerAVX2(uint8* destIndex, uint8* destDepth, uint8* destMath,
+                               const uint8* index, const uint8* depth, int step,
+                               const uint8* window, uint8 math, uint8 mathMin, int count);
+    static void blendLineSSE2(const uint16* mainColor, const uint16* subColor,
+                              const uint8* math, const uint8* half,
+                              bool subtract, uint16* out, int count);
+    static void blendLineAVX2(const uint16* mainColor, const uint16* subColor,
+                              const uint8* math, const uint8* half,
+                              bool subtract, uint16* out, int count);
+#endif
+};
+#endif
@@ -0,0 +1,214 @@
+//
+//  FrameOutput.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "FrameOutput.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Scale the first width pixels of each row up by factor, in place.
+    // Rows move from the bottom and pixels from the right, so nothing is
+    // overwritten before it is read.
+    template <typename Pixel>
+    void scaleRows(uint8* pixels, int height, int width, int factor, int oldStride, int newStride) {
+        for (int y = height - 1; y >= 0; --y) {
+            const Pixel* src = reinterpret_cast<const Pixel*>(pixels + y * oldStride);
+            Pixel* dst = reinterpret_cast<Pixel*>(pixels + y * newStride);
+            for (int x = width - 1; x >= 0; --x) {
+                Pixel value = src[x];
+                for (int n = factor - 1; n >= 0; --n) {
+                    dst[x * factor + n] = value;
+                }
+            }
+        }
+    }
+
+    template <typename Pixel>
+    void convertLine(Pixel* row, const uint16* colors, const uint32* palette, int count, int factor) {
+        if (factor == 1) {
+            for (int x = 0; x < count; ++x) {
+                row[x] = static_cast<Pixel>(palette[colors[x] & 0x7FFF]);
+            }
+            return;
+        }
+        for (int x = 0; x < count; ++x) {
+            Pixel value = static_cast<Pixel>(palette[colors[x] & 0x7FFF]);
+            for (int n = 0; n < factor; ++n) {
+                row[x * factor + n] = value;
+            }
+        }
+    }
+}
+
+FrameOutput::FrameOutput(int width, int height): format(FORMAT_BGRA8888), back(0), front(1), middle(2) {
+    for (Buffer& buffer : buffers) {
+        buffer.pixels = nullptr;
+        buffer.width = width;
+        buffer.height = height;
+        buffer.stride = 0;
+    }
+    setFormat(FORMAT_BGRA8888);
+}
+
+void FrameOutput::setFormat(Format format) {
+    if (format == this->format && buffers[0].pixels) {
+        return;
+    }
+    this->format = format;
+    for (int level = 0; level < BRIGHTNESS_LEVELS; ++level) {
+        palettes[level].clear();
+    }
+    for (Buffer& buffer : buffers) {
+        buffer.stride = strideFor(buffer.width);
+        reserve(buffer, static_cast<size_t>(buffer.stride) * buffer.height, false);
+    }
+    clear();
+}
+
+void FrameOutput::resize(int width, int height) {
+    Buffer& buffer = buffers[back];
+    if (width == buffer.width && height == buffer.height) {
+        return;
+    }
+    buffer.width = width;
+    buffer.height = height;
+    buffer.stride = strideFor(width);
+    reserve(buffer, static_cast<size_t>(buffer.stride) * height, false);
+}
+
+void FrameOutput::widen(int width) {
+    Buffer& buffer = buffers[back];
+    if (width <= buffer.width) {
+        return;
+    }
+    int factor = width / buffer.width;
+    int oldStride = buffer.stride;
+    int newStride = strideFor(width);
+    reserve(buffer, static_cast<size_t>(newStride) * buffer.height, true);
+    if (format == FORMAT_RGB565) {
+        scaleRows<uint16>(buffer.pixels, buffer.height, buffer.width, factor, oldStride, newStride);
+    } else {
+        scaleRows<uint32>(buffer.pixels, buffer.height, buffer.width, factor, oldStride, newStride);
+    }
+    buffer.width = width;
+    buffer.stride = newStride;
+}
+
+// Make room for bytes of rows, keeping the current ones if asked
+void FrameOutput::reserve(Buffer& buffer, size_t bytes, bool keep) {
+    if (buffer.pixels && buffer.storage.size() >= bytes + 15) {
+        return;
+    }
+    std::vector<uint8> storage(bytes + 15, 0);
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+    uint8* pixels = storage.data() + ((16 - (address & 15)) & 15);
+    if (keep && buffer.pixels) {
+        std::memcpy(pixels, buffer.pixels, static_cast<size_t>(buffer.stride) * buffer.height);
+    }
+    buffer.storage.swap(storage);
+    buffer.pixels = pixels;
+}
+
+void FrameOutput::clear() {
+    for (Buffer& buffer : buffers) {
+        clearBuffer(buffer);
+    }
+}
+
+void FrameOutput::clearBuffer(Buffer& buffer) {
+    uint32 black = convert(0, 0);
+    for (int y = 0; y < buffer.height; ++y) {
+        uint8* row = buffer.pixels + y * buffer.stride;
+        if (format == FORMAT_RGB565) {
+            std::fill(reinterpret_cast<uint16*>(row), reinterpret_cast<uint16*>(row) + buffer.width,
+                      static_cast<uint16>(black));
+        } else {
+            std::fill(reinterpret_cast<uint32*>(row), reinterpret_cast<uint32*>(row) + buffer.width, black);
+        }
+    }
+}
+
+void FrameOutput::publish() {
+    // Release makes the finished rows visible to the consumer's acquire
+    uint8 previous = middle.exchange(static_cast<uint8>(back | FRESH), std::memory_order_acq_rel);
+    back = previous & 0x03;
+}
+
+FrameOutput::Frame FrameOutput::acquireFrame() {
+    // Only the consumer clears FRESH, so it cannot be lost between the two steps
+    if (middle.load(std::memory_order_relaxed) & FRESH) {
+        uint8 previous = middle.exchange(static_cast<uint8>(front), std::memory_order_acq_rel);
+        front = previous & 0x03;
+    }
+    return describe(buffers[front]);
+}
+
+FrameOutput::Frame FrameOutput::describe(const Buffer& buffer) {
+    Frame frame;
+    frame.pixels = buffer.pixels;
+    frame.width = buffer.width;
+    frame.height = buffer.height;
+    frame.stride = buffer.stride;
+    return frame;
+}
+
+uint32 FrameOutput::convert(uint16 color, uint8 brightness) {
+    return getPalette(brightness)[color & 0x7FFF];
+}
+
+const uint32* FrameOutput::getPalette(uint8 brightness) {
+    std::vector<uint32>& palette = palettes[brightness & 0x0F];
+    if (!palette.empty()) {
+        return palette.data();
+    }
+    palette.resize(COLOR_COUNT);
+    int scale = (brightness & 0x0F) + 1;
+    for (int color = 0; color < COLOR_COUNT; ++color) {
+        // Brightness scales each 5-bit component, as the PPU's DAC does
+        uint32 r = ((color & 0x1F) * scale) >> 4;
+        uint32 g = (((color >> 5) & 0x1F) * scale) >> 4;
+        uint32 b = (((color >> 10) & 0x1F) * scale) >> 4;
+        if (brightness == 0) {
+            r = g = b = 0;
+        }
+        switch (format) {
+            case FORMAT_RGB565:
+                palette[color] = (r << 11) | (((g << 1) | (g >> 4)) << 5) | b;
+                break;
+            case FORMAT_RGBA8888:
+                r = (r << 3) | (r >> 2);
+                g = (g << 3) | (g >> 2);
+                b = (b << 3) | (b >> 2);
+                palette[color] = 0xFF000000 | (b << 16) | (g << 8) | r;
+                break;
+            case FORMAT_BGRA8888:
+            default:
+                r = (r << 3) | (r >> 2);
+                g = (g << 3) | (g >> 2);
+                b = (b << 3) | (b >> 2);
+                palette[color] = 0xFF000000 | (r << 16) | (g << 8) | b;
+                break;
+        }
+    }
+    return palette.data();
+}
+
+void FrameOutput::writeLine(int y, const uint16* colors, uint8 brightness, int count) {
+    if (y < 0 || y >= getHeight() || count <= 0) {
+        return;
+    }
+    if (count > getWidth()) {
+        widen(count);
+    }
+    int factor = getWidth() / count;
+    const uint32* palette = getPalette(brightness);
+    if (format == FORMAT_RGB565) {
+        convertLine(reinterpret_cast<uint16*>(getRow(y)), colors, palette, count, factor);
+    } else {
+        convertLine(reinterpret_cast<uint32*>(getRow(y)), colors, palette, count, factor);
+    }
+}
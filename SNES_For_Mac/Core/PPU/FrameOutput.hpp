@@ -0,0 +1,130 @@
+//
+//  FrameOutput.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef FRAMEOUTPUT_HPP
+#define FRAMEOUTPUT_HPP
+
+#include "../Types/Types.hpp"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Display-ready frames
+// Finished BGR555 lines are converted straight into the pixel format the
+// front end uploads, through a 32768-entry palette per master brightness
+// level. Palettes are built the first time a level is used. Rows start on
+// 16-byte boundaries; the stride is the distance between them in bytes.
+//
+// Frames are triple buffered between one producer (the emulation thread,
+// writing rows and calling publish()) and one consumer (the presenter,
+// calling acquireFrame()). The two sides trade buffers through a single
+// atomic, so neither ever waits or copies, and the consumer always gets
+// the newest complete frame.
+//
+// Each buffer has its own size. A frame is 256 wide until a hi-res line
+// is written; only then is it widened to 512 and narrower lines are
+// doubled, so ordinary frames never touch more than 256 pixels a row.
+class FrameOutput {
+public:
+    // Named by byte order in memory. BGRA8888 is XRGB8888 read as a
+    // little-endian uint32.
+    enum Format {
+        FORMAT_BGRA8888 = 0,
+        FORMAT_RGBA8888,
+        FORMAT_RGB565
+    };
+
+    // Size and rows of one complete frame
+    struct Frame {
+        const uint8* pixels;
+        int width;                      // 256, or 512 with hi-res lines
+        int height;                     // 224/239, doubled when interlaced
+        int stride;                     // Bytes between rows
+    };
+
+    FrameOutput(int width, int height);
+
+    // Reallocates the buffers and drops the palettes; not while a
+    // consumer is reading frames
+    void setFormat(Format format);
+
+    // Producer: size of the frame being rendered. Only the back buffer
+    // changes (growing if it has to), so the consumer can keep reading.
+    void resize(int width, int height);
+
+    // Producer: make the frame being rendered at least width pixels wide;
+    // rows already written are scaled up in place
+    void widen(int width);
+
+    // Size of the frame being rendered
+    Format getFormat() const { return format; }
+    int getWidth() const { return buffers[back].width; }
+    int getHeight() const { return buffers[back].height; }
+    int getBytesPerPixel() const { return format == FORMAT_RGB565 ? 2 : 4; }
+    int getStride() const { return buffers[back].stride; }
+
+    // Producer: row y of the frame being rendered
+    uint8* getRow(int y) { return buffers[back].pixels + y * buffers[back].stride; }
+    const uint8* getRow(int y) const { return buffers[back].pixels + y * buffers[back].stride; }
+
+    // Producer: convert count BGR555 pixels into row y at master
+    // brightness 0-15. A wider line widens the frame; a narrower one is
+    // scaled up to the frame's width.
+    void writeLine(int y, const uint16* colors, uint8 brightness, int count);
+
+    // Producer: the frame being rendered is complete
+    void publish();
+
+    // Consumer: newest complete frame. It stays valid and unchanged until
+    // the next acquireFrame() call.
+    Frame acquireFrame();
+
+    // Consumer: the frame the last acquireFrame() returned
+    Frame getFrontFrame() const { return describe(buffers[front]); }
+
+    // Every row of every buffer black; not while a consumer is reading frames
+    void clear();
+
+    // Converted value of one BGR555 color (low 16 bits for RGB565)
+    uint32 convert(uint16 color, uint8 brightness);
+
+    // Build the palette for a brightness level now. Once every level in
+    // use is built, writeLine() only reads shared state, so several
+    // threads can write different rows at once (after any widen()).
+    void preparePalette(uint8 brightness) { getPalette(brightness); }
+
+private:
+    static const int BRIGHTNESS_LEVELS = 16;
+    static const int COLOR_COUNT = 0x8000;
+
+    Format format;
+
+    struct Buffer {
+        std::vector<uint8> storage;
+        uint8* pixels;                  // 16-byte aligned inside storage
+        int width;
+        int height;
+        int stride;
+    };
+    Buffer buffers[3];
+
+    // Buffer roles: back is the producer's, front the consumer's; the
+    // third waits in middle, with FRESH set if it holds an unread frame
+    static const uint8 FRESH = 0x04;
+    int back;
+    int front;
+    std::atomic<uint8> middle;
+
+    std::vector<uint32> palettes[BRIGHTNESS_LEVELS];
+
+    int strideFor(int width) const { return (width * getBytesPerPixel() + 15) & ~15; }
+    void reserve(Buffer& buffer, size_t bytes, bool keep);
+    void clearBuffer(Buffer& buffer);
+    static Frame describe(const Buffer& buffer);
+    const uint32* getPalette(uint8 brightness);
+};
+#endif
@@ -0,0 +1,178 @@
+//
+//  Mode7Renderer.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "Mode7Renderer.hpp"
+#include "TileDecoder.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MODE7_X86 1
+#endif
+
+namespace {
+    // Scroll minus center is treated as a signed 10-bit value
+    inline int32 clip(int32 value) {
+        return (value & 0x2000) ? (value | ~0x3FF) : (value & 0x3FF);
+    }
+
+    inline uint8 samplePixel(const uint8* vram, int32 pixelX, int32 pixelY, uint8 screenOver) {
+        bool outside = ((pixelX | pixelY) & ~0x3FF) != 0;
+        uint8 tile = 0;
+        if (!outside || screenOver != 3) {
+            tile = vram[((((pixelY >> 3) & 127) << 7) | ((pixelX >> 3) & 127)) << 1];
+        }
+        if (outside && screenOver == 2) {
+            return 0;
+        }
+        return vram[((tile << 7) | ((pixelY & 7) << 4) | ((pixelX & 7) << 1)) | 1];
+    }
+}
+
+Mode7Renderer::Line Mode7Renderer::setupLine(const Matrix& matrix, int y) {
+    int32 a = matrix.a;
+    int32 b = matrix.b;
+    int32 c = matrix.c;
+    int32 d = matrix.d;
+    int32 screenY = (matrix.select & 0x02) ? 255 - y : y;
+    int32 hofs = clip(matrix.hofs - matrix.centerX);
+    int32 vofs = clip(matrix.vofs - matrix.centerY);
+
+    // The hardware drops the low 6 bits of each product
+    int32 originX = ((a * hofs) & ~63) + ((b * vofs) & ~63) + ((b * screenY) & ~63) + (matrix.centerX << 8);
+    int32 originY = ((c * hofs) & ~63) + ((d * vofs) & ~63) + ((d * screenY) & ~63) + (matrix.centerY << 8);
+
+    Line line;
+    line.screenOver = matrix.select >> 6;
+    if (matrix.select & 0x01) {
+        // Horizontal flip walks the line from x = 255 back to 0
+        line.startX = originX + a * 255;
+        line.startY = originY + c * 255;
+        line.stepX = -a;
+        line.stepY = -c;
+    } else {
+        line.startX = originX;
+        line.startY = originY;
+        line.stepX = a;
+        line.stepY = c;
+    }
+    return line;
+}
+
+void Mode7Renderer::renderLine(const uint8* vram, const Line& line, uint8* out) {
+    switch (TileDecoder::getLevel()) {
+#ifdef MODE7_X86
+        case TileDecoder::LEVEL_AVX2:
+            renderLineAVX2(vram, line, out);
+            break;
+        case TileDecoder::LEVEL_SSE2:
+            renderLineSSE2(vram, line, out);
+            break;
+#endif
+        default:
+            renderLineScalar(vram, line, out);
+            break;
+    }
+}
+
+void Mode7Renderer::renderLineScalar(const uint8* vram, const Line& line, uint8* out) {
+    int32 x = line.startX;
+    int32 y = line.startY;
+    for (int i = 0; i < 256; ++i) {
+        out[i] = samplePixel(vram, x >> 8, y >> 8, line.screenOver);
+        x += line.stepX;
+        y += line.stepY;
+    }
+}
+
+#ifdef MODE7_X86
+
+// Coordinates and addresses 4 pixels at a time; the lookups are unrolled scalar loads
+__attribute__((target("sse2")))
+void Mode7Renderer::renderLineSSE2(const uint8* vram, const Line& line, uint8* out) {
+    const __m128i planeMask = _mm_set1_epi32(~0x3FF);
+    const __m128i tileMask = _mm_set1_epi32(127);
+    const __m128i fineMask = _mm_set1_epi32(7);
+    __m128i x = _mm_setr_epi32(line.startX, line.startX + line.stepX,
+                               line.startX + line.stepX * 2, line.startX + line.stepX * 3);
+    __m128i y = _mm_setr_epi32(line.startY, line.startY + line.stepY,
+                               line.startY + line.stepY * 2, line.startY + line.stepY * 3);
+    const __m128i stepX = _mm_set1_epi32(line.stepX * 4);
+    const __m128i stepY = _mm_set1_epi32(line.stepY * 4);
+    alignas(16) int32 tileAddress[4];
+    alignas(16) int32 fineAddress[4];
+    alignas(16) int32 inside[4];
+
+    for (int i = 0; i < 256; i += 4) {
+        __m128i pixelX = _mm_srai_epi32(x, 8);
+        __m128i pixelY = _mm_srai_epi32(y, 8);
+        __m128i in = _mm_cmpeq_epi32(_mm_and_si128(_mm_or_si128(pixelX, pixelY), planeMask), _mm_setzero_si128());
+        __m128i map = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srai_epi32(pixelY, 3), tileMask), 8),
+                                   _mm_slli_epi32(_mm_and_si128(_mm_srai_epi32(pixelX, 3), tileMask), 1));
+        __m128i fine = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pixelY, fineMask), 4),
+                                    _mm_slli_epi32(_mm_and_si128(pixelX, fineMask), 1));
+        _mm_store_si128(reinterpret_cast<__m128i*>(tileAddress), map);
+        _mm_store_si128(reinterpret_cast<__m128i*>(fineAddress), _mm_or_si128(fine, _mm_set1_epi32(1)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(inside), in);
+
+        for (int n = 0; n < 4; ++n) {
+            uint8 tile = (inside[n] || line.screenOver != 3) ? vram[tileAddress[n]] : 0;
+            uint8 color = vram[(tile << 7) | fineAddress[n]];
+            out[i + n] = (inside[n] || line.screenOver != 2) ? color : 0;
+        }
+        x = _mm_add_epi32(x, stepX);
+        y = _mm_add_epi32(y, stepY);
+    }
+}
+
+// 8 pixels per step with hardware gathers. Mode 7 only addresses the
+// first 32KB of VRAM, so the 4-byte gather loads never leave the buffer.
+__attribute__((target("avx2")))
+void Mode7Renderer::renderLineAVX2(const uint8* vram, const Line& line, uint8* out) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i planeMask = _mm256_set1_epi32(~0x3FF);
+    const __m256i tileMask = _mm256_set1_epi32(127);
+    const __m256i fineMask = _mm256_set1_epi32(7);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i one = _mm256_set1_epi32(1);
+    // Byte 0 of each dword to the bottom of its 128-bit lane, then both lanes together
+    const __m256i packBytes = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                               0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i packLanes = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+    const bool fillTile0 = line.screenOver == 3;
+    const bool transparent = line.screenOver == 2;
+
+    __m256i x = _mm256_add_epi32(_mm256_set1_epi32(line.startX), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(line.stepX)));
+    __m256i y = _mm256_add_epi32(_mm256_set1_epi32(line.startY), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(line.stepY)));
+    const __m256i stepX = _mm256_set1_epi32(line.stepX * 8);
+    const __m256i stepY = _mm256_set1_epi32(line.stepY * 8);
+    const int* base = reinterpret_cast<const int*>(vram);
+
+    for (int i = 0; i < 256; i += 8) {
+        __m256i pixelX = _mm256_srai_epi32(x, 8);
+        __m256i pixelY = _mm256_srai_epi32(y, 8);
+        __m256i inside = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_or_si256(pixelX, pixelY), planeMask), _mm256_setzero_si256());
+        __m256i map = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(_mm256_srai_epi32(pixelY, 3), tileMask), 8),
+                                      _mm256_slli_epi32(_mm256_and_si256(_mm256_srai_epi32(pixelX, 3), tileMask), 1));
+        __m256i tile = _mm256_and_si256(_mm256_i32gather_epi32(base, map, 1), byteMask);
+        if (fillTile0) {
+            tile = _mm256_and_si256(tile, inside);
+        }
+        __m256i fine = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(pixelY, fineMask), 4),
+                                       _mm256_slli_epi32(_mm256_and_si256(pixelX, fineMask), 1));
+        __m256i address = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(tile, 7), fine), one);
+        __m256i color = _mm256_i32gather_epi32(base, address, 1);
+        if (transparent) {
+            color = _mm256_and_si256(color, inside);
+        }
+        __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(color, packBytes), packLanes);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+        x = _mm256_add_epi32(x, stepX);
+        y = _mm256_add_epi32(y, stepY);
+    }
+}
+
+#endif
@@ -0,0 +1,49 @@
+//
+//  Mode7Renderer.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef MODE7RENDERER_HPP
+#define MODE7RENDERER_HPP
+
+#include "../Types/Types.hpp"
+
+// Mode 7 affine line kernels
+// A Mode 7 line is a straight walk through the 1024x1024 plane, so each
+// kernel only needs the 8.8 fixed-point position of the first pixel and
+// the per-pixel step. VRAM words hold the 128x128 tilemap in their low
+// bytes and the 8bpp tile pixels in their high bytes.
+// The kernel level follows TileDecoder::getLevel().
+class Mode7Renderer {
+public:
+    struct Line {
+        int32 startX;                   // 8.8 fixed-point plane position of pixel 0
+        int32 startY;
+        int32 stepX;                    // Added per screen pixel
+        int32 stepY;
+        uint8 screenOver;               // M7SEL bits 6-7: 0/1 wrap, 2 transparent, 3 tile 0
+    };
+
+    // Matrix registers as the game wrote them
+    struct Matrix {
+        int16 a, b, c, d;               // M7A-M7D, signed 8.8
+        int16 centerX, centerY;         // M7X/M7Y, signed 13-bit
+        int16 hofs, vofs;               // M7HOFS/M7VOFS, signed 13-bit
+        uint8 select;                   // M7SEL ($211A)
+    };
+
+    // Walk for screen line y (1-224), with M7SEL flips applied
+    static Line setupLine(const Matrix& matrix, int y);
+
+    // 256 pixels of raw 8-bit color (0 = transparent)
+    static void renderLine(const uint8* vram, const Line& line, uint8* out);
+
+    static void renderLineScalar(const uint8* vram, const Line& line, uint8* out);
+#if defined(__x86_64__) || defined(__i386__)
+    static void renderLineSSE2(const uint8* vram, const Line& line, uint8* out);
+    static void renderLineAVX2(const uint8* vram, const Line& line, uint8* out);
+#endif
+};
+#endif
@@ -0,0 +1,521 @@
+//
+//  PPU.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "PPU.hpp"
+#include "../Memory/Memory.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Mode 7 center/scroll registers are 13-bit two's complement
+    inline int16 signExtend13(uint16 value) {
+        return static_cast<int16>(((value & 0x1FFF) ^ 0x1000) - 0x1000);
+    }
+
+    const int CGRAM_SIZE = 512;
+
+    // Forced blank shows black, like brightness 0
+    inline uint8 lineBrightness(const PPU::RenderState& state) {
+        return (state.displayControl & 0x80) ? 0 : state.displayControl & 0x0F;
+    }
+}
+
+PPU::PPU(): memory(nullptr), output(SCREEN_WIDTH, SCREEN_HEIGHT), cgramCopyCount(0),
+             skipUnchanged(true), renderEnabled(true), renderedLines(0), skippedLines(0) {
+    renderers.emplace_back(new ScanlineRenderer());
+    reset();
+}
+
+void PPU::reset() {
+    std::memset(&state, 0, sizeof(state));
+    state.displayControl = 0x80;        // Forced blank at power on
+    scrollLatch = 0;
+    hscrollLatch = 0;
+    mode7Latch = 0;
+    rangeOver = false;
+    timeOver = false;
+    pending.clear();
+    cgramCopyCount = 0;
+    spriteTable.setObjectSelect(0);
+    spriteTable.invalidate();
+    // Back to a compact 256x224 frame
+    visibleLines = SCREEN_HEIGHT;
+    interlace = false;
+    field = 0;
+    frameWidth = SCREEN_WIDTH;
+    frameHeight = SCREEN_HEIGHT;
+    frameStride = SCREEN_WIDTH;
+    frameBuffer.assign(SCREEN_WIDTH * MAX_SCREEN_HEIGHT, 0);
+    frameBuffer.shrink_to_fit();
+    output.resize(SCREEN_WIDTH, SCREEN_HEIGHT);
+    output.clear();
+    for (auto& renderer : renderers) {
+        renderer->getTileCache().reset();
+    }
+    clearHistory();
+    resetLineStats();
+}
+
+void PPU::setMemory(Memory* mem) {
+    pending.clear();
+    cgramCopyCount = 0;
+    memory = mem;
+    for (auto& renderer : renderers) {
+        renderer->getTileCache().invalidateAll();
+    }
+    clearHistory();
+}
+
+void PPU::setSkipUnchangedLines(bool enabled) {
+    flushLines();
+    skipUnchanged = enabled;
+    clearHistory();
+}
+
+void PPU::setRenderEnabled(bool enabled) {
+    flushLines();
+    renderEnabled = enabled;
+}
+
+void PPU::saveState(State& saved) {
+    // Recorded lines would be drawn from the registers as they are now
+    flushLines();
+    std::memcpy(&saved.registers, &state, sizeof(state));
+    saved.scrollLatch = scrollLatch;
+    saved.hscrollLatch = hscrollLatch;
+    saved.mode7Latch = mode7Latch;
+    saved.visibleLines = visibleLines;
+    saved.interlace = interlace;
+    saved.field = field;
+    saved.rangeOver = rangeOver;
+    saved.timeOver = timeOver;
+}
+
+void PPU::loadState(const State& saved) {
+    flushLines();
+    std::memcpy(&state, &saved.registers, sizeof(state));
+    scrollLatch = saved.scrollLatch;
+    hscrollLatch = saved.hscrollLatch;
+    mode7Latch = saved.mode7Latch;
+    spriteTable.setObjectSelect(state.objectSelect);
+    setGeometry(saved.interlace, saved.visibleLines);
+    field = saved.field;
+    rangeOver = saved.rangeOver;
+    timeOver = saved.timeOver;
+}
+
+void PPU::clearHistory() {
+    writeCount = 0;
+    std::memset(vramStamp, 0, sizeof(vramStamp));
+    cgramStamp = 0;
+    oamStamp = 0;
+    std::memset(history, 0, sizeof(history));
+    for (LineHistory& row : history) {
+        row.width = SCREEN_WIDTH;
+    }
+}
+
+// Line 1: latch the frame's size from SETINI
+void PPU::startFrame() {
+    flushLines();
+    bool interlaced = (state.screenInit & 0x01) != 0;
+    int lines = (state.screenInit & 0x04) ? MAX_SCREEN_HEIGHT : SCREEN_HEIGHT;
+    field = interlaced ? field ^ 1 : 0;
+    setGeometry(interlaced, lines);
+    frameWidth = SCREEN_WIDTH;
+    output.resize(SCREEN_WIDTH, frameHeight);
+}
+
+void PPU::setGeometry(bool interlaced, int lines) {
+    if (interlaced == interlace && lines == visibleLines) {
+        return;
+    }
+    // Rows mean different lines now
+    interlace = interlaced;
+    visibleLines = lines;
+    frameHeight = interlaced ? lines * 2 : lines;
+    if (static_cast<int>(frameBuffer.size()) < frameStride * frameHeight) {
+        frameBuffer.resize(frameStride * frameHeight);
+    }
+    clearHistory();
+}
+
+// Make the frame width pixels wide: the output scales up the rows written
+// so far, and the first hi-res line ever moves the BGR555 rows apart
+void PPU::widenFrame(int width) {
+    if (width <= frameWidth) {
+        return;
+    }
+    frameWidth = width;
+    output.widen(width);
+    if (width > frameStride) {
+        int rows = static_cast<int>(frameBuffer.size()) / frameStride;
+        frameBuffer.resize(rows * width);
+        for (int row = rows - 1; row > 0; --row) {
+            std::memmove(&frameBuffer[row * width], &frameBuffer[row * frameStride], frameStride * sizeof(uint16));
+        }
+        frameStride = width;
+    }
+}
+
+// Get the output ready for a line's rows (its own and, interlaced, the
+// other field's row it is shown with), so drawing only reads shared state
+void PPU::prepareOutput(int line, const RenderState& lineState) {
+    int width = ScanlineRenderer::lineWidth(lineState);
+    output.preparePalette(lineBrightness(lineState));
+    if (interlace) {
+        const LineHistory& other = history[frameRow(line) ^ 1];
+        if (other.valid) {
+            width = std::max<int>(width, other.width);
+            output.preparePalette(lineBrightness(other.state));
+        }
+        output.preparePalette(0);
+    }
+    widenFrame(width);
+}
+
+void PPU::setRenderThreads(int threads) {
+    flushLines();
+    if (threads <= 0) {
+        workers.reset();
+        renderers.resize(1);
+        return;
+    }
+    workers.reset(new RenderWorkers(threads));
+    while (static_cast<int>(renderers.size()) < threads + 1) {
+        renderers.emplace_back(new ScanlineRenderer());
+    }
+    renderers.resize(threads + 1);
+    pending.reserve(MAX_SCREEN_HEIGHT);
+    cgramCopies.resize(CGRAM_SIZE * (MAX_SCREEN_HEIGHT + 1));
+}
+
+void PPU::beforeVRAMWrite(uint32 byteAddress, uint32 length) {
+    if (length == 0) {
+        return;
+    }
+    flushLines();
+    for (auto& renderer : renderers) {
+        renderer->getTileCache().invalidateRange(byteAddress, length);
+    }
+    uint64 stamp = ++writeCount;
+    if (length >= 0x10000) {
+        std::fill(vramStamp, vramStamp + 64, stamp);
+        return;
+    }
+    for (uint32 block = byteAddress >> 10; block <= (byteAddress + length - 1) >> 10; ++block) {
+        vramStamp[block & 63] = stamp;
+    }
+}
+
+uint8 PPU::readRegister(uint16 offset) {
+    switch (offset) {
+        case 0x2134:            // MPYL/MPYM/MPYH: M7A * high byte of M7B
+        case 0x2135:
+        case 0x2136:
+        {
+            int32 product = state.mode7.a * static_cast<int8>(state.mode7.b >> 8);
+            return static_cast<uint8>(product >> ((offset - 0x2134) * 8));
+        }
+        case 0x213E:            // STAT77: sprite overflow flags, PPU1 version
+            flushLines();
+            return (timeOver ? 0x80 : 0x00) | (rangeOver ? 0x40 : 0x00) | 0x01;
+        case 0x213F:            // STAT78: PPU2 version, NTSC
+            return 0x03;
+        default:
+            return 0xFF;        // Open bus
+    }
+}
+
+void PPU::writeRegister(uint16 offset, uint8 value) {
+    switch (offset) {
+        case 0x2100:            // INIDISP
+            state.displayControl = value;
+            break;
+        case 0x2101:            // OBSEL
+            // Recorded lines share the sprite table, which this rebuilds
+            flushLines();
+            state.objectSelect = value;
+            spriteTable.setObjectSelect(value);
+            break;
+        case 0x2105:            // BGMODE
+            state.bgMode = value;
+            break;
+        case 0x2106:            // MOSAIC
+            state.mosaic = value;
+            break;
+        case 0x2107:            // BG1SC-BG4SC
+        case 0x2108:
+        case 0x2109:
+        case 0x210A:
+        {
+            BGLayer& layer = state.bg[offset - 0x2107];
+            layer.tilemapAddress = (value & 0xFC) << 8;
+            layer.tilemapSize = value & 0x03;
+            break;
+        }
+        case 0x210B:            // BG12NBA
+            state.bg[0].charAddress = (value & 0x0F) << 12;
+            state.bg[1].charAddress = (value & 0xF0) << 8;
+            break;
+        case 0x210C:            // BG34NBA
+            state.bg[2].charAddress = (value & 0x0F) << 12;
+            state.bg[3].charAddress = (value & 0xF0) << 8;
+            break;
+        case 0x210D:            // BGnHOFS / BGnVOFS (write twice)
+        case 0x210E:
+        case 0x210F:
+        case 0x2110:
+        case 0x2111:
+        case 0x2112:
+        case 0x2113:
+        case 0x2114:
+        {
+            // BG1 scroll doubles as the Mode 7 scroll, with its own latch
+            if (offset == 0x210D) {
+                state.mode7.hofs = signExtend13((value << 8) | mode7Latch);
+                mode7Latch = value;
+            } else if (offset == 0x210E) {
+                state.mode7.vofs = signExtend13((value << 8) | mode7Latch);
+                mode7Latch = value;
+            }
+            BGLayer& layer = state.bg[(offset - 0x210D) >> 1];
+            if (((offset - 0x210D) & 0x01) == 0) {
+                layer.hofs = ((value << 8) | (scrollLatch & ~0x07) | (hscrollLatch & 0x07)) & 0x3FF;
+                hscrollLatch = value;
+            } else {
+                layer.vofs = ((value << 8) | scrollLatch) & 0x3FF;
+            }
+            scrollLatch = value;
+            break;
+        }
+        case 0x211A:            // M7SEL
+            state.mode7.select = value;
+            break;
+        case 0x211B:            // M7A-M7D (write twice, low then high)
+        case 0x211C:
+        case 0x211D:
+        case 0x211E:
+        {
+            int16 matrixValue = static_cast<int16>((value << 8) | mode7Latch);
+            int16* targets[4] = { &state.mode7.a, &state.mode7.b, &state.mode7.c, &state.mode7.d };
+            *targets[offset - 0x211B] = matrixValue;
+            mode7Latch = value;
+            break;
+        }
+        case 0x211F:            // M7X/M7Y
+            state.mode7.centerX = signExtend13((value << 8) | mode7Latch);
+            mode7Latch = value;
+            break;
+        case 0x2120:
+            state.mode7.centerY = signExtend13((value << 8) | mode7Latch);
+            mode7Latch = value;
+            break;
+        case 0x2123:            // W12SEL/W34SEL/WOBJSEL
+        case 0x2124:
+        case 0x2125:
+            state.windowSelect[offset - 0x2123] = value;
+            break;
+        case 0x2126:            // WH0-WH3
+        case 0x2128:
+            state.windowLeft[(offset - 0x2126) >> 1] = value;
+            break;
+        case 0x2127:
+        case 0x2129:
+            state.windowRight[(offset - 0x2127) >> 1] = value;
+            break;
+        case 0x212A:            // WBGLOG/WOBJLOG
+        case 0x212B:
+            state.windowLogic[offset - 0x212A] = value;
+            break;
+        case 0x212C:            // TM
+            state.mainScreen = value & 0x1F;
+            break;
+        case 0x212D:            // TS
+            state.subScreen = value & 0x1F;
+            break;
+        case 0x212E:            // TMW
+            state.mainWindow = value & 0x1F;
+            break;
+        case 0x212F:            // TSW
+            state.subWindow = value & 0x1F;
+            break;
+        case 0x2130:            // CGWSEL
+            state.colorSelect = value;
+            break;
+        case 0x2131:            // CGADSUB
+            state.colorMath = value;
+            break;
+        case 0x2132:            // COLDATA: bits 5-7 pick which components get the intensity
+            if (value & 0x20) {
+                state.fixedColor = (state.fixedColor & ~0x001F) | (value & 0x1F);
+            }
+            if (value & 0x40) {
+                state.fixedColor = (state.fixedColor & ~0x03E0) | ((value & 0x1F) << 5);
+            }
+            if (value & 0x80) {
+                state.fixedColor = (state.fixedColor & ~0x7C00) | ((value & 0x1F) << 10);
+            }
+            break;
+        case 0x2133:            // SETINI
+            state.screenInit = value;
+            break;
+        default:
+            break;
+    }
+}
+
+void PPU::renderScanline(int line) {
+    if (line < 1 || !memory) {
+        return;
+    }
+    if (line == 1) {
+        startFrame();
+    }
+    if (line > visibleLines) {
+        return;
+    }
+    if (!renderEnabled) {
+        // Nothing is drawn, but games can still poll STAT77
+        spriteTable.update(memory->getOAM());
+        raiseFlags(line, ScanlineRenderer::objectFlags(state, line, spriteTable));
+        return;
+    }
+    const uint8* cgram = memory->getCGRAM();
+    if (workers) {
+        // Record the line; it is drawn at v-blank or at the next flush.
+        // A line recorded again before that starts a new batch.
+        if (!pending.empty() && line <= pending.back().line) {
+            renderPendingLines();
+        }
+        if (cgramCopyCount == 0 ||
+            std::memcmp(&cgramCopies[(cgramCopyCount - 1) * CGRAM_SIZE], cgram, CGRAM_SIZE) != 0) {
+            if (static_cast<int>(cgramCopies.size()) < (cgramCopyCount + 1) * CGRAM_SIZE) {
+                cgramCopies.resize((cgramCopyCount + 1) * CGRAM_SIZE);
+            }
+            std::memcpy(&cgramCopies[cgramCopyCount * CGRAM_SIZE], cgram, CGRAM_SIZE);
+            cgramCopyCount++;
+        }
+        pending.emplace_back();
+        LineSnapshot& snapshot = pending.back();
+        std::memcpy(&snapshot.state, &state, sizeof(state));
+        snapshot.line = line;
+        snapshot.cgram = cgramCopyCount - 1;
+        snapshot.writes = writeCount;
+        snapshot.flags = 0;
+        snapshot.skipped = false;
+        return;
+    }
+
+    spriteTable.update(memory->getOAM());
+    prepareOutput(line, state);
+    uint8 flags = 0;
+    if (renderLine(*renderers[0], state, line, cgram, writeCount, flags)) {
+        skippedLines++;
+    } else {
+        renderedLines++;
+    }
+    raiseFlags(line, flags);
+}
+
+void PPU::endFrame() {
+    flushLines();
+    if (renderEnabled) {
+        output.publish();
+    }
+}
+
+// Draw a line, or reuse its pixels if nothing it depends on changed.
+// Returns true if it was reused.
+bool PPU::renderLine(ScanlineRenderer& renderer, const RenderState& lineState, int line,
+                     const uint8* cgram, uint64 writes, uint8& flags) {
+    int row = frameRow(line);
+    uint16* out = &frameBuffer[row * frameStride];
+    LineHistory& last = history[row];
+    bool skip = skipUnchanged && lineUnchanged(last, lineState, writes);
+    if (skip) {
+        flags = last.flags;
+    } else {
+        ScanlineRenderer::Sources sources;
+        sources.vram = memory->getVRAM();
+        sources.cgram = cgram;
+        sources.sprites = &spriteTable;
+        flags = renderer.render(lineState, line, field, sources, out);
+        last.valid = true;
+        std::memcpy(&last.state, &lineState, sizeof(lineState));
+        last.writes = writes;
+        last.vramBlocks = renderer.getVRAMBlocks();
+        last.flags = flags;
+        last.width = static_cast<uint16>(ScanlineRenderer::lineWidth(lineState));
+    }
+    output.writeLine(row, out, lineBrightness(lineState), last.width);
+    if (interlace) {
+        // Weave in the other field's row (black until it has been drawn)
+        const LineHistory& other = history[row ^ 1];
+        output.writeLine(row ^ 1, &frameBuffer[(row ^ 1) * frameStride],
+                         other.valid ? lineBrightness(other.state) : 0, other.width);
+    }
+    return skip;
+}
+
+bool PPU::lineUnchanged(const LineHistory& last, const RenderState& lineState, uint64 writes) const {
+    if (!last.valid || std::memcmp(&last.state, &lineState, sizeof(lineState)) != 0) {
+        return false;
+    }
+    // Anything changed after the last drawing's inputs were recorded?
+    uint64 since = last.writes;
+    if (since == writes) {
+        return true;
+    }
+    if (cgramStamp > since) {
+        return false;
+    }
+    if (((lineState.mainScreen | lineState.subScreen) & 0x10) && oamStamp > since) {
+        return false;
+    }
+    for (uint64 blocks = last.vramBlocks; blocks; blocks &= blocks - 1) {
+        if (vramStamp[__builtin_ctzll(blocks)] > since) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Draw the recorded lines across the workers. Everything they share
+// (VRAM, OAM, the sprite table, the output palettes) is made ready first
+// and stays read-only until they finish.
+void PPU::renderPendingLines() {
+    spriteTable.update(memory->getOAM());
+    for (const LineSnapshot& snapshot : pending) {
+        prepareOutput(snapshot.line, snapshot.state);
+    }
+    workers->run(static_cast<int>(pending.size()), [this](int worker, int item) {
+        LineSnapshot& snapshot = pending[item];
+        snapshot.skipped = renderLine(*renderers[worker], snapshot.state, snapshot.line,
+                                      &cgramCopies[snapshot.cgram * CGRAM_SIZE], snapshot.writes, snapshot.flags);
+    });
+    for (const LineSnapshot& snapshot : pending) {
+        raiseFlags(snapshot.line, snapshot.flags);
+        if (snapshot.skipped) {
+            skippedLines++;
+        } else {
+            renderedLines++;
+        }
+    }
+    pending.clear();
+    cgramCopyCount = 0;
+}
+
+void PPU::raiseFlags(int line, uint8 flags) {
+    if (line == 1) {
+        // Overflow flags are per frame
+        rangeOver = false;
+        timeOver = false;
+    }
+    rangeOver = rangeOver || (flags & ScanlineRenderer::RANGE_OVER);
+    timeOver = timeOver || (flags & ScanlineRenderer::TIME_OVER);
+}
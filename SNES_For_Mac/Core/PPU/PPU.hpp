@@ -0,0 +1,234 @@
+//
+//  PPU.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef PPU_HPP
+#define PPU_HPP
+
+#include "../Types/Types.hpp"
+#include "TileCache.hpp"
+#include "SpriteTable.hpp"
+#include "FrameOutput.hpp"
+#include "ScanlineRenderer.hpp"
+#include "RenderWorkers.hpp"
+#include <memory>
+#include <vector>
+
+class Memory;
+
+// Picture Processing Unit
+// Renders whole scanlines from VRAM/CGRAM (owned by Memory) into a
+// BGR555 frame buffer and the display-format FrameOutput. Each layer is
+// drawn into line-sized arrays and then merged by priority, so there is
+// no per-pixel dispatch.
+//
+// Lines are normally drawn as soon as they finish. With render threads
+// enabled, each line's registers are recorded instead and the frame is
+// drawn in parallel at v-blank. A VRAM/OAM/OBSEL change or a STAT77
+// read first draws the lines recorded so far, so the result is identical.
+//
+// A line whose inputs are the same as when it was last drawn (registers,
+// the VRAM blocks it read, CGRAM and, with sprites on, OAM) keeps its
+// previous BGR555 pixels and is only converted to the output format.
+//
+// Frames are 256x224 unless the game asks for more: overscan gives 239
+// lines, interlace doubles the rows (each field draws every other one)
+// and hi-res lines are 512 pixels. Storage only grows when such a frame
+// shows up, and only hi-res lines cost 512 pixels of work.
+class PPU {
+public:
+    static const int SCREEN_WIDTH = 256;
+    static const int SCREEN_HEIGHT = 224;
+    static const int MAX_SCREEN_HEIGHT = 239;       // Overscan
+    static const int HIRES_WIDTH = 512;
+    static const int MAX_FRAME_HEIGHT = MAX_SCREEN_HEIGHT * 2;  // Interlaced
+
+    using BGLayer = ScanlineRenderer::BGLayer;
+    using RenderState = ScanlineRenderer::RenderState;
+
+    PPU();
+
+    void reset();
+
+    void setMemory(Memory* mem);
+
+    // PPU registers ($2100-$213F; the VRAM/CGRAM/OAM data ports live in Memory)
+    uint8 readRegister(uint16 offset);
+    void writeRegister(uint16 offset, uint8 value);
+
+    // Render scanline 1 to getVisibleLines(). Line 1 starts a frame and
+    // latches its size from SETINI (overscan, interlace).
+    void renderScanline(int line);
+
+    // Lines in the current frame: 224, or 239 with overscan
+    int getVisibleLines() const { return visibleLines; }
+    bool isInterlaced() const { return interlace; }
+    int getField() const { return field; }
+
+    // V-blank: finish the frame and hand it to the display side
+    void endFrame();
+
+    // Extra threads for deferred, parallel line rendering (0 = draw each
+    // line immediately on the calling thread)
+    void setRenderThreads(int threads);
+    int getRenderThreads() const { return workers ? workers->getWorkerCount() - 1 : 0; }
+
+    // Reuse unchanged lines (on by default)
+    void setSkipUnchangedLines(bool enabled);
+
+    // Draw lines and publish frames (on by default). Off, frames still
+    // start and end on time and every register works (STAT77 included),
+    // but nothing is drawn or published.
+    void setRenderEnabled(bool enabled);
+    bool isRenderEnabled() const { return renderEnabled; }
+
+    // Savestate: registers, latches and frame geometry. Video memory
+    // belongs to Memory; frame buffers and caches are not part of it.
+    struct State {
+        RenderState registers;
+        uint8 scrollLatch;
+        uint8 hscrollLatch;
+        uint8 mode7Latch;
+        int visibleLines;
+        bool interlace;
+        int field;
+        bool rangeOver;
+        bool timeOver;
+    };
+    void saveState(State& saved);
+    void loadState(const State& saved);
+
+    // Lines drawn and lines reused since the last resetLineStats()
+    uint64 getRenderedLines() const { return renderedLines; }
+    uint64 getSkippedLines() const { return skippedLines; }
+    void resetLineStats() { renderedLines = 0; skippedLines = 0; }
+
+    // Draw every recorded line now
+    void flushLines() {
+        if (!pending.empty()) {
+            renderPendingLines();
+        }
+    }
+
+    // BGR555 frame buffer before master brightness. Rows are
+    // getFrameStride() pixels apart (512 only once a hi-res line has been
+    // drawn since reset); row r holds getLineWidth(r) pixels. Interlaced
+    // frames put line n of field f in row (n - 1) * 2 + f.
+    const uint16* getFrameBuffer() const { return frameBuffer.data(); }
+    int getFrameStride() const { return frameStride; }
+    int getFrameWidth() const { return frameWidth; }                   // Widest line this frame
+    int getFrameHeight() const { return frameHeight; }
+    int getLineWidth(int row) const { return history[row].width; }
+
+    // The same frame in the front end's pixel format, brightness applied;
+    // the display side reads it through getOutput().acquireFrame()
+    FrameOutput& getOutput() { return output; }
+
+    // Decoded tiles of the first renderer (statistics cover its lines only)
+    TileCache& getTileCache() { return renderers[0]->getTileCache(); }
+
+    // Memory calls these before every VRAM/CGRAM/OAM write that changes
+    // a value: recorded lines are drawn from the old contents first, then
+    // decoded copies are dropped and the change is stamped for line reuse
+    void beforeVRAMWrite(uint32 byteAddress) {
+        flushLines();
+        for (auto& renderer : renderers) {
+            renderer->getTileCache().invalidate(byteAddress);
+        }
+        vramStamp[(byteAddress & 0xFFFF) >> 10] = ++writeCount;
+    }
+    void beforeVRAMWrite(uint32 byteAddress, uint32 length);
+    void beforeCGRAMWrite() {
+        // Recorded lines keep their own CGRAM copy, so no flush is needed
+        cgramStamp = ++writeCount;
+    }
+    void beforeOAMWrite() {
+        flushLines();
+        spriteTable.invalidate();
+        oamStamp = ++writeCount;
+    }
+
+private:
+    Memory* memory;
+
+    RenderState state;
+
+    // Write-twice latches for the scroll registers
+    uint8 scrollLatch;
+    uint8 hscrollLatch;
+    uint8 mode7Latch;                   // Shared by $210D/$210E and $211B-$2120
+
+    // Frame geometry, latched at line 1
+    int visibleLines;
+    bool interlace;
+    int field;
+    int frameWidth;
+    int frameHeight;
+    int frameStride;
+
+    std::vector<uint16> frameBuffer;
+    FrameOutput output;
+    SpriteTable spriteTable;
+
+    // STAT77 sprite overflow flags for the current frame
+    bool rangeOver;
+    bool timeOver;
+
+    // One renderer per worker; renderers[0] also draws immediate lines
+    std::vector<std::unique_ptr<ScanlineRenderer>> renderers;
+    std::unique_ptr<RenderWorkers> workers;
+
+    // A recorded line: its registers and which CGRAM copy it sees
+    struct LineSnapshot {
+        RenderState state;
+        int line;
+        int cgram;                      // Index into cgramCopies
+        uint64 writes;                  // writeCount when recorded
+        uint8 flags;                    // STAT77 flags, filled in when drawn
+        bool skipped;                   // Reused the previous pixels
+    };
+    std::vector<LineSnapshot> pending;
+    // CGRAM is copied only when it differs from the previous line's copy
+    std::vector<uint8> cgramCopies;
+    int cgramCopyCount;
+
+    // Video memory changes: writeCount is bumped per change, and each area
+    // keeps the count of its last change (VRAM in 1KB blocks)
+    uint64 writeCount;
+    uint64 vramStamp[64];
+    uint64 cgramStamp;
+    uint64 oamStamp;
+
+    // What each line was last drawn from. States are compared bytewise;
+    // every copy is a memcpy of a zero-initialised state, so padding matches.
+    // Rows are indexed like the frame buffer.
+    struct LineHistory {
+        bool valid;
+        RenderState state;
+        uint64 writes;                  // writeCount when its inputs were recorded
+        uint64 vramBlocks;              // 1KB VRAM blocks it read
+        uint8 flags;
+        uint16 width;                   // Pixels in its frame buffer row
+    };
+    LineHistory history[MAX_FRAME_HEIGHT];
+    bool skipUnchanged;
+    bool renderEnabled;
+    uint64 renderedLines;
+    uint64 skippedLines;
+
+    bool renderLine(ScanlineRenderer& renderer, const RenderState& lineState, int line,
+                    const uint8* cgram, uint64 writes, uint8& flags);
+    bool lineUnchanged(const LineHistory& last, const RenderState& lineState, uint64 writes) const;
+    void clearHistory();
+    void startFrame();
+    void setGeometry(bool interlaced, int lines);
+    void prepareOutput(int line, const RenderState& lineState);
+    void widenFrame(int width);
+    int frameRow(int line) const { return interlace ? ((line - 1) << 1) | field : line - 1; }
+    void renderPendingLines();
+    void raiseFlags(int line, uint8 flags);
+};
+#endif
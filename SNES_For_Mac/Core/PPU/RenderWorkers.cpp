@@ -0,0 +1,84 @@
+//
+//  RenderWorkers.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "RenderWorkers.hpp"
+
+RenderWorkers::RenderWorkers(int threadCount): job(nullptr), count(0), generation(0), busy(0),
+                                               stopping(false), next(0), remaining(0) {
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&RenderWorkers::threadMain, this, i + 1);
+    }
+}
+
+RenderWorkers::~RenderWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void RenderWorkers::run(int items, const std::function<void(int, int)>& batchJob) {
+    if (items <= 0) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // A thread that woke late for the previous batch may still be
+        // looking at its counter; let it leave before reusing it
+        idle.wait(lock, [this]() { return busy == 0; });
+        job = &batchJob;
+        count = items;
+        next = 0;
+        remaining = items;
+        generation++;
+    }
+    wake.notify_all();
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return remaining == 0; });
+}
+
+void RenderWorkers::threadMain(int worker) {
+    uint64 seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            busy++;
+        }
+        work(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy--;
+        }
+        idle.notify_all();
+    }
+}
+
+void RenderWorkers::work(int worker) {
+    while (true) {
+        int item = next.fetch_add(1);
+        if (item >= count) {
+            return;
+        }
+        (*job)(worker, item);
+        if (remaining.fetch_sub(1) == 1) {
+            // Last item: wake the caller (taking the lock so the wake-up cannot be missed)
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,55 @@
+//
+//  RenderWorkers.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef RENDERWORKERS_HPP
+#define RENDERWORKERS_HPP
+
+#include "../Types/Types.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed thread pool for batches of independent items (scanlines)
+// The calling thread works as worker 0, so a batch always makes progress
+// even with no extra threads. Items are handed out one at a time from an
+// atomic counter, which balances cheap and expensive lines.
+class RenderWorkers {
+public:
+    // Start threads extra threads (0 = run everything on the caller)
+    explicit RenderWorkers(int threads);
+    ~RenderWorkers();
+
+    RenderWorkers(const RenderWorkers&) = delete;
+    RenderWorkers& operator=(const RenderWorkers&) = delete;
+
+    int getWorkerCount() const { return static_cast<int>(threads.size()) + 1; }
+
+    // Call job(worker, item) for every item in [0, count); returns when all are done
+    void run(int count, const std::function<void(int, int)>& job);
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;       // New batch or shutdown
+    std::condition_variable idle;       // Batch finished
+
+    // Current batch; written under mutex while no worker is busy
+    const std::function<void(int, int)>* job;
+    int count;
+    uint64 generation;
+    int busy;                           // Threads inside work()
+    bool stopping;
+    std::atomic<int> next;
+    std::atomic<int> remaining;
+
+    void threadMain(int worker);
+    void work(int worker);
+};
+#endif
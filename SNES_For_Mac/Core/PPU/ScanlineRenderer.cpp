@@ -0,0 +1,436 @@
+//
+//  ScanlineRenderer.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "ScanlineRenderer.hpp"
+#include "TileDecoder.hpp"
+#include "Compositor.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Bits per pixel of BG1-BG4 for each mode (0 = layer not present)
+    const uint8 BG_BPP[8][4] = {
+        { 2, 2, 2, 2 },     // Mode 0
+        { 4, 4, 2, 0 },     // Mode 1
+        { 4, 4, 0, 0 },     // Mode 2 (offset-per-tile)
+        { 8, 4, 0, 0 },     // Mode 3
+        { 8, 2, 0, 0 },     // Mode 4 (offset-per-tile)
+        { 4, 2, 0, 0 },     // Mode 5 (hi-res)
+        { 4, 0, 0, 0 },     // Mode 6 (hi-res, offset-per-tile)
+        { 0, 0, 0, 0 }      // Mode 7 (affine, not a tiled layer)
+    };
+
+    // Depth of BG1-BG4 for tile priority 0/1 in each mode; higher is in front.
+    // Index 8 is mode 1 with the BG3 priority bit ($2105 bit 3) set.
+    // Sprites slot in between (OBJ_Z).
+    const uint8 BG_Z[9][4][2] = {
+        { { 8, 11 }, { 7, 10 }, { 2, 5 }, { 1, 4 } },
+        { { 6, 9 },  { 5, 8 },  { 1, 3 }, { 0, 0 } },
+        { { 3, 7 },  { 1, 5 },  { 0, 0 }, { 0, 0 } },
+        { { 3, 7 },  { 1, 5 },  { 0, 0 }, { 0, 0 } },
+        { { 3, 7 },  { 1, 5 },  { 0, 0 }, { 0, 0 } },
+        { { 3, 7 },  { 1, 5 },  { 0, 0 }, { 0, 0 } },
+        { { 3, 7 },  { 0, 0 },  { 0, 0 }, { 0, 0 } },
+        { { 3, 3 },  { 1, 5 },  { 0, 0 }, { 0, 0 } },
+        { { 5, 8 },  { 4, 7 },  { 1, 10 }, { 0, 0 } }
+    };
+
+    // Depth of OBJ priority 0-3, interleaved with BG_Z (same indexing)
+    const uint8 OBJ_Z[9][4] = {
+        { 3, 6, 9, 12 },
+        { 2, 4, 7, 10 },
+        { 2, 4, 6, 8 },
+        { 2, 4, 6, 8 },
+        { 2, 4, 6, 8 },
+        { 2, 4, 6, 8 },
+        { 2, 4, 6, 8 },
+        { 2, 4, 6, 8 },
+        { 2, 3, 6, 9 }
+    };
+
+    // Sprite tiles fetched per line before the time limit kicks in
+    const int OBJ_LINE_SPRITES = 32;
+    const int OBJ_LINE_TILES = 34;
+}
+
+ScanlineRenderer::ScanlineRenderer(): state(nullptr), flags(0), vramBlocks(0), windowsValid(false) {
+    std::memset(&sources, 0, sizeof(sources));
+    std::memset(windowKey, 0, sizeof(windowKey));
+    std::memset(noWindow, 0, sizeof(noWindow));
+}
+
+uint8 ScanlineRenderer::render(const RenderState& lineState, int line, int field, const Sources& lineSources,
+                              uint16* out) {
+    state = &lineState;
+    sources = lineSources;
+    flags = 0;
+    vramBlocks = 0;
+
+    uint8 brightness = state->displayControl & 0x0F;
+    if ((state->displayControl & 0x80) || brightness == 0) {
+        std::fill(out, out + lineWidth(lineState), 0);
+        return flags;
+    }
+
+    // Window masks only depend on $2123-$212B
+    uint8 key[9];
+    std::memcpy(key, state->windowSelect, 3);
+    std::memcpy(key + 3, state->windowLeft, 2);
+    std::memcpy(key + 5, state->windowRight, 2);
+    std::memcpy(key + 7, state->windowLogic, 2);
+    if (!windowsValid || std::memcmp(key, windowKey, sizeof(key)) != 0) {
+        std::memcpy(windowKey, key, sizeof(key));
+        updateWindows();
+    }
+
+    // Start from the backdrop (CGRAM color 0) at depth 0
+    std::memset(&mainLine, 0, sizeof(mainLine));
+    std::memset(&subLine, 0, sizeof(subLine));
+    std::memset(mainLine.math, (state->colorMath & 0x20) ? 0xFF : 0x00, SCREEN_WIDTH);
+
+    uint8 mode = state->bgMode & 0x07;
+    int zTable = (mode == 1 && (state->bgMode & 0x08)) ? 8 : mode;
+    bool hires = mode == 5 || mode == 6;
+    // Interlaced hi-res modes show every BG row, alternating fields
+    int bgLine = (hires && (state->screenInit & 0x01)) ? ((line - 1) << 1) | (field & 0x01) : line - 1;
+    uint8 enabled = state->mainScreen | state->subScreen;
+    if (mode == 7) {
+        renderMode7(line);
+    }
+    for (int bg = 0; bg < 4 && mode != 7; ++bg) {
+        int bpp = BG_BPP[mode][bg];
+        if (bpp == 0 || (enabled & (1 << bg)) == 0) {
+            continue;
+        }
+        uint8 paletteBase = mode == 0 ? bg * 32 : 0;
+        renderBackground(bg, bgLine, bpp, paletteBase, BG_Z[zTable][bg][0], BG_Z[zTable][bg][1]);
+        // Hi-res layers are drawn 512 wide: odd columns go to the main screen, even ones to the sub screen
+        composeLayer(bgIndex + LINE_PAD, bgDepth + LINE_PAD, hires ? 2 : 1, bg);
+    }
+    if (enabled & 0x10) {
+        renderObjects(line - 1, OBJ_Z[zTable]);
+        composeLayer(objIndex, objDepth, 1, LAYER_OBJ);
+    }
+
+    resolveColors(out, isHires(lineState));
+    return flags;
+}
+
+// Same range/time evaluation as render() and renderObjects(), counting tiles instead of fetching them
+uint8 ScanlineRenderer::objectFlags(const RenderState& lineState, int line, const SpriteTable& sprites) {
+    if ((lineState.displayControl & 0x80) || (lineState.displayControl & 0x0F) == 0 ||
+        ((lineState.mainScreen | lineState.subScreen) & 0x10) == 0) {
+        return 0;
+    }
+    int count = 0;
+    const uint8* list = sprites.getLine(line - 1, count);
+    uint8 lineFlags = 0;
+    if (count > OBJ_LINE_SPRITES) {
+        lineFlags |= RANGE_OVER;
+        count = OBJ_LINE_SPRITES;
+    }
+    int tiles = 0;
+    for (int i = 0; i < count; ++i) {
+        const SpriteTable::Sprite& sprite = sprites.getSprite(list[i]);
+        for (int sx = sprite.x; sx < sprite.x + sprite.width; sx += 8) {
+            if (sx > -8 && sx < SCREEN_WIDTH && ++tiles > OBJ_LINE_TILES) {
+                return lineFlags | TIME_OVER;
+            }
+        }
+    }
+    return lineFlags;
+}
+
+// Turn the main/sub lines into colors, then blend. Hi-res lines put the
+// sub screen, unblended, between the main screen's pixels.
+void ScanlineRenderer::resolveColors(uint16* out, bool hires) {
+    const uint8* cgram = sources.cgram;
+    const uint8* colorWindow = windowMask[LAYER_COLOR];
+    bool useSub = (state->colorSelect & 0x02) != 0;
+    // CGWSEL regions: 0 never, 1 outside the color window, 2 inside, 3 always
+    uint8 clipOutside = (state->colorSelect & 0x40) ? 0xFF : 0x00;
+    uint8 clipInside = (state->colorSelect & 0x80) ? 0xFF : 0x00;
+    uint8 preventOutside = (state->colorSelect & 0x10) ? 0xFF : 0x00;
+    uint8 preventInside = (state->colorSelect & 0x20) ? 0xFF : 0x00;
+    uint8 half = (state->colorMath & 0x40) ? 0xFF : 0x00;
+    uint8 subOnly = useSub ? 0xFF : 0x00;
+
+    for (int x = 0; x < SCREEN_WIDTH; ++x) {
+        uint8 inside = colorWindow[x];
+        uint8 clip = (inside & clipInside) | (~inside & clipOutside);
+        uint8 prevent = (inside & preventInside) | (~inside & preventOutside);
+        uint8 subTransparent = subLine.z[x] == 0 ? 0xFF : 0x00;
+        uint16 mainValue = cgram[mainLine.index[x] << 1] | (cgram[(mainLine.index[x] << 1) + 1] << 8);
+        uint16 subValue = cgram[subLine.index[x] << 1] | (cgram[(subLine.index[x] << 1) + 1] << 8);
+        uint8 fixed = subTransparent | ~subOnly;
+        mainColor[x] = clip ? 0 : mainValue;
+        subColor[x] = fixed ? state->fixedColor : subValue;
+        mathMask[x] = mainLine.math[x] & ~prevent;
+        // Halving is skipped for clipped pixels and for the subscreen backdrop
+        halfMask[x] = half & ~clip & ~(subTransparent & subOnly);
+    }
+    bool subtract = (state->colorMath & 0x80) != 0;
+    if (!hires) {
+        Compositor::blendLine(mainColor, subColor, mathMask, halfMask, subtract, out, SCREEN_WIDTH);
+        return;
+    }
+    Compositor::blendLine(mainColor, subColor, mathMask, halfMask, subtract, blendColor, SCREEN_WIDTH);
+    for (int x = 0; x < SCREEN_WIDTH; ++x) {
+        // The sub screen's backdrop is the fixed color
+        uint16 subValue = cgram[subLine.index[x] << 1] | (cgram[(subLine.index[x] << 1) + 1] << 8);
+        out[x * 2] = subLine.z[x] == 0 ? state->fixedColor : subValue;
+        out[x * 2 + 1] = blendColor[x];
+    }
+}
+
+// Rebuild the inside-window masks of every layer
+void ScanlineRenderer::updateWindows() {
+    windowsValid = true;
+    uint64 spans[2][SCREEN_WIDTH / 64];
+    for (int w = 0; w < 2; ++w) {
+        for (int word = 0; word < SCREEN_WIDTH / 64; ++word) {
+            int low = std::max<int>(state->windowLeft[w], word * 64);
+            int high = std::min<int>(state->windowRight[w], word * 64 + 63);
+            spans[w][word] = low > high ? 0 : ((~0ULL >> (63 - (high - low))) << (low - word * 64));
+        }
+    }
+
+    for (int layer = 0; layer < WINDOW_LAYERS; ++layer) {
+        uint8 select = (state->windowSelect[layer >> 1] >> ((layer & 0x01) * 4)) & 0x0F;
+        uint8 logic = layer < LAYER_OBJ ? (state->windowLogic[0] >> (layer * 2)) & 0x03
+                                        : (state->windowLogic[1] >> ((layer - LAYER_OBJ) * 2)) & 0x03;
+        bool enable1 = (select & 0x02) != 0;
+        bool enable2 = (select & 0x08) != 0;
+        for (int word = 0; word < SCREEN_WIDTH / 64; ++word) {
+            uint64 w1 = spans[0][word] ^ ((select & 0x01) ? ~0ULL : 0);
+            uint64 w2 = spans[1][word] ^ ((select & 0x04) ? ~0ULL : 0);
+            uint64 bits = 0;
+            if (enable1 && enable2) {
+                switch (logic) {
+                    case 0: bits = w1 | w2; break;
+                    case 1: bits = w1 & w2; break;
+                    case 2: bits = w1 ^ w2; break;
+                    default: bits = ~(w1 ^ w2); break;
+                }
+            } else if (enable1) {
+                bits = w1;
+            } else if (enable2) {
+                bits = w2;
+            }
+            windowBits[layer][word] = bits;
+        }
+        for (int x = 0; x < SCREEN_WIDTH; ++x) {
+            windowMask[layer][x] = ((windowBits[layer][x >> 6] >> (x & 63)) & 1) ? 0xFF : 0x00;
+        }
+    }
+}
+
+// Draw one BG layer's scanline into bgIndex/bgDepth (CGRAM index, 0 = transparent)
+void ScanlineRenderer::renderBackground(int bg, int y, int bpp, uint8 paletteBase, uint8 zLow, uint8 zHigh) {
+    const uint8* vram = sources.vram;
+    const BGLayer& layer = state->bg[bg];
+    uint8 mode = state->bgMode & 0x07;
+    bool hires = mode == 5 || mode == 6;
+    bool offsetPerTile = mode == 2 || mode == 4 || mode == 6;
+    bool largeTiles = (state->bgMode & (0x10 << bg)) != 0;
+
+    int tileHeight = largeTiles ? 16 : 8;
+    int tileWidth = (largeTiles || hires) ? 16 : 8;
+    int width = hires ? 512 : SCREEN_WIDTH;
+    int hofs = hires ? (layer.hofs << 1) : layer.hofs;
+    int fine = hofs & 0x07;
+    int tileBytes = bpp * 8;
+    uint32 charBase = static_cast<uint32>(layer.charAddress) << 1;
+    int colMask = (layer.tilemapSize & 0x01) ? 63 : 31;
+    int rowMask = (layer.tilemapSize & 0x02) ? 63 : 31;
+    uint16 optMask = bg == 0 ? 0x2000 : 0x4000;
+    const BGLayer& bg3 = state->bg[2];
+
+    // Walk the line in 8-pixel pieces; each piece is one row of one 8x8 character
+    for (int piece = 0; piece <= width / 8; ++piece) {
+        int sx = piece * 8 - fine;
+        int ho = hofs;
+        int vo = layer.vofs;
+
+        if (offsetPerTile && piece > 0) {
+            // BG3's tilemap holds a replacement scroll value per column
+            int optColumn = ((piece - 1) * 8 + (bg3.hofs & ~0x07)) >> 3;
+            int optRow = bg3.vofs >> 3;
+            uint16 hval = readVRAMWord(tilemapAddress(bg3, optColumn, optRow));
+            uint16 vval = readVRAMWord(tilemapAddress(bg3, optColumn, optRow + 1));
+            if (mode == 4) {
+                if (hval & optMask) {
+                    if (hval & 0x8000) {
+                        vo = hval & 0x3FF;
+                    } else {
+                        ho = ((hires ? (hval << 1) : hval) & ~0x07) | fine;
+                    }
+                }
+            } else {
+                if (hval & optMask) {
+                    ho = ((hires ? ((hval & 0x3FF) << 1) : (hval & 0x3FF)) & ~0x07) | fine;
+                }
+                if (vval & optMask) {
+                    vo = vval & 0x3FF;
+                }
+            }
+        }
+
+        int px = sx + ho;
+        int py = y + vo;
+        int tileColumn = (px / tileWidth) & colMask;
+        int tileRow = (py / tileHeight) & rowMask;
+        uint16 entry = readVRAMWord(tilemapAddress(layer, tileColumn, tileRow));
+
+        int fy = py & (tileHeight - 1);
+        if (entry & 0x8000) {
+            fy = tileHeight - 1 - fy;
+        }
+        int subX = (px & (tileWidth - 1)) >> 3;
+        if ((entry & 0x4000) && tileWidth == 16) {
+            subX ^= 1;
+        }
+        uint32 tile = ((entry & 0x3FF) + subX + ((fy >> 3) << 4)) & 0x3FF;
+        uint32 tileAddress = (charBase + tile * tileBytes) & 0xFFFF;
+        vramBlocks |= 1ULL << (tileAddress >> 10);
+        const uint64* rows = tileCache.getTile(vram, bpp, tileAddress);
+        uint64 pixels = rows[fy & 0x07];
+        if (entry & 0x4000) {
+            pixels = __builtin_bswap64(pixels);
+        }
+        pieceRows[piece] = pixels;
+        piecePalette[piece] = bpp == 8 ? 0 : static_cast<uint8>(paletteBase + (((entry >> 10) & 0x07) << bpp));
+        pieceDepth[piece] = (entry & 0x2000) ? zHigh : zLow;
+    }
+
+    TileDecoder::writeRows(bgIndex + LINE_PAD - fine, bgDepth + LINE_PAD - fine,
+                           pieceRows, piecePalette, pieceDepth, width / 8 + 1);
+}
+
+// Mode 7 BG1 and, with EXTBG, BG2 (bit 7 of the same pixel is its priority)
+void ScanlineRenderer::renderMode7(int line) {
+    bool extbg = (state->screenInit & 0x40) != 0;
+    uint8 enabled = state->mainScreen | state->subScreen;
+    bool bg1 = (enabled & 0x01) != 0;
+    bool bg2 = extbg && (enabled & 0x02) != 0;
+    if (!bg1 && !bg2) {
+        return;
+    }
+    // The map and tiles are interleaved in the low 32KB
+    vramBlocks |= 0xFFFFFFFFULL;
+    Mode7Renderer::renderLine(sources.vram, Mode7Renderer::setupLine(state->mode7, line), mode7Line);
+
+    uint8* index = bgIndex + LINE_PAD;
+    uint8* depth = bgDepth + LINE_PAD;
+    if (bg1) {
+        std::memset(depth, BG_Z[7][0][0], SCREEN_WIDTH);
+        composeLayer(mode7Line, depth, 1, 0);
+    }
+    if (bg2) {
+        for (int x = 0; x < SCREEN_WIDTH; ++x) {
+            index[x] = mode7Line[x] & 0x7F;
+            depth[x] = (mode7Line[x] & 0x80) ? BG_Z[7][1][1] : BG_Z[7][1][0];
+        }
+        composeLayer(index, depth, 1, 1);
+    }
+}
+
+uint16 ScanlineRenderer::tilemapAddress(const BGLayer& layer, int column, int row) const {
+    int colMask = (layer.tilemapSize & 0x01) ? 63 : 31;
+    int rowMask = (layer.tilemapSize & 0x02) ? 63 : 31;
+    column &= colMask;
+    row &= rowMask;
+    uint16 address = layer.tilemapAddress + ((row & 31) << 5) + (column & 31);
+    if (column & 32) {
+        address += 0x400;
+    }
+    if (row & 32) {
+        address += (layer.tilemapSize & 0x01) ? 0x800 : 0x400;
+    }
+    return address;
+}
+
+// Evaluate the sprites on line y and draw them into objIndex/objDepth
+void ScanlineRenderer::renderObjects(int y, const uint8* z) {
+    std::memset(objIndex, 0, sizeof(objIndex));
+    int count = 0;
+    const uint8* list = sources.sprites->getLine(y, count);
+    if (count == 0) {
+        return;
+    }
+    // Range: only the first 32 sprites in OAM order are kept
+    if (count > OBJ_LINE_SPRITES) {
+        flags |= RANGE_OVER;
+        count = OBJ_LINE_SPRITES;
+    }
+
+    const uint8* vram = sources.vram;
+    uint32 nameBase = (state->objectSelect & 0x07) << 13;
+    uint32 nameGap = ((state->objectSelect >> 3) & 0x03) + 1;
+    int tiles = 0;
+
+    // Time: tiles are fetched starting from the last sprite in range, so
+    // earlier sprites lose theirs first. Drawing in the same order lets
+    // lower-numbered sprites overwrite higher ones.
+    for (int i = count - 1; i >= 0; --i) {
+        const SpriteTable::Sprite& sprite = sources.sprites->getSprite(list[i]);
+        int row = (y - sprite.y) & 0xFF;
+        if (sprite.vflip) {
+            row = sprite.height - 1 - row;
+        }
+        uint32 tableBase = nameBase + ((sprite.character & 0x100) ? (nameGap << 12) : 0);
+        uint8 palette = static_cast<uint8>(128 + sprite.palette * 16);
+        int columns = sprite.width / 8;
+        for (int column = 0; column < columns; ++column) {
+            int sx = sprite.x + column * 8;
+            if (sx <= -8 || sx >= SCREEN_WIDTH) {
+                continue;
+            }
+            if (tiles == OBJ_LINE_TILES) {
+                flags |= TIME_OVER;
+                return;
+            }
+            tiles++;
+
+            int charColumn = sprite.hflip ? columns - 1 - column : column;
+            uint32 character = ((sprite.character + charColumn) & 0x0F) |
+                               ((sprite.character + ((row >> 3) << 4)) & 0xF0);
+            uint32 address = ((tableBase + character * 16) & 0x7FFF) << 1;
+            vramBlocks |= 1ULL << (address >> 10);
+            uint64 pixels = tileCache.getTile(vram, 4, address)[row & 0x07];
+            if (sprite.hflip) {
+                pixels = __builtin_bswap64(pixels);
+            }
+            for (int n = 0; n < 8; ++n) {
+                uint8 c = static_cast<uint8>(pixels >> (n * 8));
+                int x = sx + n;
+                if (c != 0 && x >= 0 && x < SCREEN_WIDTH) {
+                    objIndex[x] = palette + c;
+                    objDepth[x] = z[sprite.priority];
+                }
+            }
+        }
+    }
+}
+
+// Merge a layer into the main and/or sub screen line it is enabled on.
+// With step 2 (hi-res) the main screen takes the odd pixels, the sub screen the even ones.
+void ScanlineRenderer::composeLayer(const uint8* index, const uint8* depth, int step, int layer) {
+    uint8 bit = 1 << layer;
+    uint8 math = (state->colorMath & bit) ? 0xFF : 0x00;
+    // Only sprites using palettes 4-7 take part in color math
+    uint8 mathMin = layer == LAYER_OBJ ? 192 : 0;
+    if (state->mainScreen & bit) {
+        Compositor::mergeLayer(mainLine.index, mainLine.z, mainLine.math, index + step - 1, depth + step - 1, step,
+                               (state->mainWindow & bit) ? windowMask[layer] : noWindow, math, mathMin, SCREEN_WIDTH);
+    }
+    if (state->subScreen & bit) {
+        Compositor::mergeLayer(subLine.index, subLine.z, subLine.math, index, depth, step,
+                               (state->subWindow & bit) ? windowMask[layer] : noWindow, math, mathMin, SCREEN_WIDTH);
+    }
+}
+
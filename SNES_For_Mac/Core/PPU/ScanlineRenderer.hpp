@@ -0,0 +1,154 @@
+//
+//  ScanlineRenderer.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef SCANLINERENDERER_HPP
+#define SCANLINERENDERER_HPP
+
+#include "../Types/Types.hpp"
+#include "TileCache.hpp"
+#include "Mode7Renderer.hpp"
+#include "SpriteTable.hpp"
+
+// Draws one scanline from a register snapshot
+// Everything a line depends on is passed in: the register state, video
+// memory and the decoded sprite table. The renderer only owns scratch
+// line buffers, window masks and a tile cache, so several renderers can
+// draw different lines of the same frame at once.
+class ScanlineRenderer {
+public:
+    static const int SCREEN_WIDTH = 256;
+    static const int HIRES_WIDTH = 512;
+
+    // STAT77 flags a line can raise
+    static const uint8 RANGE_OVER = 0x40;
+    static const uint8 TIME_OVER = 0x80;
+
+    struct BGLayer {
+        uint16 tilemapAddress;          // Word address (BGnSC bits 2-7)
+        uint8  tilemapSize;             // bit 0 = 64 tiles wide, bit 1 = 64 tiles tall
+        uint16 charAddress;             // Word address (BG12NBA/BG34NBA)
+        uint16 hofs;                    // BGnHOFS (10 bits)
+        uint16 vofs;                    // BGnVOFS (10 bits)
+    };
+
+    // Everything the renderer reads from registers
+    struct RenderState {
+        uint8  displayControl;          // INIDISP ($2100): bit 7 force blank, bits 0-3 brightness
+        uint8  objectSelect;            // OBSEL   ($2101)
+        uint8  bgMode;                  // BGMODE  ($2105)
+        uint8  mosaic;                  // MOSAIC  ($2106)
+        BGLayer bg[4];
+        Mode7Renderer::Matrix mode7;    // $211A-$2120, M7HOFS/M7VOFS
+        uint8  windowSelect[3];         // W12SEL/W34SEL/WOBJSEL ($2123-$2125)
+        uint8  windowLeft[2];           // WH0/WH2
+        uint8  windowRight[2];          // WH1/WH3
+        uint8  windowLogic[2];          // WBGLOG/WOBJLOG ($212A/$212B)
+        uint8  mainScreen;              // TM      ($212C)
+        uint8  subScreen;               // TS      ($212D)
+        uint8  mainWindow;              // TMW     ($212E)
+        uint8  subWindow;               // TSW     ($212F)
+        uint8  colorSelect;             // CGWSEL  ($2130)
+        uint8  colorMath;               // CGADSUB ($2131)
+        uint16 fixedColor;              // COLDATA ($2132), BGR555
+        uint8  screenInit;              // SETINI  ($2133)
+    };
+
+    // Video memory for one line; sprites must be up to date with oam
+    struct Sources {
+        const uint8* vram;
+        const uint8* cgram;
+        const SpriteTable* sprites;
+    };
+
+    ScanlineRenderer();
+
+    // Render line 1-239 into lineWidth(state) BGR555 pixels (before master
+    // brightness). field (0/1) picks the BG rows of interlaced hi-res
+    // modes. Returns the STAT77 flags the line raised.
+    uint8 render(const RenderState& state, int line, int field, const Sources& sources, uint16* out);
+
+    // The STAT77 flags render() would return for the line, without drawing
+    // it. Only needs the sprite table.
+    static uint8 objectFlags(const RenderState& state, int line, const SpriteTable& sprites);
+
+    // Hi-res lines (modes 5/6 or pseudo hi-res) are 512 pixels, with the
+    // sub screen in the even columns
+    static bool isHires(const RenderState& state) {
+        uint8 mode = state.bgMode & 0x07;
+        return mode == 5 || mode == 6 || (state.screenInit & 0x08) != 0;
+    }
+    static int lineWidth(const RenderState& state) { return isHires(state) ? HIRES_WIDTH : SCREEN_WIDTH; }
+
+    // 1KB VRAM blocks (bit n = bytes n * 1024 onwards) the last render() read
+    uint64 getVRAMBlocks() const { return vramBlocks; }
+
+    TileCache& getTileCache() { return tileCache; }
+
+private:
+    TileCache tileCache;
+
+    // Per-line inputs while render() runs
+    const RenderState* state;
+    Sources sources;
+    uint8 flags;
+    uint64 vramBlocks;
+
+    // Window layers: BG1-BG4, OBJ, color window
+    static const int LAYER_OBJ = 4;
+    static const int LAYER_COLOR = 5;
+    static const int WINDOW_LAYERS = 6;
+
+    // Inside-window masks for the window registers in windowKey, rebuilt
+    // only when those change: one bit per pixel, and the same expanded to
+    // 0x00/0xFF bytes
+    uint8 windowKey[9];
+    bool windowsValid;
+    uint64 windowBits[WINDOW_LAYERS][SCREEN_WIDTH / 64];
+    uint8 windowMask[WINDOW_LAYERS][SCREEN_WIDTH];
+    uint8 noWindow[SCREEN_WIDTH];
+
+    // Front pixel of the main or sub screen
+    struct Screen {
+        uint8 index[SCREEN_WIDTH];      // CGRAM index
+        uint8 z[SCREEN_WIDTH];          // Depth (0 = backdrop)
+        uint8 math[SCREEN_WIDTH];       // 0xFF if color math is enabled for it
+    };
+
+    // Line buffers shared by all layers while rendering one scanline
+    // Index/depth buffers carry 16 pixels of slack on the left for
+    // partially scrolled-in tiles (512 wide for hi-res modes)
+    static const int LINE_PAD = 16;
+    uint8 bgIndex[LINE_PAD + 512 + 16];
+    uint8 bgDepth[LINE_PAD + 512 + 16];
+    uint64 pieceRows[512 / 8 + 1];      // Decoded row of each 8-pixel piece
+    uint8 piecePalette[512 / 8 + 1];
+    uint8 pieceDepth[512 / 8 + 1];
+    uint8 mode7Line[SCREEN_WIDTH];
+    uint8 objIndex[SCREEN_WIDTH];       // Front sprite pixel (CGRAM index, 0 = none)
+    uint8 objDepth[SCREEN_WIDTH];
+    Screen mainLine;
+    Screen subLine;
+    uint16 mainColor[SCREEN_WIDTH];
+    uint16 subColor[SCREEN_WIDTH];
+    uint16 blendColor[SCREEN_WIDTH];    // Blended main screen of a hi-res line
+    uint8 mathMask[SCREEN_WIDTH];
+    uint8 halfMask[SCREEN_WIDTH];
+
+    void renderBackground(int bg, int y, int bpp, uint8 paletteBase, uint8 zLow, uint8 zHigh);
+    void renderMode7(int line);
+    void renderObjects(int y, const uint8* z);
+    void composeLayer(const uint8* index, const uint8* depth, int step, int layer);
+    void resolveColors(uint16* out, bool hires);
+    void updateWindows();
+    uint16 readVRAMWord(uint16 wordAddress) {
+        uint32 byte = (wordAddress & 0x7FFF) << 1;
+        vramBlocks |= 1ULL << (byte >> 10);
+        return sources.vram[byte] | (sources.vram[byte + 1] << 8);
+    }
+    uint16 tilemapAddress(const BGLayer& layer, int column, int row) const;
+};
+#endif
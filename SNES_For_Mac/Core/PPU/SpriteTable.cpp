@@ -0,0 +1,91 @@
+//
+//  SpriteTable.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "SpriteTable.hpp"
+#include <cstring>
+
+namespace {
+    // Small/large sprite width and height for each OBSEL size setting
+    const uint8 OBJ_SIZE[8][2][2] = {
+        { { 8, 8 },   { 16, 16 } },
+        { { 8, 8 },   { 32, 32 } },
+        { { 8, 8 },   { 64, 64 } },
+        { { 16, 16 }, { 32, 32 } },
+        { { 16, 16 }, { 64, 64 } },
+        { { 32, 32 }, { 64, 64 } },
+        { { 16, 32 }, { 32, 64 } },
+        { { 16, 32 }, { 32, 32 } }
+    };
+
+    // Completely off the left edge: never in range (X = 256 still counts)
+    inline bool offLeftEdge(const SpriteTable::Sprite& sprite) {
+        return sprite.x < 0 && sprite.x != -256 && sprite.x + sprite.width <= 0;
+    }
+}
+
+SpriteTable::SpriteTable(): objectSelect(0), dirty(true) {
+    std::memset(sprites, 0, sizeof(sprites));
+    std::memset(lineStart, 0, sizeof(lineStart));
+    lineSprites.resize(SPRITE_COUNT * 64);
+}
+
+void SpriteTable::setObjectSelect(uint8 value) {
+    if ((value & 0xE0) != (objectSelect & 0xE0)) {
+        dirty = true;
+    }
+    objectSelect = value;
+}
+
+void SpriteTable::update(const uint8* oam) {
+    if (!dirty) {
+        return;
+    }
+    dirty = false;
+
+    uint16 lineCount[256];
+    std::memset(lineCount, 0, sizeof(lineCount));
+    const uint8 (*sizes)[2] = OBJ_SIZE[objectSelect >> 5];
+
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        const uint8* entry = oam + i * 4;
+        uint8 high = oam[0x200 + (i >> 2)] >> ((i & 0x03) * 2);
+        Sprite& sprite = sprites[i];
+        int x = entry[0] | ((high & 0x01) << 8);
+        sprite.x = static_cast<int16>(x >= 256 ? x - 512 : x);
+        sprite.y = entry[1];
+        sprite.character = entry[2] | ((entry[3] & 0x01) << 8);
+        sprite.palette = (entry[3] >> 1) & 0x07;
+        sprite.priority = (entry[3] >> 4) & 0x03;
+        sprite.hflip = (entry[3] & 0x40) != 0;
+        sprite.vflip = (entry[3] & 0x80) != 0;
+        sprite.width = sizes[(high >> 1) & 0x01][0];
+        sprite.height = sizes[(high >> 1) & 0x01][1];
+
+        if (offLeftEdge(sprite)) {
+            continue;
+        }
+        for (int row = 0; row < sprite.height; ++row) {
+            lineCount[(sprite.y + row) & 0xFF]++;
+        }
+    }
+
+    lineStart[0] = 0;
+    for (int y = 0; y < 256; ++y) {
+        lineStart[y + 1] = lineStart[y] + lineCount[y];
+    }
+    uint16 fill[256];
+    std::memcpy(fill, lineStart, sizeof(fill));
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        const Sprite& sprite = sprites[i];
+        if (offLeftEdge(sprite)) {
+            continue;
+        }
+        for (int row = 0; row < sprite.height; ++row) {
+            lineSprites[fill[(sprite.y + row) & 0xFF]++] = static_cast<uint8>(i);
+        }
+    }
+}
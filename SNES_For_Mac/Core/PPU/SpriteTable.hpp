@@ -0,0 +1,60 @@
+//
+//  SpriteTable.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef SPRITETABLE_HPP
+#define SPRITETABLE_HPP
+
+#include "../Types/Types.hpp"
+#include <vector>
+
+// Decoded OAM
+// OAM is unpacked into a sprite table only after it (or OBSEL) changes,
+// together with an index of which sprites cover each of the 256 lines.
+// Per-line evaluation then only looks at the sprites in that line's bucket.
+class SpriteTable {
+public:
+    static const int SPRITE_COUNT = 128;
+
+    struct Sprite {
+        int16 x;                        // -256..255
+        uint8 y;
+        uint8 width;                    // 8, 16, 32 or 64
+        uint8 height;
+        uint16 character;               // 9 bits: name table select + tile
+        uint8 palette;                  // 0-7
+        uint8 priority;                 // 0-3
+        bool hflip;
+        bool vflip;
+    };
+
+    SpriteTable();
+
+    // OAM or OBSEL changed; the table is rebuilt on the next update()
+    void invalidate() { dirty = true; }
+    void setObjectSelect(uint8 value);
+
+    // Rebuild from the 544-byte OAM if anything changed
+    void update(const uint8* oam);
+
+    const Sprite& getSprite(int index) const { return sprites[index]; }
+
+    // Sprites with a row on line y (0-255), in OAM order
+    const uint8* getLine(int y, int& count) const {
+        count = lineStart[y + 1] - lineStart[y];
+        return &lineSprites[lineStart[y]];
+    }
+
+private:
+    Sprite sprites[SPRITE_COUNT];
+    uint8 objectSelect;
+    bool dirty;
+
+    // Counting-sorted per-line buckets
+    uint16 lineStart[257];
+    std::vector<uint8> lineSprites;
+};
+#endif
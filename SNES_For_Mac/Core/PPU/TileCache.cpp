@@ -0,0 +1,60 @@
+//
+//  TileCache.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "TileCache.hpp"
+#include "TileDecoder.hpp"
+#include <algorithm>
+
+// Only 2, 4 and 8 are valid
+const int TileCache::VIEW_OF_BPP[9] = { 0, 0, 0, 0, 1, 1, 1, 1, 2 };
+
+TileCache::TileCache() {
+    for (int view = 0; view < VIEW_COUNT; ++view) {
+        uint32 tiles = 0x10000 >> (4 + view);
+        decoded[view].resize(tiles * 8);
+        valid[view].resize(tiles);
+    }
+    reset();
+}
+
+void TileCache::reset() {
+    invalidateAll();
+    resetStats();
+}
+
+void TileCache::invalidateAll() {
+    for (int view = 0; view < VIEW_COUNT; ++view) {
+        std::fill(valid[view].begin(), valid[view].end(), 0);
+    }
+}
+
+void TileCache::invalidateRange(uint32 byteAddress, uint32 length) {
+    if (length == 0) {
+        return;
+    }
+    if (length >= 0x10000) {
+        invalidateAll();
+        return;
+    }
+    byteAddress &= 0xFFFF;
+    if (byteAddress + length > 0x10000) {
+        uint32 head = 0x10000 - byteAddress;
+        invalidateRange(byteAddress, head);
+        invalidateRange(0, length - head);
+        return;
+    }
+    uint32 last = byteAddress + length - 1;
+    for (int view = 0; view < VIEW_COUNT; ++view) {
+        int shift = 4 + view;
+        std::fill(valid[view].begin() + (byteAddress >> shift), valid[view].begin() + (last >> shift) + 1, 0);
+    }
+}
+
+void TileCache::decodeTile(const uint8* vram, int view, uint32 tile) {
+    TileDecoder::decodeTile(vram + (tile << (4 + view)), 2 << view, &decoded[view][tile * 8]);
+    valid[view][tile] = 1;
+}
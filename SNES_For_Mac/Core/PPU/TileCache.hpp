@@ -0,0 +1,74 @@
+//
+//  TileCache.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef TILECACHE_HPP
+#define TILECACHE_HPP
+
+#include "../Types/Types.hpp"
+#include <vector>
+
+// Decoded character cache
+// VRAM keeps tiles as interleaved bitplanes. The cache keeps a chunky
+// copy (one byte per pixel, 8 pixels per uint64 row) of every tile for
+// each of the 2bpp/4bpp/8bpp views of VRAM. VRAM writes only clear the
+// valid flag; tiles are decoded again the next time they are used.
+class TileCache {
+public:
+    TileCache();
+
+    // Drop every decoded tile and clear the statistics
+    void reset();
+
+    // VRAM byte at byteAddress changed
+    void invalidate(uint32 byteAddress) {
+        byteAddress &= 0xFFFF;
+        valid[0][byteAddress >> 4] = 0;
+        valid[1][byteAddress >> 5] = 0;
+        valid[2][byteAddress >> 6] = 0;
+    }
+
+    // VRAM bytes [byteAddress, byteAddress + length) changed (wraps at 64KB)
+    void invalidateRange(uint32 byteAddress, uint32 length);
+    void invalidateAll();
+
+    // 8 decoded rows of the tile starting at VRAM byte address
+    // tileAddress (aligned to the tile size); byte n of a row is the
+    // color index of pixel n
+    const uint64* getTile(const uint8* vram, int bpp, uint32 tileAddress) {
+        int view = VIEW_OF_BPP[bpp];
+        uint32 tile = (tileAddress & 0xFFFF) >> (4 + view);
+        if (valid[view][tile]) {
+            hits++;
+        } else {
+            misses++;
+            decodeTile(vram, view, tile);
+        }
+        return &decoded[view][tile * 8];
+    }
+
+    // Lookup statistics since the last reset
+    uint64 getHits() const { return hits; }
+    uint64 getMisses() const { return misses; }
+    double getHitRate() const {
+        uint64 total = hits + misses;
+        return total ? static_cast<double>(hits) / total : 0.0;
+    }
+    void resetStats() { hits = 0; misses = 0; }
+
+private:
+    static const int VIEW_COUNT = 3;            // 2bpp, 4bpp, 8bpp
+    static const int VIEW_OF_BPP[9];
+
+    std::vector<uint64> decoded[VIEW_COUNT];    // 8 rows per tile
+    std::vector<uint8> valid[VIEW_COUNT];
+
+    uint64 hits;
+    uint64 misses;
+
+    void decodeTile(const uint8* vram, int view, uint32 tile);
+};
+#endif
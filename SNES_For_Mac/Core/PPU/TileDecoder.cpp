@@ -0,0 +1,196 @@
+//
+//  TileDecoder.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "TileDecoder.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TILEDECODER_X86 1
+#endif
+
+TileDecoder::Kernels TileDecoder::kernels = TileDecoder::kernelsFor(TileDecoder::detectLevel());
+
+namespace {
+    // Spread the 8 bits of a bitplane byte over 8 bytes: bit (7 - n) -> bit 0 of byte n
+    inline uint64 expandPlane(uint8 value) {
+        return ((value * 0x8040201008040201ULL) & 0x8080808080808080ULL) >> 7;
+    }
+
+    const uint64 BYTES_ONE = 0x0101010101010101ULL;
+}
+
+TileDecoder::Level TileDecoder::detectLevel() {
+#ifdef TILEDECODER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return LEVEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return LEVEL_SSE2;
+    }
+#endif
+    return LEVEL_SCALAR;
+}
+
+TileDecoder::Level TileDecoder::setLevel(Level level) {
+    Level best = detectLevel();
+    kernels = kernelsFor(level > best ? best : level);
+    return kernels.level;
+}
+
+TileDecoder::Kernels TileDecoder::kernelsFor(Level level) {
+    switch (level) {
+#ifdef TILEDECODER_X86
+        case LEVEL_AVX2:
+            return { LEVEL_AVX2, decodeTileAVX2, writeRowsAVX2 };
+        case LEVEL_SSE2:
+            return { LEVEL_SSE2, decodeTileSSE2, writeRowsSSE2 };
+#endif
+        default:
+            return { LEVEL_SCALAR, decodeTileScalar, writeRowsScalar };
+    }
+}
+
+// Planes come in pairs: row r of planes 2p/2p+1 is at bytes p * 16 + r * 2 (+1)
+void TileDecoder::decodeTileScalar(const uint8* planar, int bpp, uint64* rows) {
+    int pairs = bpp >> 1;
+    for (int row = 0; row < 8; ++row) {
+        uint64 pixels = 0;
+        for (int pair = 0; pair < pairs; ++pair) {
+            const uint8* source = planar + pair * 16 + row * 2;
+            pixels |= (expandPlane(source[0]) << (pair * 2)) | (expandPlane(source[1]) << (pair * 2 + 1));
+        }
+        rows[row] = pixels;
+    }
+}
+
+void TileDecoder::writeRowsScalar(uint8* index, uint8* priority, const uint64* rows,
+                                  const uint8* palettes, const uint8* priorities, int count) {
+    for (int i = 0; i < count; ++i) {
+        for (int n = 0; n < 8; ++n) {
+            uint8 c = static_cast<uint8>(rows[i] >> (n * 8));
+            index[i * 8 + n] = c ? static_cast<uint8>(c + palettes[i]) : 0;
+            priority[i * 8 + n] = priorities[i];
+        }
+    }
+}
+
+#ifdef TILEDECODER_X86
+
+// Byte masks selecting pixel n's bit of a broadcast plane byte
+#define PIXEL_BITS 0x0102040810204080LL
+
+__attribute__((target("sse2")))
+void TileDecoder::decodeTileSSE2(const uint8* planar, int bpp, uint64* rows) {
+    const __m128i evenMask = _mm_set1_epi16(0x00FF);
+    const __m128i pixelBits = _mm_set1_epi64x(PIXEL_BITS);
+    __m128i acc[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+
+    for (int pair = 0; pair < (bpp >> 1); ++pair) {
+        // Split the interleaved pair into 8 row bytes per plane
+        __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planar + pair * 16));
+        __m128i planes[2] = {
+            _mm_packus_epi16(_mm_and_si128(source, evenMask), _mm_setzero_si128()),
+            _mm_packus_epi16(_mm_srli_epi16(source, 8), _mm_setzero_si128())
+        };
+        for (int p = 0; p < 2; ++p) {
+            const __m128i bit = _mm_set1_epi8(static_cast<char>(1 << (pair * 2 + p)));
+            // Broadcast each row byte over 8 lanes, two rows per register
+            __m128i doubled = _mm_unpacklo_epi8(planes[p], planes[p]);
+            __m128i quads[2] = { _mm_unpacklo_epi16(doubled, doubled), _mm_unpackhi_epi16(doubled, doubled) };
+            for (int q = 0; q < 2; ++q) {
+                __m128i spread[2] = { _mm_unpacklo_epi32(quads[q], quads[q]), _mm_unpackhi_epi32(quads[q], quads[q]) };
+                for (int s = 0; s < 2; ++s) {
+                    __m128i set = _mm_cmpeq_epi8(_mm_and_si128(spread[s], pixelBits), pixelBits);
+                    acc[q * 2 + s] = _mm_or_si128(acc[q * 2 + s], _mm_and_si128(set, bit));
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows + i * 2), acc[i]);
+    }
+}
+
+__attribute__((target("sse2")))
+void TileDecoder::writeRowsSSE2(uint8* index, uint8* priority, const uint64* rows,
+                                const uint8* palettes, const uint8* priorities, int count) {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + i));
+        __m128i palette = _mm_set_epi64x(static_cast<int64>(palettes[i + 1] * BYTES_ONE),
+                                         static_cast<int64>(palettes[i] * BYTES_ONE));
+        __m128i transparent = _mm_cmpeq_epi8(pixels, zero);
+        __m128i colors = _mm_andnot_si128(transparent, _mm_add_epi8(pixels, palette));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(index + i * 8), colors);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(priority + i * 8),
+                         _mm_set_epi64x(static_cast<int64>(priorities[i + 1] * BYTES_ONE),
+                                        static_cast<int64>(priorities[i] * BYTES_ONE)));
+    }
+    if (i < count) {
+        writeRowsScalar(index + i * 8, priority + i * 8, rows + i, palettes + i, priorities + i, count - i);
+    }
+}
+
+__attribute__((target("avx2")))
+void TileDecoder::decodeTileAVX2(const uint8* planar, int bpp, uint64* rows) {
+    const __m128i evenMask = _mm_set1_epi16(0x00FF);
+    const __m256i pixelBits = _mm256_set1_epi64x(PIXEL_BITS);
+    // Broadcast row bytes 0-3 / 4-7 over 8 lanes each
+    const __m256i spreadLow = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                               2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i spreadHigh = _mm256_add_epi8(spreadLow, _mm256_set1_epi8(4));
+    __m256i low = _mm256_setzero_si256();
+    __m256i high = _mm256_setzero_si256();
+
+    for (int pair = 0; pair < (bpp >> 1); ++pair) {
+        __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planar + pair * 16));
+        __m128i planes[2] = {
+            _mm_packus_epi16(_mm_and_si128(source, evenMask), _mm_setzero_si128()),
+            _mm_packus_epi16(_mm_srli_epi16(source, 8), _mm_setzero_si128())
+        };
+        for (int p = 0; p < 2; ++p) {
+            const __m256i bit = _mm256_set1_epi8(static_cast<char>(1 << (pair * 2 + p)));
+            __m256i plane = _mm256_broadcastq_epi64(planes[p]);
+            __m256i setLow = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_shuffle_epi8(plane, spreadLow), pixelBits), pixelBits);
+            __m256i setHigh = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_shuffle_epi8(plane, spreadHigh), pixelBits), pixelBits);
+            low = _mm256_or_si256(low, _mm256_and_si256(setLow, bit));
+            high = _mm256_or_si256(high, _mm256_and_si256(setHigh, bit));
+        }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows), low);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows + 4), high);
+}
+
+__attribute__((target("avx2")))
+void TileDecoder::writeRowsAVX2(uint8* index, uint8* priority, const uint64* rows,
+                                const uint8* palettes, const uint8* priorities, int count) {
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + i));
+        __m256i palette = _mm256_setr_epi64x(static_cast<int64>(palettes[i] * BYTES_ONE),
+                                             static_cast<int64>(palettes[i + 1] * BYTES_ONE),
+                                             static_cast<int64>(palettes[i + 2] * BYTES_ONE),
+                                             static_cast<int64>(palettes[i + 3] * BYTES_ONE));
+        __m256i transparent = _mm256_cmpeq_epi8(pixels, zero);
+        __m256i colors = _mm256_andnot_si256(transparent, _mm256_add_epi8(pixels, palette));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(index + i * 8), colors);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(priority + i * 8),
+                            _mm256_setr_epi64x(static_cast<int64>(priorities[i] * BYTES_ONE),
+                                               static_cast<int64>(priorities[i + 1] * BYTES_ONE),
+                                               static_cast<int64>(priorities[i + 2] * BYTES_ONE),
+                                               static_cast<int64>(priorities[i + 3] * BYTES_ONE)));
+    }
+    if (i < count) {
+        writeRowsSSE2(index + i * 8, priority + i * 8, rows + i, palettes + i, priorities + i, count - i);
+    }
+}
+
+#endif
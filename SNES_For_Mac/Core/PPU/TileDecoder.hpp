@@ -0,0 +1,68 @@
+//
+//  TileDecoder.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef TILEDECODER_HPP
+#define TILEDECODER_HPP
+
+#include "../Types/Types.hpp"
+
+// Bitplane -> chunky kernels
+// Every kernel has a portable scalar version; SSE2/AVX2 versions are
+// picked at startup from the CPU's feature flags. All versions produce
+// identical output.
+class TileDecoder {
+public:
+    enum Level {
+        LEVEL_SCALAR,
+        LEVEL_SSE2,
+        LEVEL_AVX2
+    };
+
+    // Decode one 2/4/8bpp tile in VRAM layout (16/32/64 bytes) into 8 rows;
+    // byte n of a row is the color index of pixel n
+    static void decodeTile(const uint8* planar, int bpp, uint64* rows) {
+        kernels.decodeTile(planar, bpp, rows);
+    }
+
+    // Write count tile rows side by side into a scanline:
+    // index[i * 8 + n] = pixel n of rows[i], plus palettes[i] unless it is 0,
+    // priority[i * 8 + n] = priorities[i]
+    static void writeRows(uint8* index, uint8* priority, const uint64* rows,
+                          const uint8* palettes, const uint8* priorities, int count) {
+        kernels.writeRows(index, priority, rows, palettes, priorities, count);
+    }
+
+    // Best level this CPU supports / level currently in use
+    static Level detectLevel();
+    static Level getLevel() { return kernels.level; }
+
+    // Switch kernels (clamped to what the CPU supports); returns the level set
+    static Level setLevel(Level level);
+
+    // Individual kernels, for tests and benchmarks
+    static void decodeTileScalar(const uint8* planar, int bpp, uint64* rows);
+    static void writeRowsScalar(uint8* index, uint8* priority, const uint64* rows,
+                                const uint8* palettes, const uint8* priorities, int count);
+#if defined(__x86_64__) || defined(__i386__)
+    static void decodeTileSSE2(const uint8* planar, int bpp, uint64* rows);
+    static void writeRowsSSE2(uint8* index, uint8* priority, const uint64* rows,
+                              const uint8* palettes, const uint8* priorities, int count);
+    static void decodeTileAVX2(const uint8* planar, int bpp, uint64* rows);
+    static void writeRowsAVX2(uint8* index, uint8* priority, const uint64* rows,
+                              const uint8* palettes, const uint8* priorities, int count);
+#endif
+
+private:
+    struct Kernels {
+        Level level;
+        void (*decodeTile)(const uint8*, int, uint64*);
+        void (*writeRows)(uint8*, uint8*, const uint64*, const uint8*, const uint8*, int);
+    };
+    static Kernels kernels;
+    static Kernels kernelsFor(Level level);
+};
+#endif
@@ -0,0 +1,76 @@
+//
+//  EventQueue.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef EVENTQUEUE_HPP
+#define EVENTQUEUE_HPP
+
+#include "../Types/Types.hpp"
+
+// Fixed-capacity priority queue of timed events, one slot per kind
+// Each kind is pending at most once (scheduling it again moves it), so
+// with a handful of kinds a scan beats a heap; the earliest is cached
+// since it is asked for far more often than anything changes.
+// Events due at the same time come out in kind order.
+template <int KINDS>
+class EventQueue {
+public:
+    static const uint64 NEVER = ~0ULL;
+
+    EventQueue() { clear(); }
+
+    void clear() {
+        for (int i = 0; i < KINDS; ++i) {
+            times[i] = NEVER;
+        }
+        earliest = NEVER;
+        earliestKind = 0;
+    }
+
+    void schedule(int kind, uint64 time) {
+        times[kind] = time;
+        update();
+    }
+
+    void cancel(int kind) {
+        times[kind] = NEVER;
+        update();
+    }
+
+    bool isPending(int kind) const { return times[kind] != NEVER; }
+    uint64 getTime(int kind) const { return times[kind]; }
+
+    // Time of the earliest event (NEVER if none)
+    uint64 next() const { return earliest; }
+
+    // Take the earliest event if it is due by now
+    bool pop(uint64 now, int& kind, uint64& time) {
+        if (earliest > now) {
+            return false;
+        }
+        kind = earliestKind;
+        time = earliest;
+        times[kind] = NEVER;
+        update();
+        return true;
+    }
+
+private:
+    uint64 times[KINDS];
+    uint64 earliest;
+    int earliestKind;
+
+    void update() {
+        earliest = NEVER;
+        for (int i = 0; i < KINDS; ++i) {
+            if (times[i] < earliest) {
+                earliest = times[i];
+                earliestKind = i;
+            }
+        }
+    }
+};
+#endif
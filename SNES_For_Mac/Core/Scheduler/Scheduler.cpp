@@ -0,0 +1,286 @@
+//
+//  Scheduler.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "Scheduler.hpp"
+#include "../CPU/CPU65c816.hpp"
+#include "../Memory/Memory.hpp"
+#include "../PPU/PPU.hpp"
+#include "../DMA/DMAController.hpp"
+#include "../APU/APUClock.hpp"
+#include <algorithm>
+
+Scheduler::Scheduler(): cpu(nullptr), memory(nullptr), ppu(nullptr), dma(nullptr), apuClock(nullptr),
+                        apuSyncInterval(0) {
+    for (int i = 0; i < 4; ++i) {
+        joypads[i] = 0;
+    }
+    reset();
+}
+
+void Scheduler::setCPU(CPU65c816* processor) {
+    cpu = processor;
+}
+
+void Scheduler::setMemory(Memory* mem) {
+    memory = mem;
+}
+
+void Scheduler::setPPU(PPU* video) {
+    ppu = video;
+}
+
+void Scheduler::setDMA(DMAController* controller) {
+    dma = controller;
+}
+
+void Scheduler::setAPUClock(APUClock* clock) {
+    apuClock = clock;
+}
+
+void Scheduler::reset() {
+    frameStart = getTime();
+    line = 0;
+    nextLine = 0;
+    vblank = false;
+    frames = 0;
+    batches = 0;
+    nmitimen = 0;
+    htime = 0x1FF;
+    vtime = 0x1FF;
+    rdnmi = 0;
+    timeup = 0;
+    joypadBusy = false;
+    for (int i = 0; i < 4; ++i) {
+        joypadData[i] = 0;
+    }
+    events.clear();
+    events.schedule(EVENT_LINE, frameStart);
+    if (apuSyncInterval) {
+        events.schedule(EVENT_APU_SYNC, frameStart + apuSyncInterval);
+    }
+}
+
+uint64 Scheduler::getTime() const {
+    return cpu ? cpu->totalCycles * MASTER_CYCLES_PER_CPU_CYCLE : 0;
+}
+
+int Scheduler::getVisibleLines() const {
+    return ppu ? ppu->getVisibleLines() : 224;
+}
+
+void Scheduler::setAPUSyncInterval(uint32 cycles) {
+    apuSyncInterval = cycles;
+    if (cycles) {
+        events.schedule(EVENT_APU_SYNC, getTime() + cycles);
+    } else {
+        events.cancel(EVENT_APU_SYNC);
+    }
+}
+
+void Scheduler::runFrame() {
+    if (!cpu) {
+        return;
+    }
+    // Line 0 of the next frame belongs to the next call
+    uint64 end = events.getTime(EVENT_LINE) + LINES_PER_FRAME * MASTER_CYCLES_PER_SCANLINE;
+    while (true) {
+        uint64 now = getTime();
+        int event;
+        uint64 time;
+        while (events.pop(std::min(now, end - 1), event, time)) {
+            dispatch(event, time);
+        }
+        if (now >= end) {
+            break;
+        }
+        // Round up: the CPU has to get at least as far as the event
+        uint64 target = std::min(events.next(), end);
+        cpu->run((target + MASTER_CYCLES_PER_CPU_CYCLE - 1) / MASTER_CYCLES_PER_CPU_CYCLE);
+        batches++;
+    }
+    if (apuClock) {
+        apuClock->catchUp();
+    }
+    frames++;
+}
+
+void Scheduler::dispatch(int event, uint64 time) {
+    switch (event) {
+        case EVENT_LINE:
+            startLine(time);
+            break;
+        case EVENT_HBLANK:
+            // The line is finished, then this line's HDMA writes are applied
+            // in one batch for the next one
+            if (line <= getVisibleLines()) {
+                if (ppu) {
+                    ppu->renderScanline(line);
+                }
+                if (dma && memory) {
+                    memory->addStallCycles(dma->runHDMALine(line));
+                }
+            }
+            break;
+        case EVENT_IRQ:
+            timeup = 0x80;
+            if (cpu) {
+                cpu->setIRQ(true);
+            }
+            scheduleIRQ(time + 1);
+            break;
+        case EVENT_JOYPAD:
+            joypadBusy = false;
+            break;
+        case EVENT_APU_SYNC:
+            if (apuClock) {
+                apuClock->catchUp();
+            }
+            events.schedule(EVENT_APU_SYNC, time + apuSyncInterval);
+            break;
+        default:
+            break;
+    }
+}
+
+void Scheduler::startLine(uint64 time) {
+    line = nextLine;
+    if (line == 0) {
+        frameStart = time;
+        // V-blank ends; HDMA tables are reloaded at the top of every frame
+        vblank = false;
+        rdnmi &= ~0x80;
+        if (dma && memory) {
+            memory->addStallCycles(dma->initHDMA());
+        }
+    } else if (line == getVisibleLines() + 1) {
+        // V-blank starts: the frame is complete
+        vblank = true;
+        if (ppu) {
+            ppu->endFrame();
+        }
+        rdnmi |= 0x80;
+        if ((nmitimen & 0x80) && cpu) {
+            cpu->setNMI();
+        }
+        if (nmitimen & 0x01) {
+            for (int i = 0; i < 4; ++i) {
+                joypadData[i] = joypads[i];
+            }
+            joypadBusy = true;
+            events.schedule(EVENT_JOYPAD, time + JOYPAD_READ_CYCLES);
+        }
+    }
+    nextLine = (line + 1) % LINES_PER_FRAME;
+    events.schedule(EVENT_HBLANK, time + HBLANK_START);
+    events.schedule(EVENT_LINE, time + MASTER_CYCLES_PER_SCANLINE);
+}
+
+void Scheduler::scheduleIRQ(uint64 from) {
+    // NMITIMEN bits 4-5: 1 = every line at HTIME, 2 = line VTIME at dot 0,
+    // 3 = line VTIME at HTIME
+    int mode = (nmitimen >> 4) & 0x03;
+    bool horizontal = mode & 0x01;
+    if (mode == 0 || (horizontal && htime >= DOTS_PER_LINE) || (mode != 1 && vtime >= LINES_PER_FRAME)) {
+        events.cancel(EVENT_IRQ);
+        return;
+    }
+    uint64 dot = horizontal ? htime * MASTER_CYCLES_PER_DOT : 0;
+    uint64 time;
+    if (mode == 1) {
+        uint64 start = frameStart + (from > frameStart ? (from - frameStart) / MASTER_CYCLES_PER_SCANLINE : 0) * MASTER_CYCLES_PER_SCANLINE;
+        time = start + dot;
+        if (time < from) {
+            time += MASTER_CYCLES_PER_SCANLINE;
+        }
+    } else {
+        const uint64 frame = LINES_PER_FRAME * MASTER_CYCLES_PER_SCANLINE;
+        time = frameStart + vtime * MASTER_CYCLES_PER_SCANLINE + dot;
+        while (time < from) {
+            time += frame;
+        }
+    }
+    events.schedule(EVENT_IRQ, time);
+    if (cpu) {
+        // Written mid-run: stop the CPU in time for it
+        cpu->limitRun((time + MASTER_CYCLES_PER_CPU_CYCLE - 1) / MASTER_CYCLES_PER_CPU_CYCLE);
+    }
+}
+
+uint8 Scheduler::readRegister(uint16 offset) {
+    switch (offset) {
+        case 0x4210:            // RDNMI: NMI flag (cleared by reading), CPU version 2
+        {
+            uint8 value = rdnmi | 0x02;
+            rdnmi &= ~0x80;
+            return value;
+        }
+        case 0x4211:            // TIMEUP: IRQ flag, cleared (with the IRQ) by reading
+        {
+            uint8 value = timeup;
+            timeup = 0;
+            if (cpu) {
+                cpu->setIRQ(false);
+            }
+            return value;
+        }
+        case 0x4212:            // HVBJOY
+        {
+            uint64 position = (getTime() - std::min(getTime(), frameStart)) % MASTER_CYCLES_PER_SCANLINE;
+            bool hblank = position >= HBLANK_START || position < HBLANK_END;
+            return (vblank ? 0x80 : 0) | (hblank ? 0x40 : 0) | (joypadBusy ? 0x01 : 0);
+        }
+        case 0x4218: case 0x421A: case 0x421C: case 0x421E:     // JOYnL
+            return joypadData[(offset - 0x4218) >> 1] & 0xFF;
+        case 0x4219: case 0x421B: case 0x421D: case 0x421F:     // JOYnH
+            return joypadData[(offset - 0x4218) >> 1] >> 8;
+        default:
+            return 0xFF;        // Open bus
+    }
+}
+
+void Scheduler::writeRegister(uint16 offset, uint8 value) {
+    switch (offset) {
+        case 0x4200:            // NMITIMEN
+        {
+            // Enabling NMI during V-blank, before RDNMI is read, fires it at once
+            if (!(nmitimen & 0x80) && (value & 0x80) && (rdnmi & 0x80) && cpu) {
+                cpu->setNMI();
+            }
+            nmitimen = value;
+            if (!(value & 0x30)) {
+                timeup = 0;
+                if (cpu) {
+                    cpu->setIRQ(false);
+                }
+            }
+            scheduleIRQ(getTime());
+            break;
+        }
+        case 0x4207:            // HTIMEL
+            htime = (htime & 0x100) | value;
+            scheduleIRQ(getTime());
+            break;
+        case 0x4208:            // HTIMEH
+            htime = (htime & 0xFF) | ((value & 0x01) << 8);
+            scheduleIRQ(getTime());
+            break;
+        case 0x4209:            // VTIMEL
+            vtime = (vtime & 0x100) | value;
+            scheduleIRQ(getTime());
+            break;
+        case 0x420A:            // VTIMEH
+            vtime = (vtime & 0xFF) | ((value & 0x01) << 8);
+            scheduleIRQ(getTime());
+            break;
+        default:
+            break;
+    }
+}
+
+void Scheduler::setJoypad(int port, uint16 buttons) {
+    joypads[port & 0x03] = buttons;
+}
@@ -0,0 +1,115 @@
+//
+//  Scheduler.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include "../Types/Types.hpp"
+#include "../Types/Timing.hpp"
+#include "EventQueue.hpp"
+
+class CPU65c816;
+class Memory;
+class PPU;
+class DMAController;
+class APUClock;
+
+// Runs the frame off the master clock (the CPU's cycle count x 6)
+// Everything that happens at a point in time is an event: the start of
+// each line (V-blank, NMI, auto-joypad read, HDMA setup), H-blank (line
+// rendering and HDMA), the H/V timer IRQ, the end of the joypad read and
+// APU sync points. The CPU runs uninterrupted up to the next one, so
+// nothing is checked between its instructions.
+// Also owns the CPU's timing registers: NMITIMEN ($4200), HTIME/VTIME
+// ($4207-$420A), RDNMI/TIMEUP/HVBJOY ($4210-$4212) and the auto-read
+// joypad data ($4218-$421F); Memory forwards them here.
+class Scheduler {
+public:
+    static const uint32 LINES_PER_FRAME = SCANLINES_PER_FRAME_NTSC;
+    static const uint32 MASTER_CYCLES_PER_DOT = 4;
+    static const uint32 DOTS_PER_LINE = 340;
+    static const uint32 HBLANK_START = 274 * MASTER_CYCLES_PER_DOT;
+    static const uint32 HBLANK_END = 1 * MASTER_CYCLES_PER_DOT;
+    static const uint32 JOYPAD_READ_CYCLES = 4224;      // Auto-joypad read busy time
+
+    Scheduler();
+
+    void setCPU(CPU65c816* processor);
+    void setMemory(Memory* mem);
+    void setPPU(PPU* video);
+    void setDMA(DMAController* controller);
+    void setAPUClock(APUClock* clock);
+
+    // Start a frame at the CPU's current time (after it is reset)
+    void reset();
+
+    // Run the CPU and everything around it for one frame; the APU is
+    // caught up at the end
+    void runFrame();
+
+    // Also catch the APU up every cycles master cycles (0 = only when the
+    // CPU touches its ports and at the end of the frame)
+    void setAPUSyncInterval(uint32 cycles);
+
+    // $4200-$421F
+    uint8 readRegister(uint16 offset);
+    void writeRegister(uint16 offset, uint8 value);
+
+    // Buttons on joypad port (0-3), as the auto-read reports them:
+    // bit 15 B, Y, Select, Start, Up, Down, Left, Right, A, X, L, bit 4 R
+    void setJoypad(int port, uint16 buttons);
+    uint16 getJoypad(int port) const { return joypads[port & 0x03]; }
+
+    // Current master cycle, and where it falls
+    uint64 getTime() const;
+    uint64 getFrameStart() const { return frameStart; }
+    int getLine() const { return line; }
+
+    uint64 getFrames() const { return frames; }
+    // CPU runs between events since reset
+    uint64 getBatches() const { return batches; }
+
+private:
+    enum Event {
+        EVENT_LINE,                     // Start of line nextLine
+        EVENT_HBLANK,
+        EVENT_IRQ,                      // H/V timer
+        EVENT_JOYPAD,                   // Auto-joypad read done
+        EVENT_APU_SYNC,
+        EVENT_COUNT
+    };
+    EventQueue<EVENT_COUNT> events;
+
+    CPU65c816* cpu;
+    Memory* memory;
+    PPU* ppu;
+    DMAController* dma;
+    APUClock* apuClock;
+
+    uint64 frameStart;                  // Master cycle line 0 started at
+    int line;
+    int nextLine;
+    bool vblank;
+    uint32 apuSyncInterval;
+    uint64 frames;
+    uint64 batches;
+
+    uint8 nmitimen;
+    uint16 htime;                       // 9 bits
+    uint16 vtime;
+    uint8 rdnmi;                        // Bit 7: NMI flag
+    uint8 timeup;                       // Bit 7: IRQ flag
+    bool joypadBusy;
+    uint16 joypads[4];
+    uint16 joypadData[4];               // Latched by the last auto-read
+
+    void dispatch(int event, uint64 time);
+    void startLine(uint64 time);
+    void scheduleIRQ(uint64 from);
+    int getVisibleLines() const;
+};
+#endif
@@ -0,0 +1,884 @@
+//
+//  test_apu.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "../APU/SPC700.hpp"
+#include "../APU/DSP.hpp"
+#include "../APU/VoiceMixer.hpp"
+#include "../APU/EchoFilter.hpp"
+#include "../APU/APUClock.hpp"
+#include "../APU/APUThread.hpp"
+#include "../APU/Resampler.hpp"
+#include "../CPU/CPU65c816.hpp"
+#include "../Types/Timing.hpp"
+#include "../PPU/TileDecoder.hpp"
+#include "../Memory/Memory.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#define COLOR_RESET     "\033[0m"
+#define COLOR_GREEN     "\033[32m"
+#define COLOR_RED       "\033[31m"
+#define COLOR_YELLOW    "\033[33m"
+#define COLOR_CYAN      "\033[36m"
+
+using namespace std;
+
+class APUTester {
+private:
+    SPC700 apu;
+    DSP dsp;
+    Memory memory;
+    int testsPassed;
+    int testsFailed;
+
+public:
+    APUTester() {
+        memory.setAPU(&apu);
+        apu.setDSP(&dsp);
+        dsp.setAPU(&apu);
+        testsPassed = 0;
+        testsFailed = 0;
+    }
+
+    int runAllTests() {
+        cout << COLOR_CYAN << "=== SNES Emulator APU Tests ===" << COLOR_RESET << endl;
+
+        testBoot();
+        testIPLUpload();
+        testArithmetic();
+        testMultiplyDivide();
+        testBranches();
+        testCallReturn();
+        testTimers();
+        testControl();
+        testCPUPorts();
+        testCatchUp();
+        testAPUThread();
+        testVoiceKernels();
+        testEchoKernels();
+        testResampler();
+        testVoicePlayback();
+        testBRRCache();
+        testEcho();
+
+        cout << endl;
+        cout << COLOR_CYAN << "=== Test Summary ===" << COLOR_RESET << endl;
+        cout << COLOR_GREEN << "Passed: " << testsPassed << COLOR_RESET << endl;
+        if (testsFailed > 0) {
+            cout << COLOR_RED << "Failed: " << testsFailed << COLOR_RESET << endl;
+        } else {
+            cout << COLOR_GREEN << "All tests Passed! ✓" << COLOR_RESET << endl;
+        }
+        return testsFailed;
+    }
+
+private:
+    void assert_equal(const string& testName, uint32 expected, uint32 actual) {
+        if (expected == actual) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            cout << " Expected: 0x" << hex << expected << ", Got: 0x" << actual << dec << endl;
+            testsFailed++;
+        }
+    }
+
+    void assert_true(const string& testName, bool condition) {
+        if (condition) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            testsFailed++;
+        }
+    }
+
+    void printTestHeader(const string& testName) {
+        cout << endl << COLOR_YELLOW << "--- " << testName << " ---" << COLOR_RESET << endl;
+    }
+
+    // Place code at $0200 and point PC at it
+    void loadProgram(const vector<uint8>& code) {
+        apu.reset();
+        for (size_t i = 0; i < code.size(); ++i) {
+            apu.getRAM()[0x0200 + i] = code[i];
+        }
+        apu.registers.PC = 0x0200;
+    }
+
+    void writeDSP(uint8 address, uint8 value) {
+        apu.write(0x00F2, address);
+        apu.write(0x00F3, value);
+    }
+
+    uint8 readDSP(uint8 address) {
+        apu.write(0x00F2, address);
+        return apu.read(0x00F3);
+    }
+
+    // Voice 0 playing one looping BRR block of constant samples from $0300
+    // (directory at $0200) at 32 kHz, GAIN $7F, full volume
+    void startTestVoice(uint8 nibbles) {
+        apu.reset();
+        apu.write(0x0200, 0x00);
+        apu.write(0x0201, 0x03);
+        apu.write(0x0202, 0x00);
+        apu.write(0x0203, 0x03);
+        apu.write(0x0300, 0xC3);                // Range 12, filter 0, loop, end
+        for (int i = 1; i < 9; ++i) {
+            apu.write(0x0300 + i, nibbles);
+        }
+        writeDSP(DSP::DIR, 0x02);
+        writeDSP(DSP::FLG, 0x20);               // Out of reset, echo writes off
+        writeDSP(DSP::MVOLL, 0x7F);
+        writeDSP(DSP::MVOLR, 0x7F);
+        writeDSP(DSP::VOLL, 0x7F);
+        writeDSP(DSP::VOLR, 0x7F);
+        writeDSP(DSP::PITCHH, 0x10);
+        writeDSP(DSP::GAIN, 0x7F);
+        writeDSP(DSP::KON, 0x01);
+    }
+
+    // Run the SPC700 for count samples; reading $F3 brings the DSP (which
+    // otherwise follows a chunk at a time) up to date
+    void runSamples(int count) {
+        apu.run(DSP::CYCLES_PER_SAMPLE * count);
+        readDSP(DSP::ENDX);
+    }
+
+    // Run the SPC700 until an output port holds value (as the S-CPU polls it)
+    bool waitForPort(int port, uint8 value) {
+        for (int i = 0; i < 10000; ++i) {
+            if (apu.readPort(port) == value) {
+                return true;
+            }
+            apu.run(32);
+        }
+        return false;
+    }
+
+    void testBoot() {
+        printTestHeader("IPL Boot");
+        apu.reset();
+        assert_equal("PC starts at the IPL ROM", 0xFFC0, apu.registers.PC);
+        assert_true("IPL announces itself", waitForPort(0, 0xAA) && apu.readPort(1) == 0xBB);
+        assert_equal("SP set by the IPL", 0xEF, apu.registers.SP);
+    }
+
+    void testIPLUpload() {
+        printTestHeader("IPL Upload");
+        apu.reset();
+        waitForPort(0, 0xAA);
+
+        // MOV A,#$42; MOV $F4,A; BRA $
+        vector<uint8> program = {0xE8, 0x42, 0xC4, 0xF4, 0x2F, 0xFE};
+        apu.writePort(2, 0x00);
+        apu.writePort(3, 0x03);
+        apu.writePort(1, 0x01);
+        apu.writePort(0, 0xCC);
+        assert_true("Transfer start acknowledged", waitForPort(0, 0xCC));
+
+        bool echoed = true;
+        for (size_t i = 0; i < program.size(); ++i) {
+            apu.writePort(1, program[i]);
+            apu.writePort(0, static_cast<uint8>(i));
+            echoed = echoed && waitForPort(0, static_cast<uint8>(i));
+        }
+        assert_true("Every byte echoed", echoed);
+
+        // Port 1 = 0: jump to the address in ports 2/3
+        apu.writePort(2, 0x00);
+        apu.writePort(3, 0x03);
+        apu.writePort(1, 0x00);
+        apu.writePort(0, static_cast<uint8>(program.size() + 1));
+        assert_true("Uploaded program runs", waitForPort(0, 0x42));
+        assert_equal("Program stored at $0300", 0xE8, apu.read(0x0300));
+        assert_equal("Last byte stored", 0xFE, apu.read(0x0305));
+    }
+
+    void testArithmetic() {
+        printTestHeader("ADC/SBC");
+        // CLRC; MOV A,#$7F; ADC A,#$01
+        loadProgram({0x60, 0xE8, 0x7F, 0x88, 0x01});
+        for (int i = 0; i < 3; ++i) {
+            apu.executeInstruction();
+        }
+        uint8 psw = apu.registers.PSW;
+        assert_equal("ADC result", 0x80, apu.registers.A);
+        assert_true("ADC sets V, N and H", (psw & SPC700::FLAG_V) && (psw & SPC700::FLAG_N) && (psw & SPC700::FLAG_H));
+        assert_true("ADC clears C and Z", !(psw & SPC700::FLAG_C) && !(psw & SPC700::FLAG_Z));
+
+        // SETC; MOV A,#$10; SBC A,#$20
+        loadProgram({0x80, 0xE8, 0x10, 0xA8, 0x20});
+        for (int i = 0; i < 3; ++i) {
+            apu.executeInstruction();
+        }
+        assert_equal("SBC result", 0xF0, apu.registers.A);
+        assert_true("SBC borrow clears C", !(apu.registers.PSW & SPC700::FLAG_C));
+
+        // MOV $10,#$FF; INC $10
+        loadProgram({0x8F, 0xFF, 0x10, 0xAB, 0x10});
+        apu.executeInstruction();
+        apu.executeInstruction();
+        assert_equal("INC dp wraps", 0x00, apu.read(0x0010));
+        assert_true("INC dp sets Z", apu.registers.PSW & SPC700::FLAG_Z);
+    }
+
+    void testMultiplyDivide() {
+        printTestHeader("MUL/DIV");
+        // MOV A,#12; MOV Y,#11; MUL YA
+        loadProgram({0xE8, 0x0C, 0x8D, 0x0B, 0xCF});
+        apu.executeInstruction();
+        apu.executeInstruction();
+        int cycles = apu.executeInstruction();
+        assert_equal("MUL product", 132, (apu.registers.Y << 8) | apu.registers.A);
+        assert_equal("MUL takes 9 cycles", 9, cycles);
+
+        // MOV A,#$E8; MOV Y,#$03; MOV X,#7; DIV YA,X (1000 / 7)
+        loadProgram({0xE8, 0xE8, 0x8D, 0x03, 0xCD, 0x07, 0x9E});
+        for (int i = 0; i < 3; ++i) {
+            apu.executeInstruction();
+        }
+        cycles = apu.executeInstruction();
+        assert_equal("DIV quotient", 142, apu.registers.A);
+        assert_equal("DIV remainder", 6, apu.registers.Y);
+        assert_equal("DIV takes 12 cycles", 12, cycles);
+        assert_true("DIV fits: V clear", !(apu.registers.PSW & SPC700::FLAG_V));
+    }
+
+    void testBranches() {
+        printTestHeader("Branches");
+        // MOV A,#0; BNE +2; BEQ +2
+        loadProgram({0xE8, 0x00, 0xD0, 0x02, 0xF0, 0x02});
+        apu.executeInstruction();
+        assert_equal("Branch not taken: 2 cycles", 2, apu.executeInstruction());
+        assert_equal("Falls through", 0x0204, apu.registers.PC);
+        assert_equal("Branch taken: 4 cycles", 4, apu.executeInstruction());
+        assert_equal("Branch target", 0x0208, apu.registers.PC);
+
+        // MOV Y,#3; DBNZ Y,$ (loops until Y = 0)
+        loadProgram({0x8D, 0x03, 0xFE, 0xFE});
+        for (int i = 0; i < 4; ++i) {
+            apu.executeInstruction();
+        }
+        assert_equal("DBNZ counts down", 0, apu.registers.Y);
+        assert_equal("DBNZ exits", 0x0204, apu.registers.PC);
+
+        // MOV $20,#$80; BBS $20.7,+4
+        loadProgram({0x8F, 0x80, 0x20, 0xE3, 0x20, 0x04});
+        apu.executeInstruction();
+        apu.executeInstruction();
+        assert_equal("BBS on a set bit", 0x020A, apu.registers.PC);
+    }
+
+    void testCallReturn() {
+        printTestHeader("CALL/RET");
+        // CALL $0300 ... $0300: RET
+        loadProgram({0x3F, 0x00, 0x03});
+        apu.getRAM()[0x0300] = 0x6F;
+        apu.registers.SP = 0xEF;
+        assert_equal("CALL takes 8 cycles", 8, apu.executeInstruction());
+        assert_equal("CALL target", 0x0300, apu.registers.PC);
+        assert_equal("Return address pushed", 0x0203, apu.read(0x01EE) | (apu.read(0x01EF) << 8));
+        assert_equal("SP after CALL", 0xED, apu.registers.SP);
+        apu.executeInstruction();
+        assert_equal("RET returns", 0x0203, apu.registers.PC);
+        assert_equal("SP after RET", 0xEF, apu.registers.SP);
+
+        // PUSH A; POP X
+        loadProgram({0xE8, 0x5A, 0x2D, 0xCE});
+        apu.registers.SP = 0xEF;
+        for (int i = 0; i < 3; ++i) {
+            apu.executeInstruction();
+        }
+        assert_equal("PUSH/POP", 0x5A, apu.registers.X);
+    }
+
+    void testTimers() {
+        printTestHeader("Timers");
+        apu.reset();
+        // Timer 2 (64 kHz, 16 cycles per tick) with a target of 4, IPL kept mapped
+        apu.write(0x00FC, 4);
+        apu.write(0x00F1, 0x84);
+        apu.run(16 * 4 * 3 + 8);
+        assert_equal("Timer 2 counted 3 periods", 3, apu.read(0x00FF));
+        assert_equal("Reading clears the counter", 0, apu.read(0x00FF));
+
+        apu.run(16 * 4 * 20);
+        assert_equal("Counter is 4 bits", 20 & 0x0F, apu.read(0x00FF));
+
+        apu.run(128 * 10);
+        assert_equal("Disabled timer stays 0", 0, apu.read(0x00FD));
+
+        // Target 0 counts 256 ticks
+        apu.reset();
+        apu.write(0x00FA, 0);
+        apu.write(0x00F1, 0x81);
+        apu.run(128 * 255);
+        assert_equal("Target 0 is 256: not yet", 0, apu.read(0x00FD));
+        apu.run(128);
+        assert_equal("Target 0 is 256", 1, apu.read(0x00FD));
+    }
+
+    void testControl() {
+        printTestHeader("Control Registers");
+        apu.reset();
+        for (int i = 0; i < 4; ++i) {
+            apu.writePort(i, 0x10 + i);
+        }
+        apu.write(0x00F1, 0x90);
+        assert_true("Bit 4 clears ports 0/1", apu.read(0x00F4) == 0 && apu.read(0x00F5) == 0);
+        assert_true("Ports 2/3 kept", apu.read(0x00F6) == 0x12 && apu.read(0x00F7) == 0x13);
+        apu.write(0x00F1, 0xA0);
+        assert_true("Bit 5 clears ports 2/3", apu.read(0x00F6) == 0 && apu.read(0x00F7) == 0);
+
+        // RAM under the IPL ROM
+        apu.write(0xFFC0, 0x5A);
+        assert_equal("IPL ROM read while mapped", 0xCD, apu.read(0xFFC0));
+        apu.write(0x00F1, 0x00);
+        assert_equal("RAM visible once unmapped", 0x5A, apu.read(0xFFC0));
+        apu.write(0x00F1, 0x80);
+        assert_equal("IPL ROM mapped again", 0xCD, apu.read(0xFFC0));
+
+        // DSP registers through $F2/$F3
+        apu.write(0x00F2, 0x0C);
+        apu.write(0x00F3, 0x7F);
+        assert_equal("DSP register written", 0x7F, dsp.read(0x0C));
+        apu.write(0x00F2, 0x8C);
+        apu.write(0x00F3, 0x00);
+        assert_equal("$80-$FF are read-only mirrors", 0x7F, apu.read(0x00F3));
+    }
+
+    void testCPUPorts() {
+        printTestHeader("CPU Ports");
+        apu.reset();
+        memory.write(0x002140, 0x12);
+        memory.write(0x002143, 0x34);
+        assert_equal("$2140 reaches port 0", 0x12, apu.read(0x00F4));
+        assert_equal("$2143 reaches port 3", 0x34, apu.read(0x00F7));
+        apu.write(0x00F5, 0x56);
+        assert_equal("SPC700 writes read at $2141", 0x56, memory.read(0x002141));
+        assert_equal("Mirrored at $2145", 0x56, memory.read(0x002145));
+        assert_equal("Writes are one-way", 0x12, apu.read(0x00F4));
+    }
+    // One S-CPU with an SPC700 behind $2140-$2143
+    struct System {
+        CPU65c816 cpu;
+        Memory memory;
+        SPC700 apu;
+        DSP dsp;
+        APUClock clock;
+        APUThread thread;               // Only used if started
+
+        System() {
+            memory.setAPU(&apu);
+            apu.setDSP(&dsp);
+            dsp.setAPU(&apu);
+            clock.setCPU(&cpu);
+            clock.setAPU(&apu);
+            clock.reset();
+            thread.setAPU(&apu);
+            thread.setDSP(&dsp);
+            // Port 1 = port 0 + 1, port 2 counts loops, voice 0 volume = port 0
+            const uint8 code[] = {
+                0xE4, 0xF4,                     // loop: MOV A, $F4
+                0xBC,                           //       INC A
+                0xC4, 0xF5,                     //       MOV $F5, A
+                0xAB, 0x10,                     //       INC $10
+                0xE4, 0x10,                     //       MOV A, $10
+                0xC4, 0xF6,                     //       MOV $F6, A
+                0x8F, 0x00, 0xF2,               //       MOV $F2, #VOLL
+                0xFA, 0xF4, 0xF3,               //       MOV $F3, $F4
+                0x2F, 0xED                      //       BRA loop
+            };
+            for (size_t i = 0; i < sizeof(code); ++i) {
+                apu.getRAM()[0x0200 + i] = code[i];
+            }
+            apu.registers.PC = 0x0200;
+
+            // Voice 0 looping a BRR block from $0400 (directory at $0300)
+            uint8* ram = apu.getRAM();
+            ram[0x0300] = 0x00;
+            ram[0x0301] = 0x04;
+            ram[0x0302] = 0x00;
+            ram[0x0303] = 0x04;
+            ram[0x0400] = 0xC3;
+            for (int i = 1; i < 9; ++i) {
+                ram[0x0400 + i] = 0x17 * i;
+            }
+            dsp.write(DSP::DIR, 0x03);
+            dsp.write(DSP::FLG, 0x20);
+            dsp.write(DSP::MVOLL, 0x7F);
+            dsp.write(DSP::MVOLR, 0x7F);
+            dsp.write(DSP::VOLR, 0x7F);
+            dsp.write(DSP::PITCHH, 0x08);
+            dsp.write(DSP::GAIN, 0x7F);
+            dsp.write(DSP::KON, 0x01);
+        }
+    };
+
+    void testCatchUp() {
+        printTestHeader("APU Catch-up");
+        System lockstep;
+        System lazy;
+        lazy.memory.setAPUClock(&lazy.clock);
+
+        // The same S-CPU instruction stream on both; the lockstep SPC700 is
+        // run after every instruction, the lazy one only on port access
+        srand(42);
+        vector<uint8> lockstepReads;
+        vector<uint8> lazyReads;
+        const int INSTRUCTIONS = 20000;
+        for (int i = 0; i < INSTRUCTIONS; ++i) {
+            int action = rand() % 64;
+            uint8 value = rand();
+            if (action == 0) {
+                lockstep.memory.write(0x2140, value);
+                lazy.memory.write(0x2140, value);
+            } else if (action == 1) {
+                lockstepReads.push_back(lockstep.memory.read(0x2141));
+                lazyReads.push_back(lazy.memory.read(0x2141));
+            } else if (action == 2) {
+                lockstepReads.push_back(lockstep.memory.read(0x2142));
+                lazyReads.push_back(lazy.memory.read(0x2142));
+            }
+            int cycles = 2 + rand() % 7;
+            lockstep.cpu.totalCycles += cycles;
+            lazy.cpu.totalCycles += cycles;
+            lockstep.clock.catchUp();
+        }
+        // End of frame
+        lazy.clock.catchUp();
+
+        assert_true("Port reads match lockstep", lockstepReads == lazyReads);
+        assert_true("Port 1 follows port 0", lazy.apu.readPort(1) == static_cast<uint8>(lazy.apu.read(0x00F4) + 1));
+        assert_equal("Same SPC700 cycle", static_cast<uint32>(lockstep.apu.totalCycles), static_cast<uint32>(lazy.apu.totalCycles));
+        assert_equal("Same PC", lockstep.apu.registers.PC, lazy.apu.registers.PC);
+        assert_equal("Same loop count", lockstep.apu.read(0x0010), lazy.apu.read(0x0010));
+        assert_equal("Same master time", static_cast<uint32>(lockstep.clock.getTime()), static_cast<uint32>(lazy.clock.getTime()));
+        assert_true("Batched runs", lazy.clock.getCatchUps() < static_cast<uint64>(INSTRUCTIONS) / 16);
+
+        // 1.024 MHz against the 21.477 MHz master clock
+        uint64 expected = lazy.clock.getTime() * APU_CLOCK / MASTER_CLOCK_NTSC;
+        assert_true("SPC700 clock rate", lazy.apu.totalCycles >= expected && lazy.apu.totalCycles < expected + 8);
+    }
+
+    void testAPUThread() {
+        printTestHeader("APU Thread");
+        System lazy;
+        System threaded;
+        lazy.memory.setAPUClock(&lazy.clock);
+        threaded.memory.setAPUClock(&threaded.clock);
+        threaded.clock.setThread(&threaded.thread);
+        vector<int16> lazyAudio(16384 * 2);
+        lazy.dsp.setOutput(lazyAudio.data(), 16384);
+        threaded.thread.start();
+        assert_true("Thread running", threaded.thread.isRunning());
+
+        // Bursts of port traffic between quiet stretches the thread runs
+        // ahead through; writes after those roll it back
+        srand(45);
+        vector<uint8> lazyReads;
+        vector<uint8> threadedReads;
+        vector<int16> threadedAudio;
+        int16 chunk[512];
+        const int INSTRUCTIONS = 200000;
+        for (int i = 0; i < INSTRUCTIONS; ++i) {
+            bool busy = (i / 5000) % 2 == 0;
+            int action = rand() % (busy ? 16 : 4096);
+            uint8 value = rand();
+            if (action == 0) {
+                lazy.memory.write(0x2140, value);
+                threaded.memory.write(0x2140, value);
+            } else if (action == 1) {
+                lazyReads.push_back(lazy.memory.read(0x2141));
+                threadedReads.push_back(threaded.memory.read(0x2141));
+            } else if (action == 2) {
+                lazyReads.push_back(lazy.memory.read(0x2142));
+                threadedReads.push_back(threaded.memory.read(0x2142));
+            }
+            int cycles = 2 + rand() % 7;
+            lazy.cpu.totalCycles += cycles;
+            threaded.cpu.totalCycles += cycles;
+            if (i % 64 == 0) {
+                // As the frame loop hands over time without touching the ports
+                threaded.clock.catchUp();
+            }
+            size_t count;
+            while ((count = threaded.thread.getAudio().pop(chunk, 512)) > 0) {
+                threadedAudio.insert(threadedAudio.end(), chunk, chunk + count);
+            }
+        }
+        lazy.clock.catchUp();
+        threaded.clock.catchUp();
+        threaded.thread.stop();
+        size_t count;
+        while ((count = threaded.thread.getAudio().pop(chunk, 512)) > 0) {
+            threadedAudio.insert(threadedAudio.end(), chunk, chunk + count);
+        }
+        lazyAudio.resize(lazy.dsp.getSampleCount() * 2);
+
+        assert_true("Port reads match catch-up", lazyReads == threadedReads);
+        assert_true("Speculation was rolled back", threaded.thread.getRollbacks() > 0);
+        assert_equal("Same SPC700 cycle", static_cast<uint32>(lazy.apu.totalCycles), static_cast<uint32>(threaded.apu.totalCycles));
+        assert_equal("Same PC", lazy.apu.registers.PC, threaded.apu.registers.PC);
+        assert_equal("Same loop count", lazy.apu.read(0x0010), threaded.apu.read(0x0010));
+        assert_equal("Same ports", lazy.apu.readPort(1), threaded.apu.readPort(1));
+        assert_true("Audio made", lazyAudio.size() > 1000);
+        assert_true("Same audio", lazyAudio == threadedAudio);
+        assert_true("Stopped", !threaded.thread.isRunning());
+        assert_equal("Thread's output detached", 0, threaded.dsp.getSampleCount());
+    }
+
+    void testVoiceKernels() {
+        printTestHeader("SIMD Voice Kernels");
+        srand(0x51DC);
+        int16 taps[4][VoiceMixer::VOICES];
+        int16 coeffs[4][VoiceMixer::VOICES];
+        int16 samples[VoiceMixer::VOICES];
+        int16 envelope[VoiceMixer::VOICES];
+        int16 volumeLeft[VoiceMixer::VOICES];
+        int16 volumeRight[VoiceMixer::VOICES];
+
+        // A constant signal comes through the Gaussian filter unchanged but for rounding
+        for (int v = 0; v < VoiceMixer::VOICES; ++v) {
+            taps[0][v] = taps[1][v] = taps[2][v] = taps[3][v] = 28672;
+            coeffs[0][v] = 370;
+            coeffs[1][v] = 1305;
+            coeffs[2][v] = 374;
+            coeffs[3][v] = 0;
+        }
+        int16 reference[VoiceMixer::VOICES];
+        VoiceMixer::interpolateScalar(taps, coeffs, reference);
+        assert_equal("Scalar interpolation", 28686, reference[0]);
+
+#if defined(__x86_64__) || defined(__i386__)
+        if (TileDecoder::detectLevel() < TileDecoder::LEVEL_SSE2) {
+            return;
+        }
+        bool interpolation = true;
+        bool volume = true;
+        for (int trial = 0; trial < 2000; ++trial) {
+            for (int v = 0; v < VoiceMixer::VOICES; ++v) {
+                for (int n = 0; n < 4; ++n) {
+                    // Extremes often, to reach the wrap and clamp paths
+                    taps[n][v] = (rand() & 3) ? static_cast<int16>(rand()) : ((rand() & 1) ? 32767 : -32768);
+                    coeffs[n][v] = rand() % 1306;
+                }
+                samples[v] = static_cast<int16>(rand());
+                envelope[v] = rand() & 0x7FF;
+                volumeLeft[v] = static_cast<int8>(rand());
+                volumeRight[v] = static_cast<int8>(rand());
+            }
+            int16 vector[VoiceMixer::VOICES];
+            VoiceMixer::interpolateScalar(taps, coeffs, reference);
+            VoiceMixer::interpolateSSE2(taps, coeffs, vector);
+            interpolation = interpolation && std::memcmp(reference, vector, sizeof(reference)) == 0;
+
+            int16 out[2][VoiceMixer::VOICES];
+            int16 left[2][VoiceMixer::VOICES];
+            int16 right[2][VoiceMixer::VOICES];
+            VoiceMixer::applyVolumeScalar(samples, envelope, volumeLeft, volumeRight, out[0], left[0], right[0]);
+            VoiceMixer::applyVolumeSSE2(samples, envelope, volumeLeft, volumeRight, out[1], left[1], right[1]);
+            volume = volume && std::memcmp(out[0], out[1], sizeof(out[0])) == 0 &&
+                     std::memcmp(left[0], left[1], sizeof(left[0])) == 0 &&
+                     std::memcmp(right[0], right[1], sizeof(right[0])) == 0;
+        }
+        assert_true("SSE2 interpolation matches scalar", interpolation);
+        assert_true("SSE2 volume matches scalar", volume);
+#endif
+    }
+
+    void testEchoKernels() {
+        printTestHeader("Echo Kernels");
+        const int count = 29;                  // Not a whole number of vectors
+        int16 history[count + EchoFilter::TAPS - 1];
+        int8 coefficients[EchoFilter::TAPS] = {0, 0, 0, 0, 0, 0, 0, 0x7F};
+        for (int i = 0; i < count + EchoFilter::TAPS - 1; ++i) {
+            history[i] = 16383;
+        }
+        int16 reference[count];
+        EchoFilter::filterScalar(history, coefficients, count, reference);
+        assert_equal("Scalar FIR", 32510, reference[0]);
+
+        // The first seven taps wrap to 16 bits before the last is added and clamped
+        coefficients[0] = 0x7F;
+        coefficients[1] = 0x7F;
+        coefficients[7] = 0x00;
+        EchoFilter::filterScalar(history, coefficients, count, reference);
+        assert_equal("FIR wraps before the last tap", static_cast<uint16>(-516), static_cast<uint16>(reference[0]));
+
+        int16 main[count];
+        int16 echo[count];
+        for (int i = 0; i < count; ++i) {
+            main[i] = -32768;
+            echo[i] = 0;
+        }
+        EchoFilter::mixScalar(main, echo, -128, 0, count, reference);
+        assert_equal("Volume product wraps", static_cast<uint16>(-32768), static_cast<uint16>(reference[0]));
+
+#if defined(__x86_64__) || defined(__i386__)
+        TileDecoder::Level level = TileDecoder::detectLevel();
+        if (level < TileDecoder::LEVEL_SSE2) {
+            return;
+        }
+        bool filtered[2] = {true, true};
+        bool mixed[2] = {true, true};
+        for (int trial = 0; trial < 1000; ++trial) {
+            for (int i = 0; i < count + EchoFilter::TAPS - 1; ++i) {
+                // Echo samples are stored halved; extremes often
+                history[i] = (rand() & 3) ? static_cast<int16>(rand()) >> 1 : ((rand() & 1) ? 16383 : -16384);
+            }
+            for (int n = 0; n < EchoFilter::TAPS; ++n) {
+                coefficients[n] = (rand() & 3) ? static_cast<int8>(rand()) : ((rand() & 1) ? 127 : -128);
+            }
+            for (int i = 0; i < count; ++i) {
+                main[i] = (rand() & 3) ? static_cast<int16>(rand()) : -32768;
+                echo[i] = static_cast<int16>(rand());
+            }
+            int8 mainVolume = (rand() & 3) ? static_cast<int8>(rand()) : -128;
+            int8 echoVolume = static_cast<int8>(rand());
+
+            int16 vector[count];
+            EchoFilter::filterScalar(history, coefficients, count, reference);
+            EchoFilter::filterSSE2(history, coefficients, count, vector);
+            filtered[0] = filtered[0] && std::memcmp(reference, vector, sizeof(reference)) == 0;
+            if (level >= TileDecoder::LEVEL_AVX2) {
+                EchoFilter::filterAVX2(history, coefficients, count, vector);
+                filtered[1] = filtered[1] && std::memcmp(reference, vector, sizeof(reference)) == 0;
+            }
+
+            EchoFilter::mixScalar(main, echo, mainVolume, echoVolume, count, reference);
+            EchoFilter::mixSSE2(main, echo, mainVolume, echoVolume, count, vector);
+            mixed[0] = mixed[0] && std::memcmp(reference, vector, sizeof(reference)) == 0;
+            if (level >= TileDecoder::LEVEL_AVX2) {
+                EchoFilter::mixAVX2(main, echo, mainVolume, echoVolume, count, vector);
+                mixed[1] = mixed[1] && std::memcmp(reference, vector, sizeof(reference)) == 0;
+            }
+        }
+        assert_true("SSE2 FIR matches scalar", filtered[0]);
+        assert_true("SSE2 echo mix matches scalar", mixed[0]);
+        if (level >= TileDecoder::LEVEL_AVX2) {
+            assert_true("AVX2 FIR matches scalar", filtered[1]);
+            assert_true("AVX2 echo mix matches scalar", mixed[1]);
+        }
+#endif
+    }
+
+    void testResampler() {
+        printTestHeader("Resampler");
+        // One second of a 1 kHz tone at half scale, fed in frame-sized pieces
+        const double PI = 3.14159265358979323846;
+        vector<int16> input(32000 * 2);
+        for (int i = 0; i < 32000; ++i) {
+            int16 value = static_cast<int16>(std::lround(16384 * std::sin(2 * PI * 1000 * i / 32000)));
+            input[i * 2] = value;
+            input[i * 2 + 1] = -value;
+        }
+        Resampler resampler(65536);
+        resampler.setRates(32000, 48000);
+        int made = 0;
+        for (int i = 0; i < 32000; i += 533) {
+            made += resampler.write(&input[i * 2], std::min(533, 32000 - i));
+        }
+        // Short of 48000 by the filter's look-ahead
+        assert_true("48 kHz out", made > 47950 && made <= 48000);
+        assert_equal("All buffered", made, resampler.getBufferedFrames());
+        vector<float> output(made * 2);
+        assert_equal("Read back", made, resampler.read(output.data(), made));
+        double error = 0.0;
+        for (int n = Resampler::TAPS; n < made - Resampler::TAPS; ++n) {
+            double expected = 0.5 * std::sin(2 * PI * 1000 * n / 48000.0);
+            error = std::max(error, std::fabs(output[n * 2] - expected));
+            error = std::max(error, std::fabs(output[n * 2 + 1] + expected));
+        }
+        assert_true("Tone comes through", error < 0.001);
+
+        // The ring: empty reads are silence, a full ring drops frames
+        float frame[4] = {1, 1, 1, 1};
+        assert_equal("Underrun", 0, resampler.read(frame, 2));
+        assert_true("Silence", frame[0] == 0 && frame[3] == 0);
+        assert_equal("Underruns counted", 2, static_cast<uint32>(resampler.getUnderruns()));
+        Resampler small(1024);
+        small.setRates(32000, 48000);
+        small.write(input.data(), 1000);
+        assert_equal("Full", 1024, small.getBufferedFrames());
+        assert_true("Fill level", small.getFillLevel() == 1.0);
+        assert_true("Overruns counted", small.getOverruns() > 400);
+        // Cleared from the producer's side, dropped on the consumer's
+        small.clear();
+        assert_equal("Cleared ring reads empty", 0, small.read(frame, 2));
+        small.write(input.data(), 100);
+        assert_true("Frames after clearing kept", small.read(frame, 2) == 2);
+
+        // The adjustment for rate control is bounded
+        resampler.setAdjust(1.005);
+        made = resampler.write(input.data(), 32000);
+        assert_true("Adjusted rate", made > 48200 && made < 48300);
+        resampler.setAdjust(2.0);
+        assert_true("Adjustment clamped", resampler.getAdjust() == 1.0 + Resampler::MAX_ADJUST_PERCENT / 100.0);
+
+#if defined(__x86_64__) || defined(__i386__)
+        TileDecoder::Level level = TileDecoder::detectLevel();
+        if (level < TileDecoder::LEVEL_SSE2) {
+            return;
+        }
+        float left[Resampler::TAPS];
+        float right[Resampler::TAPS];
+        float phase[Resampler::TAPS];
+        float next[Resampler::TAPS];
+        bool matched[2] = {true, true};
+        for (int trial = 0; trial < 1000; ++trial) {
+            for (int k = 0; k < Resampler::TAPS; ++k) {
+                left[k] = static_cast<int16>(rand()) / 32768.0f;
+                right[k] = static_cast<int16>(rand()) / 32768.0f;
+                phase[k] = static_cast<int16>(rand()) / 65536.0f;
+                next[k] = static_cast<int16>(rand()) / 65536.0f;
+            }
+            float t = (rand() & 0xFFFF) / 65536.0f;
+            float reference[2];
+            float vector[2];
+            Resampler::convolveScalar(left, right, phase, next, t, reference);
+            Resampler::convolveSSE2(left, right, phase, next, t, vector);
+            matched[0] = matched[0] && std::fabs(reference[0] - vector[0]) < 1e-5f && std::fabs(reference[1] - vector[1]) < 1e-5f;
+            if (level >= TileDecoder::LEVEL_AVX2) {
+                Resampler::convolveAVX2(left, right, phase, next, t, vector);
+                matched[1] = matched[1] && std::fabs(reference[0] - vector[0]) < 1e-5f && std::fabs(reference[1] - vector[1]) < 1e-5f;
+            }
+        }
+        assert_true("SSE2 convolution matches scalar", matched[0]);
+        if (level >= TileDecoder::LEVEL_AVX2) {
+            assert_true("AVX2 convolution matches scalar", matched[1]);
+        }
+#endif
+    }
+
+    // Echo with feedback over a buffer of edl, rendered in steps of step samples
+    void renderEcho(uint8 edl, int step, int16* samples, int count) {
+        startTestVoice(0x77);
+        writeDSP(DSP::FLG, 0x00);
+        writeDSP(DSP::ESA, 0x80);
+        writeDSP(DSP::EDL, edl);
+        writeDSP(DSP::EON, 0x01);
+        writeDSP(DSP::EFB, 0x60);
+        writeDSP(DSP::EVOLL, 0x40);
+        writeDSP(DSP::EVOLR, 0xC0);
+        for (int n = 0; n < EchoFilter::TAPS; ++n) {
+            writeDSP(DSP::FIR + n * 0x10, n == 7 ? 0x60 : 0x08);
+        }
+        dsp.setOutput(samples, count);
+        for (int i = 0; i < count; i += step) {
+            runSamples(step);
+        }
+        dsp.setOutput(nullptr, 0);
+    }
+
+    void testVoicePlayback() {
+        printTestHeader("DSP Voice Playback");
+        startTestVoice(0x77);
+        int16 samples[200 * 2];
+        dsp.setOutput(samples, 200);
+        runSamples(100);
+        assert_equal("One sample per 32 cycles", 100, dsp.getSampleCount());
+        assert_equal("ENVX follows GAIN", 0x7F, readDSP(DSP::ENVX));
+        assert_equal("OUTX", 111, readDSP(DSP::OUTX));
+        assert_equal("Left output", 28016, static_cast<uint16>(samples[99 * 2]));
+        assert_equal("Right output", 28016, static_cast<uint16>(samples[99 * 2 + 1]));
+        assert_true("ENDX set after the end block", readDSP(DSP::ENDX) & 0x01);
+        writeDSP(DSP::ENDX, 0xFF);
+        assert_equal("Writing ENDX clears it", 0, readDSP(DSP::ENDX));
+
+        writeDSP(DSP::VOLL, 0x80);
+        runSamples(4);
+        assert_true("Negative volume inverts", samples[103 * 2] < 0 && samples[103 * 2 + 1] > 0);
+
+        writeDSP(DSP::FLG, 0x60);
+        runSamples(4);
+        assert_true("FLG mute", samples[107 * 2] == 0 && samples[107 * 2 + 1] == 0);
+
+        writeDSP(DSP::FLG, 0x20);
+        writeDSP(DSP::KOFF, 0x01);
+        runSamples(300);
+        assert_equal("Key off releases", 0, readDSP(DSP::ENVX));
+        dsp.setOutput(nullptr, 0);
+    }
+
+    void testBRRCache() {
+        printTestHeader("BRR Cache");
+        startTestVoice(0x77);
+        dsp.resetCacheStats();
+        runSamples(16 * 10);
+        assert_true("Looping block served from the cache", dsp.getCacheHits() >= 9);
+        assert_equal("Decoded once", 1, dsp.getCacheMisses());
+
+        // Rewriting the sample drops the cached block
+        for (int i = 1; i < 9; ++i) {
+            apu.write(0x0300 + i, 0x00);
+        }
+        runSamples(40);
+        assert_equal("Decoded again after a write", 2, dsp.getCacheMisses());
+        assert_equal("New sample plays", 0, readDSP(DSP::OUTX));
+
+        // Blocks with a prediction filter depend on the samples before them
+        startTestVoice(0x35);
+        apu.write(0x0300, 0xB7);                // Range 11, filter 1, loop, end
+        writeDSP(DSP::KON, 0x01);
+        int16 cached[64 * 2];
+        dsp.setOutput(cached, 64);
+        runSamples(64);
+        dsp.setOutput(nullptr, 0);
+        assert_true("Filtered loop keeps changing", dsp.getCacheMisses() >= 2);
+        assert_true("Filtered output differs per pass", cached[20 * 2] != cached[36 * 2]);
+    }
+
+    void testEcho() {
+        printTestHeader("DSP Echo");
+        startTestVoice(0x77);
+        writeDSP(DSP::MVOLL, 0x00);
+        writeDSP(DSP::MVOLR, 0x00);
+        writeDSP(DSP::ESA, 0x80);
+        writeDSP(DSP::EDL, 0x01);              // 2KB: 512 samples
+        writeDSP(DSP::EON, 0x01);
+        writeDSP(DSP::FIR + 0x70, 0x7F);       // Newest tap only
+        writeDSP(DSP::EVOLL, 0x7F);
+        writeDSP(DSP::EVOLR, 0x7F);
+        runSamples(20);
+        assert_equal("FLG bit 5 blocks echo writes", 0, apu.read(0x8000 + 16 * 4) | apu.read(0x8001 + 16 * 4));
+
+        writeDSP(DSP::FLG, 0x00);
+        int16 samples[600 * 2];
+        dsp.setOutput(samples, 600);
+        runSamples(600);
+        dsp.setOutput(nullptr, 0);
+        uint16 written = apu.read(0x8000 + 100 * 4) | (apu.read(0x8001 + 100 * 4) << 8);
+        assert_equal("Echo buffer holds the voice", 28236, written);
+        assert_equal("Nothing before the delay", 0, samples[200 * 2]);
+        assert_true("Echo returns after EDL * 512 samples", samples[590 * 2] > 20000 && samples[590 * 2 + 1] > 20000);
+
+        // Chunks filter the echo up front unless the buffer is a single slot
+        int16 single[1200 * 2];
+        int16 chunked[1200 * 2];
+        for (uint8 edl = 0; edl < 2; ++edl) {
+            renderEcho(edl, 1, single, 1200);
+            renderEcho(edl, 1200, chunked, 1200);
+            string name = edl ? "Chunked echo matches per-sample" : "Chunked single-slot echo matches per-sample";
+            assert_true(name, std::memcmp(single, chunked, sizeof(single)) == 0);
+        }
+        assert_true("Echo feedback audible", chunked[1100 * 2] != single[100 * 2]);
+    }
+};
+
+int main() {
+    APUTester tester;
+    tester.runAllTests();
+    return 0;
+}
@@ -100,6 +100,10 @@ public:
         testInterrupts();
         // Block move
         testBlockMove();
+        // Cached code page fetch
+        testCodePageFetch();
+        // Stack and direct page served straight from low WRAM
+        testLowRAMFastPath();
         
         testCounterLoop();
         testBitPattern();
@@ -3188,6 +3192,140 @@ private:
         assert_equal("MVP X decremented", 0x0FFF, cpu.registers.X);
         assert_equal("MVP Y decremented", 0x2FFF, cpu.registers.Y);
     }
+    
+    // ===== CODE FETCH TESTS =====
+    void testCodePageFetch() {
+        printTestHeader("Test Cached Code Page Fetch");
+        
+        cpu.reset();
+        std::vector<uint8> rom(0x10000, 0xEA);
+        // LDA #$xx straddling a page boundary: opcode at $80FF, operand at $8100
+        rom[0x80FF] = 0xA9;
+        rom[0x8100] = 0x5A;
+        memory.loadROM(rom);
+        memory.reset();
+        
+        cpu.registers.PC = 0x80FF;
+        cpu.executeInstruction();
+        assert_equal("Operand fetched across page boundary", 0x5A, cpu.registers.A & 0xFF);
+        assert_equal("PC after page crossing", 0x8101, cpu.registers.PC);
+        
+        // Reloading the ROM must not leave stale bytes in the cached page
+        rom[0x8100] = 0x3C;
+        memory.loadROM(rom);
+        cpu.registers.PC = 0x80FF;
+        cpu.executeInstruction();
+        assert_equal("Fetch sees reloaded ROM", 0x3C, cpu.registers.A & 0xFF);
+        
+        // Code running from WRAM sees its own stores (self-modifying code)
+        memory.write(0x000200, 0xA9);       // LDA #$11
+        memory.write(0x000201, 0x11);
+        cpu.registers.PC = 0x0200;
+        cpu.executeInstruction();
+        assert_equal("Fetch from WRAM", 0x11, cpu.registers.A & 0xFF);
+        memory.write(0x000201, 0x22);
+        cpu.registers.PC = 0x0200;
+        cpu.executeInstruction();
+        assert_equal("Fetch sees WRAM store", 0x22, cpu.registers.A & 0xFF);
+        
+        // Changing PBR directly switches to the new bank's page
+        memory.write(0x7E0200, 0xA9);       // LDA #$33 in bank $7E
+        memory.write(0x7E0201, 0x33);
+        cpu.registers.PBR = 0x7E;
+        cpu.registers.PC = 0x0200;
+        cpu.executeInstruction();
+        assert_equal("Fetch follows PBR change", 0x33, cpu.registers.A & 0xFF);
+    }
+    
+    // Runs the instruction at addr in ROM
+    void executeAt(uint16 addr) {
+        cpu.registers.PBR = 0;
+        cpu.registers.PC = addr;
+        cpu.executeInstruction();
+    }
+    
+    void testLowRAMFastPath() {
+        printTestHeader("Test Low WRAM Fast Path");
+        
+        cpu.reset();
+        std::vector<uint8> rom(0x10000, 0xEA);
+        rom[0x8000] = 0x48;                 // PHA
+        rom[0x8001] = 0x68;                 // PLA
+        rom[0x8002] = 0x85;                 // STA $FF
+        rom[0x8003] = 0xFF;
+        rom[0x8004] = 0xA6;                 // LDX $FF
+        rom[0x8005] = 0xFF;
+        rom[0x8006] = 0x85;                 // STA $80
+        rom[0x8007] = 0x80;
+        rom[0x8008] = 0xA6;                 // LDX $80
+        rom[0x8009] = 0x80;
+        memory.loadROM(rom);
+        memory.reset();
+        
+        // Stack in page 1: the same bytes Memory sees at $7E:01xx
+        cpu.registers.A = 0x5A;
+        executeAt(0x8000);
+        assert_equal("Push lands in WRAM", 0x5A, memory.read(0x7E01FF));
+        assert_equal("Push seen in bank $00", 0x5A, memory.read(0x0001FF));
+        assert_equal("SP after push", 0x01FE, cpu.registers.SP);
+        memory.write(0x7E01FF, 0x77);
+        executeAt(0x8001);
+        assert_equal("Pull sees Memory's write", 0x77, cpu.registers.A & 0xFF);
+        assert_equal("SP after pull", 0x01FF, cpu.registers.SP);
+        
+        // Direct page at the top of low WRAM
+        cpu.registers.D = 0x1F00;
+        cpu.registers.A = 0x3C;
+        executeAt(0x8002);
+        assert_equal("Direct page store at $1FFF", 0x3C, memory.read(0x7E1FFF));
+        memory.write(0x001FFF, 0x42);
+        executeAt(0x8004);
+        assert_equal("Direct page load at $1FFF", 0x42, cpu.registers.X & 0xFF);
+        
+        // Direct page over the B-bus: $2180 is the WRAM port, which moves on
+        // with every access
+        memory.write(0x2181, 0x00);         // WMADD = $000500
+        memory.write(0x2182, 0x05);
+        memory.write(0x2183, 0x00);
+        memory.write(0x7E0502, 0x99);
+        cpu.registers.D = 0x2100;
+        cpu.registers.A = 0x11;
+        executeAt(0x8006);
+        cpu.registers.A = 0x22;
+        executeAt(0x8006);
+        assert_equal("Direct page store through WMDATA", 0x11, memory.read(0x7E0500));
+        assert_equal("WMDATA address advanced", 0x22, memory.read(0x7E0501));
+        executeAt(0x8008);
+        assert_equal("Direct page load through WMDATA", 0x99, cpu.registers.X & 0xFF);
+        memory.write(0x7E0503, 0x5C);
+        assert_equal("Load advanced WMDATA too", 0x5C, memory.read(0x2180));
+        cpu.registers.D = 0x0000;
+        
+        // Native mode stack just above low WRAM: $00:2000 is not WRAM, so
+        // the byte must not reach $7E:2000; the next one is back in WRAM
+        cpu.registers.E = false;
+        cpu.registers.SP = 0x2000;
+        cpu.registers.A = 0x66;
+        executeAt(0x8000);
+        assert_equal("Push above low WRAM skips WRAM", 0x00, memory.read(0x7E2000));
+        assert_equal("SP crosses into low WRAM", 0x1FFF, cpu.registers.SP);
+        cpu.registers.A = 0x67;
+        executeAt(0x8000);
+        assert_equal("Push at $1FFF lands in WRAM", 0x67, memory.read(0x7E1FFF));
+        
+        // Stack over the WRAM port: pushes keep their side effects
+        memory.write(0x2181, 0x00);         // WMADD = $000600
+        memory.write(0x2182, 0x06);
+        cpu.registers.SP = 0x2180;
+        cpu.registers.A = 0x81;
+        executeAt(0x8000);
+        cpu.registers.A = 0x82;
+        cpu.registers.SP = 0x2180;
+        executeAt(0x8000);
+        assert_equal("Push through WMDATA", 0x81, memory.read(0x7E0600));
+        assert_equal("Second push through WMDATA", 0x82, memory.read(0x7E0601));
+        cpu.reset();
+    }
 };
 
 int main() {
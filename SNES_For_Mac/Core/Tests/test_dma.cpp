@@ -0,0 +1,413 @@
+//
+//  test_dma.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "../CPU/CPU65c816.hpp"
+#include "../Memory/Memory.hpp"
+#include "../DMA/DMAController.hpp"
+#include "../Types/Timing.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define COLOR_RESET     "\033[0m"
+#define COLOR_GREEN     "\033[32m"
+#define COLOR_RED       "\033[31m"
+#define COLOR_YELLOW    "\033[33m"
+#define COLOR_CYAN      "\033[36m"
+
+using namespace std;
+
+class DMATester {
+private:
+    CPU65c816 cpu;
+    Memory memory;
+    DMAController dma;
+    int testsPassed;
+    int testsFailed;
+
+public:
+    DMATester() {
+        cpu.setMemory(&memory);
+        memory.setDMA(&dma);
+        dma.setMemory(&memory);
+        testsPassed = 0;
+        testsFailed = 0;
+    }
+
+    int runAllTests() {
+        cout << COLOR_CYAN << "=== SNES Emulator DMA Tests ===" << COLOR_RESET << endl;
+
+        testChannelRegisters();
+        testWRAMToVRAM();
+        testFixedFill();
+        testCGRAMAndOAM();
+        testROMToWRAMPort();
+        testVRAMToWRAM();
+        testCPUStall();
+        testHDMADirect();
+        testHDMAIndirect();
+        testHDMAStallMidFrameDisable();
+
+        cout << endl;
+        cout << COLOR_CYAN << "=== Test Summary ===" << COLOR_RESET << endl;
+        cout << COLOR_GREEN << "Passed: " << testsPassed << COLOR_RESET << endl;
+        if (testsFailed > 0) {
+            cout << COLOR_RED << "Failed: " << testsFailed << COLOR_RESET << endl;
+        } else {
+            cout << COLOR_GREEN << "All tests Passed! ✓" << COLOR_RESET << endl;
+        }
+        return testsFailed;
+    }
+
+private:
+    void assert_equal(const string& testName, uint32 expected, uint32 actual) {
+        if (expected == actual) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            cout << " Expected: 0x" << hex << expected << ", Got: 0x" << actual << dec << endl;
+            testsFailed++;
+        }
+    }
+
+    void assert_true(const string& testName, bool condition) {
+        if (condition) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            testsFailed++;
+        }
+    }
+
+    void printTestHeader(const string& testName) {
+        cout << endl << COLOR_YELLOW << "--- " << testName << " ---" << COLOR_RESET << endl;
+    }
+
+    void resetAll() {
+        vector<uint8> rom(0x10000, 0xEA);
+        for (int i = 0; i < 0x100; ++i) {
+            rom[0x9000 + i] = static_cast<uint8>(i);
+        }
+        memory.loadROM(rom);
+        memory.reset();
+        dma.reset();
+    }
+
+    // Program channel with DMAP, BBAD, A-bus address and byte count
+    void setupChannel(int channel, uint8 control, uint8 bbad, uint32 aBus, uint16 count) {
+        uint16 base = 0x4300 | (channel << 4);
+        memory.write(base + 0, control);
+        memory.write(base + 1, bbad);
+        memory.write(base + 2, aBus & 0xFF);
+        memory.write(base + 3, (aBus >> 8) & 0xFF);
+        memory.write(base + 4, (aBus >> 16) & 0xFF);
+        memory.write(base + 5, count & 0xFF);
+        memory.write(base + 6, count >> 8);
+    }
+
+    uint16 readVRAMWord(uint16 wordAddress) {
+        memory.write(0x2115, 0x80);
+        memory.write(0x2116, wordAddress & 0xFF);
+        memory.write(0x2117, wordAddress >> 8);
+        uint8 lo = memory.read(0x2139);
+        uint8 hi = memory.read(0x213A);
+        return (hi << 8) | lo;
+    }
+
+    void testChannelRegisters() {
+        printTestHeader("Test DMA Channel Registers");
+        resetAll();
+
+        setupChannel(3, 0x01, 0x18, 0x7E1234, 0x0100);
+        assert_equal("DMAP3 readback", 0x01, memory.read(0x4330));
+        assert_equal("BBAD3 readback", 0x18, memory.read(0x4331));
+        assert_equal("A1T3 low readback", 0x34, memory.read(0x4332));
+        assert_equal("A1B3 readback", 0x7E, memory.read(0x4334));
+        assert_equal("DAS3 high readback", 0x01, memory.read(0x4336));
+        memory.write(0x433B, 0x5A);
+        assert_equal("Unused register is scratch RAM", 0x5A, memory.read(0x433F));
+    }
+
+    void testWRAMToVRAM() {
+        printTestHeader("Test DMA WRAM -> VRAM (mode 1)");
+        resetAll();
+
+        for (int i = 0; i < 0x40; ++i) {
+            memory.write(0x7E2000 + i, static_cast<uint8>(0xA0 + i));
+        }
+        memory.write(0x2115, 0x80);         // Increment after $2119
+        memory.write(0x2116, 0x00);
+        memory.write(0x2117, 0x10);         // VRAM word $1000
+        setupChannel(0, 0x01, 0x18, 0x7E2000, 0x0040);
+        memory.write(0x420B, 0x01);
+
+        assert_equal("First VRAM word", 0xA1A0, readVRAMWord(0x1000));
+        assert_equal("Last VRAM word", 0xDFDE, readVRAMWord(0x101F));
+        assert_equal("A1T advanced by count", 0x2040, memory.read(0x4302) | (memory.read(0x4303) << 8));
+        assert_equal("DAS cleared", 0x00, memory.read(0x4305) | memory.read(0x4306));
+
+        // Same transfer with a non-trivial increment goes through the port path
+        memory.write(0x2115, 0x81);         // Increment by 32 after $2119
+        memory.write(0x2116, 0x00);
+        memory.write(0x2117, 0x20);
+        setupChannel(1, 0x01, 0x18, 0x7E2000, 0x0004);
+        memory.write(0x420B, 0x02);
+        assert_equal("Stride-32 word 0", 0xA1A0, readVRAMWord(0x2000));
+        assert_equal("Stride-32 word 1", 0xA3A2, readVRAMWord(0x2020));
+    }
+
+    void testFixedFill() {
+        printTestHeader("Test DMA Fixed-Source Fill");
+        resetAll();
+
+        memory.write(0x0010, 0x00);
+        memory.write(0x0011, 0x77);
+
+        // Fill 16 VRAM words with $7777
+        memory.write(0x2115, 0x80);
+        memory.write(0x2116, 0x00);
+        memory.write(0x2117, 0x00);
+        setupChannel(0, 0x09, 0x18, 0x000011, 0x0020);
+        memory.write(0x420B, 0x01);
+        assert_equal("Fill word 0", 0x7777, readVRAMWord(0x0000));
+        assert_equal("Fill word 15", 0x7777, readVRAMWord(0x000F));
+        assert_equal("Word after fill untouched", 0x0000, readVRAMWord(0x0010));
+
+        // Clear only the low plane ($2118 with increment after low write)
+        memory.write(0x2115, 0x00);
+        memory.write(0x2116, 0x00);
+        memory.write(0x2117, 0x00);
+        setupChannel(0, 0x08, 0x18, 0x000010, 0x0008);
+        memory.write(0x420B, 0x01);
+        assert_equal("Low plane cleared", 0x7700, readVRAMWord(0x0000));
+        assert_equal("Low plane cleared at end", 0x7700, readVRAMWord(0x0007));
+        assert_equal("Beyond low plane clear", 0x7777, readVRAMWord(0x0008));
+        assert_equal("A1T unchanged for fixed source", 0x10, memory.read(0x4302));
+
+        // A single byte: no whole word to fill, only the low byte goes out
+        memory.write(0x2115, 0x80);
+        memory.write(0x2116, 0x20);
+        memory.write(0x2117, 0x00);
+        setupChannel(0, 0x09, 0x18, 0x000011, 0x0001);
+        memory.write(0x420B, 0x01);
+        assert_equal("One-byte fill writes low byte", 0x0077, readVRAMWord(0x0020));
+        assert_equal("One-byte fill stops there", 0x0000, readVRAMWord(0x0021));
+    }
+
+    void testCGRAMAndOAM() {
+        printTestHeader("Test DMA to CGRAM and OAM");
+        resetAll();
+
+        // Palette: 4 colors from ROM bank $00 ($9000 holds 00 01 02 ...)
+        memory.write(0x2121, 0x10);
+        setupChannel(2, 0x00, 0x22, 0x009000, 0x0008);
+        memory.write(0x420B, 0x04);
+        memory.write(0x2121, 0x10);
+        assert_equal("CGRAM color 0 low", 0x00, memory.read(0x213B));
+        assert_equal("CGRAM color 0 high", 0x01, memory.read(0x213B));
+        memory.write(0x2121, 0x13);
+        assert_equal("CGRAM color 3 low", 0x06, memory.read(0x213B));
+
+        memory.write(0x2102, 0x00);
+        memory.write(0x2103, 0x00);
+        setupChannel(2, 0x00, 0x04, 0x009010, 0x0004);
+        memory.write(0x420B, 0x04);
+        memory.write(0x2102, 0x00);
+        memory.write(0x2103, 0x00);
+        assert_equal("OAM byte 0", 0x10, memory.read(0x2138));
+        assert_equal("OAM byte 1", 0x11, memory.read(0x2138));
+        memory.read(0x2138);
+        assert_equal("OAM byte 3", 0x13, memory.read(0x2138));
+    }
+
+    void testROMToWRAMPort() {
+        printTestHeader("Test DMA ROM -> WRAM ($2180)");
+        resetAll();
+
+        memory.write(0x2181, 0xFE);
+        memory.write(0x2182, 0xFF);
+        memory.write(0x2183, 0x00);         // $7EFFFE, crosses into $7F0000
+        setupChannel(5, 0x00, 0x80, 0x009020, 0x0004);
+        memory.write(0x420B, 0x20);
+        assert_equal("WRAM port byte 0", 0x20, memory.read(0x7EFFFE));
+        assert_equal("WRAM port byte 1", 0x21, memory.read(0x7EFFFF));
+        assert_equal("WRAM port crosses into bank $7F", 0x22, memory.read(0x7F0000));
+        assert_equal("WRAM port byte 3", 0x23, memory.read(0x7F0001));
+    }
+
+    void testVRAMToWRAM() {
+        printTestHeader("Test DMA VRAM -> WRAM (mode 1, B->A)");
+        resetAll();
+
+        memory.write(0x2115, 0x80);
+        memory.write(0x2116, 0x00);
+        memory.write(0x2117, 0x30);
+        for (int i = 0; i < 8; ++i) {
+            memory.write(0x2118, static_cast<uint8>(0x10 + i));
+            memory.write(0x2119, static_cast<uint8>(0x80 + i));
+        }
+        memory.write(0x2116, 0x00);
+        memory.write(0x2117, 0x30);         // Prefetches word $3000
+        setupChannel(0, 0x81, 0x39, 0x7E4000, 0x0010);
+        memory.write(0x420B, 0x01);
+
+        assert_equal("VRAM read word 0 low", 0x10, memory.read(0x7E4000));
+        assert_equal("VRAM read word 0 high", 0x80, memory.read(0x7E4001));
+        // The latch is reloaded from the address before it increments, so
+        // the first word comes out twice (same as reading $2139/$213A by hand)
+        assert_equal("VRAM read word 1 repeats prefetch", 0x10, memory.read(0x7E4002));
+        assert_equal("VRAM read word 7 low", 0x16, memory.read(0x7E400E));
+        assert_equal("VRAM read word 7 high", 0x86, memory.read(0x7E400F));
+    }
+
+    void testCPUStall() {
+        printTestHeader("Test DMA CPU Stall");
+        resetAll();
+
+        // STA $420B with A = $01, channel 0 moving 0x600 bytes to VRAM
+        vector<uint8> rom(0x10000, 0xEA);
+        rom[0x8000] = 0x8D;
+        rom[0x8001] = 0x0B;
+        rom[0x8002] = 0x42;
+        memory.loadROM(rom);
+        setupChannel(0, 0x01, 0x18, 0x7E0000, 0x0600);
+
+        cpu.reset();
+        cpu.registers.A = 0x01;
+        int plain = 4;
+        int cycles = cpu.executeInstruction();
+        // 8 master cycles per byte -> 0x600 * 8 / 6 CPU cycles at least
+        assert_true("DMA stall charged to CPU", cycles >= plain + (0x600 * 8) / 6);
+        assert_equal("Stall consumed", 0, memory.consumeStallCycles());
+    }
+
+    void setWRAMPort(uint32 address) {
+        memory.write(0x2181, address & 0xFF);
+        memory.write(0x2182, (address >> 8) & 0xFF);
+        memory.write(0x2183, (address >> 16) & 0x01);
+    }
+
+    void testHDMADirect() {
+        printTestHeader("Test HDMA Direct Mode");
+        resetAll();
+
+        // 2 lines non-repeat (one write), then 3 lines repeat, then end
+        const uint8 table[] = { 0x02, 0xA1, 0x83, 0xB1, 0xB2, 0xB3, 0x00 };
+        for (size_t i = 0; i < sizeof(table); ++i) {
+            memory.write(0x7E3000 + i, table[i]);
+        }
+        setWRAMPort(0x5000);
+        setupChannel(0, 0x00, 0x80, 0x7E3000, 0x0000);
+        memory.write(0x420C, 0x01);
+
+        dma.initHDMA();
+        uint32 stall = dma.runHDMALine(0);
+        assert_equal("Line 0 writes first entry", 0xA1, memory.read(0x7E5000));
+        assert_true("Line 0 charges HDMA cycles", stall > 0);
+        dma.runHDMALine(1);
+        assert_equal("Non-repeat entry idles on line 1", 0x00, memory.read(0x7E5001));
+        dma.runHDMALine(2);
+        dma.runHDMALine(3);
+        assert_equal("Repeat entry line 2", 0xB1, memory.read(0x7E5001));
+        assert_equal("Repeat entry line 3", 0xB2, memory.read(0x7E5002));
+
+        // Disabling the channel mid-frame stops it immediately
+        memory.write(0x420C, 0x00);
+        dma.runHDMALine(4);
+        assert_equal("Disabled channel writes nothing", 0x00, memory.read(0x7E5003));
+        assert_equal("Idle line costs nothing", 0, dma.runHDMALine(6));
+
+        // Re-parsing next frame starts again from the top of the table
+        memory.write(0x420C, 0x01);
+        setWRAMPort(0x6000);
+        dma.initHDMA();
+        for (int line = 0; line < 8; ++line) {
+            dma.runHDMALine(line);
+        }
+        assert_equal("Second frame line 0", 0xA1, memory.read(0x7E6000));
+        assert_equal("Second frame line 4", 0xB3, memory.read(0x7E6003));
+        assert_equal("Terminated table writes nothing more", 0x00, memory.read(0x7E6004));
+    }
+
+    void testHDMAIndirect() {
+        printTestHeader("Test HDMA Indirect Mode");
+        resetAll();
+
+        // Channel 0: direct, one byte on line 0
+        memory.write(0x7E3000, 0x01);
+        memory.write(0x7E3001, 0xA1);
+        memory.write(0x7E3002, 0x00);
+        // Channel 1: indirect, mode 2 (two bytes to the same port), data at $7E3100
+        const uint8 table[] = { 0x82, 0x00, 0x31, 0x00 };
+        for (size_t i = 0; i < sizeof(table); ++i) {
+            memory.write(0x7E3010 + i, table[i]);
+        }
+        memory.write(0x7E3100, 0xC1);
+        memory.write(0x7E3101, 0xC2);
+        memory.write(0x7E3102, 0xC3);
+        memory.write(0x7E3103, 0xC4);
+
+        setWRAMPort(0x5000);
+        setupChannel(0, 0x00, 0x80, 0x7E3000, 0x0000);
+        setupChannel(1, 0x42, 0x80, 0x7E3010, 0x0000);
+        memory.write(0x4317, 0x7E);         // Indirect bank
+        memory.write(0x420C, 0x03);
+
+        dma.initHDMA();
+        dma.runHDMALine(0);
+        assert_equal("Channel 0 writes first", 0xA1, memory.read(0x7E5000));
+        assert_equal("Channel 1 indirect byte 0", 0xC1, memory.read(0x7E5001));
+        assert_equal("Channel 1 indirect byte 1", 0xC2, memory.read(0x7E5002));
+        dma.runHDMALine(1);
+        assert_equal("Indirect repeat line 1", 0xC4, memory.read(0x7E5004));
+        assert_equal("Indirect address register advanced", 0x3104,
+                     memory.read(0x4315) | (memory.read(0x4316) << 8));
+    }
+
+    void testHDMAStallMidFrameDisable() {
+        printTestHeader("Test HDMA Stall After Mid-Frame Disable");
+        resetAll();
+
+        // Channels 0 and 1: one byte every line for 4 lines
+        const uint8 table[] = { 0x84, 0xA1, 0xA2, 0xA3, 0xA4, 0x00 };
+        for (size_t i = 0; i < sizeof(table); ++i) {
+            memory.write(0x7E3000 + i, table[i]);
+            memory.write(0x7E3010 + i, table[i]);
+        }
+        setupChannel(0, 0x00, 0x80, 0x7E3000, 0x0000);
+        setupChannel(1, 0x00, 0x80, 0x7E3010, 0x0000);
+        memory.write(0x420C, 0x03);
+
+        const uint32 transfer = HDMA_CYCLES_PER_CHANNEL + DMA_CYCLES_PER_BYTE;
+        dma.initHDMA();
+        assert_equal("Both channels with headers", HDMA_CYCLES_PER_LINE + 2 * (HDMA_CYCLES_HEADER + transfer),
+                     dma.runHDMALine(0));
+        assert_equal("Both channels", HDMA_CYCLES_PER_LINE + 2 * transfer, dma.runHDMALine(1));
+
+        // Only the channel left enabled still stalls the CPU
+        memory.write(0x420C, 0x01);
+        assert_equal("Disabled channel stops costing", HDMA_CYCLES_PER_LINE + transfer, dma.runHDMALine(2));
+        memory.write(0x420C, 0x00);
+        assert_equal("Nothing enabled costs nothing", 0, dma.runHDMALine(3));
+
+        // Enabling mid-frame takes effect from the next frame
+        memory.write(0x420C, 0x03);
+        assert_equal("Re-enabled channels run again", HDMA_CYCLES_PER_LINE + 2 * transfer, dma.runHDMALine(3));
+        memory.write(0x420C, 0x00);
+        dma.initHDMA();
+        memory.write(0x420C, 0x01);
+        assert_equal("Not set up this frame", 0, dma.runHDMALine(0));
+    }
+};
+
+int main() {
+    DMATester tester;
+    tester.runAllTests();
+    return 0;
+}
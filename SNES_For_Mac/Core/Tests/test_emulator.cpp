@@ -0,0 +1,460 @@
+//
+//  test_emulator.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "../Emulator.hpp"
+#include "../Types/Timing.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#define COLOR_RESET     "\033[0m"
+#define COLOR_GREEN     "\033[32m"
+#define COLOR_RED       "\033[31m"
+#define COLOR_YELLOW    "\033[33m"
+#define COLOR_CYAN      "\033[36m"
+
+using namespace std;
+
+class EmulatorTester {
+private:
+    int testsPassed;
+    int testsFailed;
+
+public:
+    EmulatorTester() {
+        testsPassed = 0;
+        testsFailed = 0;
+    }
+
+    int runAllTests() {
+        cout << COLOR_CYAN << "=== SNES Emulator System Tests ===" << COLOR_RESET << endl;
+
+        testLoadROM();
+        testFrame();
+        testAudio();
+        testAPUThreaded();
+        testSaveState();
+        testRunAhead();
+        testFastForward();
+
+        cout << endl;
+        cout << COLOR_CYAN << "=== Test Summary ===" << COLOR_RESET << endl;
+        cout << COLOR_GREEN << "Passed: " << testsPassed << COLOR_RESET << endl;
+        if (testsFailed > 0) {
+            cout << COLOR_RED << "Failed: " << testsFailed << COLOR_RESET << endl;
+        } else {
+            cout << COLOR_GREEN << "All tests Passed! ✓" << COLOR_RESET << endl;
+        }
+        return testsFailed;
+    }
+
+private:
+    void assert_equal(const string& testName, uint32 expected, uint32 actual) {
+        if (expected == actual) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            cout << " Expected: 0x" << hex << expected << ", Got: 0x" << actual << dec << endl;
+            testsFailed++;
+        }
+    }
+
+    void assert_true(const string& testName, bool condition) {
+        if (condition) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            testsFailed++;
+        }
+    }
+
+    void printTestHeader(const string& testName) {
+        cout << endl << COLOR_YELLOW << "--- " << testName << " ---" << COLOR_RESET << endl;
+    }
+
+    // Program at $8000, where the CPU starts; the rest is NOP
+    vector<uint8> makeROM(const vector<uint8>& program) {
+        vector<uint8> rom(0x10000, 0xEA);
+        std::copy(program.begin(), program.end(), rom.begin() + 0x8000);
+        return rom;
+    }
+
+    // Counts in $10 and, from an NMI handler, frames in $11, which also
+    // become the backdrop color (so each frame looks different)
+    vector<uint8> makeFrameCounter() {
+        vector<uint8> rom = makeROM({0xA9, 0x0F,                               // LDA #$0F
+                                     0x8D, 0x00, 0x21,                         // STA $2100
+                                     0xA9, 0x80,                               // LDA #$80
+                                     0x8D, 0x00, 0x42,                         // STA $4200
+                                     0xE6, 0x10,                               // loop: INC $10
+                                     0x4C, 0x0A, 0x80});                       //       JMP loop
+        const vector<uint8> nmi = {0xE6, 0x11,                                  // INC $11
+                                   0xA9, 0x00,                                  // LDA #0
+                                   0x8D, 0x21, 0x21,                            // STA $2121
+                                   0xAD, 0x11, 0x00,                            // LDA $0011
+                                   0x8D, 0x22, 0x21,                            // STA $2122
+                                   0x8D, 0x22, 0x21,                            // STA $2122
+                                   0xAD, 0x10, 0x42,                            // LDA $4210
+                                   0x40};                                       // RTI
+        std::copy(nmi.begin(), nmi.end(), rom.begin() + 0x8100);
+        rom[0xFFFA] = 0x00;
+        rom[0xFFFB] = 0x81;
+        return rom;
+    }
+
+    // Shows the high byte of joypad 1 as the backdrop color, from the NMI
+    vector<uint8> makeJoypadEcho() {
+        vector<uint8> rom = makeROM({0xA9, 0x0F,                               // LDA #$0F
+                                     0x8D, 0x00, 0x21,                         // STA $2100
+                                     0xA9, 0x81,                               // LDA #$81
+                                     0x8D, 0x00, 0x42,                         // STA $4200
+                                     0xE6, 0x10,                               // loop: INC $10
+                                     0x4C, 0x0A, 0x80});                       //       JMP loop
+        const vector<uint8> nmi = {0xA9, 0x00,                                  // LDA #0
+                                   0x8D, 0x21, 0x21,                            // STA $2121
+                                   0xAD, 0x19, 0x42,                            // LDA $4219
+                                   0x8D, 0x22, 0x21,                            // STA $2122
+                                   0x8D, 0x22, 0x21,                            // STA $2122
+                                   0xAD, 0x10, 0x42,                            // LDA $4210
+                                   0x40};                                       // RTI
+        std::copy(nmi.begin(), nmi.end(), rom.begin() + 0x8100);
+        rom[0xFFFA] = 0x00;
+        rom[0xFFFB] = 0x81;
+        return rom;
+    }
+
+    // Sprites are enabled only while Up is held; every OAM entry is at
+    // (0, 0) after reset, so that puts 128 sprites on the top lines. The
+    // NMI keeps STAT77 in $12 and counts frames with range over in $13.
+    vector<uint8> makeSpriteOverflow() {
+        vector<uint8> rom = makeROM({0xA9, 0x0F,                               // LDA #$0F
+                                     0x8D, 0x00, 0x21,                         // STA $2100
+                                     0xA9, 0x81,                               // LDA #$81
+                                     0x8D, 0x00, 0x42,                         // STA $4200
+                                     0xE6, 0x10,                               // loop: INC $10
+                                     0x4C, 0x0A, 0x80});                       //       JMP loop
+        const vector<uint8> nmi = {0xAD, 0x3E, 0x21,                            // LDA $213E
+                                   0x85, 0x12,                                  // STA $12
+                                   0x29, 0x40,                                  // AND #$40
+                                   0xF0, 0x02,                                  // BEQ +2
+                                   0xE6, 0x13,                                  // INC $13
+                                   0xAD, 0x19, 0x42,                            // LDA $4219
+                                   0x0A,                                        // ASL A (Up -> OBJ)
+                                   0x8D, 0x2C, 0x21,                            // STA $212C
+                                   0xAD, 0x10, 0x42,                            // LDA $4210
+                                   0x40};                                       // RTI
+        std::copy(nmi.begin(), nmi.end(), rom.begin() + 0x8100);
+        rom[0xFFFA] = 0x00;
+        rom[0xFFFB] = 0x81;
+        return rom;
+    }
+
+    // Keys on a looping voice, with echo, straight through the DSP
+    void startSound(Emulator& emulator) {
+        SPC700& apu = emulator.getAPU();
+        DSP& dsp = emulator.getDSP();
+        const uint8 directory[4] = {0x00, 0x03, 0x00, 0x03};                   // Sample 0 at $0300, loops there
+        for (int i = 0; i < 4; ++i) {
+            apu.writeRAM(static_cast<uint16>(0x0200 + i), directory[i]);
+        }
+        apu.writeRAM(0x0300, 0xB3);                                            // Range 11, loop, end
+        for (int i = 1; i < 9; ++i) {
+            apu.writeRAM(static_cast<uint16>(0x0300 + i), static_cast<uint8>(i * 0x13 + 0x17));
+        }
+        const uint8 registers[][2] = {{0x00, 0x40}, {0x01, 0x40}, {0x02, 0x00}, {0x03, 0x10}, // V0 volume, pitch
+                                      {0x04, 0x00}, {0x05, 0xFF}, {0x06, 0xE0},               // V0 sample, ADSR
+                                      {0x0C, 0x7F}, {0x1C, 0x7F}, {0x2C, 0x30}, {0x3C, 0x30}, // Main/echo volume
+                                      {0x6C, 0x00}, {0x0D, 0x40}, {0x0F, 0x7F}, {0x5D, 0x02}, // FLG, EFB, C0, DIR
+                                      {0x6D, 0x40}, {0x7D, 0x01}, {0x4D, 0x01}, {0x4C, 0x01}};// ESA, EDL, EON, KON
+        for (const uint8* reg : registers) {
+            dsp.write(reg[0], reg[1]);
+        }
+    }
+
+    uint32 firstPixel(Emulator& emulator) {
+        const uint8* pixels = emulator.getOutput().acquireFrame().pixels;
+        return pixels[0] | (pixels[1] << 8) | (pixels[2] << 16) | (pixels[3] << 24);
+    }
+
+    void testLoadROM() {
+        printTestHeader("Load ROM");
+        Emulator emulator;
+        assert_true("Empty ROM rejected", !emulator.loadROM(vector<uint8>()));
+        assert_true("Missing file rejected", !emulator.loadROMFile("/nonexistent/rom.sfc"));
+
+        assert_true("Loads", emulator.loadROM(makeROM({0xA9, 0x42,             // LDA #$42
+                                                       0x8D, 0x00, 0x00})));    // STA $0000
+        assert_equal("Reset to $8000", 0x8000, emulator.getCPU().registers.PC);
+        emulator.step();
+        emulator.step();
+        assert_equal("Steps run the ROM", 0x42, emulator.getMemory().getLowRAM()[0]);
+    }
+
+    void testFrame() {
+        printTestHeader("Frame");
+        Emulator emulator;
+        emulator.loadROM(makeROM({0x4C, 0x00, 0x80}));                         // JMP $8000
+        emulator.runFrame();
+        uint64 frame = Scheduler::LINES_PER_FRAME * MASTER_CYCLES_PER_SCANLINE;
+        uint64 time = emulator.getScheduler().getTime();
+        assert_true("One frame of master cycles", time >= frame && time < frame + 48);
+        emulator.runFrame();
+        assert_equal("Frames", 2, static_cast<uint32>(emulator.getScheduler().getFrames()));
+
+        FrameOutput::Frame output = emulator.getOutput().acquireFrame();
+        assert_true("Frame published", output.pixels != nullptr);
+        assert_equal("Width", PPU::SCREEN_WIDTH, output.width);
+        assert_equal("Height", PPU::SCREEN_HEIGHT, output.height);
+    }
+
+    void testAudio() {
+        printTestHeader("Audio");
+        Emulator emulator;
+        emulator.loadROM(makeROM({0x4C, 0x00, 0x80}));
+        emulator.setAudioOutputRate(48000.0);
+        int total = 0;
+        for (int i = 0; i < 60; ++i) {
+            emulator.runFrame();
+            total += emulator.getAudioFrames();
+        }
+        // 32 kHz at 60.1 frames a second
+        assert_true("About 533 samples a frame", total >= 31900 && total <= 32000);
+
+        vector<float> out(4096 * 2);
+        int read = emulator.readAudio(out.data(), 4096);
+        assert_true("Resampled to the host rate", read > 0);
+        assert_true("Fill level", emulator.getAudioFillLevel() < 1.0);
+
+        // A reset drops what was made before it
+        emulator.reset();
+        assert_equal("No samples after reset", 0, emulator.getAudioFrames());
+        assert_equal("Ring emptied by reset", 0, emulator.readAudio(out.data(), 4096));
+        assert_true("Fill level after reset", emulator.getAudioFillLevel() == 0.0);
+    }
+
+    void testAPUThreaded() {
+        printTestHeader("APU Thread");
+        // Same samples with the APU on its own thread, though they can come
+        // out a frame later
+        Emulator lazy;
+        Emulator threaded;
+        threaded.setAPUThreaded(true);
+        assert_true("Threaded", threaded.isAPUThreaded() && threaded.getAPUThread().isRunning());
+        vector<uint8> rom = makeROM({0x4C, 0x00, 0x80});
+        lazy.loadROM(rom);
+        threaded.loadROM(rom);
+        vector<int16> expected;
+        vector<int16> actual;
+        for (int i = 0; i < 10; ++i) {
+            lazy.runFrame();
+            threaded.runFrame();
+            expected.insert(expected.end(), lazy.getAudio(), lazy.getAudio() + lazy.getAudioFrames() * 2);
+            actual.insert(actual.end(), threaded.getAudio(), threaded.getAudio() + threaded.getAudioFrames() * 2);
+        }
+        assert_true("Samples made", !actual.empty());
+        // At most a frame behind, and nothing dropped on the way
+        assert_true("All samples kept", actual.size() <= expected.size() && expected.size() - actual.size() <= 1100);
+        size_t count = std::min(expected.size(), actual.size());
+        assert_true("Same samples", std::equal(actual.begin(), actual.begin() + count, expected.begin()));
+        assert_equal("Same CPU time", static_cast<uint32>(lazy.getCPU().totalCycles), static_cast<uint32>(threaded.getCPU().totalCycles));
+    }
+
+    void testSaveState() {
+        printTestHeader("Save State");
+        Emulator emulator;
+        emulator.loadROM(makeFrameCounter());
+        for (int i = 0; i < 5; ++i) {
+            emulator.runFrame();
+        }
+        Emulator::State state;
+        emulator.saveState(state);
+        uint64 cycles = emulator.getCPU().totalCycles;
+        uint8* ram = emulator.getMemory().getLowRAM();
+
+        vector<uint32> expected;
+        for (int i = 0; i < 3; ++i) {
+            emulator.runFrame();
+            expected.push_back(ram[0x10] | (ram[0x11] << 8));
+            expected.push_back(firstPixel(emulator));
+            expected.push_back(static_cast<uint32>(emulator.getCPU().totalCycles));
+        }
+        assert_equal("Frames counted", 8, ram[0x11]);
+
+        emulator.loadState(state);
+        assert_equal("CPU time restored", static_cast<uint32>(cycles), static_cast<uint32>(emulator.getCPU().totalCycles));
+        assert_equal("RAM restored", 5, ram[0x11]);
+        assert_equal("Frame count restored", 5, static_cast<uint32>(emulator.getScheduler().getFrames()));
+        vector<uint32> actual;
+        for (int i = 0; i < 3; ++i) {
+            emulator.runFrame();
+            actual.push_back(ram[0x10] | (ram[0x11] << 8));
+            actual.push_back(firstPixel(emulator));
+            actual.push_back(static_cast<uint32>(emulator.getCPU().totalCycles));
+        }
+        assert_true("Same frames again", actual == expected);
+    }
+
+    void testRunAhead() {
+        printTestHeader("Run-Ahead");
+        Emulator plain;
+        Emulator ahead;
+        ahead.setAPUThreaded(true);
+        ahead.setRunAhead(1);
+        assert_true("APU on this thread", !ahead.getAPUThread().isRunning());
+        plain.loadROM(makeFrameCounter());
+        ahead.loadROM(makeFrameCounter());
+
+        vector<uint32> plainFrames;
+        vector<uint32> aheadFrames;
+        bool sameState = true;
+        bool sameAudio = true;
+        for (int i = 0; i < 8; ++i) {
+            plain.runFrame();
+            ahead.runFrame();
+            plainFrames.push_back(firstPixel(plain));
+            aheadFrames.push_back(firstPixel(ahead));
+            sameState = sameState && plain.getCPU().totalCycles == ahead.getCPU().totalCycles &&
+                        std::equal(plain.getMemory().getLowRAM(), plain.getMemory().getLowRAM() + 0x2000,
+                                   ahead.getMemory().getLowRAM());
+            sameAudio = sameAudio && plain.getAudioFrames() == ahead.getAudioFrames() &&
+                        std::equal(plain.getAudio(), plain.getAudio() + plain.getAudioFrames() * 2, ahead.getAudio());
+        }
+        assert_true("Frames differ", plainFrames[3] != plainFrames[4]);
+        // What is shown is the frame after the one kept
+        assert_true("Shows a frame ahead", std::equal(aheadFrames.begin(), aheadFrames.end() - 1, plainFrames.begin() + 1));
+        assert_true("Same state kept", sameState);
+        assert_true("Audio of the kept frame", sameAudio);
+
+        ahead.setRunAhead(0);
+        assert_true("Thread back", ahead.getAPUThread().isRunning());
+
+        // Frames already run ahead are reused while the input stays the
+        // same, and run again once it changes: either way the same as
+        // running them all every time
+        Emulator reused;
+        Emulator rerun;
+        reused.setRunAhead(2);
+        rerun.setRunAhead(2);
+        reused.loadROM(makeJoypadEcho());
+        rerun.loadROM(makeJoypadEcho());
+        startSound(reused);
+        startSound(rerun);
+        bool sameFrames = true;
+        bool sameKept = true;
+        bool inputShown = false;
+        bool heard = false;
+        uint32 idle = 0;
+        for (int i = 0; i < 12; ++i) {
+            uint16 buttons = (i >= 4 && i < 8) ? 0x0800 : 0x0000;      // Up
+            reused.setJoypad(0, buttons);
+            rerun.setJoypad(0, buttons);
+            rerun.setRunAhead(2);
+            reused.runFrame();
+            rerun.runFrame();
+            uint32 shown = firstPixel(reused);
+            sameFrames = sameFrames && shown == firstPixel(rerun);
+            sameKept = sameKept && reused.getCPU().totalCycles == rerun.getCPU().totalCycles &&
+                       std::equal(reused.getMemory().getLowRAM(), reused.getMemory().getLowRAM() + 0x2000,
+                                  rerun.getMemory().getLowRAM()) &&
+                       reused.getAudioFrames() == rerun.getAudioFrames() &&
+                       std::equal(reused.getAudio(), reused.getAudio() + reused.getAudioFrames() * 2, rerun.getAudio());
+            heard = heard || std::any_of(reused.getAudio(), reused.getAudio() + reused.getAudioFrames() * 2,
+                                         [](int16 sample) { return sample != 0; });
+            if (i == 3) {
+                idle = shown;
+            }
+            inputShown = inputShown || (i >= 4 && i < 8 && shown != idle);
+        }
+        assert_true("Reused frames as if run again", sameFrames);
+        assert_true("Reused kept state as if run again", sameKept);
+        assert_true("Input change seen", inputShown);
+        assert_true("Sound heard", heard);
+
+        // Frames run without drawing still raise the sprite overflow flags
+        Emulator polled;
+        Emulator polledAhead;
+        polledAhead.setRunAhead(2);
+        polled.loadROM(makeSpriteOverflow());
+        polledAhead.loadROM(makeSpriteOverflow());
+        bool sameStat = true;
+        bool rangeSeen = false;
+        for (int i = 0; i < 12; ++i) {
+            uint16 buttons = (i >= 3 && i < 7) ? 0x0800 : 0x0000;
+            polled.setJoypad(0, buttons);
+            polledAhead.setJoypad(0, buttons);
+            polled.runFrame();
+            polledAhead.runFrame();
+            sameStat = sameStat && polled.getCPU().totalCycles == polledAhead.getCPU().totalCycles &&
+                       std::equal(polled.getMemory().getLowRAM(), polled.getMemory().getLowRAM() + 0x2000,
+                                  polledAhead.getMemory().getLowRAM());
+            rangeSeen = rangeSeen || (polled.getMemory().getLowRAM()[0x12] & 0x40);
+        }
+        assert_true("Range over polled", rangeSeen);
+        assert_true("Same STAT77 as a plain run", sameStat);
+    }
+
+    void testFastForward() {
+        printTestHeader("Fast-Forward");
+        Emulator plain;
+        Emulator fast;
+        fast.setAPUThreaded(true);
+        plain.loadROM(makeFrameCounter());
+        fast.loadROM(makeFrameCounter());
+        for (int i = 0; i < 60; ++i) {
+            plain.runFrame();
+        }
+        fast.getPPU().resetLineStats();
+        double speed = fast.fastForward(60);
+        assert_true("Speed reported", speed > 0.0);
+        assert_equal("Frames", 60, static_cast<uint32>(fast.getScheduler().getFrames()));
+        PPU& ppu = fast.getPPU();
+        assert_equal("Only the last frame drawn", PPU::SCREEN_HEIGHT,
+                     static_cast<uint32>(ppu.getRenderedLines() + ppu.getSkippedLines()));
+        assert_equal("Last frame shown", firstPixel(plain), firstPixel(fast));
+        assert_equal("Same CPU time", static_cast<uint32>(plain.getCPU().totalCycles), static_cast<uint32>(fast.getCPU().totalCycles));
+        assert_true("Same RAM", std::equal(plain.getMemory().getLowRAM(), plain.getMemory().getLowRAM() + 0x2000,
+                                           fast.getMemory().getLowRAM()));
+        assert_true("Same sound RAM", std::equal(plain.getAPU().getRAM(), plain.getAPU().getRAM() + 0x10000,
+                                                 fast.getAPU().getRAM()));
+        bool sameDSP = true;
+        for (int address = 0; address < 0x80; ++address) {
+            sameDSP = sameDSP && plain.getDSP().read(address) == fast.getDSP().read(address);
+        }
+        assert_true("Same DSP registers", sameDSP);
+        assert_equal("No audio", 0, fast.getAudioFrames());
+        assert_true("Thread back", fast.getAPUThread().isRunning());
+
+        ppu.resetLineStats();
+        fast.fastForward(30, 10);
+        assert_equal("Every 10th frame drawn", PPU::SCREEN_HEIGHT * 3,
+                     static_cast<uint32>(ppu.getRenderedLines() + ppu.getSkippedLines()));
+
+        // Undrawn frames still raise the sprite overflow flags
+        Emulator polled;
+        Emulator polledFast;
+        polled.loadROM(makeSpriteOverflow());
+        polledFast.loadROM(makeSpriteOverflow());
+        polled.setJoypad(0, 0x0800);
+        polledFast.setJoypad(0, 0x0800);
+        for (int i = 0; i < 20; ++i) {
+            polled.runFrame();
+        }
+        polledFast.fastForward(20);
+        assert_true("Range over counted", polled.getMemory().getLowRAM()[0x13] > 1);
+        assert_true("Same STAT77 as drawn frames", std::equal(polled.getMemory().getLowRAM(), polled.getMemory().getLowRAM() + 0x2000,
+                                                              polledFast.getMemory().getLowRAM()));
+    }
+};
+
+int main() {
+    EmulatorTester tester;
+    tester.runAllTests();
+    return 0;
+}
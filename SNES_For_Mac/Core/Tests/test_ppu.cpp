@@ -0,0 +1,1214 @@
+//
+//  test_ppu.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "../Memory/Memory.hpp"
+#include "../DMA/DMAController.hpp"
+#include "../PPU/PPU.hpp"
+#include "../PPU/TileDecoder.hpp"
+#include "../PPU/Mode7Renderer.hpp"
+#include "../PPU/Compositor.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <atomic>
+
+#define COLOR_RESET     "\033[0m"
+#define COLOR_GREEN     "\033[32m"
+#define COLOR_RED       "\033[31m"
+#define COLOR_YELLOW    "\033[33m"
+#define COLOR_CYAN      "\033[36m"
+
+using namespace std;
+
+class PPUTester {
+private:
+    Memory memory;
+    DMAController dma;
+    PPU ppu;
+    int testsPassed;
+    int testsFailed;
+
+public:
+    PPUTester() {
+        memory.setDMA(&dma);
+        memory.setPPU(&ppu);
+        dma.setMemory(&memory);
+        ppu.setMemory(&memory);
+        testsPassed = 0;
+        testsFailed = 0;
+    }
+
+    int runAllTests() {
+        cout << COLOR_CYAN << "=== SNES Emulator PPU Tests ===" << COLOR_RESET << endl;
+
+        testForcedBlank();
+        testMode1SingleTile();
+        testScrolling();
+        testLayerPriority();
+        testLargeTilesAndFlip();
+        testBrightness();
+        testOutputFormats();
+        testFrameExchange();
+        testTileCache();
+        testDecodeKernels();
+        testMode7();
+        testMode7Kernels();
+        testSprites();
+        testSpriteLimits();
+        testParallelRendering();
+        testLineSkipping();
+        testFrameGeometry();
+        testWindows();
+        testColorMath();
+        testCompositorKernels();
+
+        cout << endl;
+        cout << COLOR_CYAN << "=== Test Summary ===" << COLOR_RESET << endl;
+        cout << COLOR_GREEN << "Passed: " << testsPassed << COLOR_RESET << endl;
+        if (testsFailed > 0) {
+            cout << COLOR_RED << "Failed: " << testsFailed << COLOR_RESET << endl;
+        } else {
+            cout << COLOR_GREEN << "All tests Passed! ✓" << COLOR_RESET << endl;
+        }
+        return testsFailed;
+    }
+
+private:
+    void assert_equal(const string& testName, uint32 expected, uint32 actual) {
+        if (expected == actual) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            cout << " Expected: 0x" << hex << expected << ", Got: 0x" << actual << dec << endl;
+            testsFailed++;
+        }
+    }
+
+    void assert_true(const string& testName, bool condition) {
+        if (condition) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            testsFailed++;
+        }
+    }
+
+    void printTestHeader(const string& testName) {
+        cout << endl << COLOR_YELLOW << "--- " << testName << " ---" << COLOR_RESET << endl;
+    }
+
+    void resetAll() {
+        memory.reset();
+        dma.reset();
+        ppu.reset();
+    }
+
+    void writeVRAMWord(uint16 wordAddress, uint16 value) {
+        memory.write(0x2115, 0x80);
+        memory.write(0x2116, wordAddress & 0xFF);
+        memory.write(0x2117, wordAddress >> 8);
+        memory.write(0x2118, value & 0xFF);
+        memory.write(0x2119, value >> 8);
+    }
+
+    void writeColor(uint8 index, uint16 color) {
+        memory.write(0x2121, index);
+        memory.write(0x2122, color & 0xFF);
+        memory.write(0x2122, color >> 8);
+    }
+
+    // Fill every row of a 4bpp tile at charWord with the given color index
+    void writeSolidTile4bpp(uint16 charWord, uint8 colorIndex) {
+        for (int row = 0; row < 8; ++row) {
+            uint8 p0 = (colorIndex & 1) ? 0xFF : 0x00;
+            uint8 p1 = (colorIndex & 2) ? 0xFF : 0x00;
+            uint8 p2 = (colorIndex & 4) ? 0xFF : 0x00;
+            uint8 p3 = (colorIndex & 8) ? 0xFF : 0x00;
+            writeVRAMWord(charWord + row, p0 | (p1 << 8));
+            writeVRAMWord(charWord + 8 + row, p2 | (p3 << 8));
+        }
+    }
+
+    // Mode 1, BG1 tilemap at $0000, chars at $2000 (word), BG2 tilemap at $0400
+    void setupMode1() {
+        memory.write(0x2105, 0x01);
+        memory.write(0x2107, 0x00);         // BG1SC: tilemap at word $0000, 32x32
+        memory.write(0x2108, 0x04);         // BG2SC: tilemap at word $0400
+        memory.write(0x210B, 0x22);         // BG1/BG2 chars at word $2000
+        memory.write(0x212C, 0x01);         // BG1 on main screen
+        memory.write(0x2100, 0x0F);         // Display on, full brightness
+        writeColor(0, 0x7C00);              // Backdrop: blue
+        writeColor(1, 0x001F);              // Red
+        writeColor(2, 0x03E0);              // Green
+    }
+
+    uint16 pixel(int x, int y) {
+        return ppu.getFrameBuffer()[(y - 1) * ppu.getFrameStride() + x];
+    }
+
+    void testForcedBlank() {
+        printTestHeader("Test Forced Blank");
+        resetAll();
+        setupMode1();
+        memory.write(0x2100, 0x8F);
+        ppu.renderScanline(1);
+        assert_equal("Forced blank renders black", 0x0000, pixel(0, 1));
+        assert_equal("Frame is 256 wide", 256, ppu.getFrameWidth());
+        assert_equal("Frame is 224 tall", 224, ppu.getFrameHeight());
+    }
+
+    void testMode1SingleTile() {
+        printTestHeader("Test Mode 1 Single Tile");
+        resetAll();
+        setupMode1();
+        writeSolidTile4bpp(0x2000 + 16, 1);        // Tile 1 = color 1
+        writeVRAMWord(0x0000, 0x0001);              // Map (0,0) -> tile 1
+
+        ppu.renderScanline(1);
+        assert_equal("Tile pixel 0", 0x001F, pixel(0, 1));
+        assert_equal("Tile pixel 7", 0x001F, pixel(7, 1));
+        assert_equal("Backdrop after tile", 0x7C00, pixel(8, 1));
+        ppu.renderScanline(9);
+        assert_equal("Next tile row is backdrop", 0x7C00, pixel(0, 9));
+
+        memory.write(0x212C, 0x00);
+        ppu.renderScanline(1);
+        assert_equal("Disabled layer shows backdrop", 0x7C00, pixel(0, 1));
+    }
+
+    void testScrolling() {
+        printTestHeader("Test BG Scrolling");
+        resetAll();
+        setupMode1();
+        writeSolidTile4bpp(0x2000 + 16, 1);
+        writeVRAMWord(0x0000, 0x0001);
+
+        // BG1HOFS = 4, BG1VOFS = 2 (write twice: low then high)
+        memory.write(0x210D, 0x04);
+        memory.write(0x210D, 0x00);
+        memory.write(0x210E, 0x02);
+        memory.write(0x210E, 0x00);
+        ppu.renderScanline(1);
+        assert_equal("Scrolled tile pixel 0", 0x001F, pixel(0, 1));
+        assert_equal("Scrolled tile pixel 3", 0x001F, pixel(3, 1));
+        assert_equal("Scrolled past tile", 0x7C00, pixel(4, 1));
+        ppu.renderScanline(6);
+        assert_equal("Vertical scroll moves tile up", 0x001F, pixel(0, 6));
+        ppu.renderScanline(7);
+        assert_equal("Vertical scroll end of tile", 0x7C00, pixel(0, 7));
+
+        // Wrap around: HOFS = 252 shows the tile at x = 4
+        memory.write(0x210D, 0xFC);
+        memory.write(0x210D, 0x00);
+        memory.write(0x210E, 0x00);
+        memory.write(0x210E, 0x00);
+        ppu.renderScanline(1);
+        assert_equal("Wrapped scroll before tile", 0x7C00, pixel(3, 1));
+        assert_equal("Wrapped scroll tile", 0x001F, pixel(4, 1));
+    }
+
+    void testLayerPriority() {
+        printTestHeader("Test Layer Priority");
+        resetAll();
+        setupMode1();
+        writeSolidTile4bpp(0x2000 + 16, 1);
+        writeSolidTile4bpp(0x2000 + 32, 2);
+        writeVRAMWord(0x0000, 0x0001);              // BG1: tile 1, priority 0
+        writeVRAMWord(0x0400, 0x0002);              // BG2: tile 2, priority 0
+        memory.write(0x212C, 0x03);
+
+        ppu.renderScanline(1);
+        assert_equal("BG1 in front of BG2 at equal priority", 0x001F, pixel(0, 1));
+
+        writeVRAMWord(0x0400, 0x2002);              // BG2 tile with priority 1
+        ppu.renderScanline(1);
+        assert_equal("High priority BG2 in front of BG1", 0x03E0, pixel(0, 1));
+    }
+
+    void testLargeTilesAndFlip() {
+        printTestHeader("Test 16x16 Tiles and Flipping");
+        resetAll();
+        setupMode1();
+        memory.write(0x2105, 0x11);                 // Mode 1, BG1 16x16
+        writeSolidTile4bpp(0x2000 + 16 * 1, 1);     // Top-left
+        writeSolidTile4bpp(0x2000 + 16 * 2, 2);     // Top-right
+        writeVRAMWord(0x0000, 0x0001);
+
+        ppu.renderScanline(1);
+        assert_equal("16x16 left half", 0x001F, pixel(0, 1));
+        assert_equal("16x16 right half", 0x03E0, pixel(8, 1));
+        assert_equal("16x16 ends at 16", 0x7C00, pixel(16, 1));
+
+        writeVRAMWord(0x0000, 0x4001);              // Horizontal flip
+        ppu.renderScanline(1);
+        assert_equal("H-flipped left half", 0x03E0, pixel(0, 1));
+        assert_equal("H-flipped right half", 0x001F, pixel(8, 1));
+    }
+
+    void testBrightness() {
+        printTestHeader("Test Master Brightness");
+        resetAll();
+        setupMode1();
+        writeColor(0, 0x7FFF);
+        memory.write(0x2100, 0x07);                 // Half brightness
+        ppu.renderScanline(1);
+        // Brightness is applied by the output palette, not the BGR555 frame
+        assert_equal("BGR555 frame unscaled", 0x7FFF, pixel(0, 1));
+        FrameOutput& output = ppu.getOutput();
+        const uint32* row = reinterpret_cast<const uint32*>(output.getRow(0));
+        assert_equal("Half brightness white (BGRA)", 0xFF7B7B7B, row[0]);
+    }
+
+    void testOutputFormats() {
+        printTestHeader("Test Output Formats");
+        resetAll();
+        setupMode1();
+        writeColor(0, 0x001F);                      // Pure red
+        memory.write(0x2100, 0x0F);
+        FrameOutput& output = ppu.getOutput();
+
+        ppu.renderScanline(1);
+        assert_equal("BGRA stride", 1024, output.getStride());
+        assert_equal("BGRA red", 0xFFFF0000, reinterpret_cast<const uint32*>(output.getRow(0))[0]);
+
+        output.setFormat(FrameOutput::FORMAT_RGBA8888);
+        ppu.renderScanline(1);
+        assert_equal("RGBA red", 0xFF0000FF, reinterpret_cast<const uint32*>(output.getRow(0))[0]);
+
+        output.setFormat(FrameOutput::FORMAT_RGB565);
+        ppu.renderScanline(1);
+        assert_equal("RGB565 stride", 512, output.getStride());
+        assert_equal("RGB565 red", 0xF800, reinterpret_cast<const uint16*>(output.getRow(0))[0]);
+        assert_true("Rows 16-byte aligned", (reinterpret_cast<uintptr_t>(output.getRow(1)) & 15) == 0);
+
+        memory.write(0x2100, 0x80);                 // Forced blank
+        ppu.renderScanline(1);
+        assert_equal("Forced blank black", 0x0000, reinterpret_cast<const uint16*>(output.getRow(0))[0]);
+        output.setFormat(FrameOutput::FORMAT_BGRA8888);
+    }
+
+    // Fill the producer's frame with one color
+    void writeFrame(FrameOutput& output, uint16 color) {
+        uint16 line[PPU::SCREEN_WIDTH];
+        std::fill(line, line + PPU::SCREEN_WIDTH, color);
+        for (int y = 0; y < output.getHeight(); ++y) {
+            output.writeLine(y, line, 0x0F, PPU::SCREEN_WIDTH);
+        }
+    }
+
+    void testFrameExchange() {
+        printTestHeader("Test Triple-Buffered Frame Exchange");
+        FrameOutput output(PPU::SCREEN_WIDTH, PPU::SCREEN_HEIGHT);
+        uint32 red = output.convert(0x001F, 0x0F);
+        uint32 blue = output.convert(0x7C00, 0x0F);
+
+        writeFrame(output, 0x001F);
+        output.publish();
+        const uint8* frame = output.acquireFrame().pixels;
+        assert_equal("Published frame", red, *reinterpret_cast<const uint32*>(frame));
+
+        writeFrame(output, 0x03E0);
+        assert_true("Unpublished frame not handed out", output.acquireFrame().pixels == frame);
+        assert_equal("Front frame untouched", red, *reinterpret_cast<const uint32*>(frame));
+
+        output.publish();
+        writeFrame(output, 0x7C00);
+        output.publish();
+        frame = output.acquireFrame().pixels;
+        assert_equal("Newest frame wins", blue, *reinterpret_cast<const uint32*>(frame));
+        assert_true("Producer never writes the front frame", output.getRow(0) != frame);
+
+        // Every frame the consumer sees must be complete: one color throughout
+        std::atomic<bool> done(false);
+        std::thread producer([&]() {
+            for (int i = 0; i < 300; ++i) {
+                writeFrame(output, (i & 1) ? 0x001F : 0x7C00);
+                output.publish();
+            }
+            done = true;
+        });
+        bool consistent = true;
+        while (!done) {
+            FrameOutput::Frame latest = output.acquireFrame();
+            uint32 first = *reinterpret_cast<const uint32*>(latest.pixels);
+            const uint32* lastRow = reinterpret_cast<const uint32*>(latest.pixels + latest.stride * (latest.height - 1));
+            consistent = consistent && (first == red || first == blue) && lastRow[PPU::SCREEN_WIDTH - 1] == first;
+        }
+        producer.join();
+        assert_true("Consumer only sees whole frames", consistent);
+    }
+
+    void testTileCache() {
+        printTestHeader("Test Tile Cache Invalidation");
+        resetAll();
+        setupMode1();
+        writeSolidTile4bpp(0x2000 + 16, 1);
+        writeVRAMWord(0x0000, 0x0001);
+        TileCache& cache = ppu.getTileCache();
+
+        cache.resetStats();
+        ppu.renderScanline(1);
+        uint64 misses = cache.getMisses();
+        assert_true("First line decodes its tiles", misses > 0);
+        ppu.renderScanline(2);
+        ppu.renderScanline(3);
+        assert_equal("Unchanged VRAM causes no new decodes", misses, cache.getMisses());
+        assert_true("Later lines hit the cache", cache.getHits() >= 2 * 33);
+
+        // Port write: tile 1 becomes color 2
+        writeSolidTile4bpp(0x2000 + 16, 2);
+        ppu.renderScanline(1);
+        assert_equal("Port write invalidates tile", 0x03E0, pixel(0, 1));
+
+        // DMA write: tile 1 back to color 1 (plane 0 set, plane 1 clear)
+        for (int i = 0; i < 32; ++i) {
+            memory.write(0x7E2000 + i, (i < 16 && (i & 1) == 0) ? 0xFF : 0x00);
+        }
+        memory.write(0x2115, 0x80);
+        memory.write(0x2116, 0x10);
+        memory.write(0x2117, 0x20);                 // Word $2010 = tile 1
+        memory.write(0x4300, 0x01);
+        memory.write(0x4301, 0x18);
+        memory.write(0x4302, 0x00);
+        memory.write(0x4303, 0x20);
+        memory.write(0x4304, 0x7E);
+        memory.write(0x4305, 0x20);
+        memory.write(0x4306, 0x00);
+        memory.write(0x420B, 0x01);
+        ppu.renderScanline(1);
+        assert_equal("DMA write invalidates tile", 0x001F, pixel(0, 1));
+
+        // Fixed-source DMA fill clears the tile
+        memory.write(0x2116, 0x10);
+        memory.write(0x2117, 0x20);
+        memory.write(0x4300, 0x09);                 // Fixed source, mode 1
+        memory.write(0x4305, 0x20);
+        memory.write(0x420B, 0x01);
+        ppu.renderScanline(1);
+        assert_equal("DMA fill invalidates tile", 0x7C00, pixel(0, 1));
+        assert_true("Hit rate reported", cache.getHitRate() > 0.5);
+    }
+
+    void testDecodeKernels() {
+        printTestHeader("Test SIMD Decode Kernels");
+        srand(0x5AFC);
+        uint8 planar[64];
+        uint64 rows[65];
+        uint8 palettes[65];
+        uint8 priorities[65];
+        for (int i = 0; i < 65; ++i) {
+            // Keep a few fully transparent rows and palette 0 in the mix
+            rows[i] = (i % 7 == 0) ? 0 : (static_cast<uint64>(rand()) << 32 | rand()) & 0x0F0F0F0F0F0F0F0FULL;
+            palettes[i] = static_cast<uint8>((rand() & 0x07) << 4);
+            priorities[i] = rand() & 0x01;
+        }
+
+        // Known pattern: plane 0 = $81, plane 1 = $FF -> pixels 3 2 2 2 2 2 2 3
+        std::memset(planar, 0, sizeof(planar));
+        planar[0] = 0x81;
+        planar[1] = 0xFF;
+        uint64 expected[8];
+        TileDecoder::decodeTileScalar(planar, 2, expected);
+        assert_equal("Scalar decode row 0", 0x0302020202020203ULL & 0xFFFFFFFF, expected[0] & 0xFFFFFFFF);
+        assert_equal("Scalar decode row 0 high", 0x0302020202020203ULL >> 32, expected[0] >> 32);
+
+        TileDecoder::Level best = TileDecoder::detectLevel();
+        cout << "Detected kernel level: " << best << endl;
+        assert_true("Active kernels are the best supported", TileDecoder::getLevel() == best);
+
+#if defined(__x86_64__) || defined(__i386__)
+        bool decodeSSE2 = true;
+        bool decodeAVX2 = true;
+        for (int trial = 0; trial < 200; ++trial) {
+            for (int i = 0; i < 64; ++i) {
+                planar[i] = static_cast<uint8>(rand());
+            }
+            for (int bpp = 2; bpp <= 8; bpp <<= 1) {
+                uint64 reference[8];
+                uint64 vector[8];
+                TileDecoder::decodeTileScalar(planar, bpp, reference);
+                TileDecoder::decodeTileSSE2(planar, bpp, vector);
+                decodeSSE2 = decodeSSE2 && std::memcmp(reference, vector, sizeof(reference)) == 0;
+                if (best == TileDecoder::LEVEL_AVX2) {
+                    TileDecoder::decodeTileAVX2(planar, bpp, vector);
+                    decodeAVX2 = decodeAVX2 && std::memcmp(reference, vector, sizeof(reference)) == 0;
+                }
+            }
+        }
+        assert_true("SSE2 decode matches scalar", decodeSSE2);
+        assert_true("AVX2 decode matches scalar", decodeAVX2);
+
+        // Odd counts exercise the scalar/SSE2 tails
+        bool writeSSE2 = true;
+        bool writeAVX2 = true;
+        for (int count = 1; count <= 65; count += 16) {
+            uint8 refIndex[520], refPriority[520], vecIndex[520], vecPriority[520];
+            TileDecoder::writeRowsScalar(refIndex, refPriority, rows, palettes, priorities, count);
+            TileDecoder::writeRowsSSE2(vecIndex, vecPriority, rows, palettes, priorities, count);
+            writeSSE2 = writeSSE2 && std::memcmp(refIndex, vecIndex, count * 8) == 0 &&
+                        std::memcmp(refPriority, vecPriority, count * 8) == 0;
+            if (best == TileDecoder::LEVEL_AVX2) {
+                TileDecoder::writeRowsAVX2(vecIndex, vecPriority, rows, palettes, priorities, count);
+                writeAVX2 = writeAVX2 && std::memcmp(refIndex, vecIndex, count * 8) == 0 &&
+                            std::memcmp(refPriority, vecPriority, count * 8) == 0;
+            }
+        }
+        assert_true("SSE2 row writer matches scalar", writeSSE2);
+        assert_true("AVX2 row writer matches scalar", writeAVX2);
+#endif
+
+        // Rendering must not depend on the kernel level
+        resetAll();
+        setupMode1();
+        writeSolidTile4bpp(0x2000 + 16, 5);
+        writeVRAMWord(0x0000, 0x4401);              // Palette 1, h-flip
+        writeColor(0x15, 0x1234);
+        std::vector<uint16> frames[2];
+        TileDecoder::Level levels[2] = { TileDecoder::LEVEL_SCALAR, best };
+        ppu.setSkipUnchangedLines(false);           // Really draw the line twice
+        for (int i = 0; i < 2; ++i) {
+            TileDecoder::setLevel(levels[i]);
+            ppu.getTileCache().invalidateAll();
+            ppu.renderScanline(1);
+            frames[i].assign(ppu.getFrameBuffer(), ppu.getFrameBuffer() + PPU::SCREEN_WIDTH);
+        }
+        ppu.setSkipUnchangedLines(true);
+        assert_true("Scalar and SIMD scanlines match", frames[0] == frames[1]);
+        assert_equal("Palette applied to tile", 0x1234, frames[1][0]);
+    }
+
+    void writeMode7Register(uint16 address, uint16 value) {
+        memory.write(address, value & 0xFF);
+        memory.write(address, value >> 8);
+    }
+
+    // Tile 0 is solid color $22, tile 1 solid $11 (or $91 when extbg);
+    // the map has tile 1 at (0,0) and (126,0), tile 0 elsewhere
+    void setupMode7(uint8 tile1Color) {
+        memory.write(0x2105, 0x07);
+        memory.write(0x212C, 0x01);
+        memory.write(0x2100, 0x0F);
+        writeColor(0, 0x7C00);
+        writeColor(0x11, 0x001F);
+        writeColor(0x22, 0x03E0);
+        for (int word = 0; word < 128; ++word) {
+            uint8 map = (word == 0 || word == 126) ? 1 : 0;
+            uint8 pixel = word < 64 ? 0x22 : tile1Color;
+            writeVRAMWord(word, (pixel << 8) | map);
+        }
+        writeMode7Register(0x211B, 0x0100);         // Identity matrix
+        writeMode7Register(0x211C, 0x0000);
+        writeMode7Register(0x211D, 0x0000);
+        writeMode7Register(0x211E, 0x0100);
+    }
+
+    void testMode7() {
+        printTestHeader("Test Mode 7");
+        resetAll();
+        setupMode7(0x11);
+
+        ppu.renderScanline(1);
+        assert_equal("Identity: tile 1 at x = 0", 0x001F, pixel(0, 1));
+        assert_equal("Identity: tile 1 at x = 7", 0x001F, pixel(7, 1));
+        assert_equal("Identity: tile 0 at x = 8", 0x03E0, pixel(8, 1));
+
+        writeMode7Register(0x211B, 0x0080);         // Half step per pixel = 2x zoom
+        ppu.renderScanline(1);
+        assert_equal("Zoomed tile reaches x = 15", 0x001F, pixel(15, 1));
+        assert_equal("Zoomed tile ends at x = 16", 0x03E0, pixel(16, 1));
+        writeMode7Register(0x211B, 0x0100);
+
+        memory.write(0x211A, 0x01);                 // Horizontal flip
+        ppu.renderScanline(1);
+        assert_equal("H-flip moves tile to the right edge", 0x001F, pixel(255, 1));
+        assert_equal("H-flip left edge", 0x03E0, pixel(0, 1));
+
+        // Scroll 16 pixels left of the plane
+        writeMode7Register(0x210D, 0x1FF0);
+        memory.write(0x211A, 0x00);
+        ppu.renderScanline(1);
+        assert_equal("Wrap: plane repeats", 0x001F, pixel(0, 1));
+        memory.write(0x211A, 0x80);
+        ppu.renderScanline(1);
+        assert_equal("Outside is transparent", 0x7C00, pixel(0, 1));
+        assert_equal("Inside still drawn", 0x001F, pixel(16, 1));
+        memory.write(0x211A, 0xC0);
+        ppu.renderScanline(1);
+        assert_equal("Outside filled with tile 0", 0x03E0, pixel(0, 1));
+
+        // EXTBG: BG2 shows the low 7 bits of the same pixels
+        resetAll();
+        setupMode7(0x91);
+        memory.write(0x2133, 0x40);
+        memory.write(0x212C, 0x02);
+        ppu.renderScanline(1);
+        assert_equal("EXTBG strips priority bit", 0x001F, pixel(0, 1));
+        memory.write(0x2133, 0x00);
+        ppu.renderScanline(1);
+        assert_equal("BG2 absent without EXTBG", 0x7C00, pixel(0, 1));
+
+        // Signed 16x8 multiply through the matrix registers
+        writeMode7Register(0x211B, 0x1234);
+        writeMode7Register(0x211C, 0xFE00);         // High byte -2
+        assert_equal("MPYL", 0x98, memory.read(0x2134));
+        assert_equal("MPYM", 0xDB, memory.read(0x2135));
+        assert_equal("MPYH", 0xFF, memory.read(0x2136));
+    }
+
+    void testMode7Kernels() {
+        printTestHeader("Test Mode 7 Kernels");
+        srand(0x7777);
+        std::vector<uint8> vram(0x10000);
+        for (size_t i = 0; i < vram.size(); ++i) {
+            vram[i] = static_cast<uint8>(rand());
+        }
+        bool sse2 = true;
+        bool avx2 = true;
+        TileDecoder::Level best = TileDecoder::detectLevel();
+        for (int trial = 0; trial < 256; ++trial) {
+            Mode7Renderer::Matrix matrix;
+            matrix.a = static_cast<int16>(rand());
+            matrix.b = static_cast<int16>(rand());
+            matrix.c = static_cast<int16>(rand());
+            matrix.d = static_cast<int16>(rand());
+            matrix.centerX = static_cast<int16>((rand() & 0x1FFF) - 0x1000);
+            matrix.centerY = static_cast<int16>((rand() & 0x1FFF) - 0x1000);
+            matrix.hofs = static_cast<int16>((rand() & 0x1FFF) - 0x1000);
+            matrix.vofs = static_cast<int16>((rand() & 0x1FFF) - 0x1000);
+            matrix.select = static_cast<uint8>(trial & 0xC3);
+            Mode7Renderer::Line line = Mode7Renderer::setupLine(matrix, 1 + trial % 224);
+            uint8 reference[256];
+            Mode7Renderer::renderLineScalar(vram.data(), line, reference);
+#if defined(__x86_64__) || defined(__i386__)
+            uint8 vector[256];
+            Mode7Renderer::renderLineSSE2(vram.data(), line, vector);
+            sse2 = sse2 && std::memcmp(reference, vector, sizeof(reference)) == 0;
+            if (best == TileDecoder::LEVEL_AVX2) {
+                Mode7Renderer::renderLineAVX2(vram.data(), line, vector);
+                avx2 = avx2 && std::memcmp(reference, vector, sizeof(reference)) == 0;
+            }
+#endif
+        }
+        assert_true("SSE2 Mode 7 matches scalar", sse2);
+        assert_true("AVX2 Mode 7 matches scalar", avx2);
+    }
+
+    void writeSprite(int index, uint8 x, uint8 y, uint8 tile, uint8 attributes) {
+        memory.write(0x2102, index * 2);
+        memory.write(0x2103, 0x00);
+        memory.write(0x2104, x);
+        memory.write(0x2104, y);
+        memory.write(0x2104, tile);
+        memory.write(0x2104, attributes);
+    }
+
+    // X bit 8 / size bits for all 128 sprites
+    void writeSpriteHighTable(const uint8* table) {
+        memory.write(0x2102, 0x00);
+        memory.write(0x2103, 0x01);
+        for (int i = 0; i < 32; ++i) {
+            memory.write(0x2104, table[i]);
+        }
+    }
+
+    // Mode 1 with sprites on, every sprite parked below the screen
+    void setupSprites() {
+        setupMode1();
+        memory.write(0x212C, 0x10);
+        memory.write(0x2101, 0x02);                 // 8x8/16x16, names at word $4000
+        for (int i = 0; i < 128; ++i) {
+            writeSprite(i, 0, 0xF0, 0, 0);
+        }
+        writeSolidTile4bpp(0x4000 + 16 * 1, 3);     // OBJ tile 1
+        writeSolidTile4bpp(0x4000 + 16 * 2, 4);     // OBJ tile 2
+        writeColor(128 + 3, 0x001F);                // Palette 0 color 3: red
+        writeColor(128 + 4, 0x03E0);                // Palette 0 color 4: green
+        writeColor(128 + 16 + 3, 0x7FFF);           // Palette 1 color 3: white
+    }
+
+    void testSprites() {
+        printTestHeader("Test Sprites");
+        resetAll();
+        setupSprites();
+        writeSprite(0, 10, 20, 1, 0x00);
+
+        ppu.renderScanline(21);
+        assert_equal("Sprite left edge", 0x001F, pixel(10, 21));
+        assert_equal("Sprite right edge", 0x001F, pixel(17, 21));
+        assert_equal("Backdrop beside sprite", 0x7C00, pixel(18, 21));
+        ppu.renderScanline(20);
+        assert_equal("Sprite starts one line below Y", 0x7C00, pixel(10, 20));
+        ppu.renderScanline(29);
+        assert_equal("8x8 sprite ends after 8 lines", 0x7C00, pixel(10, 29));
+
+        // Lower OAM index is in front of higher ones
+        writeSprite(1, 14, 20, 1, 0x02);            // Palette 1
+        ppu.renderScanline(21);
+        assert_equal("Sprite 0 wins the overlap", 0x001F, pixel(14, 21));
+        assert_equal("Sprite 1 visible past sprite 0", 0x7FFF, pixel(18, 21));
+
+        // Priority against BG1 (mode 1: OBJ priority 0 is behind BG1)
+        memory.write(0x212C, 0x11);
+        writeSolidTile4bpp(0x2000 + 16, 1);
+        writeColor(1, 0x0000);
+        writeVRAMWord(0x0000 + 2 * 32 + 1, 0x0001); // BG1 tile at (8, 16)
+        ppu.renderScanline(21);
+        assert_equal("OBJ priority 0 behind BG1", 0x0000, pixel(10, 21));
+        writeSprite(0, 10, 20, 1, 0x30);
+        ppu.renderScanline(21);
+        assert_equal("OBJ priority 3 in front of BG1", 0x001F, pixel(10, 21));
+
+        // Large 16x16 sprite with horizontal flip, partly off the left edge
+        resetAll();
+        setupSprites();
+        uint8 high[32] = { 0x02 | 0x01 };           // Sprite 0: large, X bit 8
+        writeSpriteHighTable(high);
+        writeSprite(0, 0xFC, 0, 1, 0x40);           // X = -4, tiles 1,2 flipped
+        writeSolidTile4bpp(0x4000 + 16 * 17, 3);    // Second row, left half
+        ppu.renderScanline(1);
+        assert_equal("Flipped right half shows first", 0x03E0, pixel(0, 1));
+        assert_equal("Flipped right half ends", 0x03E0, pixel(3, 1));
+        assert_equal("Flipped left half", 0x001F, pixel(4, 1));
+        assert_equal("Large sprite is 16 wide", 0x7C00, pixel(12, 1));
+        ppu.renderScanline(9);
+        assert_equal("Second tile row, flipped", 0x001F, pixel(11, 9));
+        assert_equal("Second tile row, empty half", 0x7C00, pixel(0, 9));
+        ppu.renderScanline(17);
+        assert_equal("Large sprite is 16 tall", 0x7C00, pixel(11, 17));
+    }
+
+    void testSpriteLimits() {
+        printTestHeader("Test Sprite Range/Time Limits");
+        resetAll();
+        setupSprites();
+
+        for (int i = 0; i < 32; ++i) {
+            writeSprite(i, i * 8, 40, 1, 0x00);
+        }
+        ppu.renderScanline(41);
+        assert_equal("32 sprites: no range over", 0x00, memory.read(0x213E) & 0xC0);
+        writeSprite(32, 0, 40, 1, 0x00);
+        ppu.renderScanline(41);
+        assert_equal("33 sprites: range over", 0x40, memory.read(0x213E) & 0x40);
+        ppu.renderScanline(1);
+        assert_equal("Flags clear at frame start", 0x00, memory.read(0x213E) & 0xC0);
+
+        // 5 sprites of 64x64 = 40 tiles; sprite 0 keeps only 2 of its 8
+        resetAll();
+        setupSprites();
+        memory.write(0x2101, 0x42);                 // 8x8/64x64
+        uint8 high[32] = { 0xAA, 0x02 };            // Sprites 0-4 large
+        writeSpriteHighTable(high);
+        writeSprite(0, 0, 0, 1, 0x02);              // Palette 1 (white)
+        for (int i = 1; i < 5; ++i) {
+            writeSprite(i, 0, 0, 1, 0x00);
+        }
+        writeSolidTile4bpp(0x4000 + 16 * 3, 3);     // Tile column 2
+        ppu.renderScanline(1);
+        assert_equal("Time over flagged", 0x80, memory.read(0x213E) & 0x80);
+        assert_equal("Sprite 0 keeps its first tiles", 0x7FFF, pixel(0, 1));
+        assert_equal("Sprite 0 third tile dropped", 0x001F, pixel(16, 1));
+
+        // Drawing off still raises the same flags
+        ppu.setRenderEnabled(false);
+        ppu.renderScanline(1);
+        assert_equal("Time over without drawing", 0x80, memory.read(0x213E) & 0xC0);
+        for (int i = 5; i < 33; ++i) {
+            writeSprite(i, 0, 0, 1, 0x00);
+        }
+        ppu.renderScanline(1);
+        assert_equal("Range over without drawing", 0xC0, memory.read(0x213E) & 0xC0);
+        memory.write(0x212C, 0x01);
+        ppu.renderScanline(1);
+        assert_equal("No flags with OBJ disabled", 0x00, memory.read(0x213E) & 0xC0);
+        ppu.setRenderEnabled(true);
+    }
+
+    // BG1 row 0 all tile 1 (color 1 red), BG2 row 0 all tile 2 (color 2 green)
+    void setupTwoLayers() {
+        setupMode1();
+        writeSolidTile4bpp(0x2000 + 16, 1);
+        writeSolidTile4bpp(0x2000 + 32, 2);
+        for (int column = 0; column < 32; ++column) {
+            writeVRAMWord(0x0000 + column, 0x0001);
+            writeVRAMWord(0x0400 + column, 0x0002);
+        }
+    }
+
+    // A frame whose registers, CGRAM, VRAM and OAM change between lines.
+    // Returns the BGR555 frame, the published output frame and STAT77.
+    void renderBusyFrame(vector<uint16>& frame, vector<uint8>& display, uint8& stat) {
+        resetAll();
+        setupSprites();
+        srand(0x5EED);
+        for (int word = 0; word < 0x800; ++word) {
+            writeVRAMWord(word, rand() & 0x3C07);           // Tiles 0-7, any palette/priority/flip
+        }
+        for (int word = 0x2000; word < 0x2080; ++word) {
+            writeVRAMWord(word, rand());
+        }
+        for (int color = 0; color < 256; ++color) {
+            writeColor(color, rand() & 0x7FFF);
+        }
+        for (int i = 0; i < 40; ++i) {
+            writeSprite(i, i * 6, 100, 1 + (i & 1), (i & 3) << 4);
+        }
+        memory.write(0x212C, 0x13);                         // BG1, BG2, OBJ on main
+        memory.write(0x212D, 0x02);                         // BG2 on sub
+        memory.write(0x2131, 0x01);                         // Add sub screen to BG1
+        memory.write(0x2130, 0x02);
+
+        for (int line = 1; line <= PPU::SCREEN_HEIGHT; ++line) {
+            memory.write(0x210D, line & 0xFF);              // Per-line BG1 scroll, like HDMA
+            memory.write(0x210D, 0x00);
+            if (line == 50) {
+                writeColor(1, 0x7FFF);
+            }
+            if (line == 80) {
+                memory.write(0x2126, 40);
+                memory.write(0x2127, 90);
+                memory.write(0x2123, 0x02);
+                memory.write(0x212E, 0x01);
+            }
+            if (line == 120) {
+                writeVRAMWord(0x2010, 0xFFFF);              // Mid-frame tile change
+            }
+            if (line == 150) {
+                writeSprite(0, 30, 150, 2, 0x30);
+            }
+            if (line == 170) {
+                memory.write(0x2100, 0x08);
+            }
+            if (line == 190) {
+                memory.write(0x2100, 0x80);
+            }
+            if (line == 200) {
+                memory.write(0x2100, 0x0F);
+            }
+            ppu.renderScanline(line);
+        }
+        ppu.endFrame();
+        stat = ppu.readRegister(0x213E);
+        frame.assign(ppu.getFrameBuffer(), ppu.getFrameBuffer() + PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT);
+        FrameOutput& output = ppu.getOutput();
+        FrameOutput::Frame latest = output.acquireFrame();
+        display.assign(latest.pixels, latest.pixels + latest.stride * latest.height);
+    }
+
+    void testParallelRendering() {
+        printTestHeader("Test Parallel Scanline Rendering");
+        vector<uint16> serialFrame, parallelFrame;
+        vector<uint8> serialDisplay, parallelDisplay;
+        uint8 serialStat = 0;
+        uint8 parallelStat = 0;
+        renderBusyFrame(serialFrame, serialDisplay, serialStat);
+
+        ppu.setRenderThreads(3);
+        assert_equal("Render threads", 3, ppu.getRenderThreads());
+        renderBusyFrame(parallelFrame, parallelDisplay, parallelStat);
+        ppu.setRenderThreads(0);
+
+        assert_true("BGR555 frame identical", serialFrame == parallelFrame);
+        assert_true("Display frame identical", serialDisplay == parallelDisplay);
+        assert_equal("STAT77 identical", serialStat, parallelStat);
+        assert_true("Sprite range overflow seen", (serialStat & 0x40) != 0);
+    }
+
+    void renderFrame() {
+        for (int line = 1; line <= ppu.getVisibleLines(); ++line) {
+            ppu.renderScanline(line);
+        }
+        ppu.endFrame();
+    }
+
+    void testLineSkipping() {
+        printTestHeader("Test Unchanged Line Skipping");
+        resetAll();
+        setupSprites();
+        setupMode1();
+        writeSolidTile4bpp(0x2000 + 16, 5);
+        writeVRAMWord(0x0000, 0x0001);              // Tile 1 at the top left
+        writeColor(5, 0x001F);
+        writeSprite(0, 100, 100, 1, 0x00);
+        memory.write(0x212C, 0x11);                 // BG1 and OBJ
+        renderFrame();
+        ppu.resetLineStats();
+
+        renderFrame();
+        assert_equal("Identical frame reuses every line", PPU::SCREEN_HEIGHT, (int)ppu.getSkippedLines());
+        assert_equal("Nothing redrawn", 0, (int)ppu.getRenderedLines());
+        assert_equal("Reused line keeps its pixels", 0x001F, pixel(0, 1));
+
+        // Same values again do not count as changes
+        ppu.resetLineStats();
+        writeColor(5, 0x001F);
+        writeVRAMWord(0x0000, 0x0001);
+        renderFrame();
+        assert_equal("Rewriting same values", 0, (int)ppu.getRenderedLines());
+
+        ppu.resetLineStats();
+        writeColor(5, 0x03E0);
+        renderFrame();
+        assert_equal("CGRAM change redraws all lines", PPU::SCREEN_HEIGHT, (int)ppu.getRenderedLines());
+        assert_equal("New color drawn", 0x03E0, pixel(0, 1));
+
+        // A VRAM block no line reads
+        ppu.resetLineStats();
+        writeVRAMWord(0x6000, 0x1234);
+        renderFrame();
+        assert_equal("Unread VRAM block", 0, (int)ppu.getRenderedLines());
+
+        ppu.resetLineStats();
+        writeSolidTile4bpp(0x2000 + 16, 6);
+        writeColor(6, 0x7C00);
+        renderFrame();
+        assert_equal("Tile change drawn", 0x7C00, pixel(0, 1));
+
+        ppu.resetLineStats();
+        writeSprite(0, 100, 120, 1, 0x00);
+        renderFrame();
+        assert_equal("OAM change redraws all lines", PPU::SCREEN_HEIGHT, (int)ppu.getRenderedLines());
+        assert_equal("Sprite drawn at new place", 0x001F, pixel(100, 125));
+        assert_true("Sprite gone from old place", pixel(100, 105) != 0x001F);
+
+        // Register changes only redraw the lines they apply to
+        ppu.resetLineStats();
+        for (int line = 1; line <= PPU::SCREEN_HEIGHT; ++line) {
+            memory.write(0x210D, line == 10 ? 4 : 0);
+            memory.write(0x210D, 0x00);
+            ppu.renderScanline(line);
+        }
+        ppu.endFrame();
+        assert_equal("Scroll change on one line", 1, (int)ppu.getRenderedLines());
+
+        // The same holds with render threads, and matches a full redraw
+        vector<uint16> frames[2];
+        for (int i = 0; i < 2; ++i) {
+            ppu.setRenderThreads(i == 0 ? 2 : 0);
+            ppu.setSkipUnchangedLines(i == 0);
+            renderFrame();
+            ppu.resetLineStats();
+            for (int line = 1; line <= PPU::SCREEN_HEIGHT; ++line) {
+                if (line == 100) {
+                    writeColor(5, 0x7FFF);          // Mid-frame CGRAM change
+                }
+                ppu.renderScanline(line);
+            }
+            ppu.endFrame();
+            writeColor(5, 0x03E0);
+            frames[i].assign(ppu.getFrameBuffer(), ppu.getFrameBuffer() + PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT);
+            if (i == 0) {
+                assert_equal("Threaded: lines before the change reused", 99, (int)ppu.getSkippedLines());
+            }
+        }
+        ppu.setSkipUnchangedLines(true);
+        assert_true("Reused lines match a full redraw", frames[0] == frames[1]);
+    }
+
+    uint32 outputPixel(const FrameOutput::Frame& frame, int x, int row) {
+        return reinterpret_cast<const uint32*>(frame.pixels + row * frame.stride)[x];
+    }
+
+    // Low-res lines 1-4, pseudo hi-res (BG1 main, BG2 sub) from line 5
+    void renderMixedFrame() {
+        memory.write(0x2133, 0x00);
+        for (int line = 1; line <= PPU::SCREEN_HEIGHT; ++line) {
+            if (line == 5) {
+                memory.write(0x2133, 0x08);
+            }
+            ppu.renderScanline(line);
+        }
+        ppu.endFrame();
+    }
+
+    void testFrameGeometry() {
+        printTestHeader("Test Hi-Res, Interlace and Overscan Frames");
+        resetAll();
+        setupTwoLayers();
+        memory.write(0x212D, 0x02);                 // BG2 on the sub screen
+        FrameOutput& output = ppu.getOutput();
+        uint32 red = output.convert(0x001F, 0x0F);
+        uint32 green = output.convert(0x03E0, 0x0F);
+        uint32 blue = output.convert(0x7C00, 0x0F);
+
+        renderFrame();
+        FrameOutput::Frame frame = output.acquireFrame();
+        assert_equal("Normal frame width", 256, frame.width);
+        assert_equal("Normal frame height", 224, frame.height);
+        assert_equal("Normal BGR555 stride", 256, ppu.getFrameStride());
+
+        // Pseudo hi-res: sub screen in even columns, main in odd ones
+        renderMixedFrame();
+        frame = output.acquireFrame();
+        assert_equal("Hi-res frame width", 512, frame.width);
+        assert_equal("Hi-res line width", 512, ppu.getLineWidth(4));
+        assert_equal("Low-res line width", 256, ppu.getLineWidth(0));
+        assert_equal("Sub screen pixel", 0x03E0, pixel(0, 5));
+        assert_equal("Main screen pixel", 0x001F, pixel(1, 5));
+        assert_equal("Low-res line kept", 0x001F, pixel(1, 4));
+        assert_equal("Output sub pixel", green, outputPixel(frame, 0, 4));
+        assert_equal("Output main pixel", red, outputPixel(frame, 1, 4));
+        assert_true("Low-res line doubled", outputPixel(frame, 0, 0) == red && outputPixel(frame, 1, 0) == red &&
+                                            outputPixel(frame, 511, 0) == red);
+
+        // Threads give the same frame, widened before the workers start
+        vector<uint16> serialRows(ppu.getFrameBuffer(), ppu.getFrameBuffer() + 512 * PPU::SCREEN_HEIGHT);
+        vector<uint8> serialOutput(frame.pixels, frame.pixels + frame.stride * frame.height);
+        ppu.setRenderThreads(2);
+        ppu.setSkipUnchangedLines(false);
+        renderMixedFrame();
+        ppu.setRenderThreads(0);
+        ppu.setSkipUnchangedLines(true);
+        frame = output.acquireFrame();
+        assert_true("Threaded hi-res BGR555 identical",
+                    vector<uint16>(ppu.getFrameBuffer(), ppu.getFrameBuffer() + 512 * PPU::SCREEN_HEIGHT) == serialRows);
+        assert_true("Threaded hi-res output identical",
+                    vector<uint8>(frame.pixels, frame.pixels + frame.stride * frame.height) == serialOutput);
+
+        // Back to 256 wide on the next low-res frame
+        memory.write(0x2133, 0x00);
+        renderFrame();
+        assert_equal("Next frame narrow again", 256, output.acquireFrame().width);
+
+        // Mode 5: BG1 is 512 wide, 16-pixel characters split into two 8x8 tiles
+        memory.write(0x2105, 0x05);
+        memory.write(0x212C, 0x01);
+        memory.write(0x212D, 0x01);
+        renderFrame();
+        assert_equal("Mode 5 left character", 0x001F, pixel(7, 1));
+        assert_equal("Mode 5 right character", 0x03E0, pixel(8, 1));
+        memory.write(0x2105, 0x01);
+        memory.write(0x212D, 0x02);
+
+        // Overscan: 239 lines
+        memory.write(0x2133, 0x04);
+        renderFrame();
+        frame = output.acquireFrame();
+        assert_equal("Overscan lines", 239, ppu.getVisibleLines());
+        assert_equal("Overscan frame height", 239, frame.height);
+        assert_equal("Line 239 drawn", blue, outputPixel(frame, 0, 238));
+
+        // Interlace: each field draws every other row, the other is woven in
+        memory.write(0x2133, 0x01);
+        memory.write(0x212C, 0x00);                 // Backdrop only
+        writeColor(0, 0x001F);
+        renderFrame();
+        int firstField = ppu.getField();
+        writeColor(0, 0x7C00);
+        renderFrame();
+        frame = output.acquireFrame();
+        assert_true("Interlaced", ppu.isInterlaced());
+        assert_equal("Interlaced frame height", 448, frame.height);
+        assert_true("Fields alternate", ppu.getField() != firstField);
+        assert_equal("Current field row", blue, outputPixel(frame, 0, ppu.getField()));
+        assert_equal("Previous field row", red, outputPixel(frame, 0, firstField));
+
+        resetAll();
+        assert_equal("Reset frees the wide rows", 256, ppu.getFrameStride());
+        assert_equal("Reset frame height", 224, ppu.getFrameHeight());
+    }
+
+    void testWindows() {
+        printTestHeader("Test Windows");
+        resetAll();
+        setupTwoLayers();
+        memory.write(0x2126, 8);                    // W1: 8-15
+        memory.write(0x2127, 15);
+        memory.write(0x2128, 12);                   // W2: 12-23
+        memory.write(0x2129, 23);
+        memory.write(0x2123, 0x02);                 // BG1 uses W1
+        ppu.renderScanline(1);
+        assert_equal("Window ignored without TMW", 0x001F, pixel(8, 1));
+
+        memory.write(0x212E, 0x01);                 // Mask BG1 on main
+        ppu.renderScanline(1);
+        assert_equal("Left of window", 0x001F, pixel(7, 1));
+        assert_equal("Inside window masked", 0x7C00, pixel(8, 1));
+        assert_equal("Window right edge inclusive", 0x7C00, pixel(15, 1));
+        assert_equal("Right of window", 0x001F, pixel(16, 1));
+
+        memory.write(0x2123, 0x03);                 // Inverted W1
+        ppu.renderScanline(1);
+        assert_equal("Inverted: outside masked", 0x7C00, pixel(0, 1));
+        assert_equal("Inverted: inside shown", 0x001F, pixel(8, 1));
+
+        memory.write(0x2123, 0x0A);                 // W1 and W2
+        memory.write(0x212A, 0x01);                 // AND
+        ppu.renderScanline(1);
+        assert_equal("AND: W1 only", 0x001F, pixel(8, 1));
+        assert_equal("AND: both", 0x7C00, pixel(12, 1));
+        memory.write(0x212A, 0x02);                 // XOR
+        ppu.renderScanline(1);
+        assert_equal("XOR: W1 only", 0x7C00, pixel(8, 1));
+        assert_equal("XOR: both", 0x001F, pixel(12, 1));
+        assert_equal("XOR: W2 only", 0x7C00, pixel(20, 1));
+
+        // BG2 behind shows through the masked BG1
+        memory.write(0x212C, 0x03);
+        ppu.renderScanline(1);
+        assert_equal("Lower layer visible through window", 0x03E0, pixel(8, 1));
+    }
+
+    void testColorMath() {
+        printTestHeader("Test Color Math");
+        resetAll();
+        setupMode1();
+        memory.write(0x212C, 0x00);                 // Backdrop only
+        memory.write(0x2132, 0x30);                 // Fixed color: red 16
+        memory.write(0x2131, 0x20);                 // Add to backdrop
+        ppu.renderScanline(1);
+        assert_equal("Add fixed color", 0x7C10, pixel(0, 1));
+
+        memory.write(0x2131, 0x60);                 // Add, half
+        ppu.renderScanline(1);
+        assert_equal("Half add", (15 << 10) | 8, pixel(0, 1));
+
+        writeColor(0, 0x7FFF);
+        memory.write(0x2131, 0xA0);                 // Subtract
+        ppu.renderScanline(1);
+        assert_equal("Subtract fixed color", 0x7FEF, pixel(0, 1));
+        memory.write(0x2132, 0xFF);                 // All components 31
+        ppu.renderScanline(1);
+        assert_equal("Subtract clamps at 0", 0x0000, pixel(0, 1));
+        memory.write(0x2132, 0xE0);                 // Fixed color back to 0
+
+        // Color window: W1 over 10-19
+        writeColor(0, 0x7C00);
+        memory.write(0x2132, 0x30);
+        memory.write(0x2131, 0x20);
+        memory.write(0x2125, 0x20);
+        memory.write(0x2126, 10);
+        memory.write(0x2127, 19);
+        memory.write(0x2130, 0x20);                 // Prevent math inside
+        ppu.renderScanline(1);
+        assert_equal("Math outside color window", 0x7C10, pixel(0, 1));
+        assert_equal("No math inside color window", 0x7C00, pixel(10, 1));
+        memory.write(0x2130, 0x80);                 // Clip to black inside
+        ppu.renderScanline(1);
+        assert_equal("Clipped pixel plus fixed color", 0x0010, pixel(10, 1));
+        assert_equal("Unclipped pixel", 0x7C10, pixel(20, 1));
+
+        // Sub screen addend: red BG1 on main, green BG2 on sub
+        resetAll();
+        setupTwoLayers();
+        memory.write(0x212C, 0x01);
+        memory.write(0x212D, 0x02);
+        memory.write(0x2130, 0x02);
+        memory.write(0x2131, 0x01);
+        ppu.renderScanline(1);
+        assert_equal("Main + sub", 0x03FF, pixel(0, 1));
+        memory.write(0x2131, 0x41);
+        ppu.renderScanline(1);
+        assert_equal("(Main + sub) / 2", (15 << 5) | 15, pixel(0, 1));
+        memory.write(0x212D, 0x00);                 // Sub is all backdrop
+        memory.write(0x2132, 0x88);                 // Fixed color: blue 8
+        ppu.renderScanline(1);
+        assert_equal("Sub backdrop uses fixed color, no half", (8 << 10) | 31, pixel(0, 1));
+        memory.write(0x2131, 0x00);
+        ppu.renderScanline(1);
+        assert_equal("Math disabled for BG1", 0x001F, pixel(0, 1));
+
+        // Sprites with palettes 0-3 never take part in color math
+        resetAll();
+        setupSprites();
+        writeSprite(0, 0, 0, 1, 0x00);              // Palette 0
+        writeSprite(1, 8, 0, 1, 0x08);              // Palette 4
+        writeColor(128 + 64 + 3, 0x001F);
+        memory.write(0x2132, 0x50);                 // Fixed color: green 16
+        memory.write(0x2131, 0x10);
+        ppu.renderScanline(1);
+        assert_equal("OBJ palette 0 ignores math", 0x001F, pixel(0, 1));
+        assert_equal("OBJ palette 4 gets math", 0x021F, pixel(8, 1));
+    }
+
+    // Same pseudo-random screen line for every kernel
+    void seedScreen(uint8* index, uint8* depth, uint8* math, unsigned seed) {
+        srand(seed);
+        for (int i = 0; i < 256; ++i) {
+            index[i] = rand() & 0xFF;
+            depth[i] = rand() & 0x7F;
+            math[i] = 0;
+        }
+    }
+
+    bool sameScreen(const uint8* index1, const uint8* depth1, const uint8* math1,
+                    const uint8* index2, const uint8* depth2, const uint8* math2) {
+        return std::memcmp(index1, index2, 256) == 0 && std::memcmp(depth1, depth2, 256) == 0 &&
+               std::memcmp(math1, math2, 256) == 0;
+    }
+
+    void testCompositorKernels() {
+        printTestHeader("Test Compositor Kernels");
+        srand(0xC0DE);
+        uint16 mainColors[256], subColors[256], reference[256], vector[256];
+        uint8 math[256], half[256];
+        for (int i = 0; i < 256; ++i) {
+            mainColors[i] = rand() & 0x7FFF;
+            subColors[i] = rand() & 0x7FFF;
+            math[i] = (rand() & 1) ? 0xFF : 0x00;
+            half[i] = (rand() & 1) ? 0xFF : 0x00;
+        }
+        bool sse2 = true;
+        bool avx2 = true;
+        TileDecoder::Level best = TileDecoder::detectLevel();
+        for (int subtract = 0; subtract < 2; ++subtract) {
+            // 253 pixels exercises the tails
+            Compositor::blendLineScalar(mainColors, subColors, math, half, subtract, reference, 253);
+#if defined(__x86_64__) || defined(__i386__)
+            Compositor::blendLineSSE2(mainColors, subColors, math, half, subtract, vector, 253);
+            sse2 = sse2 && std::memcmp(reference, vector, 253 * 2) == 0;
+            if (best == TileDecoder::LEVEL_AVX2) {
+                Compositor::blendLineAVX2(mainColors, subColors, math, half, subtract, vector, 253);
+                avx2 = avx2 && std::memcmp(reference, vector, 253 * 2) == 0;
+            }
+#endif
+        }
+        assert_true("SSE2 blend matches scalar", sse2);
+        assert_true("AVX2 blend matches scalar", avx2);
+
+        // Merge with both layer strides; the layer buffers hold 2x pixels
+        uint8 index[512], depth[512], window[256];
+        for (int i = 0; i < 512; ++i) {
+            index[i] = (rand() & 3) ? rand() & 0xFF : 0;
+            depth[i] = rand() & 0x7F;
+        }
+        for (int i = 0; i < 256; ++i) {
+            window[i] = (rand() & 3) ? 0x00 : 0xFF;
+        }
+        sse2 = true;
+        avx2 = true;
+        for (int step = 1; step <= 2; ++step) {
+            uint8 refIndex[256], refDepth[256], refMath[256];
+            uint8 vecIndex[256], vecDepth[256], vecMath[256];
+            seedScreen(refIndex, refDepth, refMath, step);
+            Compositor::mergeLayerScalar(refIndex, refDepth, refMath, index, depth, step, window, 0xFF, 192, 253);
+#if defined(__x86_64__) || defined(__i386__)
+            seedScreen(vecIndex, vecDepth, vecMath, step);
+            Compositor::mergeLayerSSE2(vecIndex, vecDepth, vecMath, index, depth, step, window, 0xFF, 192, 253);
+            sse2 = sse2 && sameScreen(refIndex, refDepth, refMath, vecIndex, vecDepth, vecMath);
+            if (best == TileDecoder::LEVEL_AVX2) {
+                seedScreen(vecIndex, vecDepth, vecMath, step);
+                Compositor::mergeLayerAVX2(vecIndex, vecDepth, vecMath, index, depth, step, window, 0xFF, 192, 253);
+                avx2 = avx2 && sameScreen(refIndex, refDepth, refMath, vecIndex, vecDepth, vecMath);
+            }
+#endif
+        }
+        assert_true("SSE2 merge matches scalar", sse2);
+        assert_true("AVX2 merge matches scalar", avx2);
+    }
+};
+
+int main() {
+    PPUTester tester;
+    tester.runAllTests();
+    return 0;
+}
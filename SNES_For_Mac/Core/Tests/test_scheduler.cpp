@@ -0,0 +1,311 @@
+//
+//  test_scheduler.cpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#include "../CPU/CPU65c816.hpp"
+#include "../Memory/Memory.hpp"
+#include "../Scheduler/Scheduler.hpp"
+#include "../Scheduler/EventQueue.hpp"
+#include "../Types/Timing.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define COLOR_RESET     "\033[0m"
+#define COLOR_GREEN     "\033[32m"
+#define COLOR_RED       "\033[31m"
+#define COLOR_YELLOW    "\033[33m"
+#define COLOR_CYAN      "\033[36m"
+
+using namespace std;
+
+class SchedulerTester {
+private:
+    CPU65c816 cpu;
+    Memory memory;
+    Scheduler scheduler;
+    vector<uint8> rom;
+    int testsPassed;
+    int testsFailed;
+
+public:
+    SchedulerTester() {
+        cpu.setMemory(&memory);
+        memory.setScheduler(&scheduler);
+        scheduler.setCPU(&cpu);
+        scheduler.setMemory(&memory);
+        testsPassed = 0;
+        testsFailed = 0;
+    }
+
+    int runAllTests() {
+        cout << COLOR_CYAN << "=== SNES Emulator Scheduler Tests ===" << COLOR_RESET << endl;
+
+        testEventQueue();
+        testFrame();
+        testNMI();
+        testWAI();
+        testVIRQ();
+        testHIRQ();
+        testIRQEnabledMidRun();
+        testJoypad();
+
+        cout << endl;
+        cout << COLOR_CYAN << "=== Test Summary ===" << COLOR_RESET << endl;
+        cout << COLOR_GREEN << "Passed: " << testsPassed << COLOR_RESET << endl;
+        if (testsFailed > 0) {
+            cout << COLOR_RED << "Failed: " << testsFailed << COLOR_RESET << endl;
+        } else {
+            cout << COLOR_GREEN << "All tests Passed! ✓" << COLOR_RESET << endl;
+        }
+        return testsFailed;
+    }
+
+private:
+    void assert_equal(const string& testName, uint32 expected, uint32 actual) {
+        if (expected == actual) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            cout << " Expected: 0x" << hex << expected << ", Got: 0x" << actual << dec << endl;
+            testsFailed++;
+        }
+    }
+
+    void assert_true(const string& testName, bool condition) {
+        if (condition) {
+            cout << COLOR_GREEN << "✓ " << testName << COLOR_RESET << endl;
+            testsPassed++;
+        } else {
+            cout << COLOR_RED << "✗ " << testName << COLOR_RESET << endl;
+            testsFailed++;
+        }
+    }
+
+    void printTestHeader(const string& testName) {
+        cout << endl << COLOR_YELLOW << "--- " << testName << " ---" << COLOR_RESET << endl;
+    }
+
+    // Main program at $8000, NMI handler at $8100, IRQ handler at $8200
+    // (emulation mode vectors); the CPU starts at $8000
+    void load(const vector<uint8>& main, const vector<uint8>& nmi, const vector<uint8>& irq) {
+        rom.assign(0x10000, 0xEA);
+        std::copy(main.begin(), main.end(), rom.begin() + 0x8000);
+        std::copy(nmi.begin(), nmi.end(), rom.begin() + 0x8100);
+        std::copy(irq.begin(), irq.end(), rom.begin() + 0x8200);
+        rom[0xFFFA] = 0x00;
+        rom[0xFFFB] = 0x81;
+        rom[0xFFFE] = 0x00;
+        rom[0xFFFF] = 0x82;
+        memory.loadROM(rom);
+        memory.reset();
+        cpu.reset();
+        scheduler.reset();
+    }
+
+    uint8 ram(uint16 address) {
+        return memory.getLowRAM()[address];
+    }
+
+    void testEventQueue() {
+        printTestHeader("Event Queue");
+        EventQueue<4> queue;
+        assert_true("Empty", queue.next() == EventQueue<4>::NEVER);
+        queue.schedule(2, 500);
+        queue.schedule(0, 300);
+        queue.schedule(3, 300);
+        queue.schedule(1, 900);
+        assert_equal("Earliest", 300, static_cast<uint32>(queue.next()));
+
+        int kind;
+        uint64 time;
+        assert_true("Nothing due yet", !queue.pop(299, kind, time));
+        assert_true("Due", queue.pop(1000, kind, time));
+        assert_equal("Ties in kind order", 0, kind);
+        assert_true("Next", queue.pop(1000, kind, time));
+        assert_equal("Then the other", 3, kind);
+        assert_equal("At its time", 300, static_cast<uint32>(time));
+
+        queue.schedule(1, 400);
+        assert_true("Rescheduling moves it", queue.pop(1000, kind, time) && kind == 1 && time == 400);
+        queue.cancel(2);
+        assert_true("Cancelled", !queue.isPending(2) && queue.next() == EventQueue<4>::NEVER);
+    }
+
+    void testFrame() {
+        printTestHeader("Frame");
+        load({0x4C, 0x00, 0x80}, {0x40}, {0x40});       // JMP $8000
+        scheduler.runFrame();
+        uint64 frame = Scheduler::LINES_PER_FRAME * MASTER_CYCLES_PER_SCANLINE;
+        uint64 time = scheduler.getTime();
+        assert_true("One frame of master cycles", time >= frame && time < frame + 48);
+        assert_equal("Ends before line 0", Scheduler::LINES_PER_FRAME - 1, scheduler.getLine());
+        // A batch per event: line start and H-blank on every line
+        assert_true("CPU runs in batches", scheduler.getBatches() <= Scheduler::LINES_PER_FRAME * 2 + 2);
+        scheduler.runFrame();
+        assert_equal("Frames", 2, static_cast<uint32>(scheduler.getFrames()));
+        assert_equal("Next frame start", static_cast<uint32>(frame), static_cast<uint32>(scheduler.getFrameStart()));
+    }
+
+    void testNMI() {
+        printTestHeader("NMI");
+        load({0xA9, 0x80,                               // LDA #$80
+              0x8D, 0x00, 0x42,                         // STA $4200
+              0x4C, 0x05, 0x80},                        // JMP *
+             {0xE6, 0x10,                               // INC $10
+              0xAD, 0x10, 0x42,                         // LDA $4210
+              0x85, 0x11,                               // STA $11
+              0x40},                                    // RTI
+             {0x40});
+        scheduler.runFrame();
+        assert_equal("NMI once per frame", 1, ram(0x10));
+        assert_equal("RDNMI flag and version", 0x82, ram(0x11));
+        assert_equal("Reading RDNMI clears it", 0x02, memory.read(0x4210));
+        scheduler.runFrame();
+        scheduler.runFrame();
+        assert_equal("Three frames", 3, ram(0x10));
+
+        // Disabled: the flag is still set at V-blank
+        load({0x4C, 0x00, 0x80}, {0xE6, 0x10, 0x40}, {0x40});
+        scheduler.runFrame();
+        assert_equal("No NMI", 0, ram(0x10));
+        assert_equal("Flag without NMI", 0x82, memory.read(0x4210) & 0x82);
+    }
+
+    void testWAI() {
+        printTestHeader("WAI");
+        load({0xA9, 0x80,                               // LDA #$80
+              0x8D, 0x00, 0x42,                         // STA $4200
+              0xCB,                                     // loop: WAI
+              0xE6, 0x12,                               //       INC $12
+              0x4C, 0x05, 0x80},                        //       JMP loop
+             {0xE6, 0x10, 0x40},                        // INC $10, RTI
+             {0x40});
+        scheduler.runFrame();
+        scheduler.runFrame();
+        assert_equal("Woken by NMI", 2, ram(0x10));
+        assert_equal("Resumes after WAI", 2, ram(0x12));
+        assert_true("Waiting", cpu.isWaiting());
+
+        // An HDMA stall during the wait is spent in it, not charged again
+        // to the first instruction after waking
+        uint64 before = cpu.totalCycles;
+        memory.addStallCycles(48);
+        cpu.run(before + 100);
+        assert_equal("Wait skips to the target", 100, static_cast<uint32>(cpu.totalCycles - before));
+        assert_equal("Stall absorbed by the skip", 0, memory.consumeStallCycles());
+        memory.addStallCycles(48);
+        cpu.executeInstruction();
+        assert_equal("Stall absorbed while stepping", 0, memory.consumeStallCycles());
+    }
+
+    void testVIRQ() {
+        printTestHeader("V IRQ");
+        // VTIME and HTIME are $1FF (off) until both halves are written
+        load({0xA9, 0x00,                               // LDA #0
+              0x8D, 0x0A, 0x42,                         // STA $420A
+              0xA9, 0x64,                               // LDA #100
+              0x8D, 0x09, 0x42,                         // STA $4209
+              0xA9, 0x20,                               // LDA #$20
+              0x8D, 0x00, 0x42,                         // STA $4200
+              0x58,                                     // CLI
+              0x4C, 0x10, 0x80},                        // JMP *
+             {0x40},
+             {0xE6, 0x13,                               // INC $13
+              0xAD, 0x11, 0x42,                         // LDA $4211
+              0x85, 0x14,                               // STA $14
+              0x40});                                   // RTI
+        scheduler.runFrame();
+        assert_equal("Once per frame", 1, ram(0x13));
+        assert_equal("TIMEUP set", 0x80, ram(0x14));
+        assert_equal("Reading TIMEUP clears it", 0x00, memory.read(0x4211));
+        scheduler.runFrame();
+        assert_equal("Two frames", 2, ram(0x13));
+
+        // Masked: the flag is raised but the handler never runs
+        load({0xA9, 0x00, 0x8D, 0x0A, 0x42, 0xA9, 0x64, 0x8D, 0x09, 0x42, 0xA9, 0x20, 0x8D, 0x00, 0x42,
+              0x4C, 0x0F, 0x80},
+             {0x40}, {0xE6, 0x13, 0x40});
+        scheduler.runFrame();
+        assert_equal("I flag masks it", 0, ram(0x13));
+        assert_equal("Still flagged", 0x80, memory.read(0x4211));
+    }
+
+    void testHIRQ() {
+        printTestHeader("H IRQ");
+        load({0xA9, 0x00,                               // LDA #0
+              0x8D, 0x08, 0x42,                         // STA $4208
+              0xA9, 0xC8,                               // LDA #200
+              0x8D, 0x07, 0x42,                         // STA $4207
+              0xA9, 0x10,                               // LDA #$10
+              0x8D, 0x00, 0x42,                         // STA $4200
+              0x58,                                     // CLI
+              0x4C, 0x10, 0x80},                        // JMP *
+             {0x40},
+             {0xE6, 0x13,                               // INC $13
+              0xD0, 0x02,                               // BNE +2
+              0xE6, 0x14,                               // INC $14
+              0xAD, 0x11, 0x42,                         // LDA $4211
+              0x40});                                   // RTI
+        scheduler.runFrame();
+        assert_equal("Every line", Scheduler::LINES_PER_FRAME, ram(0x13) | (ram(0x14) << 8));
+    }
+
+    void testIRQEnabledMidRun() {
+        printTestHeader("IRQ Enabled Mid-run");
+        // The H IRQ is due well before the CPU's current run would end
+        // (at H-blank); it has to be taken on time, not at the end of the run
+        load({0xA9, 0x00,                               // LDA #0
+              0x8D, 0x08, 0x42,                         // STA $4208
+              0xA9, 0x64,                               // LDA #100
+              0x8D, 0x07, 0x42,                         // STA $4207
+              0xA9, 0x10,                               // LDA #$10
+              0x8D, 0x00, 0x42,                         // STA $4200
+              0x58,                                     // CLI
+              0xE6, 0x20,                               // loop: INC $20
+              0x4C, 0x10, 0x80},                        //       JMP loop
+             {0x40},
+             {0xAD, 0x20, 0x00,                         // LDA $0020
+              0x85, 0x21,                               // STA $21
+              0xA9, 0x00,                               // LDA #0
+              0x8D, 0x00, 0x42,                         // STA $4200
+              0xAD, 0x11, 0x42,                         // LDA $4211
+              0x40});                                   // RTI
+        scheduler.runFrame();
+        // Dot 100 is 400 master cycles in; a loop is 48
+        assert_true("Taken at HTIME", ram(0x21) >= 4 && ram(0x21) <= 8);
+    }
+
+    void testJoypad() {
+        printTestHeader("Auto-joypad Read");
+        load({0xA9, 0x01,                               // LDA #$01
+              0x8D, 0x00, 0x42,                         // STA $4200
+              0xAD, 0x12, 0x42,                         // loop: LDA $4212
+              0x10, 0xFB,                               //       BPL loop
+              0x85, 0x15,                               // STA $15
+              0x4C, 0x0C, 0x80},                        // JMP *
+             {0x40}, {0x40});
+        scheduler.setJoypad(0, 0x8010);                 // B and R
+        scheduler.setJoypad(1, 0x0800);                 // Up
+        scheduler.runFrame();
+        assert_equal("V-blank and busy reading", 0x81, ram(0x15) & 0x81);
+        assert_equal("JOY1L", 0x10, memory.read(0x4218));
+        assert_equal("JOY1H", 0x80, memory.read(0x4219));
+        assert_equal("JOY2H", 0x08, memory.read(0x421B));
+        assert_equal("Read done, still in V-blank", 0x80, memory.read(0x4212) & 0x81);
+
+        scheduler.setJoypad(0, 0);
+        scheduler.runFrame();
+        assert_equal("Latched every frame", 0x00, memory.read(0x4219));
+    }
+};
+
+int main() {
+    SchedulerTester tester;
+    tester.runAllTests();
+    return 0;
+}
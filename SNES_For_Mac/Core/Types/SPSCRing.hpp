@@ -0,0 +1,102 @@
+//
+//  SPSCRing.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include "Types.hpp"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock-free ring buffer for one producer thread and one consumer thread
+// Each side only writes its own index, so neither ever waits on the
+// other; a full ring refuses items and an empty one returns none.
+// Indices count up forever and are masked into the power-of-two buffer.
+template <typename T>
+class SPSCRing {
+public:
+    // Holds at least capacity items
+    explicit SPSCRing(size_t capacity): head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buffer.resize(size);
+        mask = size - 1;
+    }
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    size_t capacity() const { return buffer.size(); }
+
+    // Items waiting; exact on either side's own thread, a snapshot elsewhere
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // Producer: append up to count items; returns how many fit
+    size_t push(const T* items, size_t count) {
+        size_t end = tail.load(std::memory_order_relaxed);
+        size_t space = buffer.size() - (end - head.load(std::memory_order_acquire));
+        if (count > space) {
+            count = space;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            buffer[(end + i) & mask] = items[i];
+        }
+        tail.store(end + count, std::memory_order_release);
+        return count;
+    }
+    bool push(const T& item) { return push(&item, 1) == 1; }
+
+    // Consumer: take up to count items; returns how many there were
+    size_t pop(T* items, size_t count) {
+        size_t start = head.load(std::memory_order_relaxed);
+        size_t available = tail.load(std::memory_order_acquire) - start;
+        if (count > available) {
+            count = available;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            items[i] = buffer[(start + i) & mask];
+        }
+        head.store(start + count, std::memory_order_release);
+        return count;
+    }
+    bool pop(T& item) { return pop(&item, 1) == 1; }
+
+    // Producer: a mark after everything pushed so far, for skipTo()
+    size_t mark() const { return tail.load(std::memory_order_relaxed); }
+
+    // Consumer: drop items pushed before mark, if not taken yet
+    void skipTo(size_t mark) {
+        size_t start = head.load(std::memory_order_relaxed);
+        if (static_cast<std::ptrdiff_t>(mark - start) > 0) {
+            head.store(mark, std::memory_order_release);
+        }
+    }
+
+    // Consumer: drop up to count items
+    size_t skip(size_t count) {
+        size_t start = head.load(std::memory_order_relaxed);
+        size_t available = tail.load(std::memory_order_acquire) - start;
+        if (count > available) {
+            count = available;
+        }
+        head.store(start + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<T> buffer;
+    size_t mask;
+    // Apart so the two sides don't share a cache line
+    alignas(64) std::atomic<size_t> head;   // Next item to pop (consumer)
+    alignas(64) std::atomic<size_t> tail;   // Next slot to fill (producer)
+};
+#endif
@@ -0,0 +1,39 @@
+//
+//  Timing.hpp
+//  SNES_For_Mac
+//
+//  Created by Haide Lan on 2026/10/17.
+//
+
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include "Types.hpp"
+
+// SNES timing constants (NTSC)
+// Everything is measured in master clock cycles (~21.477 MHz)
+const uint32 MASTER_CLOCK_NTSC = 21477272;
+
+// The CPU spends 6, 8 or 12 master cycles per bus cycle depending on the
+// region being accessed; 6 is the figure the frame loop budgets with
+const uint32 MASTER_CYCLES_PER_CPU_CYCLE = 6;
+
+const uint32 MASTER_CYCLES_PER_SCANLINE = 1364;
+const uint32 SCANLINES_PER_FRAME_NTSC = 262;
+
+// The SPC700 has its own 24.576 MHz crystal, divided by 24
+const uint32 APU_CLOCK = 1024000;
+
+// DMA moves one byte every 8 master cycles, plus a fixed overhead
+const uint32 DMA_CYCLES_PER_BYTE = 8;
+const uint32 DMA_CYCLES_PER_CHANNEL = 8;
+const uint32 DMA_CYCLES_SETUP = 12;
+
+// HDMA: fixed cost on every line with an active channel, plus per-channel
+// costs for each transfer, table header and indirect address reload
+const uint32 HDMA_CYCLES_PER_LINE = 18;
+const uint32 HDMA_CYCLES_PER_CHANNEL = 8;
+const uint32 HDMA_CYCLES_HEADER = 8;
+const uint32 HDMA_CYCLES_INDIRECT = 16;
+
+#endif